@@ -39,6 +39,95 @@
 // Clear RAM on boot
 #define CLEARRAM 1
 
+// Object Pool Defines
+/// The maximum number of objects that can be loaded at once (240 in vanilla)
+#define OBJECT_POOL_CAPACITY 240
+/// Free object slots that unimportant objects (particles etc.) leave for the other
+/// object lists. Past that they replace the oldest unimportant object (0 in vanilla)
+#define OBJECT_POOL_UNIMPORTANT_RESERVE 0
+
+// Segment Cache Defines
+/// Keep decompressed segments in Expansion Pak RAM and copy them from there when a
+/// later level loads the same segment, instead of decompressing it again. Has no
+/// effect without an Expansion Pak, with USE_EXT_RAM, or with COMPRESS=uncomp
+// #define SEGMENT_CACHE
+/// Bytes of Expansion Pak RAM the segment cache may use
+#define SEGMENT_CACHE_SIZE 0x300000
+/// The maximum number of segments kept in the cache at once
+#define SEGMENT_CACHE_ENTRIES 48
+/// Decompress the segments of the level behind a warp or painting into the segment
+/// cache on a background thread while Mario approaches it. Needs SEGMENT_CACHE
+// #define LEVEL_PREFETCH
+/// How close Mario has to get to a warp object for its level to be prefetched
+#define LEVEL_PREFETCH_RADIUS 2000.0f
+
+// Environment Effect Defines
+/// Draw every flower and lava bubble with its own animation frame. In vanilla, each
+/// group of 5 particles is drawn with the frame of the first particle in the group
+// #define ENVFX_PARTICLE_FRAMES
+
+// Profiler Defines
+/// Time object updates, collision, camera, rendering, audio, DMA and environment
+/// effects on the game thread, and add a per-subsystem timeline to the profiler
+/// (press L to cycle modes)
+// #define PROFILER_SCOPES
+/// Number of frames the subsystem min/avg/max are taken over
+#define PROFILER_HISTORY_FRAMES 32
+/// Frames that take longer than this many microseconds are reported through
+/// osSyncPrintf, which goes over USB in UNF builds
+#define PROFILER_SPIKE_USEC 34000
+
+// Text Defines
+/// Keep the display lists of strings printed with print_generic_string,
+/// print_hud_lut_string and print_menu_generic_string, and call them again while
+/// the same string is printed at the same place. JP, SH and EU also unpack each
+/// dialog font character once instead of every time it is drawn
+// #define TEXT_GFX_CACHE
+/// The maximum number of strings kept at once
+#define TEXT_GFX_CACHE_ENTRIES 16
+
+// Painting Defines
+/// Keep the mesh of a rippling painting between frames instead of generating it every
+/// frame. Ripple heights come from the sine table, and normals are only recomputed
+/// around the vertices that moved
+// #define PAINTING_RIPPLE_CACHE
+
+// Trigonometry Defines
+/// Keep only a quarter of the sine table (4 KB instead of 20 KB) and fold angles into
+/// it. Gives the same values as the full table
+// #define TRIG_QUARTER_TABLE
+/// Interpolate sins/coss between the two closest table entries instead of rounding the
+/// angle down to a multiple of 0x10. More accurate, but slower and changes gameplay
+/// slightly (demos may desync)
+// #define TRIG_INTERPOLATE
+/// Find the octant in atan2s with two small tables instead of a branch per quadrant.
+/// Gives the same results. It is slower on the host, so measure it with tools/trigbench
+/// before turning it on
+// #define TRIG_ATAN2_OCTANT_TABLE
+
+// Moving Texture Defines
+/// Keep the vertices of water quads and moving texture meshes between frames and
+/// only write their texture coordinates again while the texture scrolls
+// #define MOVTEX_VERTEX_BUFFERS
+/// The maximum number of water quads kept at once
+#define MOVTEX_QUAD_BUFFERS 32
+/// The maximum number of moving texture meshes (waterfalls, lava, sand) kept at once
+#define MOVTEX_MESH_BUFFERS 8
+
+// Shadow Defines
+/// Keep the shadow of each object that stays in place and draw it again instead of
+/// making it every frame, as long as its position, floor, water level, scale and
+/// solidity are unchanged. Mario's shadow is always made again
+// #define SHADOW_CACHE
+/// Number of cached shadows. Objects share an entry when their slots in the object
+/// pool are this far apart
+#define SHADOW_CACHE_ENTRIES 64
+
+// Save Defines
+/// Write saves on a low priority thread instead of the game thread, and only write
+/// the EEPROM blocks or SRAM ranges that changed since the last write
+// #define SAVE_WRITE_THREAD
+
 // Screen Size Defines
 #define SCREEN_WIDTH 320
 #define SCREEN_HEIGHT 240
@@ -255,13 +255,16 @@ f32 gSineTable[] = {
     0.999830604f, 0.999857664f, 0.999882340f, 0.999904692f,
     0.999924719f, 0.999942362f, 0.999957621f, 0.999970615f,
     0.999981165f, 0.999989390f, 0.999995291f, 0.999998808f,
-#ifndef AVOID_UB
+// With TRIG_QUARTER_TABLE only the first four cosine entries are kept, right after the
+// sine entries, so that quarter_sine can read the sine of 0x400.
+#if !defined(AVOID_UB) && !defined(TRIG_QUARTER_TABLE)
 };
 
 f32 gCosineTable[0x1000] = {
 #endif
     // cosine
     1.000000000f, 0.999998808f, 0.999995291f, 0.999989390f,
+#ifndef TRIG_QUARTER_TABLE
     0.999981165f, 0.999970615f, 0.999957621f, 0.999942362f,
     0.999924719f, 0.999904692f, 0.999882340f, 0.999857664f,
     0.999830604f, 0.999801159f, 0.999769390f, 0.999735296f,
@@ -1291,6 +1294,7 @@ f32 gCosineTable[0x1000] = {
     0.999830604f, 0.999857664f, 0.999882340f, 0.999904692f,
     0.999924719f, 0.999942362f, 0.999957621f, 0.999970615f,
     0.999981165f, 0.999989390f, 0.999995291f, 0.999998808f,
+#endif
 };
 
 s16 gArctanTable[0x401] = {
@@ -134,6 +134,9 @@ void seq_channel_layer_process_script(struct SequenceChannelLayer *layer) {
     f32 sp24 = 0.0f;
     f32 temp_f12;
     f32 temp_f2;
+#ifdef M64_PREDECODE
+    struct M64LayerOp *op = NULL;
+#endif
 
 //! Copt: manually inline these functions in the scope of this routine
 #ifdef __sgi
@@ -168,6 +171,18 @@ void seq_channel_layer_process_script(struct SequenceChannelLayer *layer) {
 
     seqChannel = (*layer).seqChannel;
     seqPlayer = (*seqChannel).seqPlayer;
+#ifdef M64_PREDECODE
+    if (layer->op != NULL) {
+        op = seq_channel_layer_run_ops(layer);
+        if (!layer->enabled) {
+            return;
+        }
+    }
+    state = &layer->scriptState;
+    if (op != NULL) {
+        cmd = op->cmd;
+    } else
+#endif
     for (;;) {
         state = &layer->scriptState;
         //M64_READ_U8(state, cmd);
@@ -306,6 +321,11 @@ void seq_channel_layer_process_script(struct SequenceChannelLayer *layer) {
     }
 
     if (cmd == 0xc0) { // layer_delay
+#ifdef M64_PREDECODE
+        if (op != NULL) {
+            layer->delay = op->value;
+        } else
+#endif
         M64_READ_COMPRESSED_U16(state, layer->delay);
         layer->stopSomething = TRUE;
     } else {
@@ -314,6 +334,15 @@ void seq_channel_layer_process_script(struct SequenceChannelLayer *layer) {
         if (seqChannel->largeNotes == TRUE) {
             switch (cmd & 0xc0) {
                 case 0x00: // layer_note0 (play percentage, velocity, duration)
+#ifdef M64_PREDECODE
+                    if (op != NULL) {
+                        sp3A = op->value;
+                        vel = op->arg0;
+                        layer->noteDuration = op->arg1;
+                        layer->playPercentage = sp3A;
+                        goto l1090;
+                    }
+#endif
                     M64_READ_COMPRESSED_U16(state, sp3A);
                     vel = *((*state).pc++);
                     layer->noteDuration = *((*state).pc++);
@@ -321,6 +350,15 @@ void seq_channel_layer_process_script(struct SequenceChannelLayer *layer) {
                     goto l1090;
 
                 case 0x40: // layer_note1 (play percentage, velocity)
+#ifdef M64_PREDECODE
+                    if (op != NULL) {
+                        sp3A = op->value;
+                        vel = op->arg0;
+                        layer->noteDuration = 0;
+                        layer->playPercentage = sp3A;
+                        goto l1090;
+                    }
+#endif
                     M64_READ_COMPRESSED_U16(state, sp3A);
                     vel = *((*state).pc++);
                     layer->noteDuration = 0;
@@ -329,6 +367,13 @@ void seq_channel_layer_process_script(struct SequenceChannelLayer *layer) {
 
                 case 0x80: // layer_note2 (velocity, duration; uses last play percentage)
                     sp3A = layer->playPercentage;
+#ifdef M64_PREDECODE
+                    if (op != NULL) {
+                        vel = op->arg0;
+                        layer->noteDuration = op->arg1;
+                        goto l1090;
+                    }
+#endif
                     vel = *((*state).pc++);
                     layer->noteDuration = *((*state).pc++);
                     goto l1090;
@@ -339,6 +384,11 @@ l1090:
         } else {
             switch (cmd & 0xc0) {
                 case 0x00: // play note, type 0 (play percentage)
+#ifdef M64_PREDECODE
+                    if (op != NULL) {
+                        sp3A = op->value;
+                    } else
+#endif
                     M64_READ_COMPRESSED_U16(state, sp3A);
                     layer->playPercentage = sp3A;
                     goto l1138;
@@ -52,7 +52,21 @@ struct SoundCharacteristics {
     u8 freshness;
     u8 prev;
     u8 next;
-}; // size = 0x1C
+    // Position that distance (and the cached pan) were computed from, so they are only
+    // recomputed for sounds whose source moved
+    f32 lastX;
+    f32 lastY;
+    f32 lastZ;
+    f32 pan;
+    f32 intensity;      // volume intensity before vibrato, for intensityRange and intensityReach
+    f32 intensityRange;
+    u16 intensityReach;
+    u8 cacheFlags;
+}; // size = 0x38
+
+// SoundCharacteristics.cacheFlags
+#define SOUND_CACHE_PAN (1 << 0)
+#define SOUND_CACHE_INTENSITY (1 << 1)
 
 // Also the number of frames a discrete sound can be in the WAITING state before being deleted
 #define SOUND_MAX_FRESHNESS 10
@@ -882,6 +896,10 @@ static void process_sound_request(u32 bits, f32 *pos) {
         sSoundBanks[bank][soundIndex].y = &pos[1];
         sSoundBanks[bank][soundIndex].z = &pos[2];
         sSoundBanks[bank][soundIndex].distance = dist;
+        sSoundBanks[bank][soundIndex].lastX = pos[0];
+        sSoundBanks[bank][soundIndex].lastY = pos[1];
+        sSoundBanks[bank][soundIndex].lastZ = pos[2];
+        sSoundBanks[bank][soundIndex].cacheFlags = 0;
         sSoundBanks[bank][soundIndex].soundBits = bits;
         // In practice, the starting status is always WAITING
         sSoundBanks[bank][soundIndex].soundStatus = bits & SOUNDARGS_MASK_STATUS;
@@ -953,17 +971,21 @@ static void select_current_sounds(u8 bank) {
     u8 i;
     u8 j;
     u8 soundIndex;
-    u32 liveSoundPriorities[16] = { 0x10000000, 0x10000000, 0x10000000, 0x10000000,
-                                    0x10000000, 0x10000000, 0x10000000, 0x10000000,
-                                    0x10000000, 0x10000000, 0x10000000, 0x10000000,
-                                    0x10000000, 0x10000000, 0x10000000, 0x10000000 };
-    u8 liveSoundIndices[16] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-                                0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
-    u8 liveSoundStatuses[16] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-                                 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+    struct SoundCharacteristics *sound;
+    f32 x;
+    f32 y;
+    f32 z;
+    // Only sMaxChannelsForSoundBank[bank] <= MAX_CHANNELS_PER_SOUND_BANK entries are used
+    u32 liveSoundPriorities[MAX_CHANNELS_PER_SOUND_BANK];
+    u8 liveSoundIndices[MAX_CHANNELS_PER_SOUND_BANK];
     u8 numSoundsInBank = 0;
     u8 requestedPriority;
 
+    for (i = 0; i < MAX_CHANNELS_PER_SOUND_BANK; i++) {
+        liveSoundPriorities[i] = 0x10000000;
+        liveSoundIndices[i] = 0xff;
+    }
+
     //
     // Delete stale sounds and prioritize remaining sounds into the liveSound arrays
     //
@@ -1003,12 +1025,20 @@ static void select_current_sounds(u8 bank) {
         if (sSoundBanks[bank][soundIndex].soundStatus != SOUND_STATUS_STOPPED
             && soundIndex == latestSoundIndex) {
 
-            // Recompute distance each frame since the sound's position may have changed
-            sSoundBanks[bank][soundIndex].distance =
-                sqrtf((*sSoundBanks[bank][soundIndex].x * *sSoundBanks[bank][soundIndex].x)
-                      + (*sSoundBanks[bank][soundIndex].y * *sSoundBanks[bank][soundIndex].y)
-                      + (*sSoundBanks[bank][soundIndex].z * *sSoundBanks[bank][soundIndex].z))
-                * 1;
+            sound = &sSoundBanks[bank][soundIndex];
+
+            // Recompute distance only if the sound's position has changed since it was last
+            // computed, and drop the cached pan and volume along with it
+            x = *sound->x;
+            y = *sound->y;
+            z = *sound->z;
+            if (x != sound->lastX || y != sound->lastY || z != sound->lastZ) {
+                sound->distance = sqrtf(x * x + y * y + z * z) * 1;
+                sound->lastX = x;
+                sound->lastY = y;
+                sound->lastZ = z;
+                sound->cacheFlags = 0;
+            }
 
             requestedPriority = (sSoundBanks[bank][soundIndex].soundBits & SOUNDARGS_MASK_PRIORITY)
                                 >> SOUNDARGS_SHIFT_PRIORITY;
@@ -1017,37 +1047,40 @@ static void select_current_sounds(u8 bank) {
             // camera.
             // (Note that the sound's priority is the opposite of requestedPriority; lower is
             // more important)
-            if (sSoundBanks[bank][soundIndex].soundBits & SOUND_NO_PRIORITY_LOSS) {
-                sSoundBanks[bank][soundIndex].priority = 0x4c * (0xff - requestedPriority);
-            } else if (*sSoundBanks[bank][soundIndex].z > 0.0f) {
-                sSoundBanks[bank][soundIndex].priority =
-                    (u32) sSoundBanks[bank][soundIndex].distance
-                    + (u32)(*sSoundBanks[bank][soundIndex].z / US_FLOAT(6.0))
-                    + 0x4c * (0xff - requestedPriority);
+            if (sound->soundBits & SOUND_NO_PRIORITY_LOSS) {
+                sound->priority = 0x4c * (0xff - requestedPriority);
+            } else if (z > 0.0f) {
+                sound->priority =
+                    (u32) sound->distance + (u32)(z / US_FLOAT(6.0)) + 0x4c * (0xff - requestedPriority);
             } else {
-                sSoundBanks[bank][soundIndex].priority =
-                    (u32) sSoundBanks[bank][soundIndex].distance + 0x4c * (0xff - requestedPriority);
+                sound->priority = (u32) sound->distance + 0x4c * (0xff - requestedPriority);
             }
 
             // Insert the sound into the liveSound arrays, keeping the arrays sorted by priority.
             // If more than sMaxChannelsForSoundBank[bank] sounds are live, then the
             // sound with lowest priority will be removed from the arrays.
-            // In practice sMaxChannelsForSoundBank is always 1, so this code is overly general.
-            for (i = 0; i < sMaxChannelsForSoundBank[bank]; i++) {
-                // If the correct position is found
-                if (liveSoundPriorities[i] >= sSoundBanks[bank][soundIndex].priority) {
-                    // Shift remaining sounds to the right
-                    for (j = sMaxChannelsForSoundBank[bank] - 1; j > i; j--) {
-                        liveSoundPriorities[j] = liveSoundPriorities[j - 1];
-                        liveSoundIndices[j] = liveSoundIndices[j - 1];
-                        liveSoundStatuses[j] = liveSoundStatuses[j - 1];
+            // In practice sMaxChannelsForSoundBank is always 1, so that case only keeps
+            // the best sound seen so far. Later sounds win ties, as with the general case.
+            if (sMaxChannelsForSoundBank[bank] == 1) {
+                if (liveSoundPriorities[0] >= sound->priority) {
+                    liveSoundPriorities[0] = sound->priority;
+                    liveSoundIndices[0] = soundIndex;
+                }
+            } else {
+                for (i = 0; i < sMaxChannelsForSoundBank[bank]; i++) {
+                    // If the correct position is found
+                    if (liveSoundPriorities[i] >= sound->priority) {
+                        // Shift remaining sounds to the right
+                        for (j = sMaxChannelsForSoundBank[bank] - 1; j > i; j--) {
+                            liveSoundPriorities[j] = liveSoundPriorities[j - 1];
+                            liveSoundIndices[j] = liveSoundIndices[j - 1];
+                        }
+                        // Insert the sound at index i
+                        liveSoundPriorities[i] = sound->priority;
+                        liveSoundIndices[i] = soundIndex;
+                        // Break
+                        i = sMaxChannelsForSoundBank[bank];
                     }
-                    // Insert the sound at index i
-                    liveSoundPriorities[i] = sSoundBanks[bank][soundIndex].priority;
-                    liveSoundIndices[i] = soundIndex;
-                    liveSoundStatuses[i] = sSoundBanks[bank][soundIndex].soundStatus; // unused
-                    // Break
-                    i = sMaxChannelsForSoundBank[bank];
                 }
             }
 
@@ -1194,10 +1227,35 @@ static f32 get_sound_pan(f32 x, f32 z) {
     return pan;
 }
 
+/**
+ * Return the pan of a sound in a bank, reusing the pan computed on an earlier frame if the
+ * sound's source has not moved since.
+ *
+ * Called from threads: thread4_sound, thread5_game_loop (EU only)
+ */
+static f32 get_cached_sound_pan(u8 bank, u8 soundIndex) {
+    struct SoundCharacteristics *sound = &sSoundBanks[bank][soundIndex];
+    f32 x = *sound->x;
+    f32 z = *sound->z;
+    f32 pan;
+
+    if ((sound->cacheFlags & SOUND_CACHE_PAN) && x == sound->lastX && z == sound->lastZ) {
+        return sound->pan;
+    }
+
+    pan = get_sound_pan(x, z);
+    if (x == sound->lastX && z == sound->lastZ) {
+        sound->pan = pan;
+        sound->cacheFlags |= SOUND_CACHE_PAN;
+    }
+    return pan;
+}
+
 /**
  * Called from threads: thread4_sound, thread5_game_loop (EU only)
  */
 static f32 get_sound_volume(u8 bank, u8 soundIndex, f32 volumeRange) {
+    struct SoundCharacteristics *sound = &sSoundBanks[bank][soundIndex];
     f32 maxSoundDistance;
     f32 intensity;
 #ifndef VERSION_JP
@@ -1205,32 +1263,44 @@ static f32 get_sound_volume(u8 bank, u8 soundIndex, f32 volumeRange) {
 #endif
 
     if (!(sSoundBanks[bank][soundIndex].soundBits & SOUND_NO_VOLUME_LOSS)) {
-#ifdef VERSION_JP
-        // Intensity linearly lowers from 1 at the camera to 0 at maxSoundDistance
-        maxSoundDistance = sLevelAcousticReaches[gCurrLevelNum];
-        if (maxSoundDistance < sSoundBanks[bank][soundIndex].distance) {
-            intensity = 0.0f;
+        // The intensity only depends on the distance, which select_current_sounds only changes
+        // (and clears cacheFlags for) when the sound's source moves
+        if ((sound->cacheFlags & SOUND_CACHE_INTENSITY) && sound->intensityRange == volumeRange
+            && sound->intensityReach == sLevelAcousticReaches[gCurrLevelNum]) {
+            intensity = sound->intensity;
         } else {
-            intensity = 1.0 - sSoundBanks[bank][soundIndex].distance / maxSoundDistance;
-        }
-#else
-        // Intensity linearly lowers from 1 at the camera to 1 - volumeRange at maxSoundDistance,
-        // then it goes from 1 - volumeRange at maxSoundDistance to 0 at AUDIO_MAX_DISTANCE
-        if (sSoundBanks[bank][soundIndex].distance > AUDIO_MAX_DISTANCE) {
-            intensity = 0.0f;
-        } else {
-            maxSoundDistance = sLevelAcousticReaches[gCurrLevelNum] / div;
+#ifdef VERSION_JP
+            // Intensity linearly lowers from 1 at the camera to 0 at maxSoundDistance
+            maxSoundDistance = sLevelAcousticReaches[gCurrLevelNum];
             if (maxSoundDistance < sSoundBanks[bank][soundIndex].distance) {
-                intensity = ((AUDIO_MAX_DISTANCE - sSoundBanks[bank][soundIndex].distance)
-                             / (AUDIO_MAX_DISTANCE - maxSoundDistance))
-                            * (1.0f - volumeRange);
+                intensity = 0.0f;
             } else {
-                intensity =
-                    1.0f - sSoundBanks[bank][soundIndex].distance / maxSoundDistance * volumeRange;
+                intensity = 1.0 - sSoundBanks[bank][soundIndex].distance / maxSoundDistance;
+            }
+#else
+            // Intensity linearly lowers from 1 at the camera to 1 - volumeRange at maxSoundDistance,
+            // then it goes from 1 - volumeRange at maxSoundDistance to 0 at AUDIO_MAX_DISTANCE
+            if (sSoundBanks[bank][soundIndex].distance > AUDIO_MAX_DISTANCE) {
+                intensity = 0.0f;
+            } else {
+                maxSoundDistance = sLevelAcousticReaches[gCurrLevelNum] / div;
+                if (maxSoundDistance < sSoundBanks[bank][soundIndex].distance) {
+                    intensity = ((AUDIO_MAX_DISTANCE - sSoundBanks[bank][soundIndex].distance)
+                                 / (AUDIO_MAX_DISTANCE - maxSoundDistance))
+                                * (1.0f - volumeRange);
+                } else {
+                    intensity =
+                        1.0f - sSoundBanks[bank][soundIndex].distance / maxSoundDistance * volumeRange;
+                }
             }
-        }
 #endif
 
+            sound->intensity = intensity;
+            sound->intensityRange = volumeRange;
+            sound->intensityReach = sLevelAcousticReaches[gCurrLevelNum];
+            sound->cacheFlags |= SOUND_CACHE_INTENSITY;
+        }
+
         if (sSoundBanks[bank][soundIndex].soundBits & SOUND_VIBRATO) {
 #ifdef VERSION_JP
             //! @bug Intensity is 0 when the sound is far away. Due to the subtraction below, it is possible to end up with a negative intensity.
@@ -1400,12 +1470,10 @@ static void update_game_sound(void) {
                                 }
 #if defined(VERSION_EU) || defined(VERSION_SH)
                                 func_802ad770(0x03020000 | ((channelIndex & 0xff) << 8),
-                                              get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                                            *sSoundBanks[bank][soundIndex].z));
+                                              get_cached_sound_pan(bank, soundIndex));
 #else
                                 gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->pan =
-                                    get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                                  *sSoundBanks[bank][soundIndex].z);
+                                    get_cached_sound_pan(bank, soundIndex);
 #endif
 
                                 if ((sSoundBanks[bank][soundIndex].soundBits & SOUNDARGS_MASK_SOUNDID)
@@ -1463,8 +1531,7 @@ static void update_game_sound(void) {
                             func_802ad728(0x02020000 | ((channelIndex & 0xff) << 8),
                                           get_sound_volume(bank, soundIndex, VOLUME_RANGE_UNK1));
                             func_802ad770(0x03020000 | ((channelIndex & 0xff) << 8),
-                                          get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                                        *sSoundBanks[bank][soundIndex].z)
+                                          get_cached_sound_pan(bank, soundIndex)
                                                   * 127.0f
                                               + 0.5f);
                             func_802ad728(0x04020000 | ((channelIndex & 0xff) << 8),
@@ -1473,8 +1540,7 @@ static void update_game_sound(void) {
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->volume =
                                 get_sound_volume(bank, soundIndex, VOLUME_RANGE_UNK1);
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->pan =
-                                get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                              *sSoundBanks[bank][soundIndex].z);
+                                get_cached_sound_pan(bank, soundIndex);
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->freqScale =
                                 get_sound_freq_scale(bank, soundIndex);
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->reverbVol =
@@ -1493,8 +1559,7 @@ static void update_game_sound(void) {
                             func_802ad728(0x02020000 | ((channelIndex & 0xff) << 8),
                                           get_sound_volume(bank, soundIndex, VOLUME_RANGE_UNK2));
                             func_802ad770(0x03020000 | ((channelIndex & 0xff) << 8),
-                                          get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                                        *sSoundBanks[bank][soundIndex].z)
+                                          get_cached_sound_pan(bank, soundIndex)
                                                   * 127.0f
                                               + 0.5f);
                             func_802ad728(0x04020000 | ((channelIndex & 0xff) << 8),
@@ -1505,8 +1570,7 @@ static void update_game_sound(void) {
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->volume =
                                 get_sound_volume(bank, soundIndex, VOLUME_RANGE_UNK2);
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->pan =
-                                get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                              *sSoundBanks[bank][soundIndex].z);
+                                get_cached_sound_pan(bank, soundIndex);
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->freqScale =
                                 get_sound_freq_scale(bank, soundIndex);
 #endif
@@ -1584,12 +1648,10 @@ static void update_game_sound(void) {
                                 }
 #if defined(VERSION_EU) || defined(VERSION_SH)
                                 func_802ad770(0x03020000 | ((channelIndex & 0xff) << 8),
-                                              get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                                            *sSoundBanks[bank][soundIndex].z));
+                                              get_cached_sound_pan(bank, soundIndex));
 #else
                                 gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->pan =
-                                    get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                                  *sSoundBanks[bank][soundIndex].z);
+                                    get_cached_sound_pan(bank, soundIndex);
 #endif
 
                                 if ((sSoundBanks[bank][soundIndex].soundBits & SOUNDARGS_MASK_SOUNDID)
@@ -1647,8 +1709,7 @@ static void update_game_sound(void) {
                             func_802ad728(0x02020000 | ((channelIndex & 0xff) << 8),
                                           get_sound_volume(bank, soundIndex, VOLUME_RANGE_UNK1));
                             func_802ad770(0x03020000 | ((channelIndex & 0xff) << 8),
-                                          get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                                        *sSoundBanks[bank][soundIndex].z)
+                                          get_cached_sound_pan(bank, soundIndex)
                                                   * 127.0f
                                               + 0.5f);
                             func_802ad728(0x04020000 | ((channelIndex & 0xff) << 8),
@@ -1657,8 +1718,7 @@ static void update_game_sound(void) {
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->volume =
                                 get_sound_volume(bank, soundIndex, VOLUME_RANGE_UNK1);
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->pan =
-                                get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                              *sSoundBanks[bank][soundIndex].z);
+                                get_cached_sound_pan(bank, soundIndex);
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->freqScale =
                                 get_sound_freq_scale(bank, soundIndex);
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->reverbVol =
@@ -1677,8 +1737,7 @@ static void update_game_sound(void) {
                             func_802ad728(0x02020000 | ((channelIndex & 0xff) << 8),
                                           get_sound_volume(bank, soundIndex, VOLUME_RANGE_UNK2));
                             func_802ad770(0x03020000 | ((channelIndex & 0xff) << 8),
-                                          get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                                        *sSoundBanks[bank][soundIndex].z)
+                                          get_cached_sound_pan(bank, soundIndex)
                                                   * 127.0f
                                               + 0.5f);
                             func_802ad728(0x04020000 | ((channelIndex & 0xff) << 8),
@@ -1689,8 +1748,7 @@ static void update_game_sound(void) {
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->volume =
                                 get_sound_volume(bank, soundIndex, VOLUME_RANGE_UNK2);
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->pan =
-                                get_sound_pan(*sSoundBanks[bank][soundIndex].x,
-                                              *sSoundBanks[bank][soundIndex].z);
+                                get_cached_sound_pan(bank, soundIndex);
                             gSequencePlayers[SEQ_PLAYER_SFX].channels[channelIndex]->freqScale =
                                 get_sound_freq_scale(bank, soundIndex);
 #endif
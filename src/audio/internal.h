@@ -5,6 +5,10 @@
 
 #include "types.h"
 
+#ifdef M64_PREDECODE
+#include "seqdecode.h"
+#endif
+
 #if defined(VERSION_EU) || defined(VERSION_SH)
 #define SEQUENCE_PLAYERS 4
 #define SEQUENCE_CHANNELS 48
@@ -317,6 +321,9 @@ struct SequencePlayer {
 #endif
     /*0x138, 0x140*/ uintptr_t bankDmaCurrDevAddr;
     /*0x13C, 0x144*/ ssize_t bankDmaRemaining;
+#ifdef M64_PREDECODE
+    /*0x140        */ struct M64LayerOpTable layerOps;
+#endif
 }; // size = 0x140, 0x148 on EU, 0x14C on SH
 
 struct AdsrSettings {
@@ -541,6 +548,9 @@ struct SequenceChannelLayer {
 #if defined(VERSION_EU)
     u8 pad2[4];
 #endif
+#ifdef M64_PREDECODE
+    /*0x80      */ struct M64LayerOp *op; // next predecoded command, NULL when reading bytes
+#endif
 }; // size = 0x80
 
 #if defined(VERSION_EU) || defined(VERSION_SH)
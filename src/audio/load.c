@@ -68,6 +68,11 @@ u16 gSequenceCount;
 
 struct CtlEntry *gCtlEntries; // sh: 0x803505F8
 
+#ifdef M64_PREDECODE
+static struct M64LayerOp sSeqLayerOps[SEQUENCE_PLAYERS][M64_LAYER_OPS_PER_PLAYER];
+static u16 sSeqLayerOpIndex[SEQUENCE_PLAYERS][M64_LAYER_OPS_PER_PLAYER];
+#endif
+
 #if defined(VERSION_EU)
 u32 padEuBss1;
 struct AudioBufferParametersEU gAudioBufferParameters;
@@ -902,6 +907,10 @@ void load_sequence_internal(u32 player, u32 seqId, s32 loadAsync) {
     seqPlayer->enabled = TRUE;
     seqPlayer->seqData = sequenceData;
     seqPlayer->scriptState.pc = sequenceData;
+#ifdef M64_PREDECODE
+    m64_layer_ops_init(&seqPlayer->layerOps, sSeqLayerOps[player], sSeqLayerOpIndex[player],
+                       M64_LAYER_OPS_PER_PLAYER, sequenceData, gSeqFileHeader->seqArray[seqId].len);
+#endif
 }
 
 // (void) must be omitted from parameters to fix stack with -framepointer
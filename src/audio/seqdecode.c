@@ -0,0 +1,276 @@
+#include <PR/ultratypes.h>
+
+#include "seqdecode.h"
+
+#ifdef M64_PREDECODE
+
+void m64_layer_ops_init(struct M64LayerOpTable *table, struct M64LayerOp *ops, u16 *index,
+                        u16 capacity, u8 *seqData, u32 seqLength) {
+    table->ops = ops;
+    table->index = index;
+    table->seqData = seqData;
+    table->seqLength = seqLength;
+    table->count = 0;
+    table->capacity = capacity;
+    table->stale = FALSE;
+    table->full = FALSE;
+}
+
+/**
+ * Decode the layer command at offset into op, the same way seq_channel_layer_process_script
+ * reads it. Returns -1 if the command runs past the end of the sequence.
+ */
+s32 m64_decode_layer_op(struct M64LayerOp *op, u8 *seqData, u32 seqLength, u32 offset,
+                        s32 largeNotes) {
+    u32 pc = offset;
+    u8 cmd;
+
+// Reads past the end are caught once the whole command has been decoded.
+#define READ_U8() (pc < seqLength ? seqData[pc++] : (pc++, 0))
+#define READ_COMPRESSED_U16(dst)              \
+    {                                         \
+        dst = READ_U8();                      \
+        if (dst & 0x80) {                     \
+            dst = (dst << 8) & 0x7f00;        \
+            dst = READ_U8() | dst;            \
+        }                                     \
+    }
+
+    cmd = READ_U8();
+    op->cmd = cmd;
+    op->arg0 = 0;
+    op->arg1 = 0;
+    op->value = 0;
+    op->offset = offset;
+    op->target = NULL;
+
+    if (cmd == 0xc0) { // layer_delay
+        READ_COMPRESSED_U16(op->value);
+    } else if (cmd < 0xc0) {
+        if (largeNotes) {
+            switch (cmd & 0xc0) {
+                case 0x00: // layer_note0 (play percentage, velocity, duration)
+                    READ_COMPRESSED_U16(op->value);
+                    op->arg0 = READ_U8();
+                    op->arg1 = READ_U8();
+                    break;
+                case 0x40: // layer_note1 (play percentage, velocity)
+                    READ_COMPRESSED_U16(op->value);
+                    op->arg0 = READ_U8();
+                    break;
+                case 0x80: // layer_note2 (velocity, duration)
+                    op->arg0 = READ_U8();
+                    op->arg1 = READ_U8();
+                    break;
+            }
+        } else if ((cmd & 0xc0) == 0x00) { // play note, type 0 (play percentage)
+            READ_COMPRESSED_U16(op->value);
+        }
+    } else {
+        switch (cmd) {
+            case 0xfc: // layer_call
+            case 0xfb: // layer_jump
+                op->value = READ_U8() << 8;
+                op->value |= READ_U8();
+                break;
+            case 0xf8: // layer_loop
+            case 0xc1: // layer_setshortnotevelocity
+            case 0xca: // layer_setpan
+            case 0xc2: // layer_transpose
+            case 0xc9: // layer_setshortnoteduration
+            case 0xc6: // layer_setinstr
+                op->arg0 = READ_U8();
+                break;
+            case 0xc3: // layer_setshortnotedefaultplaypercentage
+                READ_COMPRESSED_U16(op->value);
+                break;
+            case 0xc7: // layer_portamento (mode, target note, u8 or var time)
+                op->arg0 = READ_U8();
+                op->arg1 = READ_U8();
+                if (op->arg0 & 0x80) {
+                    op->value = READ_U8();
+                } else {
+                    READ_COMPRESSED_U16(op->value);
+                }
+                break;
+        }
+    }
+
+#undef READ_U8
+#undef READ_COMPRESSED_U16
+
+    op->len = (pc - offset) | (largeNotes ? M64_OP_LARGE_NOTES : 0);
+    return pc <= seqLength ? 0 : -1;
+}
+
+// The order of the op index: by offset, then by the largeNotes setting
+#define M64_OP_KEY(offset, mode) (((u32) (offset) << 1) | ((mode) >> 7))
+
+/**
+ * Return the first op translated from offset for the largeNotes setting mode, or NULL.
+ */
+static struct M64LayerOp *m64_find_layer_op(struct M64LayerOpTable *table, u16 offset, u8 mode) {
+    struct M64LayerOp *op;
+    u32 key = M64_OP_KEY(offset, mode);
+    s32 lo = 0;
+    s32 hi = table->count;
+    s32 mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) >> 1;
+        op = &table->ops[table->index[mid]];
+        if (M64_OP_KEY(op->offset, op->len & M64_OP_LARGE_NOTES) < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo < table->count) {
+        op = &table->ops[table->index[lo]];
+        if (op->offset == offset && (op->len & M64_OP_LARGE_NOTES) == mode) {
+            return op;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Merge the ops from first up to the end of the table, which were decoded from increasing
+ * offsets with one setting, into the index of the ops before them.
+ */
+static void m64_index_run(struct M64LayerOpTable *table, u16 first) {
+    struct M64LayerOp *ops = table->ops;
+    u16 *index = table->index;
+    s32 i = first - 1;
+    s32 j = table->count - 1;
+    s32 dst = table->count - 1;
+    u32 key;
+
+    while (j >= first) {
+        key = M64_OP_KEY(ops[j].offset, ops[j].len & M64_OP_LARGE_NOTES);
+        if (i >= 0 && M64_OP_KEY(ops[index[i]].offset, ops[index[i]].len & M64_OP_LARGE_NOTES) > key) {
+            index[dst--] = index[i--];
+        } else {
+            index[dst--] = j--;
+        }
+    }
+}
+
+/**
+ * Append and index the ops from offset up to the next layer_end or layer_jump, which both
+ * end the straight-line part of a script. Returns -1 if they don't fit, or -2 if they run
+ * off the end of the sequence; the table is left as it was then.
+ */
+static s32 m64_translate_run(struct M64LayerOpTable *table, u32 offset, s32 largeNotes) {
+    struct M64LayerOp *op;
+    u16 first = table->count;
+
+    do {
+        if (table->count >= table->capacity) {
+            table->count = first;
+            return -1;
+        }
+        op = &table->ops[table->count];
+        if (offset >= table->seqLength
+            || m64_decode_layer_op(op, table->seqData, table->seqLength, offset, largeNotes) != 0) {
+            table->count = first;
+            return -2;
+        }
+        table->count++;
+        offset += op->len & M64_OP_LEN_MASK;
+    } while (op->cmd != 0xff && op->cmd != 0xfb);
+
+    m64_index_run(table, first);
+    return 0;
+}
+
+/**
+ * Return the op for the layer script starting at offset, translating it and everything it
+ * calls or jumps to if needed. Returns NULL if the script can't be predecoded.
+ */
+struct M64LayerOp *m64_layer_ops_translate(struct M64LayerOpTable *table, u16 offset, s32 largeNotes) {
+    u8 mode = largeNotes ? M64_OP_LARGE_NOTES : 0;
+    struct M64LayerOp *entry;
+    struct M64LayerOp *op;
+    struct M64LayerOp *target;
+    u16 start;
+    u16 i;
+    u16 kept;
+    s32 ret;
+
+    if (table->stale) {
+        return NULL;
+    }
+
+    entry = m64_find_layer_op(table, offset, mode);
+    if (entry != NULL || table->full) {
+        return entry;
+    }
+
+    start = table->count;
+    if ((ret = m64_translate_run(table, offset, largeNotes)) != 0) {
+        goto fail;
+    }
+
+    // Resolve targets, translating the runs they start. Ops appended here are visited too.
+    for (i = start; i < table->count; i++) {
+        op = &table->ops[i];
+        if (op->cmd != 0xfc && op->cmd != 0xfb) {
+            continue;
+        }
+        target = m64_find_layer_op(table, op->value, mode);
+        if (target == NULL) {
+            target = &table->ops[table->count];
+            if ((ret = m64_translate_run(table, op->value, largeNotes)) != 0) {
+                goto fail;
+            }
+        }
+        op->target = target;
+    }
+
+    return &table->ops[start];
+
+fail:
+    // Drop the ops of the runs that did translate from the index
+    for (i = 0, kept = 0; i < table->count; i++) {
+        if (table->index[i] < start) {
+            table->index[kept++] = table->index[i];
+        }
+    }
+    table->count = start;
+    if (ret == -1) {
+        table->full = TRUE;
+    }
+    return NULL;
+}
+
+/**
+ * Called after the sequence byte at offset was written by chan_writeseq. Ops decoded from it
+ * take the new operand; if the write changed a command or its length, the table is marked
+ * stale and layers drop back to reading bytes.
+ */
+void m64_layer_ops_write(struct M64LayerOpTable *table, u16 offset) {
+    struct M64LayerOp *op = table->ops;
+    struct M64LayerOp *end = table->ops + table->count;
+    struct M64LayerOp decoded;
+
+    for (; op < end; op++) {
+        if (offset < op->offset || offset >= op->offset + (op->len & M64_OP_LEN_MASK)) {
+            continue;
+        }
+
+        if (m64_decode_layer_op(&decoded, table->seqData, table->seqLength, op->offset,
+                                op->len & M64_OP_LARGE_NOTES) != 0
+            || decoded.cmd != op->cmd || decoded.len != op->len
+            || ((op->cmd == 0xfc || op->cmd == 0xfb) && decoded.value != op->value)) {
+            table->stale = TRUE;
+            return;
+        }
+        op->arg0 = decoded.arg0;
+        op->arg1 = decoded.arg1;
+        op->value = decoded.value;
+    }
+}
+
+#endif
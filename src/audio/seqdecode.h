@@ -0,0 +1,59 @@
+#ifndef AUDIO_SEQDECODE_H
+#define AUDIO_SEQDECODE_H
+
+#include <PR/ultratypes.h>
+
+/**
+ * Predecoded sequence layer scripts, enabled with M64PREDECODE=1 (US/JP command set).
+ *
+ * The first time a channel starts a layer at some offset, the layer script reachable from
+ * there is translated into an array of fixed-size M64LayerOps. Operands are decoded up front
+ * and layer_call/layer_jump point straight at their target op, so the layer interpreter
+ * walks ops instead of reading the script byte by byte. Execution continues at op + 1.
+ *
+ * Note commands are encoded differently depending on the channel's largeNotes setting, so a
+ * script is translated for one setting and tagged with it. Anything that cannot be translated
+ * (out of room, out of range) keeps using the byte interpreter.
+ *
+ * The ops are also indexed in order of offset and setting, so the op for an offset is found
+ * with a binary search.
+ *
+ * This file has no dependencies on the rest of the audio code so that tools/m64verify can
+ * build it for the host.
+ */
+
+#define M64_LAYER_OPS_PER_PLAYER 1536
+
+// M64LayerOp.len
+#define M64_OP_LEN_MASK 0x7f
+#define M64_OP_LARGE_NOTES 0x80 // translated for largeNotes == TRUE
+
+struct M64LayerOp {
+    /*0x00*/ u8 cmd;
+    /*0x01*/ u8 len; // encoded length in bytes, | M64_OP_LARGE_NOTES
+    /*0x02*/ u8 arg0;
+    /*0x03*/ u8 arg1;
+    /*0x04*/ u16 value;  // s16 or var-length operand
+    /*0x06*/ u16 offset; // of the command in the sequence data
+    /*0x08*/ struct M64LayerOp *target; // layer_call/layer_jump destination
+}; // size = 0xC
+
+struct M64LayerOpTable {
+    struct M64LayerOp *ops;
+    u16 *index; // indices of all ops, ordered by offset, then largeNotes, then index
+    u8 *seqData;
+    u32 seqLength;
+    u16 count;
+    u16 capacity;
+    u8 stale; // translated bytes were overwritten, ops must no longer be entered
+    u8 full;  // a translation did not fit, don't retry
+};
+
+void m64_layer_ops_init(struct M64LayerOpTable *table, struct M64LayerOp *ops, u16 *index,
+                        u16 capacity, u8 *seqData, u32 seqLength);
+struct M64LayerOp *m64_layer_ops_translate(struct M64LayerOpTable *table, u16 offset, s32 largeNotes);
+void m64_layer_ops_write(struct M64LayerOpTable *table, u16 offset);
+s32 m64_decode_layer_op(struct M64LayerOp *op, u8 *seqData, u32 seqLength, u32 offset,
+                        s32 largeNotes);
+
+#endif // AUDIO_SEQDECODE_H
@@ -127,6 +127,9 @@ s32 seq_channel_set_layer(struct SequenceChannel *seqChannel, s32 layerIndex) {
 #endif
     layer->portamento.mode = 0;
     layer->scriptState.depth = 0;
+#ifdef M64_PREDECODE
+    layer->op = NULL;
+#endif
     layer->status = SOUND_LOAD_STATUS_NOT_LOADED;
     layer->noteDuration = 0x80;
 #if defined(VERSION_EU) || defined(VERSION_SH)
@@ -968,6 +971,162 @@ u8 audioString107[] = "Error: Your assignchannel is stolen.\n";
 #endif
 
 #else
+#ifdef M64_PREDECODE
+/**
+ * Called when a channel starts a layer: run the layer from the predecoded form of its
+ * script, translating the script the first time it is started.
+ */
+static void seq_channel_layer_start_ops(struct SequenceChannelLayer *layer) {
+    struct SequencePlayer *seqPlayer = layer->seqChannel->seqPlayer;
+
+    layer->op = m64_layer_ops_translate(&seqPlayer->layerOps,
+                                        (u16)(layer->scriptState.pc - seqPlayer->seqData),
+                                        layer->seqChannel->largeNotes == TRUE);
+}
+
+/**
+ * Switch a layer from predecoded ops back to reading bytes, resuming at op.
+ */
+static void seq_channel_layer_ops_to_bytes(struct SequenceChannelLayer *layer, struct M64LayerOp *op) {
+    u8 *seqData = layer->seqChannel->seqPlayer->seqData;
+    struct M64ScriptState *state = &layer->scriptState;
+    s32 i;
+
+    state->pc = seqData + op->offset;
+    for (i = 0; i < state->depth; i++) {
+        state->stack[i] = seqData + ((struct M64LayerOp *) state->stack[i])->offset;
+    }
+    layer->op = NULL;
+}
+
+/**
+ * Predecoded counterpart of the command loop in seq_channel_layer_process_script. Runs
+ * commands up to the next delay or note and returns it, with layer->op past it. Returns NULL
+ * if the layer ended, or if it dropped back to reading bytes (layer->op is then NULL).
+ * While predecoded, scriptState.stack holds op pointers instead of script pointers.
+ */
+static struct M64LayerOp *seq_channel_layer_run_ops(struct SequenceChannelLayer *layer) {
+    struct SequenceChannel *seqChannel = layer->seqChannel;
+    struct SequencePlayer *seqPlayer = seqChannel->seqPlayer;
+    struct M64ScriptState *state = &layer->scriptState;
+    struct M64LayerOp *op = layer->op;
+    u8 cmdSemitone;
+    u16 velocity;
+
+    if (seqPlayer->layerOps.stale) {
+        seq_channel_layer_ops_to_bytes(layer, op);
+        return NULL;
+    }
+
+    for (;;) {
+        if (op->cmd <= 0xc0) {
+            // Notes were translated for the other largeNotes setting
+            if (op->cmd != 0xc0
+                && (op->len & M64_OP_LARGE_NOTES) != (seqChannel->largeNotes == TRUE ? M64_OP_LARGE_NOTES : 0)) {
+                seq_channel_layer_ops_to_bytes(layer, op);
+                return NULL;
+            }
+            layer->op = op + 1;
+            return op;
+        }
+
+        switch (op->cmd) {
+            case 0xff: // layer_end; function return or end of script
+                if (state->depth == 0) {
+                    seq_channel_layer_disable(layer);
+                    layer->op = NULL;
+                    return NULL;
+                }
+                op = (struct M64LayerOp *) state->stack[--state->depth];
+                continue;
+
+            case 0xfc: // layer_call
+                state->stack[state->depth++] = (u8 *) (op + 1);
+                op = op->target;
+                continue;
+
+            case 0xf8: // layer_loop; loop start, N iterations (or 256 if N = 0)
+                state->remLoopIters[state->depth] = op->arg0;
+                state->stack[state->depth++] = (u8 *) (op + 1);
+                break;
+
+            case 0xf7: // layer_loopend
+                if (--state->remLoopIters[state->depth - 1] != 0) {
+                    op = (struct M64LayerOp *) state->stack[state->depth - 1];
+                    continue;
+                }
+                state->depth--;
+                break;
+
+            case 0xfb: // layer_jump
+                op = op->target;
+                continue;
+
+            case 0xc1: // layer_setshortnotevelocity
+                layer->velocitySquare = (f32)(op->arg0 * op->arg0);
+                break;
+
+            case 0xca: // layer_setpan
+                layer->pan = (f32) op->arg0 / US_FLOAT(128.0);
+                break;
+
+            case 0xc2: // layer_transpose; set transposition in semitones
+                layer->transposition = op->arg0;
+                break;
+
+            case 0xc9: // layer_setshortnoteduration
+                layer->noteDuration = op->arg0;
+                break;
+
+            case 0xc4: // layer_somethingon
+            case 0xc5: // layer_somethingoff
+                layer->continuousNotes = (op->cmd == 0xc4) ? TRUE : FALSE;
+                seq_channel_layer_note_decay(layer);
+                break;
+
+            case 0xc3: // layer_setshortnotedefaultplaypercentage
+                layer->shortNoteDefaultPlayPercentage = op->value;
+                break;
+
+            case 0xc6: // layer_setinstr
+                if (op->arg0 < 127) {
+                    get_instrument(seqChannel, op->arg0, &layer->instrument, &layer->adsr);
+                }
+                break;
+
+            case 0xc7: // layer_portamento
+                layer->portamento.mode = op->arg0;
+
+                cmdSemitone = op->arg1 + seqChannel->transposition;
+                cmdSemitone += layer->transposition;
+                cmdSemitone += seqPlayer->transposition;
+                if (cmdSemitone >= 0x80) {
+                    cmdSemitone = 0;
+                }
+                layer->portamentoTargetNote = cmdSemitone;
+                layer->portamentoTime = op->value;
+                break;
+
+            case 0xc8: // layer_disableportamento
+                layer->portamento.mode = 0;
+                break;
+
+            default:
+                switch (op->cmd & 0xf0) {
+                    case 0xd0: // layer_setshortnotevelocityfromtable
+                        velocity = seqPlayer->shortNoteVelocityTable[op->cmd & 0xf];
+                        layer->velocitySquare = (f32)(velocity * velocity);
+                        break;
+                    case 0xe0: // layer_setshortnotedurationfromtable
+                        layer->noteDuration = seqPlayer->shortNoteDurationTable[op->cmd & 0xf];
+                        break;
+                }
+        }
+        op++;
+    }
+}
+#endif
+
 // US/JP version with macros to simulate inlining by copt. Edit if you dare.
 #include "copt/seq_channel_layer_process_script_copt.inc.c"
 #endif
@@ -1863,6 +2022,13 @@ void sequence_channel_process_script(struct SequenceChannel *seqChannel) {
                             sp5A = m64_read_s16(state);
                             seqData = seqPlayer->seqData + sp5A;
                             *seqData = (u8)value + cmd;
+#ifdef M64_PREDECODE
+                            for (i = 0; i < SEQUENCE_PLAYERS; i++) {
+                                if (gSequencePlayers[i].seqData == seqPlayer->seqData) {
+                                    m64_layer_ops_write(&gSequencePlayers[i].layerOps, sp5A);
+                                }
+                            }
+#endif
                         }
                         break;
 
@@ -2160,6 +2326,9 @@ void sequence_channel_process_script(struct SequenceChannel *seqChannel) {
                             if (1) {}
 #endif
                             seqChannel->layers[loBits]->scriptState.pc = seqPlayer->seqData + sp5A;
+#ifdef M64_PREDECODE
+                            seq_channel_layer_start_ops(seqChannel->layers[loBits]);
+#endif
                         }
                         break;
 
@@ -2172,6 +2341,9 @@ void sequence_channel_process_script(struct SequenceChannel *seqChannel) {
                             seqData = (*seqChannel->dynTable)[value];
                             sp5A = ((seqData[0] << 8) + seqData[1]);
                             seqChannel->layers[loBits]->scriptState.pc = seqPlayer->seqData + sp5A;
+#ifdef M64_PREDECODE
+                            seq_channel_layer_start_ops(seqChannel->layers[loBits]);
+#endif
                         }
                         break;
 
@@ -9,6 +9,7 @@
 #include "game/game_init.h"
 #include "game/main.h"
 #include "game/memory.h"
+#include "game/profiler.h"
 #include "segment_symbols.h"
 #include "segments.h"
 #ifdef GZIP
@@ -36,15 +37,39 @@ struct MainPoolBlock {
     struct MainPoolBlock *next;
 };
 
+/**
+ * Memory pools are segregated fit allocators. Every block starts with a
+ * boundary tag holding its own size and the size of the block physically
+ * before it, so neighbors can be found and coalesced in constant time.
+ * Free blocks are additionally linked into a list per power-of-two size class:
+ * bin i holds blocks of size [16 << i, 32 << i), and the last bin holds all
+ * larger blocks. A bitmask of the non-empty bins lets mem_pool_alloc pick a
+ * bin without walking any lists.
+ */
 struct MemoryBlock {
+    u32 size;     // including this header, MEMORY_BLOCK_USED set while allocated
+    u32 prevSize; // size of the physically preceding block, 0 for the first block
+    // only valid while the block is free
     struct MemoryBlock *next;
-    u32 size;
+    struct MemoryBlock *prev;
 };
 
+#define MEMORY_BLOCK_USED 1
+#define MEMORY_BLOCK_HEADER_SIZE 8
+#define MEMORY_BLOCK_MIN_SIZE sizeof(struct MemoryBlock)
+#define MEMORY_POOL_LARGE_BIN 8 // blocks of 4 KB and up
+#define MEMORY_POOL_BIN_COUNT (MEMORY_POOL_LARGE_BIN + 1)
+
 struct MemoryPool {
     u32 totalSpace;
-    struct MemoryBlock *firstBlock;
-    struct MemoryBlock freeList;
+    u32 binMask;
+    struct MemoryBlock *bins[MEMORY_POOL_BIN_COUNT];
+#ifdef DEBUG
+    u32 usedSpace;
+    u32 peakUsedSpace;
+    u32 allocCount;
+    u32 failedAllocCount;
+#endif
 };
 
 extern uintptr_t sSegmentTable[32];
@@ -250,16 +275,17 @@ u32 main_pool_pop_state(void) {
  * Perform a DMA read from ROM. The transfer is split into 4KB blocks, and this
  * function blocks until completion.
  */
-void dma_read(u8 *dest, u8 *srcStart, u8 *srcEnd) {
+static void dma_read_with_queue(u8 *dest, u8 *srcStart, u8 *srcEnd, OSIoMesg *ioMesg,
+                                OSMesgQueue *queue) {
     u32 size = ALIGN16(srcEnd - srcStart);
+    OSMesg msg;
 
     osInvalDCache(dest, size);
     while (size != 0) {
         u32 copySize = (size >= 0x1000) ? 0x1000 : size;
 
-        osPiStartDma(&gDmaIoMesg, OS_MESG_PRI_NORMAL, OS_READ, (uintptr_t) srcStart, dest, copySize,
-                     &gDmaMesgQueue);
-        osRecvMesg(&gDmaMesgQueue, &gMainReceivedMesg, OS_MESG_BLOCK);
+        osPiStartDma(ioMesg, OS_MESG_PRI_NORMAL, OS_READ, (uintptr_t) srcStart, dest, copySize, queue);
+        osRecvMesg(queue, &msg, OS_MESG_BLOCK);
 
         dest += copySize;
         srcStart += copySize;
@@ -267,6 +293,12 @@ void dma_read(u8 *dest, u8 *srcStart, u8 *srcEnd) {
     }
 }
 
+void dma_read(u8 *dest, u8 *srcStart, u8 *srcEnd) {
+    PROFILER_BEGIN(PROFILER_SCOPE_DMA);
+    dma_read_with_queue(dest, srcStart, srcEnd, &gDmaIoMesg, &gDmaMesgQueue);
+    PROFILER_END(PROFILER_SCOPE_DMA);
+}
+
 /**
  * Perform a DMA read from ROM, allocating space in the memory pool to write to.
  * Return the destination address.
@@ -321,6 +353,243 @@ void *load_to_fixed_pool_addr(u8 *destAddr, u8 *srcStart, u8 *srcEnd) {
     return dest;
 }
 
+#ifndef UNCOMPRESSED
+static void decompress_segment(u8 *compressed, u8 *dest, UNUSED u32 compSize, UNUSED u32 size) {
+#ifdef GZIP
+    expand_gzip(compressed, dest, compSize, size);
+#elif RNC1
+    Propack_UnpackM1(compressed, dest);
+#elif RNC2
+    Propack_UnpackM2(compressed, dest);
+#elif YAY0
+    slidstart(compressed, dest);
+#elif MIO0
+    decompress(compressed, dest);
+#endif
+}
+#endif
+
+#ifdef USE_SEGMENT_CACHE
+/**
+ * Decompressed segments are kept in the upper half of an Expansion Pak, which
+ * the main pool doesn't use unless USE_EXT_RAM is set, and copied from there
+ * when a later level loads the same segment again. Entries are keyed by ROM
+ * address and kept sorted by RAM address; a new entry goes into the first gap
+ * it fits, evicting the least recently used entries until one does.
+ *
+ * The level prefetch thread fills the cache too, so every access, and every
+ * decompression (the decompressors keep static state), holds the cache lock.
+ */
+struct SegmentCacheEntry {
+    u8 *romStart;
+    u8 *addr;
+    u32 size;
+    u32 lastUse;
+};
+
+static struct SegmentCacheEntry sSegmentCache[SEGMENT_CACHE_ENTRIES];
+static s32 sSegmentCacheCount = -1; // -1 until the cache is set up, -2 if there's no Expansion Pak
+static u32 sSegmentCacheClock;
+static u8 *sSegmentCacheStart;
+static u8 *sSegmentCacheEnd;
+
+static OSMesgQueue sSegmentCacheLockQueue;
+static OSMesg sSegmentCacheLockMesg;
+static OSIoMesg sSegmentCacheDmaIoMesg;
+static OSMesgQueue sSegmentCacheDmaQueue;
+static OSMesg sSegmentCacheDmaMesg;
+static ALIGNED16 u32 sSegmentCacheHeader[4];
+
+/**
+ * Set up the cache if an Expansion Pak is present. Return whether the cache
+ * can be used.
+ */
+s32 segment_cache_init(void) {
+    // Stay clear of the crash screen framebuffer at the top of RAM.
+    u8 *ramEnd = (u8 *) ((osMemSize | 0x80000000) - SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(u16));
+
+    if (sSegmentCacheCount == -1) {
+        sSegmentCacheCount = -2;
+        if (osMemSize > RAM_END - 0x80000000) {
+            sSegmentCacheStart = (u8 *) ALIGN16(RAM_END);
+            sSegmentCacheEnd = sSegmentCacheStart + SEGMENT_CACHE_SIZE;
+            if (sSegmentCacheEnd > ramEnd) {
+                sSegmentCacheEnd = (u8 *) ((uintptr_t) ramEnd & ~0xF);
+            }
+            osCreateMesgQueue(&sSegmentCacheLockQueue, &sSegmentCacheLockMesg, 1);
+            osSendMesg(&sSegmentCacheLockQueue, NULL, OS_MESG_NOBLOCK);
+            osCreateMesgQueue(&sSegmentCacheDmaQueue, &sSegmentCacheDmaMesg, 1);
+            sSegmentCacheCount = 0;
+        }
+    }
+    return sSegmentCacheCount >= 0;
+}
+
+static void segment_cache_lock(void) {
+    OSMesg msg;
+
+    if (segment_cache_init()) {
+        osRecvMesg(&sSegmentCacheLockQueue, &msg, OS_MESG_BLOCK);
+    }
+}
+
+static void segment_cache_unlock(void) {
+    if (sSegmentCacheCount >= 0) {
+        osSendMesg(&sSegmentCacheLockQueue, NULL, OS_MESG_NOBLOCK);
+    }
+}
+
+static struct SegmentCacheEntry *segment_cache_find(u8 *romStart) {
+    s32 i;
+
+    for (i = 0; i < sSegmentCacheCount; i++) {
+        if (sSegmentCache[i].romStart == romStart) {
+            sSegmentCache[i].lastUse = ++sSegmentCacheClock;
+            return &sSegmentCache[i];
+        }
+    }
+    return NULL;
+}
+
+static void segment_cache_remove(s32 index) {
+    sSegmentCacheCount--;
+    for (; index < sSegmentCacheCount; index++) {
+        sSegmentCache[index] = sSegmentCache[index + 1];
+    }
+}
+
+/**
+ * Add an entry of size bytes for the segment at romStart and return it.
+ * Return NULL if the segment is larger than the whole cache.
+ */
+static struct SegmentCacheEntry *segment_cache_alloc(u8 *romStart, u32 size) {
+    u8 *gapStart;
+    s32 lru;
+    s32 i;
+
+    size = ALIGN16(size);
+    if (size > (u32) (sSegmentCacheEnd - sSegmentCacheStart)) {
+        return NULL;
+    }
+
+    while (TRUE) {
+        gapStart = sSegmentCacheStart;
+        for (i = 0; i < sSegmentCacheCount; i++) {
+            if ((u32) (sSegmentCache[i].addr - gapStart) >= size) {
+                break;
+            }
+            gapStart = sSegmentCache[i].addr + sSegmentCache[i].size;
+        }
+        if (sSegmentCacheCount < SEGMENT_CACHE_ENTRIES
+            && (u32) ((i < sSegmentCacheCount ? sSegmentCache[i].addr : sSegmentCacheEnd) - gapStart)
+                   >= size) {
+            break;
+        }
+
+        lru = 0;
+        for (i = 1; i < sSegmentCacheCount; i++) {
+            if (sSegmentCache[i].lastUse < sSegmentCache[lru].lastUse) {
+                lru = i;
+            }
+        }
+        segment_cache_remove(lru);
+    }
+
+    for (i = sSegmentCacheCount; i > 0 && sSegmentCache[i - 1].addr > gapStart; i--) {
+        sSegmentCache[i] = sSegmentCache[i - 1];
+    }
+    sSegmentCache[i].romStart = romStart;
+    sSegmentCache[i].addr = gapStart;
+    sSegmentCache[i].size = size;
+    sSegmentCache[i].lastUse = ++sSegmentCacheClock;
+    sSegmentCacheCount++;
+    return &sSegmentCache[i];
+}
+
+/**
+ * Copy size bytes of decompressed data for the segment at romStart into the
+ * cache.
+ */
+static void segment_cache_insert(u8 *romStart, u8 *data, u32 size) {
+    struct SegmentCacheEntry *entry;
+
+    if (sSegmentCacheCount >= 0 && (entry = segment_cache_alloc(romStart, size)) != NULL) {
+        bcopy(data, entry->addr, entry->size);
+    }
+}
+
+/**
+ * Copy the segment at romStart from the cache to dest, if it is cached.
+ * Return the size of the segment, or 0 if it isn't cached. If dest is NULL,
+ * the space is allocated on the left side of the main pool and returned
+ * through dest instead.
+ */
+static u32 segment_cache_load(u8 *romStart, void **dest) {
+    struct SegmentCacheEntry *entry;
+
+    if ((entry = segment_cache_find(romStart)) == NULL) {
+        return 0;
+    }
+    if (*dest == NULL && (*dest = main_pool_alloc(entry->size, MEMORY_POOL_LEFT)) == NULL) {
+        return 0;
+    }
+    bcopy(entry->addr, *dest, entry->size);
+    return entry->size;
+}
+
+/**
+ * DMA from ROM on the prefetch thread, which can't share the game thread's
+ * DMA queue.
+ */
+void segment_cache_dma_read(u8 *dest, u8 *srcStart, u8 *srcEnd) {
+    dma_read_with_queue(dest, srcStart, srcEnd, &sSegmentCacheDmaIoMesg, &sSegmentCacheDmaQueue);
+}
+
+/**
+ * Decompress the segment from srcStart to srcEnd straight into the cache,
+ * unless it is already there. This runs on the level prefetch thread while the
+ * game keeps going, so it uses its own DMA queue and never touches the pool.
+ */
+void segment_cache_prefetch(u8 *srcStart, u8 *srcEnd) {
+    struct SegmentCacheEntry *entry;
+    u32 compSize = ALIGN16(srcEnd - srcStart);
+    u32 size;
+    u8 *compressed;
+
+    segment_cache_lock();
+    if (sSegmentCacheCount >= 0 && segment_cache_find(srcStart) == NULL) {
+#ifdef GZIP
+        // Decompressed size from end of gzip
+        segment_cache_dma_read((u8 *) sSegmentCacheHeader, srcEnd - 16, srcEnd);
+        size = sSegmentCacheHeader[3];
+#else
+        // Decompressed size from header
+        segment_cache_dma_read((u8 *) sSegmentCacheHeader, srcStart, srcStart + 16);
+        size = sSegmentCacheHeader[1];
+#endif
+        size = ALIGN16(size);
+
+        // Read the compressed data into the end of the entry, then shrink it
+        // to the decompressed size.
+        entry = segment_cache_alloc(srcStart, size + compSize);
+        if (entry != NULL) {
+            compressed = entry->addr + size;
+            segment_cache_dma_read(compressed, srcStart, srcEnd);
+#ifdef GZIP
+            decompress_segment(compressed, entry->addr, srcEnd - 4 - srcStart, size);
+#else
+            decompress_segment(compressed, entry->addr, compSize, size);
+#endif
+            entry->size = size;
+        }
+    }
+    segment_cache_unlock();
+}
+#else
+#define segment_cache_lock()
+#define segment_cache_unlock()
+#endif
+
 /**
  * Decompress the block of ROM data from srcStart to srcEnd and return a
  * pointer to an allocated buffer holding the decompressed data. Set the
@@ -338,43 +607,48 @@ void *load_segment_decompress(s32 segment, u8 *srcStart, u8 *srcEnd) {
     }
 #else
     void *dest = NULL;
-
 #ifdef GZIP
     u32 compSize = (srcEnd - 4 - srcStart);
 #else
     u32 compSize = ALIGN16(srcEnd - srcStart);
 #endif
-    u8 *compressed = main_pool_alloc(compSize, MEMORY_POOL_RIGHT);
+    u8 *compressed;
+    u32 *size;
+
+    segment_cache_lock();
+#ifdef USE_SEGMENT_CACHE
+    if (segment_cache_load(srcStart, &dest) != 0) {
+        set_segment_base_addr(segment, dest);
+        segment_cache_unlock();
+        return dest;
+    }
+#endif
+
+    compressed = main_pool_alloc(compSize, MEMORY_POOL_RIGHT);
 #ifdef GZIP
     // Decompressed size from end of gzip
-    u32 *size = (u32 *) (compressed + compSize);
+    size = (u32 *) (compressed + compSize);
 #else
     // Decompressed size from header (This works for non-mio0 because they also have the size in same place)
-    u32 *size = (u32 *) (compressed + 4);
+    size = (u32 *) (compressed + 4);
 #endif
     if (compressed != NULL) {
         dma_read(compressed, srcStart, srcEnd);
         dest = main_pool_alloc(*size, MEMORY_POOL_LEFT);
         if (dest != NULL) {
 			osSyncPrintf("start decompress\n");
-#ifdef GZIP
-            expand_gzip(compressed, dest, compSize, (u32)size);
-#elif RNC1
-            Propack_UnpackM1(compressed, dest);
-#elif RNC2
-            Propack_UnpackM2(compressed, dest);
-#elif YAY0
-            slidstart(compressed, dest);
-#elif MIO0
-            decompress(compressed, dest);
-#endif
+            decompress_segment(compressed, dest, compSize, *size);
 			osSyncPrintf("end decompress\n");
+#ifdef USE_SEGMENT_CACHE
+            segment_cache_insert(srcStart, dest, *size);
+#endif
             set_segment_base_addr(segment, dest);
             main_pool_free(compressed);
         } else {
         }
     } else {
     }
+    segment_cache_unlock();
 #endif
     return dest;
 }
@@ -391,28 +665,37 @@ void *load_segment_decompress_heap(u32 segment, u8 *srcStart, u8 *srcEnd) {
 #else
     u32 compSize = ALIGN16(srcEnd - srcStart);
 #endif
-    u8 *compressed = main_pool_alloc(compSize, MEMORY_POOL_RIGHT);
+    u8 *compressed;
+    u32 *size;
+
+    segment_cache_lock();
+#ifdef USE_SEGMENT_CACHE
+    dest = gDecompressionHeap;
+    if (segment_cache_load(srcStart, &dest) != 0) {
+        set_segment_base_addr(segment, gDecompressionHeap);
+        segment_cache_unlock();
+        return gDecompressionHeap;
+    }
+#endif
+
+    compressed = main_pool_alloc(compSize, MEMORY_POOL_RIGHT);
 #ifdef GZIP
     // Decompressed size from end of gzip
-    u32 *size = (u32 *) (compressed + compSize);
+    size = (u32 *) (compressed + compSize);
+#else
+    size = (u32 *) (compressed + 4);
 #endif
     if (compressed != NULL) {
         dma_read(compressed, srcStart, srcEnd);
-#ifdef GZIP
-        expand_gzip(compressed, gDecompressionHeap, compSize, (u32)size);
-#elif RNC1
-        Propack_UnpackM1(compressed, gDecompressionHeap);
-#elif RNC2
-        Propack_UnpackM2(compressed, gDecompressionHeap);
-#elif YAY0
-        slidstart(compressed, gDecompressionHeap);
-#elif MIO0
-        decompress(compressed, gDecompressionHeap);
+        decompress_segment(compressed, gDecompressionHeap, compSize, *size);
+#ifdef USE_SEGMENT_CACHE
+        segment_cache_insert(srcStart, gDecompressionHeap, *size);
 #endif
         set_segment_base_addr(segment, gDecompressionHeap);
         main_pool_free(compressed);
     } else {
     }
+    segment_cache_unlock();
 #endif
     return gDecompressionHeap;
 }
@@ -484,6 +767,45 @@ struct AllocOnlyPool *alloc_only_pool_resize(struct AllocOnlyPool *pool, u32 siz
     return newPool;
 }
 
+static u32 mem_pool_bin_index(u32 size) {
+    u32 bin = 0;
+
+    size >>= 5;
+    while (size != 0 && bin < MEMORY_POOL_LARGE_BIN) {
+        size >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+static void mem_pool_insert_free(struct MemoryPool *pool, struct MemoryBlock *block) {
+    u32 bin = mem_pool_bin_index(block->size);
+
+    block->prev = NULL;
+    block->next = pool->bins[bin];
+    if (block->next != NULL) {
+        block->next->prev = block;
+    }
+    pool->bins[bin] = block;
+    pool->binMask |= 1 << bin;
+}
+
+static void mem_pool_remove_free(struct MemoryPool *pool, struct MemoryBlock *block) {
+    u32 bin = mem_pool_bin_index(block->size);
+
+    if (block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        pool->bins[bin] = block->next;
+        if (block->next == NULL) {
+            pool->binMask &= ~(1 << bin);
+        }
+    }
+    if (block->next != NULL) {
+        block->next->prev = block->prev;
+    }
+}
+
 /**
  * Allocate a memory pool from the main pool. This pool supports arbitrary
  * order for allocation/freeing.
@@ -492,93 +814,183 @@ struct AllocOnlyPool *alloc_only_pool_resize(struct AllocOnlyPool *pool, u32 siz
 struct MemoryPool *mem_pool_init(u32 size, u32 side) {
     void *addr;
     struct MemoryBlock *block;
+    struct MemoryBlock *end;
     struct MemoryPool *pool = NULL;
+    s32 i;
 
-    size = ALIGN4(size);
-    addr = main_pool_alloc(size + sizeof(struct MemoryPool), side);
+    size = ALIGN8(size);
+    // The pool is followed by an allocated zero-size block so that the last
+    // real block never tries to coalesce past the end.
+    addr = main_pool_alloc(ALIGN8(sizeof(struct MemoryPool)) + size + MEMORY_BLOCK_HEADER_SIZE, side);
     if (addr != NULL) {
         pool = (struct MemoryPool *) addr;
 
         pool->totalSpace = size;
-        pool->firstBlock = (struct MemoryBlock *) ((u8 *) addr + sizeof(struct MemoryPool));
-        pool->freeList.next = (struct MemoryBlock *) ((u8 *) addr + sizeof(struct MemoryPool));
+        pool->binMask = 0;
+        for (i = 0; i < MEMORY_POOL_BIN_COUNT; i++) {
+            pool->bins[i] = NULL;
+        }
+#ifdef DEBUG
+        pool->usedSpace = 0;
+        pool->peakUsedSpace = 0;
+        pool->allocCount = 0;
+        pool->failedAllocCount = 0;
+#endif
+
+        block = (struct MemoryBlock *) ((u8 *) addr + ALIGN8(sizeof(struct MemoryPool)));
+        block->size = size;
+        block->prevSize = 0;
+
+        end = (struct MemoryBlock *) ((u8 *) block + size);
+        end->size = MEMORY_BLOCK_USED;
+        end->prevSize = size;
 
-        block = pool->firstBlock;
-        block->next = NULL;
-        block->size = pool->totalSpace;
+        mem_pool_insert_free(pool, block);
     }
     return pool;
 }
 
 /**
  * Allocate from a memory pool. Return NULL if there is not enough space.
+ * Any block in a bin above the request's size class is large enough, so the
+ * lists are only walked when nothing larger is free.
  */
 void *mem_pool_alloc(struct MemoryPool *pool, u32 size) {
-    struct MemoryBlock *freeBlock = &pool->freeList;
-    void *addr = NULL;
+    struct MemoryBlock *block;
+    struct MemoryBlock *rest;
+    u32 bin;
+    u32 mask;
 
-    size = ALIGN4(size) + sizeof(struct MemoryBlock);
-    while (freeBlock->next != NULL) {
-        if (freeBlock->next->size >= size) {
-            addr = (u8 *) freeBlock->next + sizeof(struct MemoryBlock);
-            if (freeBlock->next->size - size <= sizeof(struct MemoryBlock)) {
-                freeBlock->next = freeBlock->next->next;
-            } else {
-                struct MemoryBlock *newBlock = (struct MemoryBlock *) ((u8 *) freeBlock->next + size);
-                newBlock->size = freeBlock->next->size - size;
-                newBlock->next = freeBlock->next->next;
-                freeBlock->next->size = size;
-                freeBlock->next = newBlock;
+    size = ALIGN8(size) + MEMORY_BLOCK_HEADER_SIZE;
+    if (size < MEMORY_BLOCK_MIN_SIZE) {
+        size = MEMORY_BLOCK_MIN_SIZE;
+    }
+    bin = mem_pool_bin_index(size);
+
+    block = pool->bins[bin];
+    if (block == NULL || block->size < size) {
+        mask = pool->binMask & (~1U << bin);
+        if (mask != 0) {
+            do {
+                bin++;
+            } while (!(mask & (1 << bin)));
+            block = pool->bins[bin];
+        } else {
+            while (block != NULL && block->size < size) {
+                block = block->next;
             }
-            break;
         }
-        freeBlock = freeBlock->next;
     }
-    return addr;
+
+    if (block == NULL) {
+#ifdef DEBUG
+        pool->failedAllocCount++;
+#endif
+        return NULL;
+    }
+
+    mem_pool_remove_free(pool, block);
+    if (block->size - size >= MEMORY_BLOCK_MIN_SIZE) {
+        rest = (struct MemoryBlock *) ((u8 *) block + size);
+        rest->size = block->size - size;
+        rest->prevSize = size;
+        ((struct MemoryBlock *) ((u8 *) rest + rest->size))->prevSize = rest->size;
+        block->size = size;
+        mem_pool_insert_free(pool, rest);
+    }
+#ifdef DEBUG
+    pool->usedSpace += block->size;
+    if (pool->usedSpace > pool->peakUsedSpace) {
+        pool->peakUsedSpace = pool->usedSpace;
+    }
+    pool->allocCount++;
+#endif
+    block->size |= MEMORY_BLOCK_USED;
+
+    return (u8 *) block + MEMORY_BLOCK_HEADER_SIZE;
 }
 
 /**
- * Free a block that was allocated using mem_pool_alloc.
+ * Free a block that was allocated using mem_pool_alloc, merging it with free
+ * neighbors on either side.
  */
 void mem_pool_free(struct MemoryPool *pool, void *addr) {
-    struct MemoryBlock *block = (struct MemoryBlock *) ((u8 *) addr - sizeof(struct MemoryBlock));
-    struct MemoryBlock *freeList = pool->freeList.next;
+    struct MemoryBlock *block = (struct MemoryBlock *) ((u8 *) addr - MEMORY_BLOCK_HEADER_SIZE);
+    struct MemoryBlock *neighbor;
+    u32 size = block->size & ~MEMORY_BLOCK_USED;
 
-    if (pool->freeList.next == NULL) {
-        pool->freeList.next = block;
-        block->next = NULL;
-    } else {
-        if (block < pool->freeList.next) {
-            if ((u8 *) pool->freeList.next == (u8 *) block + block->size) {
-                block->size += freeList->size;
-                block->next = freeList->next;
-                pool->freeList.next = block;
-            } else {
-                block->next = pool->freeList.next;
-                pool->freeList.next = block;
-            }
-        } else {
-            while (freeList->next != NULL) {
-                if (freeList < block && block < freeList->next) {
-                    break;
-                }
-                freeList = freeList->next;
-            }
-            if ((u8 *) freeList + freeList->size == (u8 *) block) {
-                freeList->size += block->size;
-                block = freeList;
-            } else {
-                block->next = freeList->next;
-                freeList->next = block;
-            }
-            if (block->next != NULL && (u8 *) block->next == (u8 *) block + block->size) {
-                block->size = block->size + block->next->size;
-                block->next = block->next->next;
+#ifdef DEBUG
+    pool->usedSpace -= size;
+#endif
+
+    neighbor = (struct MemoryBlock *) ((u8 *) block + size);
+    if (!(neighbor->size & MEMORY_BLOCK_USED)) {
+        mem_pool_remove_free(pool, neighbor);
+        size += neighbor->size;
+    }
+
+    if (block->prevSize != 0) {
+        neighbor = (struct MemoryBlock *) ((u8 *) block - block->prevSize);
+        if (!(neighbor->size & MEMORY_BLOCK_USED)) {
+            mem_pool_remove_free(pool, neighbor);
+            size += neighbor->size;
+            block = neighbor;
+        }
+    }
+
+    block->size = size;
+    ((struct MemoryBlock *) ((u8 *) block + size))->prevSize = size;
+    mem_pool_insert_free(pool, block);
+}
+
+#ifdef DEBUG
+/**
+ * Fill 'stats' with the usage of a memory pool. Walks the free lists, so this
+ * is meant for debug output rather than per-frame use.
+ */
+void mem_pool_get_stats(struct MemoryPool *pool, struct MemoryPoolStats *stats) {
+    struct MemoryBlock *block;
+    s32 i;
+
+    stats->totalSpace = pool->totalSpace;
+    stats->usedSpace = pool->usedSpace;
+    stats->peakUsedSpace = pool->peakUsedSpace;
+    stats->allocCount = pool->allocCount;
+    stats->failedAllocCount = pool->failedAllocCount;
+    stats->freeSpace = 0;
+    stats->freeBlockCount = 0;
+    stats->largestFreeBlock = 0;
+
+    for (i = 0; i < MEMORY_POOL_BIN_COUNT; i++) {
+        for (block = pool->bins[i]; block != NULL; block = block->next) {
+            stats->freeSpace += block->size;
+            stats->freeBlockCount++;
+            if (block->size > stats->largestFreeBlock) {
+                stats->largestFreeBlock = block->size;
             }
         }
     }
 }
 
+/**
+ * Print the usage of a memory pool. Fragmentation is the percentage of free
+ * space that lies outside the largest free block.
+ */
+void mem_pool_print_stats(struct MemoryPool *pool, const char *name) {
+    struct MemoryPoolStats stats;
+    u32 fragmentation = 0;
+
+    mem_pool_get_stats(pool, &stats);
+    if (stats.freeSpace != 0) {
+        fragmentation = 100 - stats.largestFreeBlock * 100 / stats.freeSpace;
+    }
+    osSyncPrintf("%s pool: %d/%d used, peak %d, %d allocs, %d failed, "
+                 "%d free blocks, largest %d, %d%% fragmented\n",
+                 name, stats.usedSpace, stats.totalSpace, stats.peakUsedSpace, stats.allocCount,
+                 stats.failedAllocCount, stats.freeBlockCount, stats.largestFreeBlock, fragmentation);
+}
+#endif
+
 void *alloc_display_list(u32 size) {
     void *ptr = NULL;
 
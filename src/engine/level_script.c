@@ -8,6 +8,7 @@
 #include "buffers/framebuffers.h"
 #include "buffers/zbuffer.h"
 #include "game/area.h"
+#include "game/demo_bench.h"
 #include "game/game_init.h"
 #include "game/mario.h"
 #include "game/memory.h"
@@ -311,6 +312,10 @@ static void level_cmd_init_level(void) {
 }
 
 static void level_cmd_clear_level(void) {
+#ifdef DEBUG
+    mem_pool_print_stats(gObjectMemoryPool, "Object");
+    mem_pool_print_stats(gEffectsMemoryPool, "Effects");
+#endif
     clear_objects();
     clear_area_graph_nodes();
     clear_areas();
@@ -823,15 +828,21 @@ struct LevelCommand *level_script_execute(struct LevelCommand *cmd) {
     sScriptStatus = SCRIPT_RUNNING;
     sCurrentCmd = cmd;
 
+    DEMO_BENCH_BEGIN(DEMO_BENCH_LOGIC);
     while (sScriptStatus == SCRIPT_RUNNING) {
         LevelScriptJumpTable[sCurrentCmd->type]();
     }
+    DEMO_BENCH_END(DEMO_BENCH_LOGIC);
 
     profiler_log_thread5_time(LEVEL_SCRIPT_EXECUTE);
+    DEMO_BENCH_BEGIN(DEMO_BENCH_RENDER);
     init_rcp();
+    PROFILER_BEGIN(PROFILER_SCOPE_RENDER);
     render_game();
+    PROFILER_END(PROFILER_SCOPE_RENDER);
     end_master_display_list();
     alloc_display_list(0);
+    DEMO_BENCH_END(DEMO_BENCH_RENDER);
 
     return sCurrentCmd;
 }
@@ -270,14 +270,13 @@ void mtxf_lookat(Mat4 mtx, Vec3f from, Vec3f to, s16 roll) {
  * axis, and then translates.
  */
 void mtxf_rotate_zxy_and_translate(Mat4 dest, Vec3f translate, Vec3s rotate) {
-    register f32 sx = sins(rotate[0]);
-    register f32 cx = coss(rotate[0]);
+    register f32 sx, cx;
+    register f32 sy, cy;
+    register f32 sz, cz;
 
-    register f32 sy = sins(rotate[1]);
-    register f32 cy = coss(rotate[1]);
-
-    register f32 sz = sins(rotate[2]);
-    register f32 cz = coss(rotate[2]);
+    sincoss(rotate[0], sx, cx);
+    sincoss(rotate[1], sy, cy);
+    sincoss(rotate[2], sz, cz);
 
     dest[0][0] = cy * cz + sx * sy * sz;
     dest[1][0] = -cy * sz + sx * sy * cz;
@@ -303,14 +302,13 @@ void mtxf_rotate_zxy_and_translate(Mat4 dest, Vec3f translate, Vec3s rotate) {
  * axis, and then translates.
  */
 void mtxf_rotate_xyz_and_translate(Mat4 dest, Vec3f b, Vec3s c) {
-    register f32 sx = sins(c[0]);
-    register f32 cx = coss(c[0]);
-
-    register f32 sy = sins(c[1]);
-    register f32 cy = coss(c[1]);
+    register f32 sx, cx;
+    register f32 sy, cy;
+    register f32 sz, cz;
 
-    register f32 sz = sins(c[2]);
-    register f32 cz = coss(c[2]);
+    sincoss(c[0], sx, cx);
+    sincoss(c[1], sy, cy);
+    sincoss(c[2], sz, cz);
 
     dest[0][0] = cy * cz;
     dest[0][1] = cy * sz;
@@ -480,6 +478,53 @@ void mtxf_align_terrain_triangle(Mat4 mtx, Vec3f pos, s16 yaw, f32 radius) {
     mtx[3][3] = 1;
 }
 
+/**
+ * Store one row of a float matrix into fixed point matrix 'dest'. This uses the
+ * same layout and conversion as guMtxF2L: the integer parts of all entries are
+ * stored in the first 8 words and the fraction parts in the last 8 words.
+ */
+static inline void mtx_set_row(Mtx *dest, s32 row, f32 e0, f32 e1, f32 e2, f32 e3) {
+    register s32 *intPart = &dest->m[row >> 1][(row & 1) << 1];
+    register s32 *fracPart = &dest->m[2 + (row >> 1)][(row & 1) << 1];
+    register s32 fixed0 = e0 * (1 << 16); //! same float-to-integer conversion as mtxf_to_mtx
+    register s32 fixed1 = e1 * (1 << 16);
+    register s32 fixed2 = e2 * (1 << 16);
+    register s32 fixed3 = e3 * (1 << 16);
+
+    intPart[0] = (fixed0 & 0xFFFF0000) | ((fixed1 >> 16) & 0xFFFF);
+    intPart[1] = (fixed2 & 0xFFFF0000) | ((fixed3 >> 16) & 0xFFFF);
+    fracPart[0] = ((u32) fixed0 << 16) | (fixed1 & 0xFFFF);
+    fracPart[1] = ((u32) fixed2 << 16) | (fixed3 & 0xFFFF);
+}
+
+/**
+ * Set row 'row' of 'dest' to the row vector (e0, e1, e2, row == 3) multiplied
+ * with transformation matrix 'b', and also store it in 'fixed' if that is not
+ * NULL. 'dest' must not be 'b'.
+ */
+static inline void mtxf_mul_row(Mat4 dest, Mtx *fixed, s32 row, f32 e0, f32 e1, f32 e2, Mat4 b) {
+    register f32 x = e0 * b[0][0] + e1 * b[1][0] + e2 * b[2][0];
+    register f32 y = e0 * b[0][1] + e1 * b[1][1] + e2 * b[2][1];
+    register f32 z = e0 * b[0][2] + e1 * b[1][2] + e2 * b[2][2];
+    register f32 w = 0.0f;
+
+    if (row == 3) {
+        x += b[3][0];
+        y += b[3][1];
+        z += b[3][2];
+        w = 1.0f;
+    }
+
+    dest[row][0] = x;
+    dest[row][1] = y;
+    dest[row][2] = z;
+    dest[row][3] = w;
+
+    if (fixed != NULL) {
+        mtx_set_row(fixed, row, x, y, z, w);
+    }
+}
+
 /**
  * Sets matrix 'dest' to the matrix product b * a assuming they are both
  * transformation matrices with a w-component of 1. Since the bottom row
@@ -489,47 +534,69 @@ void mtxf_align_terrain_triangle(Mat4 mtx, Vec3f pos, s16 yaw, f32 radius) {
  * then a.
  */
 void mtxf_mul(Mat4 dest, Mat4 a, Mat4 b) {
+    mtxf_mul_to_mtx(NULL, dest, a, b);
+}
+
+/**
+ * Same as mtxf_mul, but also stores the result as a fixed point matrix in
+ * 'fixed' (unless it is NULL) while each row is still in registers, instead
+ * of reading 'dest' back in a separate mtxf_to_mtx pass.
+ */
+void mtxf_mul_to_mtx(Mtx *fixed, Mat4 dest, Mat4 a, Mat4 b) {
     Mat4 temp;
-    register f32 entry0;
-    register f32 entry1;
-    register f32 entry2;
-
-    // column 0
-    entry0 = a[0][0];
-    entry1 = a[0][1];
-    entry2 = a[0][2];
-    temp[0][0] = entry0 * b[0][0] + entry1 * b[1][0] + entry2 * b[2][0];
-    temp[0][1] = entry0 * b[0][1] + entry1 * b[1][1] + entry2 * b[2][1];
-    temp[0][2] = entry0 * b[0][2] + entry1 * b[1][2] + entry2 * b[2][2];
-
-    // column 1
-    entry0 = a[1][0];
-    entry1 = a[1][1];
-    entry2 = a[1][2];
-    temp[1][0] = entry0 * b[0][0] + entry1 * b[1][0] + entry2 * b[2][0];
-    temp[1][1] = entry0 * b[0][1] + entry1 * b[1][1] + entry2 * b[2][1];
-    temp[1][2] = entry0 * b[0][2] + entry1 * b[1][2] + entry2 * b[2][2];
-
-    // column 2
-    entry0 = a[2][0];
-    entry1 = a[2][1];
-    entry2 = a[2][2];
-    temp[2][0] = entry0 * b[0][0] + entry1 * b[1][0] + entry2 * b[2][0];
-    temp[2][1] = entry0 * b[0][1] + entry1 * b[1][1] + entry2 * b[2][1];
-    temp[2][2] = entry0 * b[0][2] + entry1 * b[1][2] + entry2 * b[2][2];
-
-    // column 3
-    entry0 = a[3][0];
-    entry1 = a[3][1];
-    entry2 = a[3][2];
-    temp[3][0] = entry0 * b[0][0] + entry1 * b[1][0] + entry2 * b[2][0] + b[3][0];
-    temp[3][1] = entry0 * b[0][1] + entry1 * b[1][1] + entry2 * b[2][1] + b[3][1];
-    temp[3][2] = entry0 * b[0][2] + entry1 * b[1][2] + entry2 * b[2][2] + b[3][2];
-
-    temp[0][3] = temp[1][3] = temp[2][3] = 0;
-    temp[3][3] = 1;
-
-    mtxf_copy(dest, temp);
+    register s32 i;
+
+    // Rows of 'a' are read before the same row of 'dest' is written, so only
+    // 'b' has to be copied when it is the destination.
+    if (dest == b) {
+        mtxf_copy(temp, b);
+        b = temp;
+    }
+
+    for (i = 0; i < 4; i++) {
+        mtxf_mul_row(dest, fixed, i, a[i][0], a[i][1], a[i][2], b);
+    }
+}
+
+/**
+ * Fused mtxf_rotate_zxy_and_translate followed by mtxf_mul_to_mtx with
+ * 'parent'. The rows of the local matrix are built in registers and never
+ * stored. 'dest' must not be 'parent'; 'fixed' may be NULL.
+ */
+void mtxf_rotate_zxy_and_translate_mul(Mtx *fixed, Mat4 dest, Vec3f translate, Vec3s rotate,
+                                       Mat4 parent) {
+    register f32 sx, cx;
+    register f32 sy, cy;
+    register f32 sz, cz;
+
+    sincoss(rotate[0], sx, cx);
+    sincoss(rotate[1], sy, cy);
+    sincoss(rotate[2], sz, cz);
+
+    mtxf_mul_row(dest, fixed, 0, cy * cz + sx * sy * sz, cx * sz, -sy * cz + sx * cy * sz, parent);
+    mtxf_mul_row(dest, fixed, 1, -cy * sz + sx * sy * cz, cx * cz, sy * sz + sx * cy * cz, parent);
+    mtxf_mul_row(dest, fixed, 2, cx * sy, -sx, cx * cy, parent);
+    mtxf_mul_row(dest, fixed, 3, translate[0], translate[1], translate[2], parent);
+}
+
+/**
+ * Fused mtxf_rotate_xyz_and_translate followed by mtxf_mul_to_mtx with
+ * 'parent'. 'dest' must not be 'parent'; 'fixed' may be NULL.
+ */
+void mtxf_rotate_xyz_and_translate_mul(Mtx *fixed, Mat4 dest, Vec3f translate, Vec3s rotate,
+                                       Mat4 parent) {
+    register f32 sx, cx;
+    register f32 sy, cy;
+    register f32 sz, cz;
+
+    sincoss(rotate[0], sx, cx);
+    sincoss(rotate[1], sy, cy);
+    sincoss(rotate[2], sz, cz);
+
+    mtxf_mul_row(dest, fixed, 0, cy * cz, cy * sz, -sy, parent);
+    mtxf_mul_row(dest, fixed, 1, sx * sy * cz - cx * sz, sx * sy * sz + cx * cz, sx * cy, parent);
+    mtxf_mul_row(dest, fixed, 2, cx * sy * cz + sx * sz, cx * sy * sz - sx * cz, cx * cy, parent);
+    mtxf_mul_row(dest, fixed, 3, translate[0], translate[1], translate[2], parent);
 }
 
 /**
@@ -555,10 +622,20 @@ void mtxf_mul_vec3s(Mat4 mtx, Vec3s b) {
     register f32 x = b[0];
     register f32 y = b[1];
     register f32 z = b[2];
+    register f32 rx;
+    register f32 ry;
+    register f32 rz;
 
-    b[0] = x * mtx[0][0] + y * mtx[1][0] + z * mtx[2][0] + mtx[3][0];
-    b[1] = x * mtx[0][1] + y * mtx[1][1] + z * mtx[2][1] + mtx[3][1];
-    b[2] = x * mtx[0][2] + y * mtx[1][2] + z * mtx[2][2] + mtx[3][2];
+    // All three results are computed before 'b' is written. The game is built
+    // with -fno-strict-aliasing, so a store to 'b' in between would make the
+    // compiler load the matrix entries for the next component again.
+    rx = x * mtx[0][0] + y * mtx[1][0] + z * mtx[2][0] + mtx[3][0];
+    ry = x * mtx[0][1] + y * mtx[1][1] + z * mtx[2][1] + mtx[3][1];
+    rz = x * mtx[0][2] + y * mtx[1][2] + z * mtx[2][2] + mtx[3][2];
+
+    b[0] = rx;
+    b[1] = ry;
+    b[2] = rz;
 }
 
 /**
@@ -691,68 +768,13 @@ f32 approach_f32(f32 current, f32 target, f32 inc, f32 dec) {
     return current;
 }
 
-/**
- * Helper function for atan2s. Does a look up of the arctangent of y/x assuming
- * the resulting angle is in range [0, 0x2000] (1/8 of a circle).
- */
-static u16 atan2_lookup(f32 y, f32 x) {
-    u16 ret;
-
-    if (x == 0) {
-        ret = gArctanTable[0];
-    } else {
-        ret = gArctanTable[(s32)(y / x * 1024 + 0.5f)];
-    }
-    return ret;
-}
-
-/**
- * Compute the angle from (0, 0) to (x, y) as a s16. Given that terrain is in
- * the xz-plane, this is commonly called with (z, x) to get a yaw angle.
- */
-s16 atan2s(f32 y, f32 x) {
-    u16 ret;
-
-    if (x >= 0) {
-        if (y >= 0) {
-            if (y >= x) {
-                ret = atan2_lookup(x, y);
-            } else {
-                ret = 0x4000 - atan2_lookup(y, x);
-            }
-        } else {
-            y = -y;
-            if (y < x) {
-                ret = 0x4000 + atan2_lookup(y, x);
-            } else {
-                ret = 0x8000 - atan2_lookup(x, y);
-            }
-        }
-    } else {
-        x = -x;
-        if (y < 0) {
-            y = -y;
-            if (y >= x) {
-                ret = 0x8000 + atan2_lookup(x, y);
-            } else {
-                ret = 0xC000 - atan2_lookup(y, x);
-            }
-        } else {
-            if (y < x) {
-                ret = 0xC000 + atan2_lookup(y, x);
-            } else {
-                ret = -atan2_lookup(x, y);
-            }
-        }
-    }
-    return ret;
-}
-
 /**
  * Compute the atan2 in radians by calling atan2s and converting the result.
  */
 f32 atan2f(f32 y, f32 x) {
-    return (f32) atan2s(y, x) * M_PI / 0x8000;
+    // Dividing by a power of two is exact, so multiplying by M_PI / 0x8000
+    // instead gives the same result.
+    return atan2s(y, x) * (M_PI / 0x8000);
 }
 
 #define CURVE_BEGIN_1 1
@@ -5,6 +5,7 @@
 #include "game/level_update.h"
 #include "game/mario.h"
 #include "game/object_list_processor.h"
+#include "game/profiler.h"
 #include "surface_collision.h"
 #include "surface_load.h"
 
@@ -29,6 +30,8 @@ static s32 find_wall_collisions_from_list(struct SurfaceNode *surfaceNode,
     register f32 y1, y2, y3;
     s32 numCols = 0;
 
+    PROFILER_BEGIN(PROFILER_SCOPE_COLLISION);
+
     // Max collision radius = 200
     if (radius > 200.0f) {
         radius = 200.0f;
@@ -150,6 +153,8 @@ static s32 find_wall_collisions_from_list(struct SurfaceNode *surfaceNode,
         numCols++;
     }
 
+    PROFILER_END(PROFILER_SCOPE_COLLISION);
+
     return numCols;
 }
 
@@ -300,17 +305,45 @@ static struct Surface *find_ceil_from_list(struct SurfaceNode *surfaceNode, s32
     return ceil;
 }
 
+/**
+ * Find the lowest ceiling above a point in a cell's dynamic and static ceiling lists.
+ */
+static f32 find_ceil_in_cell(struct SurfaceNode *dynamicList, struct SurfaceNode *staticList,
+                             s16 x, s16 y, s16 z, struct Surface **pceil) {
+    struct Surface *ceil, *dynamicCeil;
+    f32 height = CELL_HEIGHT_LIMIT;
+    f32 dynamicHeight = CELL_HEIGHT_LIMIT;
+
+    PROFILER_BEGIN(PROFILER_SCOPE_COLLISION);
+
+    // Check for surfaces belonging to objects.
+    dynamicCeil = find_ceil_from_list(dynamicList, x, y, z, &dynamicHeight);
+
+    // Check for surfaces that are a part of level geometry.
+    ceil = find_ceil_from_list(staticList, x, y, z, &height);
+
+    if (dynamicHeight < height) {
+        ceil = dynamicCeil;
+        height = dynamicHeight;
+    }
+
+    *pceil = ceil;
+
+    // Increment the debug tracker.
+    gNumCalls.ceil++;
+
+    PROFILER_END(PROFILER_SCOPE_COLLISION);
+
+    return height;
+}
+
 /**
  * Find the lowest ceiling above a given position and return the height.
  */
 f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
     s16 cellZ, cellX;
 
-    struct Surface *ceil, *dynamicCeil;
-    struct SurfaceNode *surfaceList;
-
     f32 height = CELL_HEIGHT_LIMIT;
-    f32 dynamicHeight = CELL_HEIGHT_LIMIT;
 
     //! (Parallel Universes) Because position is casted to an s16, reaching higher
     //  float locations can return ceilings despite them not existing there.
@@ -332,25 +365,9 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
     cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
     cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
 
-    // Check for surfaces belonging to objects.
-    surfaceList = gDynamicSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_CEILS].next;
-    dynamicCeil = find_ceil_from_list(surfaceList, x, y, z, &dynamicHeight);
-
-    // Check for surfaces that are a part of level geometry.
-    surfaceList = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_CEILS].next;
-    ceil = find_ceil_from_list(surfaceList, x, y, z, &height);
-
-    if (dynamicHeight < height) {
-        ceil = dynamicCeil;
-        height = dynamicHeight;
-    }
-
-    *pceil = ceil;
-
-    // Increment the debug tracker.
-    gNumCalls.ceil++;
-
-    return height;
+    return find_ceil_in_cell(gDynamicSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_CEILS].next,
+                             gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_CEILS].next,
+                             x, y, z, pceil);
 }
 
 /**************************************************
@@ -508,44 +525,21 @@ f32 unused_find_dynamic_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfl
 }
 
 /**
- * Find the highest floor under a given position and return the height.
+ * Find the highest floor under a point in a cell's dynamic and static floor lists.
  */
-f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
-    s16 cellZ, cellX;
-
+static f32 find_floor_in_cell(struct SurfaceNode *dynamicList, struct SurfaceNode *staticList,
+                              s16 x, s16 y, s16 z, struct Surface **pfloor) {
     struct Surface *floor, *dynamicFloor;
-    struct SurfaceNode *surfaceList;
-
     f32 height = FLOOR_LOWER_LIMIT;
     f32 dynamicHeight = FLOOR_LOWER_LIMIT;
 
-    //! (Parallel Universes) Because position is casted to an s16, reaching higher
-    //  float locations can return floors despite them not existing there.
-    //  (Dynamic floors will unload due to the range.)
-    s16 x = (s16) xPos;
-    s16 y = (s16) yPos;
-    s16 z = (s16) zPos;
-
-    *pfloor = NULL;
-
-    if (x <= -LEVEL_BOUNDARY_MAX || x >= LEVEL_BOUNDARY_MAX) {
-        return height;
-    }
-    if (z <= -LEVEL_BOUNDARY_MAX || z >= LEVEL_BOUNDARY_MAX) {
-        return height;
-    }
-
-    // Each level is split into cells to limit load, find the appropriate cell.
-    cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
-    cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+    PROFILER_BEGIN(PROFILER_SCOPE_COLLISION);
 
     // Check for surfaces belonging to objects.
-    surfaceList = gDynamicSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS].next;
-    dynamicFloor = find_floor_from_list(surfaceList, x, y, z, &dynamicHeight);
+    dynamicFloor = find_floor_from_list(dynamicList, x, y, z, &dynamicHeight);
 
     // Check for surfaces that are a part of level geometry.
-    surfaceList = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS].next;
-    floor = find_floor_from_list(surfaceList, x, y, z, &height);
+    floor = find_floor_from_list(staticList, x, y, z, &height);
 
     // To prevent the Merry-Go-Round room from loading when Mario passes above the hole that leads
     // there, SURFACE_INTANGIBLE is used. This prevent the wrong room from loading, but can also allow
@@ -556,7 +550,7 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
         //  (happens when there is no floor under the SURFACE_INTANGIBLE floor) but returns the height
         //  of the SURFACE_INTANGIBLE floor instead of the typical -11000 returned for a NULL floor.
         if (floor != NULL && floor->type == SURFACE_INTANGIBLE) {
-            floor = find_floor_from_list(surfaceList, x, (s32)(height - 200.0f), z, &height);
+            floor = find_floor_from_list(staticList, x, (s32)(height - 200.0f), z, &height);
         }
     } else {
         // To prevent accidentally leaving the floor tangible, stop checking for it.
@@ -578,9 +572,275 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
     // Increment the debug tracker.
     gNumCalls.floor++;
 
+    PROFILER_END(PROFILER_SCOPE_COLLISION);
+
     return height;
 }
 
+/**
+ * Find the highest floor under a given position and return the height.
+ */
+f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
+    s16 cellZ, cellX;
+
+    f32 height = FLOOR_LOWER_LIMIT;
+
+    //! (Parallel Universes) Because position is casted to an s16, reaching higher
+    //  float locations can return floors despite them not existing there.
+    //  (Dynamic floors will unload due to the range.)
+    s16 x = (s16) xPos;
+    s16 y = (s16) yPos;
+    s16 z = (s16) zPos;
+
+    *pfloor = NULL;
+
+    if (x <= -LEVEL_BOUNDARY_MAX || x >= LEVEL_BOUNDARY_MAX) {
+        return height;
+    }
+    if (z <= -LEVEL_BOUNDARY_MAX || z >= LEVEL_BOUNDARY_MAX) {
+        return height;
+    }
+
+    // Each level is split into cells to limit load, find the appropriate cell.
+    cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+    cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+
+    return find_floor_in_cell(gDynamicSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS].next,
+                              gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS].next,
+                              x, y, z, pfloor);
+}
+
+/**************************************************
+ *             STEP COLLISION CONTEXT             *
+ **************************************************/
+
+/**
+ * Node pool for the filtered lists of the current step collision context.
+ */
+static struct SurfaceNode sStepCollisionNodes[STEP_COLLISION_MAX_NODES];
+static s32 sStepCollisionNodeCount;
+
+/**
+ * Copy the surfaces in list that a query inside the context's bounds could hit,
+ * keeping their order, since the first matching floor or ceiling is the one returned.
+ * Return FALSE if the node pool ran out.
+ */
+static s32 step_collision_filter_list(struct StepCollisionContext *ctx, struct SurfaceNode *list,
+                                      s32 partition, struct SurfaceNode **filtered) {
+    struct SurfaceNode **tail = filtered;
+    struct Surface *surf;
+    s32 minX, maxX, minZ, maxZ;
+    s32 margin = (partition == SPATIAL_PARTITION_WALLS) ? ctx->wallMargin : 0;
+
+    for (; list != NULL; list = list->next) {
+        surf = list->surface;
+
+        switch (partition) {
+            case SPATIAL_PARTITION_FLOORS:
+                // The floor height inside the triangle isn't below its lowest vertex, give or
+                // take float error, and floors are hit from up to 78 units below.
+                if (surf->lowerY - 100 > ctx->maxY + 78) {
+                    continue;
+                }
+                break;
+            case SPATIAL_PARTITION_WALLS:
+                if (surf->upperY < ctx->minY || surf->lowerY > ctx->maxY) {
+                    continue;
+                }
+                break;
+        }
+
+        minX = maxX = surf->vertex1[0];
+        minZ = maxZ = surf->vertex1[2];
+        if (surf->vertex2[0] < minX) minX = surf->vertex2[0];
+        if (surf->vertex2[0] > maxX) maxX = surf->vertex2[0];
+        if (surf->vertex3[0] < minX) minX = surf->vertex3[0];
+        if (surf->vertex3[0] > maxX) maxX = surf->vertex3[0];
+        if (surf->vertex2[2] < minZ) minZ = surf->vertex2[2];
+        if (surf->vertex2[2] > maxZ) maxZ = surf->vertex2[2];
+        if (surf->vertex3[2] < minZ) minZ = surf->vertex3[2];
+        if (surf->vertex3[2] > maxZ) maxZ = surf->vertex3[2];
+
+        if (maxX + margin < ctx->minX || minX - margin > ctx->maxX
+            || maxZ + margin < ctx->minZ || minZ - margin > ctx->maxZ) {
+            continue;
+        }
+
+        if (sStepCollisionNodeCount >= STEP_COLLISION_MAX_NODES) {
+            return FALSE;
+        }
+        *tail = &sStepCollisionNodes[sStepCollisionNodeCount++];
+        (*tail)->surface = surf;
+        tail = &(*tail)->next;
+    }
+
+    *tail = NULL;
+    return TRUE;
+}
+
+/**
+ * Gather the floors, ceilings and walls that queries inside the box from (minX, minY, minZ)
+ * to (maxX, maxY, maxZ) could hit, for wall searches with a radius of up to wallRadius.
+ * Ceilings are kept regardless of height, since they are searched from the floor below.
+ * If the box spans more than 2x2 cells or too many surfaces, the context is left invalid
+ * and every query goes through the regular functions.
+ */
+void step_collision_init(struct StepCollisionContext *ctx, f32 minX, f32 minY, f32 minZ,
+                         f32 maxX, f32 maxY, f32 maxZ, f32 wallRadius) {
+    s32 i, j, k;
+
+    ctx->valid = FALSE;
+
+    // Also rejects NaN.
+    if (!(minX > -0x8000 && minY > -0x8000 && minZ > -0x8000 && maxX < 0x7FFF && maxY < 0x7FFF
+          && maxZ < 0x7FFF)) {
+        return;
+    }
+
+    // Round the bounds outwards, and keep them inside the level so that every
+    // query inside them passes the level boundary checks.
+    ctx->minX = (s32) minX - 1;
+    ctx->minY = (s32) minY - 1;
+    ctx->minZ = (s32) minZ - 1;
+    ctx->maxX = (s32) maxX + 1;
+    ctx->maxY = (s32) maxY + 1;
+    ctx->maxZ = (s32) maxZ + 1;
+    if (ctx->minX < -LEVEL_BOUNDARY_MAX + 1) {
+        ctx->minX = -LEVEL_BOUNDARY_MAX + 1;
+    }
+    if (ctx->minZ < -LEVEL_BOUNDARY_MAX + 1) {
+        ctx->minZ = -LEVEL_BOUNDARY_MAX + 1;
+    }
+    if (ctx->maxX > LEVEL_BOUNDARY_MAX - 1) {
+        ctx->maxX = LEVEL_BOUNDARY_MAX - 1;
+    }
+    if (ctx->maxZ > LEVEL_BOUNDARY_MAX - 1) {
+        ctx->maxZ = LEVEL_BOUNDARY_MAX - 1;
+    }
+    ctx->wallRadius = wallRadius;
+    // A wall can push from up to radius * sqrt(2) past its bounding box in x or z.
+    ctx->wallMargin = 2 * (s32) wallRadius + 1;
+
+    if (ctx->minX > ctx->maxX || ctx->minZ > ctx->maxZ) {
+        return;
+    }
+
+    ctx->cellX = (ctx->minX + LEVEL_BOUNDARY_MAX) / CELL_SIZE;
+    ctx->cellZ = (ctx->minZ + LEVEL_BOUNDARY_MAX) / CELL_SIZE;
+    ctx->numCellsX = (ctx->maxX + LEVEL_BOUNDARY_MAX) / CELL_SIZE - ctx->cellX + 1;
+    ctx->numCellsZ = (ctx->maxZ + LEVEL_BOUNDARY_MAX) / CELL_SIZE - ctx->cellZ + 1;
+
+    if (ctx->numCellsX > 2 || ctx->numCellsZ > 2) {
+        return;
+    }
+
+    sStepCollisionNodeCount = 0;
+
+    for (i = 0; i < ctx->numCellsZ; i++) {
+        for (j = 0; j < ctx->numCellsX; j++) {
+            for (k = 0; k < 3; k++) {
+                if (!step_collision_filter_list(
+                        ctx, gDynamicSurfacePartition[ctx->cellZ + i][ctx->cellX + j][k].next, k,
+                        &ctx->dynamicLists[i][j][k])
+                    || !step_collision_filter_list(
+                        ctx, gStaticSurfacePartition[ctx->cellZ + i][ctx->cellX + j][k].next, k,
+                        &ctx->staticLists[i][j][k])) {
+                    return;
+                }
+            }
+        }
+    }
+
+    ctx->valid = TRUE;
+}
+
+/**
+ * Return whether the filtered lists apply to a query at (x, z). Checking the unrounded
+ * position also keeps out positions that wrap around when truncated to s16.
+ */
+static s32 step_collision_contains(struct StepCollisionContext *ctx, f32 x, f32 z) {
+    return ctx->valid && x >= ctx->minX && x <= ctx->maxX && z >= ctx->minZ && z <= ctx->maxZ;
+}
+
+/**
+ * Same as find_wall_collisions, using the context's lists when the search is inside it.
+ */
+s32 step_find_wall_collisions(struct StepCollisionContext *ctx, struct WallCollisionData *colData) {
+    struct SurfaceNode *node;
+    s32 numCollisions = 0;
+    s16 x = colData->x;
+    s16 z = colData->z;
+    f32 y = colData->y + colData->offsetY;
+    s32 i, j;
+
+    if (!step_collision_contains(ctx, colData->x, colData->z) || colData->radius > ctx->wallRadius
+        || y < ctx->minY || y > ctx->maxY) {
+        return find_wall_collisions(colData);
+    }
+
+    colData->numWalls = 0;
+
+    i = (z + LEVEL_BOUNDARY_MAX) / CELL_SIZE - ctx->cellZ;
+    j = (x + LEVEL_BOUNDARY_MAX) / CELL_SIZE - ctx->cellX;
+
+    // A list walk checks every wall against the position it started from, however far
+    // earlier walls in the list pushed it (see find_wall_collisions_from_list), so the
+    // position only has to be inside the bounds when each list starts.
+    numCollisions += find_wall_collisions_from_list(ctx->dynamicLists[i][j][SPATIAL_PARTITION_WALLS], colData);
+
+    // Object walls may have pushed the position out of the bounds the static walls were
+    // gathered for. The cell stays the same either way.
+    if (step_collision_contains(ctx, colData->x, colData->z)) {
+        node = ctx->staticLists[i][j][SPATIAL_PARTITION_WALLS];
+    } else {
+        node = gStaticSurfacePartition[ctx->cellZ + i][ctx->cellX + j][SPATIAL_PARTITION_WALLS].next;
+    }
+    numCollisions += find_wall_collisions_from_list(node, colData);
+
+    // Increment the debug tracker.
+    gNumCalls.wall++;
+
+    return numCollisions;
+}
+
+/**
+ * Same as find_ceil, using the context's lists when the position is inside it.
+ */
+f32 step_find_ceil(struct StepCollisionContext *ctx, f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
+    s16 x = (s16) posX;
+    s16 z = (s16) posZ;
+    s32 i, j;
+
+    if (!step_collision_contains(ctx, posX, posZ)) {
+        return find_ceil(posX, posY, posZ, pceil);
+    }
+
+    i = (z + LEVEL_BOUNDARY_MAX) / CELL_SIZE - ctx->cellZ;
+    j = (x + LEVEL_BOUNDARY_MAX) / CELL_SIZE - ctx->cellX;
+
+    return find_ceil_in_cell(ctx->dynamicLists[i][j][SPATIAL_PARTITION_CEILS],
+                             ctx->staticLists[i][j][SPATIAL_PARTITION_CEILS], x, (s16) posY, z, pceil);
+}
+
+/**
+ * Same as find_floor, using the context's lists when the position is inside it.
+ */
+f32 step_find_floor(struct StepCollisionContext *ctx, f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
+    s16 x = (s16) xPos;
+    s16 z = (s16) zPos;
+    s32 i, j;
+
+    if (!step_collision_contains(ctx, xPos, zPos) || yPos > ctx->maxY) {
+        return find_floor(xPos, yPos, zPos, pfloor);
+    }
+
+    i = (z + LEVEL_BOUNDARY_MAX) / CELL_SIZE - ctx->cellZ;
+    j = (x + LEVEL_BOUNDARY_MAX) / CELL_SIZE - ctx->cellX;
+
+    return find_floor_in_cell(ctx->dynamicLists[i][j][SPATIAL_PARTITION_FLOORS],
+                              ctx->staticLists[i][j][SPATIAL_PARTITION_FLOORS], x, (s16) yPos, z, pfloor);
+}
+
 /**************************************************
  *               ENVIRONMENTAL BOXES              *
  **************************************************/
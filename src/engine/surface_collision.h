@@ -34,6 +34,26 @@ struct FloorGeometry {
     f32 originOffset;
 };
 
+#define STEP_COLLISION_MAX_NODES 512
+
+/**
+ * The floors, ceilings and walls near a movement step, gathered once so that
+ * repeated searches over the step only check surfaces that could be hit.
+ * Searches outside the bounds use the regular cell lists, so the results
+ * are the same as find_floor, find_ceil and find_wall_collisions.
+ */
+struct StepCollisionContext {
+    s32 minX, minY, minZ;
+    s32 maxX, maxY, maxZ;
+    f32 wallRadius;
+    s32 wallMargin;
+    s16 cellX, cellZ;
+    s16 numCellsX, numCellsZ;
+    s32 valid;
+    struct SurfaceNode *dynamicLists[2][2][3];
+    struct SurfaceNode *staticLists[2][2][3];
+};
+
 s32 f32_find_wall_collision(f32 *xPtr, f32 *yPtr, f32 *zPtr, f32 offsetY, f32 radius);
 s32 find_wall_collisions(struct WallCollisionData *colData);
 f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil);
@@ -43,5 +63,10 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor);
 f32 find_water_level(f32 x, f32 z);
 f32 find_poison_gas_level(f32 x, f32 z);
 void debug_surface_list_info(f32 xPos, f32 zPos);
+void step_collision_init(struct StepCollisionContext *ctx, f32 minX, f32 minY, f32 minZ,
+                         f32 maxX, f32 maxY, f32 maxZ, f32 wallRadius);
+s32 step_find_wall_collisions(struct StepCollisionContext *ctx, struct WallCollisionData *colData);
+f32 step_find_ceil(struct StepCollisionContext *ctx, f32 posX, f32 posY, f32 posZ, struct Surface **pceil);
+f32 step_find_floor(struct StepCollisionContext *ctx, f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor);
 
 #endif // SURFACE_COLLISION_H
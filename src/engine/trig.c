@@ -0,0 +1,167 @@
+#include <PR/ultratypes.h>
+
+#include "trig.h"
+
+/**
+ * This file contains the table based trigonometry that isn't a plain table
+ * lookup: sine and cosine from a quarter of the sine table or interpolated
+ * between table entries (see TRIG_QUARTER_TABLE and TRIG_INTERPOLATE), and
+ * the two versions of atan2s (see TRIG_ATAN2_OCTANT_TABLE). It doesn't
+ * depend on the rest of the game, so that tools/trigbench can measure it on
+ * the host.
+ */
+
+#ifdef TRIG_QUARTER_TABLE
+#define SINE_AT(index) quarter_sine(index)
+#else
+#define SINE_AT(index) gSineTable[(index) & 0xFFF]
+#endif
+
+/**
+ * Return the sine of 'index' in steps of 1/0x1000 of a period, using only the
+ * first quarter of the sine table. The sine table is symmetric, so this gives
+ * the same values as the full table.
+ */
+static f32 quarter_sine(u32 index) {
+    u32 i = index & 0x3FF;
+
+    if (index & 0x400) {
+        i = 0x400 - i;
+    }
+    return (index & 0x800) ? -gSineTable[i] : gSineTable[i];
+}
+
+f32 sins_quarter(u16 angle) {
+    return quarter_sine(angle >> 4);
+}
+
+f32 coss_quarter(u16 angle) {
+    return quarter_sine((angle >> 4) + 0x400);
+}
+
+/**
+ * Return the sine of 'angle', interpolated between the two closest table
+ * entries instead of rounding the angle down to a multiple of 0x10.
+ */
+f32 sins_lerp(u16 angle) {
+    u32 index = angle >> 4;
+    f32 a = SINE_AT(index);
+    f32 b = SINE_AT(index + 1);
+
+    return a + (b - a) * (f32) (angle & 0xF) * (1.0f / 16);
+}
+
+f32 coss_lerp(u16 angle) {
+    return sins_lerp(angle + 0x4000);
+}
+
+/**
+ * Helper function for atan2s_branches. Does a look up of the arctangent of y/x
+ * assuming the resulting angle is in range [0, 0x2000] (1/8 of a circle).
+ */
+static u16 atan2_lookup(f32 y, f32 x) {
+    u16 ret;
+
+    if (x == 0) {
+        ret = gArctanTable[0];
+    } else {
+        ret = gArctanTable[(s32)(y / x * 1024 + 0.5f)];
+    }
+    return ret;
+}
+
+/**
+ * Compute the angle from (0, 0) to (x, y) as a s16. Given that terrain is in
+ * the xz-plane, this is commonly called with (z, x) to get a yaw angle.
+ * This is the version atan2s uses unless TRIG_ATAN2_OCTANT_TABLE is defined.
+ */
+s16 atan2s_branches(f32 y, f32 x) {
+    u16 ret;
+
+    if (x >= 0) {
+        if (y >= 0) {
+            if (y >= x) {
+                ret = atan2_lookup(x, y);
+            } else {
+                ret = 0x4000 - atan2_lookup(y, x);
+            }
+        } else {
+            y = -y;
+            if (y < x) {
+                ret = 0x4000 + atan2_lookup(y, x);
+            } else {
+                ret = 0x8000 - atan2_lookup(x, y);
+            }
+        }
+    } else {
+        x = -x;
+        if (y < 0) {
+            y = -y;
+            if (y >= x) {
+                ret = 0x8000 + atan2_lookup(x, y);
+            } else {
+                ret = 0xC000 - atan2_lookup(y, x);
+            }
+        } else {
+            if (y < x) {
+                ret = 0xC000 + atan2_lookup(y, x);
+            } else {
+                ret = -atan2_lookup(x, y);
+            }
+        }
+    }
+    return ret;
+}
+
+/*
+ * atan2s_octant looks up the angle of the smaller of |x| and |y| over the
+ * larger one, which is in range [0, 0x2000], and then adds it to or subtracts
+ * it from the start or end of the octant (x, y) is in. Both tables are indexed
+ * by (x < 0) * 4 + (y < 0) * 2 + (|y| >= |x|).
+ */
+static const u16 sAtan2OctantBase[8] = {
+    0x4000, 0x0000, // x >= 0, y >= 0
+    0x4000, 0x8000, // x >= 0, y < 0
+    0xC000, 0x0000, // x < 0, y >= 0
+    0xC000, 0x8000, // x < 0, y < 0
+};
+
+static const s8 sAtan2OctantSign[8] = {
+    -1, 1, 1, -1, 1, -1, -1, 1,
+};
+
+/**
+ * Same as atan2s_branches, but with the octant looked up in a table instead
+ * of branching on it. Used for atan2s with TRIG_ATAN2_OCTANT_TABLE.
+ */
+s16 atan2s_octant(f32 y, f32 x) {
+    s32 octant = 0;
+    f32 num;
+    f32 den;
+    u16 angle;
+
+    if (!(x >= 0)) {
+        x = -x;
+        octant = 4;
+    }
+    if (y < 0) {
+        y = -y;
+        octant += 2;
+    }
+
+    if (y >= x) {
+        num = x;
+        den = y;
+        octant++;
+    } else {
+        num = y;
+        den = x;
+    }
+
+    if (den == 0) {
+        angle = gArctanTable[0];
+    } else {
+        angle = gArctanTable[(s32)(num / den * 1024 + 0.5f)];
+    }
+    return sAtan2OctantBase[octant] + sAtan2OctantSign[octant] * angle;
+}
@@ -0,0 +1,79 @@
+#ifndef TRIG_H
+#define TRIG_H
+
+#include <PR/ultratypes.h>
+
+#include "config.h"
+
+/*
+ * The sine and cosine tables overlap, but "#define gCosineTable (gSineTable +
+ * 0x400)" doesn't give expected codegen; gSineTable and gCosineTable need to
+ * be different symbols for code to match. Most likely the tables were placed
+ * adjacent to each other, and gSineTable cut short, such that reads overflow
+ * into gCosineTable.
+ *
+ * These kinds of out of bounds reads are undefined behavior, and break on
+ * e.g. GCC (which doesn't place the tables next to each other, and probably
+ * exploits array sizes for range analysis-based optimizations as well).
+ * Thus, for non-IDO compilers we use the standard-compliant version.
+ *
+ * With TRIG_QUARTER_TABLE, only the first 0x401 entries of gSineTable (a
+ * quarter of a period) are kept, with or without AVOID_UB, and there is no
+ * separate gCosineTable.
+ */
+extern f32 gSineTable[];
+#ifdef AVOID_UB
+#define gCosineTable (gSineTable + 0x400)
+#elif !defined(TRIG_QUARTER_TABLE)
+extern f32 gCosineTable[];
+#endif
+
+/// atan of 0 to 1 in steps of 1/1024, as angles in range [0, 0x2000]
+extern s16 gArctanTable[];
+
+f32 sins_quarter(u16 angle);
+f32 coss_quarter(u16 angle);
+f32 sins_lerp(u16 angle);
+f32 coss_lerp(u16 angle);
+
+#if defined(TRIG_INTERPOLATE)
+#define sins(x) sins_lerp((u16) (x))
+#define coss(x) coss_lerp((u16) (x))
+#elif defined(TRIG_QUARTER_TABLE)
+#define sins(x) sins_quarter((u16) (x))
+#define coss(x) coss_quarter((u16) (x))
+#else
+#define sins(x) gSineTable[(u16) (x) >> 4]
+#define coss(x) gCosineTable[(u16) (x) >> 4]
+#endif
+
+/**
+ * Set 's' and 'c' to the sine and cosine of 'angle'. With the full table, both
+ * are read with the same index.
+ */
+#if defined(TRIG_INTERPOLATE) || defined(TRIG_QUARTER_TABLE)
+#define sincoss(angle, s, c)                                                                       \
+    do {                                                                                           \
+        u16 sincossAngle = (angle);                                                                \
+        (s) = sins(sincossAngle);                                                                  \
+        (c) = coss(sincossAngle);                                                                  \
+    } while (0)
+#else
+#define sincoss(angle, s, c)                                                                       \
+    do {                                                                                           \
+        u16 sincossIndex = (u16) (angle) >> 4;                                                     \
+        (s) = gSineTable[sincossIndex];                                                            \
+        (c) = gCosineTable[sincossIndex];                                                          \
+    } while (0)
+#endif
+
+s16 atan2s_branches(f32 y, f32 x);
+s16 atan2s_octant(f32 y, f32 x);
+
+#ifdef TRIG_ATAN2_OCTANT_TABLE
+#define atan2s(y, x) atan2s_octant(y, x)
+#else
+#define atan2s(y, x) atan2s_branches(y, x)
+#endif
+
+#endif // TRIG_H
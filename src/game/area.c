@@ -22,6 +22,7 @@
 #include "save_file.h"
 #include "level_table.h"
 #include "dialog_ids.h"
+#include "moving_texture.h"
 
 struct SpawnInfo gPlayerSpawnInfos[1];
 struct GraphNode *D_8033A160[0x100];
@@ -236,6 +237,9 @@ void load_area(s32 index) {
         }
 
         load_obj_warp_nodes();
+#ifdef MOVTEX_VERTEX_BUFFERS
+        movtex_clear_buffers();
+#endif
         geo_call_global_function_nodes(&gCurrentArea->unk04->node, GEO_CONTEXT_AREA_LOAD);
     }
 }
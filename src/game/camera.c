@@ -28,6 +28,7 @@
 #include "paintings.h"
 #include "engine/graph_node.h"
 #include "level_table.h"
+#include "profiler.h"
 
 #define CBUTTON_MASK (U_CBUTTONS | D_CBUTTONS | L_CBUTTONS | R_CBUTTONS)
 
@@ -3012,6 +3013,7 @@ void update_lakitu(struct Camera *c) {
 void update_camera(struct Camera *c) {
     UNUSED u8 filler[24];
 
+    PROFILER_BEGIN(PROFILER_SCOPE_CAMERA);
     gCamera = c;
     update_camera_hud_status(c);
     if (c->cutscene == 0) {
@@ -3200,6 +3202,8 @@ void update_camera(struct Camera *c) {
     update_lakitu(c);
 
     gLakituState.lastFrameAction = sMarioCamState->action;
+
+    PROFILER_END(PROFILER_SCOPE_CAMERA);
 }
 
 /**
@@ -0,0 +1,154 @@
+#include <ultra64.h>
+
+#include "sm64.h"
+#include "demo_bench.h"
+#include "game_init.h"
+#include "level_update.h"
+#include "memory.h"
+#include "moving_texture.h"
+#include "object_list_processor.h"
+#include "shadow.h"
+
+#ifdef DEMO_BENCH
+
+#define FNV_OFFSET_BASIS 0x811C9DC5
+#define FNV_PRIME 0x01000193
+
+static const char *sDemoBenchTimerNames[DEMO_BENCH_TIMER_COUNT] = {
+    "audio",
+    "logic",
+    "render",
+    "audiothread",
+};
+
+static u32 sDemoBenchTimerStart[DEMO_BENCH_TIMER_COUNT];
+static u64 sDemoBenchTimerCycles[DEMO_BENCH_TIMER_COUNT];
+static u64 sDemoBenchPreemptStart[DEMO_BENCH_TIMER_COUNT];
+static s32 sDemoBenchActive = FALSE;
+static s32 sDemoBenchDemo = 0;
+static s32 sDemoBenchLevel;
+static u32 sDemoBenchFrames;
+static u32 sDemoBenchHash;
+
+void demo_bench_begin(enum DemoBenchTimer timer) {
+    sDemoBenchTimerStart[timer] = osGetCount();
+    sDemoBenchPreemptStart[timer] = sDemoBenchTimerCycles[DEMO_BENCH_AUDIO_THREAD];
+}
+
+void demo_bench_end(enum DemoBenchTimer timer) {
+    u32 cycles = osGetCount() - sDemoBenchTimerStart[timer];
+
+    // The audio thread preempts the game thread on every vblank. Leave out the time it
+    // ran for in the middle of a game thread span.
+    if (timer != DEMO_BENCH_AUDIO_THREAD) {
+        cycles -= sDemoBenchTimerCycles[DEMO_BENCH_AUDIO_THREAD] - sDemoBenchPreemptStart[timer];
+    }
+    sDemoBenchTimerCycles[timer] += cycles;
+}
+
+static u32 hash_words(u32 hash, const u32 *data, u32 count) {
+    while (count-- != 0) {
+        hash = (hash ^ *data++) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Hash Mario and every active object in the pool into the running hash. Slot
+ * indices are included, so a different spawn order changes the hash too.
+ */
+static u32 hash_game_state(u32 hash) {
+    struct Object *obj;
+    u32 header[2];
+    s32 i;
+
+    hash = hash_words(hash, (const u32 *) gMarioState, sizeof(struct MarioState) / sizeof(u32));
+
+    for (i = 0; i < OBJECT_POOL_CAPACITY; i++) {
+        obj = &gObjectPool[i];
+        if (obj->activeFlags & ACTIVE_FLAG_ACTIVE) {
+            header[0] = (i << 16) | (u16) obj->activeFlags;
+            header[1] = (uintptr_t) obj->behavior;
+            hash = hash_words(hash, header, ARRAY_COUNT(header));
+            hash = hash_words(hash, obj->rawData.asU32, ARRAY_COUNT(obj->rawData.asU32));
+        }
+    }
+    return hash;
+}
+
+static void demo_bench_start(void) {
+    sDemoBenchActive = TRUE;
+    // The first entry of a demo holds its level number.
+    sDemoBenchLevel = (s8)((struct DemoInput *) gDemoInputsBuf.bufTarget)->timer;
+    sDemoBenchFrames = 0;
+    sDemoBenchHash = FNV_OFFSET_BASIS;
+}
+
+static void demo_bench_report(void) {
+    u64 totalCycles = 0;
+    u32 usec;
+    u32 fps;
+    s32 i;
+
+    for (i = 0; i < DEMO_BENCH_TIMER_COUNT; i++) {
+        totalCycles += sDemoBenchTimerCycles[i];
+    }
+    usec = OS_CYCLES_TO_USEC(totalCycles);
+    fps = usec != 0 ? (u64) sDemoBenchFrames * 10000000 / usec : 0;
+
+    osSyncPrintf("demobench: demo %d level %d frames %d hash %08x fps %d.%d\n", sDemoBenchDemo,
+                 sDemoBenchLevel, sDemoBenchFrames, sDemoBenchHash, fps / 10, fps % 10);
+    for (i = 0; i < DEMO_BENCH_TIMER_COUNT; i++) {
+        osSyncPrintf("demobench: demo %d %s %d us/frame\n", sDemoBenchDemo, sDemoBenchTimerNames[i],
+                     (u32) (OS_CYCLES_TO_USEC(sDemoBenchTimerCycles[i]) / sDemoBenchFrames));
+    }
+    osSyncPrintf("demobench: demo %d movtex %d verts/frame\n", sDemoBenchDemo,
+                 gMovtexVertsWritten / sDemoBenchFrames);
+#ifdef SHADOW_CACHE
+    osSyncPrintf("demobench: demo %d shadow cache hits %d misses %d\n", sDemoBenchDemo,
+                 gShadowCacheHits, gShadowCacheMisses);
+#endif
+}
+
+/**
+ * Called at the end of every game loop. A demo runs from the frame
+ * gCurrDemoInput is set to the frame the title screen clears it again.
+ */
+void demo_bench_frame(void) {
+    s32 i;
+
+    if (gCurrDemoInput != NULL) {
+        if (!sDemoBenchActive) {
+            demo_bench_start();
+        }
+        sDemoBenchFrames++;
+        sDemoBenchHash = hash_game_state(sDemoBenchHash);
+#if DEMO_BENCH >= 2
+        osSyncPrintf("demobench: demo %d frame %d hash %08x\n", sDemoBenchDemo, sDemoBenchFrames,
+                     sDemoBenchHash);
+#endif
+        return;
+    }
+
+    if (sDemoBenchActive) {
+        sDemoBenchActive = FALSE;
+        demo_bench_report();
+
+        if (++sDemoBenchDemo == (s32) gDemoInputsBuf.dmaTable->count) {
+            osSyncPrintf("demobench: done\n");
+            osStopThread(NULL);
+        }
+    }
+
+    // Time spent outside of demos isn't counted.
+    for (i = 0; i < DEMO_BENCH_TIMER_COUNT; i++) {
+        sDemoBenchTimerCycles[i] = 0;
+    }
+    gMovtexVertsWritten = 0;
+#ifdef SHADOW_CACHE
+    gShadowCacheHits = 0;
+    gShadowCacheMisses = 0;
+#endif
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef DEMO_BENCH_H
+#define DEMO_BENCH_H
+
+#include <PR/ultratypes.h>
+
+/**
+ * Demo benchmark, built with DEMOBENCH=1 or 2.
+ *
+ * The game plays every demo in the demo table back to back, starting each one
+ * as soon as the title screen comes up. Display lists are built but never sent
+ * to the RSP, controllers aren't read and the game thread never waits for
+ * vblank, so frames run as fast as the game logic allows. The state of Mario
+ * and every active object is hashed after each frame, and a summary line per
+ * demo is printed through osSyncPrintf (see DEMOBENCH in the Makefile).
+ */
+
+enum DemoBenchTimer {
+    DEMO_BENCH_AUDIO,
+    DEMO_BENCH_LOGIC,
+    DEMO_BENCH_RENDER,
+    DEMO_BENCH_AUDIO_THREAD,
+    DEMO_BENCH_TIMER_COUNT
+};
+
+#ifdef DEMO_BENCH
+void demo_bench_begin(enum DemoBenchTimer timer);
+void demo_bench_end(enum DemoBenchTimer timer);
+void demo_bench_frame(void);
+
+#define DEMO_BENCH_BEGIN(timer) demo_bench_begin(timer)
+#define DEMO_BENCH_END(timer) demo_bench_end(timer)
+#else
+#define DEMO_BENCH_BEGIN(timer)
+#define DEMO_BENCH_END(timer)
+#endif
+
+#endif // DEMO_BENCH_H
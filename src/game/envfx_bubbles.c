@@ -41,8 +41,8 @@ Vtx_t gBubbleTempVtx[3] = {
  * kill flower and bubble particles.
  */
 s32 particle_is_laterally_close(s32 index, s32 x, s32 z, s32 distance) {
-    s32 xPos = (gEnvFxBuffer + index)->xPos;
-    s32 zPos = (gEnvFxBuffer + index)->zPos;
+    s32 xPos = gEnvFxParticles.xPos[index];
+    s32 zPos = gEnvFxParticles.zPos[index];
 
     if (sqr(xPos - x) + sqr(zPos - z) > sqr(distance)) {
         return FALSE;
@@ -74,24 +74,24 @@ void envfx_update_flower(Vec3s centerPos) {
     s32 i;
     struct FloorGeometry *floorGeo; // unused
     s32 globalTimer = gGlobalTimer;
+    s32 *xPos = gEnvFxParticles.xPos;
+    s32 *zPos = gEnvFxParticles.zPos;
+    s16 *animFrame = gEnvFxParticles.animFrame;
 
     s16 centerX = centerPos[0];
     UNUSED s16 centerY = centerPos[1];
     s16 centerZ = centerPos[2];
 
     for (i = 0; i < sBubbleParticleMaxCount; i++) {
-        (gEnvFxBuffer + i)->isAlive = particle_is_laterally_close(i, centerX, centerZ, 3000);
-        if (!(gEnvFxBuffer + i)->isAlive) {
-            (gEnvFxBuffer + i)->xPos = random_flower_offset() + centerX;
-            (gEnvFxBuffer + i)->zPos = random_flower_offset() + centerZ;
-            (gEnvFxBuffer + i)->yPos = find_floor_height_and_data((gEnvFxBuffer + i)->xPos, 10000.0f,
-                                                                  (gEnvFxBuffer + i)->zPos, &floorGeo);
-            (gEnvFxBuffer + i)->isAlive = TRUE;
-            (gEnvFxBuffer + i)->animFrame = random_float() * 5.0f;
+        if (!particle_is_laterally_close(i, centerX, centerZ, 3000)) {
+            xPos[i] = random_flower_offset() + centerX;
+            zPos[i] = random_flower_offset() + centerZ;
+            gEnvFxParticles.yPos[i] = find_floor_height_and_data(xPos[i], 10000.0f, zPos[i], &floorGeo);
+            animFrame[i] = random_float() * 5.0f;
         } else if (!(globalTimer & 3)) {
-            (gEnvFxBuffer + i)->animFrame += 1;
-            if ((gEnvFxBuffer + i)->animFrame > 5) {
-                (gEnvFxBuffer + i)->animFrame = 0;
+            animFrame[i] += 1;
+            if (animFrame[i] > 5) {
+                animFrame[i] = 0;
             }
         }
     }
@@ -109,39 +109,40 @@ void envfx_update_flower(Vec3s centerPos) {
 void envfx_set_lava_bubble_position(s32 index, Vec3s centerPos) {
     struct Surface *surface;
     s16 floorY;
+    s32 *xPos = &gEnvFxParticles.xPos[index];
+    s32 *zPos = &gEnvFxParticles.zPos[index];
 
     s16 centerX = centerPos[0];
     s16 centerY = centerPos[1];
     s16 centerZ = centerPos[2];
 
-    (gEnvFxBuffer + index)->xPos = random_float() * 6000.0f - 3000.0f + centerX;
-    (gEnvFxBuffer + index)->zPos = random_float() * 6000.0f - 3000.0f + centerZ;
+    *xPos = random_float() * 6000.0f - 3000.0f + centerX;
+    *zPos = random_float() * 6000.0f - 3000.0f + centerZ;
 
-    if ((gEnvFxBuffer + index)->xPos > 8000) {
-        (gEnvFxBuffer + index)->xPos = 16000 - (gEnvFxBuffer + index)->xPos;
+    if (*xPos > 8000) {
+        *xPos = 16000 - *xPos;
     }
-    if ((gEnvFxBuffer + index)->xPos < -8000) {
-        (gEnvFxBuffer + index)->xPos = -16000 - (gEnvFxBuffer + index)->xPos;
+    if (*xPos < -8000) {
+        *xPos = -16000 - *xPos;
     }
 
-    if ((gEnvFxBuffer + index)->zPos > 8000) {
-        (gEnvFxBuffer + index)->zPos = 16000 - (gEnvFxBuffer + index)->zPos;
+    if (*zPos > 8000) {
+        *zPos = 16000 - *zPos;
     }
-    if ((gEnvFxBuffer + index)->zPos < -8000) {
-        (gEnvFxBuffer + index)->zPos = -16000 - (gEnvFxBuffer + index)->zPos;
+    if (*zPos < -8000) {
+        *zPos = -16000 - *zPos;
     }
 
-    floorY =
-        find_floor((gEnvFxBuffer + index)->xPos, centerY + 500, (gEnvFxBuffer + index)->zPos, &surface);
+    floorY = find_floor(*xPos, centerY + 500, *zPos, &surface);
     if (surface == NULL) {
-        (gEnvFxBuffer + index)->yPos = FLOOR_LOWER_LIMIT_MISC;
+        gEnvFxParticles.yPos[index] = FLOOR_LOWER_LIMIT_MISC;
         return;
     }
 
     if (surface->type == SURFACE_BURNING) {
-        (gEnvFxBuffer + index)->yPos = floorY;
+        gEnvFxParticles.yPos[index] = floorY;
     } else {
-        (gEnvFxBuffer + index)->yPos = FLOOR_LOWER_LIMIT_MISC;
+        gEnvFxParticles.yPos[index] = FLOOR_LOWER_LIMIT_MISC;
     }
 }
 
@@ -153,20 +154,22 @@ void envfx_update_lava(Vec3s centerPos) {
     s32 i;
     s32 globalTimer = gGlobalTimer;
     s8 chance;
+    s8 *isAlive = gEnvFxParticles.isAlive;
+    s16 *animFrame = gEnvFxParticles.animFrame;
 
     UNUSED s16 centerX = centerPos[0];
     UNUSED s16 centerY = centerPos[1];
     UNUSED s16 centerZ = centerPos[2];
 
     for (i = 0; i < sBubbleParticleMaxCount; i++) {
-        if (!(gEnvFxBuffer + i)->isAlive) {
+        if (!isAlive[i]) {
             envfx_set_lava_bubble_position(i, centerPos);
-            (gEnvFxBuffer + i)->isAlive = TRUE;
+            isAlive[i] = TRUE;
         } else if (!(globalTimer & 1)) {
-            (gEnvFxBuffer + i)->animFrame += 1;
-            if ((gEnvFxBuffer + i)->animFrame > 8) {
-                (gEnvFxBuffer + i)->isAlive = FALSE;
-                (gEnvFxBuffer + i)->animFrame = 0;
+            animFrame[i] += 1;
+            if (animFrame[i] > 8) {
+                isAlive[i] = FALSE;
+                animFrame[i] = 0;
             }
         }
     }
@@ -205,11 +208,11 @@ void envfx_rotate_around_whirlpool(s32 *x, s32 *y, s32 *z) {
 s32 envfx_is_whirlpool_bubble_alive(s32 index) {
     UNUSED u8 filler[4];
 
-    if ((gEnvFxBuffer + index)->bubbleY < gEnvFxBubbleConfig[ENVFX_STATE_DEST_Y] - 100) {
+    if (gEnvFxParticles.bubbleY[index] < gEnvFxBubbleConfig[ENVFX_STATE_DEST_Y] - 100) {
         return FALSE;
     }
 
-    if ((gEnvFxBuffer + index)->angleAndDist[1] < 10) {
+    if (gEnvFxParticles.dist[index] < 10) {
         return FALSE;
     }
 
@@ -222,42 +225,28 @@ s32 envfx_is_whirlpool_bubble_alive(s32 index) {
  */
 void envfx_update_whirlpool(void) {
     s32 i;
+    s32 *xPos = gEnvFxParticles.xPos;
+    s32 *yPos = gEnvFxParticles.yPos;
+    s32 *zPos = gEnvFxParticles.zPos;
+    s32 *angle = gEnvFxParticles.angle;
+    s32 *dist = gEnvFxParticles.dist;
+    s32 *bubbleY = gEnvFxParticles.bubbleY;
 
     for (i = 0; i < sBubbleParticleMaxCount; i++) {
-        (gEnvFxBuffer + i)->isAlive = envfx_is_whirlpool_bubble_alive(i);
-        if (!(gEnvFxBuffer + i)->isAlive) {
-            (gEnvFxBuffer + i)->angleAndDist[1] = random_float() * 1000.0f;
-            (gEnvFxBuffer + i)->angleAndDist[0] = random_float() * 65536.0f;
-            (gEnvFxBuffer + i)->xPos =
-                gEnvFxBubbleConfig[ENVFX_STATE_SRC_X]
-                + sins((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
-            (gEnvFxBuffer + i)->zPos =
-                gEnvFxBubbleConfig[ENVFX_STATE_SRC_Z]
-                + coss((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
-            (gEnvFxBuffer + i)->bubbleY =
-                gEnvFxBubbleConfig[ENVFX_STATE_SRC_Y] + (random_float() * 100.0f - 50.0f);
-            (gEnvFxBuffer + i)->yPos = (i + gEnvFxBuffer)->bubbleY;
-            (gEnvFxBuffer + i)->unusedBubbleVar = 0;
-            (gEnvFxBuffer + i)->isAlive = TRUE;
-
-            envfx_rotate_around_whirlpool(&(gEnvFxBuffer + i)->xPos, &(gEnvFxBuffer + i)->yPos,
-                                          &(gEnvFxBuffer + i)->zPos);
+        if (!envfx_is_whirlpool_bubble_alive(i)) {
+            dist[i] = random_float() * 1000.0f;
+            angle[i] = random_float() * 65536.0f;
+            bubbleY[i] = gEnvFxBubbleConfig[ENVFX_STATE_SRC_Y] + (random_float() * 100.0f - 50.0f);
         } else {
-            (gEnvFxBuffer + i)->angleAndDist[1] -= 40;
-            (gEnvFxBuffer + i)->angleAndDist[0] +=
-                (s16)(3000 - (gEnvFxBuffer + i)->angleAndDist[1] * 2) + 0x400;
-            (gEnvFxBuffer + i)->xPos =
-                gEnvFxBubbleConfig[ENVFX_STATE_SRC_X]
-                + sins((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
-            (gEnvFxBuffer + i)->zPos =
-                gEnvFxBubbleConfig[ENVFX_STATE_SRC_Z]
-                + coss((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
-            (gEnvFxBuffer + i)->bubbleY -= 40 - ((s16)(gEnvFxBuffer + i)->angleAndDist[1] / 100);
-            (gEnvFxBuffer + i)->yPos = (i + gEnvFxBuffer)->bubbleY;
-
-            envfx_rotate_around_whirlpool(&(gEnvFxBuffer + i)->xPos, &(gEnvFxBuffer + i)->yPos,
-                                          &(gEnvFxBuffer + i)->zPos);
+            dist[i] -= 40;
+            angle[i] += (s16)(3000 - dist[i] * 2) + 0x400;
+            bubbleY[i] -= 40 - ((s16) dist[i] / 100);
         }
+
+        xPos[i] = gEnvFxBubbleConfig[ENVFX_STATE_SRC_X] + sins(angle[i]) * dist[i];
+        yPos[i] = bubbleY[i];
+        zPos[i] = gEnvFxBubbleConfig[ENVFX_STATE_SRC_Z] + coss(angle[i]) * dist[i];
+        envfx_rotate_around_whirlpool(&xPos[i], &yPos[i], &zPos[i]);
     }
 }
 
@@ -270,7 +259,7 @@ s32 envfx_is_jestream_bubble_alive(s32 index) {
 
     if (!particle_is_laterally_close(index, gEnvFxBubbleConfig[ENVFX_STATE_SRC_X],
                                      gEnvFxBubbleConfig[ENVFX_STATE_SRC_Z], 1000)
-        || gEnvFxBubbleConfig[ENVFX_STATE_SRC_Y] + 1500 < (gEnvFxBuffer + index)->yPos) {
+        || gEnvFxBubbleConfig[ENVFX_STATE_SRC_Y] + 1500 < gEnvFxParticles.yPos[index]) {
         return FALSE;
     }
 
@@ -283,25 +272,24 @@ s32 envfx_is_jestream_bubble_alive(s32 index) {
  */
 void envfx_update_jetstream(void) {
     s32 i;
+    s32 *xPos = gEnvFxParticles.xPos;
+    s32 *yPos = gEnvFxParticles.yPos;
+    s32 *zPos = gEnvFxParticles.zPos;
+    s32 *angle = gEnvFxParticles.angle;
+    s32 *dist = gEnvFxParticles.dist;
 
     for (i = 0; i < sBubbleParticleMaxCount; i++) {
-        (gEnvFxBuffer + i)->isAlive = envfx_is_jestream_bubble_alive(i);
-        if (!(gEnvFxBuffer + i)->isAlive) {
-            (gEnvFxBuffer + i)->angleAndDist[1] = random_float() * 300.0f;
-            (gEnvFxBuffer + i)->angleAndDist[0] = random_u16();
-            (gEnvFxBuffer + i)->xPos =
-                gEnvFxBubbleConfig[ENVFX_STATE_SRC_X]
-                + sins((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
-            (gEnvFxBuffer + i)->zPos =
-                gEnvFxBubbleConfig[ENVFX_STATE_SRC_Z]
-                + coss((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
-            (gEnvFxBuffer + i)->yPos =
-                gEnvFxBubbleConfig[ENVFX_STATE_SRC_Y] + (random_float() * 400.0f - 200.0f);
+        if (!envfx_is_jestream_bubble_alive(i)) {
+            dist[i] = random_float() * 300.0f;
+            angle[i] = random_u16();
+            xPos[i] = gEnvFxBubbleConfig[ENVFX_STATE_SRC_X] + sins(angle[i]) * dist[i];
+            zPos[i] = gEnvFxBubbleConfig[ENVFX_STATE_SRC_Z] + coss(angle[i]) * dist[i];
+            yPos[i] = gEnvFxBubbleConfig[ENVFX_STATE_SRC_Y] + (random_float() * 400.0f - 200.0f);
         } else {
-            (gEnvFxBuffer + i)->angleAndDist[1] += 10;
-            (gEnvFxBuffer + i)->xPos += sins((gEnvFxBuffer + i)->angleAndDist[0]) * 10.0f;
-            (gEnvFxBuffer + i)->zPos += coss((gEnvFxBuffer + i)->angleAndDist[0]) * 10.0f;
-            (gEnvFxBuffer + i)->yPos -= ((gEnvFxBuffer + i)->angleAndDist[1] / 30) - 50;
+            dist[i] += 10;
+            xPos[i] += sins(angle[i]) * 10.0f;
+            zPos[i] += coss(angle[i]) * 10.0f;
+            yPos[i] -= (dist[i] / 30) - 50;
         }
     }
 }
@@ -337,19 +325,16 @@ s32 envfx_init_bubble(s32 mode) {
             break;
     }
 
-    gEnvFxBuffer = mem_pool_alloc(gEffectsMemoryPool,
-                                  sBubbleParticleCount * sizeof(struct EnvFxParticle));
-    if (gEnvFxBuffer == NULL) {
+    if (!envfx_alloc_particles(sBubbleParticleCount)) {
         return FALSE;
     }
 
-    bzero(gEnvFxBuffer, sBubbleParticleCount * sizeof(struct EnvFxParticle));
     bzero(gEnvFxBubbleConfig, sizeof(gEnvFxBubbleConfig));
 
     switch (mode) {
         case ENVFX_LAVA_BUBBLES:
             for (i = 0; i < sBubbleParticleCount; i++) {
-                (gEnvFxBuffer + i)->animFrame = random_float() * 7.0f;
+                gEnvFxParticles.animFrame[i] = random_float() * 7.0f;
             }
             break;
     }
@@ -396,57 +381,50 @@ void envfx_bubbles_update_switch(s32 mode, Vec3s camTo, Vec3s vertex1, Vec3s ver
 }
 
 /**
- * Append 15 vertices to 'gfx', which is enough for 5 bubbles starting at
- * 'index'. The 3 input vertices represent the rotated triangle around (0,0,0)
- * that will be translated to bubble positions to draw the bubble image
+ * Return how many animation frames particles of the given mode can be in.
+ * Particles are drawn grouped by frame so that each texture is loaded once.
  */
-void append_bubble_vertex_buffer(Gfx *gfx, s32 index, Vec3s vertex1, Vec3s vertex2, Vec3s vertex3,
-                                 Vtx *template) {
-    s32 i = 0;
-    Vtx *vertBuf = alloc_display_list(15 * sizeof(Vtx));
+s32 envfx_get_bubble_frame_count(s32 mode) {
+    switch (mode) {
+        case ENVFX_FLOWERS:
+            return 6;
 
-    if (vertBuf == NULL) {
-        return;
-    }
+        case ENVFX_LAVA_BUBBLES:
+            return 9;
 
-    for (i = 0; i < 15; i += 3) {
-        vertBuf[i] = template[0];
-        (vertBuf + i)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex1[0];
-        (vertBuf + i)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex1[1];
-        (vertBuf + i)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex1[2];
-
-        vertBuf[i + 1] = template[1];
-        (vertBuf + i + 1)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex2[0];
-        (vertBuf + i + 1)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex2[1];
-        (vertBuf + i + 1)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex2[2];
-
-        vertBuf[i + 2] = template[2];
-        (vertBuf + i + 2)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex3[0];
-        (vertBuf + i + 2)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex3[1];
-        (vertBuf + i + 2)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex3[2];
+        default:
+            return 1;
     }
+}
 
-    gSPVertex(gfx, VIRTUAL_TO_PHYSICAL(vertBuf), 15, 0);
+/**
+ * Return the animation frame the particle with the given index is drawn with.
+ * Vanilla draws particles in groups of 5 with the frame of the group's first
+ * particle, which ENVFX_PARTICLE_FRAMES replaces with the particle's own frame.
+ */
+s16 envfx_get_bubble_draw_frame(s32 index) {
+#ifdef ENVFX_PARTICLE_FRAMES
+    return gEnvFxParticles.animFrame[index];
+#else
+    return gEnvFxParticles.animFrame[index - index % 5];
+#endif
 }
 
 /**
- * Appends to the enfvx display list a command setting the appropriate texture
- * for a specific particle. The display list is not passed as parameter but uses
+ * Appends to the enfvx display list the commands loading the texture of an
+ * animation frame. The display list is not passed as parameter but uses
  * the global sGfxCursor instead.
  */
-void envfx_set_bubble_texture(s32 mode, s16 index) {
+void envfx_set_bubble_texture(s32 mode, s16 frame) {
     void **imageArr = NULL;
-    s16 frame = (gEnvFxBuffer + index)->animFrame;
 
     switch (mode) {
         case ENVFX_FLOWERS:
             imageArr = segmented_to_virtual(&flower_bubbles_textures_ptr_0B002008);
-            frame = (gEnvFxBuffer + index)->animFrame;
             break;
 
         case ENVFX_LAVA_BUBBLES:
             imageArr = segmented_to_virtual(&lava_bubble_ptr_0B006020);
-            frame = (gEnvFxBuffer + index)->animFrame;
             break;
 
         case ENVFX_WHIRLPOOL_BUBBLES:
@@ -462,39 +440,64 @@ void envfx_set_bubble_texture(s32 mode, s16 index) {
 
 /**
  * Updates the bubble particle positions, then generates and returns a display
- * list drawing them.
+ * list drawing the ones that are in view.
  */
 Gfx *envfx_update_bubble_particles(s32 mode, UNUSED Vec3s marioPos, Vec3s camFrom, Vec3s camTo) {
     s32 i;
     s16 radius, pitch, yaw;
+    s16 frame;
+    s32 numFrames = envfx_get_bubble_frame_count(mode);
+    s16 visible[ENVFX_MAX_PARTICLES];
+    s16 batch[ENVFX_MAX_PARTICLES];
+    s32 numVisible = 0;
+    s32 batchSize;
+    f32 cullRadius;
+    Vtx *vertBuf;
+    Gfx *gfxStart;
 
     Vec3s vertex1;
     Vec3s vertex2;
     Vec3s vertex3;
 
-    Gfx *gfxStart = alloc_display_list(((sBubbleParticleMaxCount / 5) * 10 + sBubbleParticleMaxCount + 3)
-                                       * sizeof(Gfx));
-    if (gfxStart == NULL) {
+    orbit_from_positions(camTo, camFrom, &radius, &pitch, &yaw);
+    envfx_bubbles_update_switch(mode, camTo, vertex1, vertex2, vertex3);
+
+    // The triangle spans from vertex3 to vertex1 and up to vertex2
+    cullRadius = MAX(vertex1[0], vertex2[1]);
+    rotate_triangle_vertices(vertex1, vertex2, vertex3, pitch, yaw);
+
+    envfx_set_view_cone(camFrom, camTo);
+    for (i = 0; i < sBubbleParticleMaxCount; i++) {
+        if (envfx_particle_in_view(i, cullRadius)) {
+            visible[numVisible++] = i;
+        }
+    }
+
+    vertBuf = alloc_display_list(numVisible * 3 * sizeof(Vtx));
+    gfxStart = alloc_display_list((numVisible * 2 + numFrames * 3 + 3) * sizeof(Gfx));
+    if (vertBuf == NULL || gfxStart == NULL) {
         return NULL;
     }
 
     sGfxCursor = gfxStart;
 
-    orbit_from_positions(camTo, camFrom, &radius, &pitch, &yaw);
-    envfx_bubbles_update_switch(mode, camTo, vertex1, vertex2, vertex3);
-    rotate_triangle_vertices(vertex1, vertex2, vertex3, pitch, yaw);
-
     gSPDisplayList(sGfxCursor++, &tiny_bubble_dl_0B006D38);
 
-    for (i = 0; i < sBubbleParticleMaxCount; i += 5) {
-        gDPPipeSync(sGfxCursor++);
-        envfx_set_bubble_texture(mode, i);
-        append_bubble_vertex_buffer(sGfxCursor++, i, vertex1, vertex2, vertex3, (Vtx *) gBubbleTempVtx);
-        gSP1Triangle(sGfxCursor++, 0, 1, 2, 0);
-        gSP1Triangle(sGfxCursor++, 3, 4, 5, 0);
-        gSP1Triangle(sGfxCursor++, 6, 7, 8, 0);
-        gSP1Triangle(sGfxCursor++, 9, 10, 11, 0);
-        gSP1Triangle(sGfxCursor++, 12, 13, 14, 0);
+    for (frame = 0; frame < numFrames; frame++) {
+        batchSize = 0;
+        for (i = 0; i < numVisible; i++) {
+            if (numFrames == 1 || envfx_get_bubble_draw_frame(visible[i]) == frame) {
+                batch[batchSize++] = visible[i];
+            }
+        }
+
+        if (batchSize != 0) {
+            gDPPipeSync(sGfxCursor++);
+            envfx_set_bubble_texture(mode, frame);
+            sGfxCursor = envfx_append_particle_batches(sGfxCursor, vertBuf, batch, batchSize, vertex1,
+                                                       vertex2, vertex3, (Vtx *) gBubbleTempVtx);
+            vertBuf += batchSize * 3;
+        }
     }
 
     gSPDisplayList(sGfxCursor++, &tiny_bubble_dl_0B006AB0);
@@ -505,7 +508,8 @@ Gfx *envfx_update_bubble_particles(s32 mode, UNUSED Vec3s marioPos, Vec3s camFro
 
 /**
  * Set the maximum particle count from the gEnvFxBubbleConfig variable,
- * which is set by the whirlpool or jet stream behavior.
+ * which is set by the whirlpool or jet stream behavior. It is limited to
+ * the number of particles the buffer was allocated for.
  */
 void envfx_set_max_bubble_particles(s32 mode) {
     switch (mode) {
@@ -516,6 +520,10 @@ void envfx_set_max_bubble_particles(s32 mode) {
             sBubbleParticleMaxCount = gEnvFxBubbleConfig[ENVFX_STATE_PARTICLECOUNT];
             break;
     }
+
+    if (sBubbleParticleMaxCount > gEnvFxParticleCapacity) {
+        sBubbleParticleMaxCount = gEnvFxParticleCapacity;
+    }
 }
 
 /**
@@ -12,6 +12,7 @@
 #include "engine/behavior_script.h"
 #include "audio/external.h"
 #include "obj_behaviors.h"
+#include "rendering_graph_node.h"
 
 /**
  * This file contains the function that handles 'environment effects',
@@ -32,7 +33,9 @@ struct SnowFlakeVertex {
     s16 z;
 };
 
-struct EnvFxParticle *gEnvFxBuffer;
+void *gEnvFxBuffer;
+struct EnvFxParticles gEnvFxParticles;
+s32 gEnvFxParticleCapacity;
 Vec3i gSnowCylinderLastPos;
 s16 gSnowParticleCount;
 s16 gSnowParticleMaxCount;
@@ -55,6 +58,48 @@ extern void *tiny_bubble_dl_0B006AB0;
 extern void *tiny_bubble_dl_0B006A50;
 extern void *tiny_bubble_dl_0B006CD8;
 
+/**
+ * A cone around the camera's line of sight that encloses the whole screen.
+ * Particles outside of it are not drawn. Unlike a frustum, a cone doesn't
+ * depend on the camera roll.
+ */
+struct EnvFxViewCone {
+    Vec3f pos;
+    Vec3f dir; // unit vector towards camTo
+    f32 tanHalfAngle;
+    f32 secHalfAngle;
+    s32 enabled;
+};
+
+static struct EnvFxViewCone sEnvFxViewCone;
+
+/**
+ * Allocate the particle buffer for 'count' particles and point the arrays of
+ * gEnvFxParticles into it. All particle state starts out zeroed.
+ */
+s32 envfx_alloc_particles(s32 count) {
+    u32 size = count * (6 * sizeof(s32) + sizeof(s16) + sizeof(s8));
+    struct EnvFxParticles *particles = &gEnvFxParticles;
+
+    gEnvFxBuffer = mem_pool_alloc(gEffectsMemoryPool, size);
+    if (gEnvFxBuffer == NULL) {
+        return FALSE;
+    }
+
+    bzero(gEnvFxBuffer, size);
+
+    particles->xPos = gEnvFxBuffer;
+    particles->yPos = particles->xPos + count;
+    particles->zPos = particles->yPos + count;
+    particles->angle = particles->zPos + count;
+    particles->dist = particles->angle + count;
+    particles->bubbleY = particles->dist + count;
+    particles->animFrame = (s16 *) (particles->bubbleY + count);
+    particles->isAlive = (s8 *) (particles->animFrame + count);
+    gEnvFxParticleCapacity = count;
+    return TRUE;
+}
+
 /**
  * Initialize snow particles by allocating a buffer for storing their state
  * and setting a start amount.
@@ -80,14 +125,10 @@ s32 envfx_init_snow(s32 mode) {
             break;
     }
 
-    gEnvFxBuffer = mem_pool_alloc(gEffectsMemoryPool,
-                                  gSnowParticleMaxCount * sizeof(struct EnvFxParticle));
-    if (gEnvFxBuffer == NULL) {
+    if (!envfx_alloc_particles(gSnowParticleMaxCount)) {
         return FALSE;
     }
 
-    bzero(gEnvFxBuffer, gSnowParticleMaxCount * sizeof(struct EnvFxParticle));
-
     gEnvFxMode = mode;
     return TRUE;
 }
@@ -175,9 +216,9 @@ void pos_from_orbit(Vec3s origin, Vec3s result, s16 radius, s16 pitch, s16 yaw)
  * x, y and z.
  */
 s32 envfx_is_snowflake_alive(s32 index, s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ) {
-    s32 x = (gEnvFxBuffer + index)->xPos;
-    s32 y = (gEnvFxBuffer + index)->yPos;
-    s32 z = (gEnvFxBuffer + index)->zPos;
+    s32 x = gEnvFxParticles.xPos[index];
+    s32 y = gEnvFxParticles.yPos[index];
+    s32 z = gEnvFxParticles.zPos[index];
 
     if (sqr(x - snowCylinderX) + sqr(z - snowCylinderZ) > sqr(300)) {
         return FALSE;
@@ -203,27 +244,32 @@ s32 envfx_is_snowflake_alive(s32 index, s32 snowCylinderX, s32 snowCylinderY, s3
  * but appears to be further by means of hacky position updates. This might
  * have been done because larger, further away snowflakes are occluded easily
  * by level geometry, wasting many particles.
+ * The spawn offset and drift are the same for every flake, so they are only
+ * computed once per frame.
  */
 void envfx_update_snow_normal(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ) {
     s32 i;
+    s32 *xPos = gEnvFxParticles.xPos;
+    s32 *yPos = gEnvFxParticles.yPos;
+    s32 *zPos = gEnvFxParticles.zPos;
     s32 deltaX = snowCylinderX - gSnowCylinderLastPos[0];
     s32 deltaY = snowCylinderY - gSnowCylinderLastPos[1];
     s32 deltaZ = snowCylinderZ - gSnowCylinderLastPos[2];
+    s16 spawnOffsetX = deltaX * 2;
+    s16 spawnOffsetZ = deltaZ * 2;
+    s16 driftX = deltaX / 1.2;
+    s16 driftZ = deltaZ / 1.2;
+    s32 fallSpeed = 2 - (s16)(deltaY * 0.8);
 
     for (i = 0; i < gSnowParticleCount; i++) {
-        (gEnvFxBuffer + i)->isAlive =
-            envfx_is_snowflake_alive(i, snowCylinderX, snowCylinderY, snowCylinderZ);
-        if (!(gEnvFxBuffer + i)->isAlive) {
-            (gEnvFxBuffer + i)->xPos =
-                400.0f * random_float() - 200.0f + snowCylinderX + (s16)(deltaX * 2);
-            (gEnvFxBuffer + i)->zPos =
-                400.0f * random_float() - 200.0f + snowCylinderZ + (s16)(deltaZ * 2);
-            (gEnvFxBuffer + i)->yPos = 200.0f * random_float() + snowCylinderY;
-            (gEnvFxBuffer + i)->isAlive = TRUE;
+        if (!envfx_is_snowflake_alive(i, snowCylinderX, snowCylinderY, snowCylinderZ)) {
+            xPos[i] = 400.0f * random_float() - 200.0f + snowCylinderX + spawnOffsetX;
+            zPos[i] = 400.0f * random_float() - 200.0f + snowCylinderZ + spawnOffsetZ;
+            yPos[i] = 200.0f * random_float() + snowCylinderY;
         } else {
-            (gEnvFxBuffer + i)->xPos += random_float() * 2 - 1.0f + (s16)(deltaX / 1.2);
-            (gEnvFxBuffer + i)->yPos -= 2 -(s16)(deltaY * 0.8);
-            (gEnvFxBuffer + i)->zPos += random_float() * 2 - 1.0f + (s16)(deltaZ / 1.2);
+            xPos[i] += random_float() * 2 - 1.0f + driftX;
+            yPos[i] -= fallSpeed;
+            zPos[i] += random_float() * 2 - 1.0f + driftZ;
         }
     }
 
@@ -240,24 +286,27 @@ void envfx_update_snow_normal(s32 snowCylinderX, s32 snowCylinderY, s32 snowCyli
  */
 void envfx_update_snow_blizzard(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ) {
     s32 i;
+    s32 *xPos = gEnvFxParticles.xPos;
+    s32 *yPos = gEnvFxParticles.yPos;
+    s32 *zPos = gEnvFxParticles.zPos;
     s32 deltaX = snowCylinderX - gSnowCylinderLastPos[0];
     s32 deltaY = snowCylinderY - gSnowCylinderLastPos[1];
     s32 deltaZ = snowCylinderZ - gSnowCylinderLastPos[2];
+    s16 spawnOffsetX = deltaX * 2;
+    s16 spawnOffsetZ = deltaZ * 2;
+    s16 driftX = deltaX / 1.2;
+    s16 driftZ = deltaZ / 1.2;
+    s32 fallSpeed = 5 - (s16)(deltaY * 0.8);
 
     for (i = 0; i < gSnowParticleCount; i++) {
-        (gEnvFxBuffer + i)->isAlive =
-            envfx_is_snowflake_alive(i, snowCylinderX, snowCylinderY, snowCylinderZ);
-        if (!(gEnvFxBuffer + i)->isAlive) {
-            (gEnvFxBuffer + i)->xPos =
-                400.0f * random_float() - 200.0f + snowCylinderX + (s16)(deltaX * 2);
-            (gEnvFxBuffer + i)->zPos =
-                400.0f * random_float() - 200.0f + snowCylinderZ + (s16)(deltaZ * 2);
-            (gEnvFxBuffer + i)->yPos = 400.0f * random_float() - 200.0f + snowCylinderY;
-            (gEnvFxBuffer + i)->isAlive = TRUE;
+        if (!envfx_is_snowflake_alive(i, snowCylinderX, snowCylinderY, snowCylinderZ)) {
+            xPos[i] = 400.0f * random_float() - 200.0f + snowCylinderX + spawnOffsetX;
+            zPos[i] = 400.0f * random_float() - 200.0f + snowCylinderZ + spawnOffsetZ;
+            yPos[i] = 400.0f * random_float() - 200.0f + snowCylinderY;
         } else {
-            (gEnvFxBuffer + i)->xPos += random_float() * 2 - 1.0f + (s16)(deltaX / 1.2) + 20.0f;
-            (gEnvFxBuffer + i)->yPos -= 5 -(s16)(deltaY * 0.8);
-            (gEnvFxBuffer + i)->zPos += random_float() * 2 - 1.0f + (s16)(deltaZ / 1.2);
+            xPos[i] += random_float() * 2 - 1.0f + driftX + 20.0f;
+            yPos[i] -= fallSpeed;
+            zPos[i] += random_float() * 2 - 1.0f + driftZ;
         }
     }
 
@@ -290,13 +339,10 @@ void envfx_update_snow_water(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylin
     s32 i;
 
     for (i = 0; i < gSnowParticleCount; i++) {
-        (gEnvFxBuffer + i)->isAlive =
-            envfx_is_snowflake_alive(i, snowCylinderX, snowCylinderY, snowCylinderZ);
-        if (!(gEnvFxBuffer + i)->isAlive) {
-            (gEnvFxBuffer + i)->xPos = 400.0f * random_float() - 200.0f + snowCylinderX;
-            (gEnvFxBuffer + i)->zPos = 400.0f * random_float() - 200.0f + snowCylinderZ;
-            (gEnvFxBuffer + i)->yPos = 400.0f * random_float() - 200.0f + snowCylinderY;
-            (gEnvFxBuffer + i)->isAlive = TRUE;
+        if (!envfx_is_snowflake_alive(i, snowCylinderX, snowCylinderY, snowCylinderZ)) {
+            gEnvFxParticles.xPos[i] = 400.0f * random_float() - 200.0f + snowCylinderX;
+            gEnvFxParticles.zPos[i] = 400.0f * random_float() - 200.0f + snowCylinderZ;
+            gEnvFxParticles.yPos[i] = 400.0f * random_float() - 200.0f + snowCylinderY;
         }
     }
 }
@@ -339,48 +385,135 @@ void rotate_triangle_vertices(Vec3s vertex1, Vec3s vertex2, Vec3s vertex3, s16 p
 }
 
 /**
- * Append 15 vertices to 'gfx', which is enough for 5 snowflakes starting at
- * 'index' in the buffer. The 3 input vertices represent the rotated triangle
- * around (0,0,0) that will be translated to snowflake positions to draw the
- * snowflake image.
+ * Set up the view cone for envfx_particle_in_view from the camera position,
+ * its focus and the fov of the current frustum.
  */
-void append_snowflake_vertex_buffer(Gfx *gfx, s32 index, Vec3s vertex1, Vec3s vertex2, Vec3s vertex3) {
-    s32 i = 0;
-    Vtx *vertBuf = (Vtx *) alloc_display_list(15 * sizeof(Vtx));
-
-    if (vertBuf == NULL) {
+void envfx_set_view_cone(Vec3s camFrom, Vec3s camTo) {
+    struct EnvFxViewCone *cone = &sEnvFxViewCone;
+    f32 dx = camTo[0] - camFrom[0];
+    f32 dy = camTo[1] - camFrom[1];
+    f32 dz = camTo[2] - camFrom[2];
+    f32 dist = sqrtf(dx * dx + dy * dy + dz * dz);
+    f32 tanHalfFovY;
+    f32 tanHalfFovX;
+    s16 halfFov;
+
+    // Without a frustum or a view direction, draw everything
+    cone->enabled = gCurGraphNodeCamFrustum != NULL && dist >= 1.0f;
+    if (!cone->enabled) {
         return;
     }
 
-    for (i = 0; i < 15; i += 3) {
-        vertBuf[i] = gSnowTempVtx[0];
-        (vertBuf + i)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex1[0];
-        (vertBuf + i)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex1[1];
-        (vertBuf + i)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex1[2];
-
-        vertBuf[i + 1] = gSnowTempVtx[1];
-        (vertBuf + i + 1)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex2[0];
-        (vertBuf + i + 1)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex2[1];
-        (vertBuf + i + 1)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex2[2];
-
-        vertBuf[i + 2] = gSnowTempVtx[2];
-        (vertBuf + i + 2)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex3[0];
-        (vertBuf + i + 2)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex3[1];
-        (vertBuf + i + 2)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex3[2];
+    // The frustum fov is vertical, the screen is SCREEN_WIDTH / SCREEN_HEIGHT
+    // times as wide. The cone goes through the corners of the screen.
+    halfFov = gCurGraphNodeCamFrustum->fov / 2.0f * 32768.0f / 180.0f + 0.5f;
+    tanHalfFovY = sins(halfFov) / coss(halfFov);
+    tanHalfFovX = tanHalfFovY * SCREEN_WIDTH / SCREEN_HEIGHT;
+
+    cone->pos[0] = camFrom[0];
+    cone->pos[1] = camFrom[1];
+    cone->pos[2] = camFrom[2];
+    cone->dir[0] = dx / dist;
+    cone->dir[1] = dy / dist;
+    cone->dir[2] = dz / dist;
+    cone->tanHalfAngle = sqrtf(tanHalfFovX * tanHalfFovX + tanHalfFovY * tanHalfFovY);
+    cone->secHalfAngle = sqrtf(1.0f + cone->tanHalfAngle * cone->tanHalfAngle);
+}
+
+/**
+ * Check whether any part of a particle, given as a sphere with the given
+ * radius around its position, can be inside the view cone.
+ */
+s32 envfx_particle_in_view(s32 index, f32 radius) {
+    struct EnvFxViewCone *cone = &sEnvFxViewCone;
+    f32 dx, dy, dz;
+    f32 depth;
+    f32 edge;
+
+    if (!cone->enabled) {
+        return TRUE;
+    }
+
+    dx = gEnvFxParticles.xPos[index] - cone->pos[0];
+    dy = gEnvFxParticles.yPos[index] - cone->pos[1];
+    dz = gEnvFxParticles.zPos[index] - cone->pos[2];
+
+    // 'edge' is the furthest the particle can be from the line of sight at
+    // this depth and still touch the cone.
+    depth = dx * cone->dir[0] + dy * cone->dir[1] + dz * cone->dir[2];
+    edge = depth * cone->tanHalfAngle + radius * cone->secHalfAngle;
+    if (edge < 0.0f) {
+        return FALSE;
+    }
+
+    return dx * dx + dy * dy + dz * dz - depth * depth <= edge * edge;
+}
+
+/**
+ * Append the particles listed in 'indices' to 'gfx' as triangles. The 3 input
+ * vertices represent the rotated triangle around (0,0,0) that is translated to
+ * each particle position, and 'template' holds their texture coordinates and
+ * colors. 'vertBuf' needs room for 3 vertices per particle. Particles are
+ * loaded ENVFX_BATCH_PARTICLES at a time with one gSPVertex each.
+ * Returns the new end of the display list, which grows by at most one command
+ * per batch plus one per particle.
+ */
+Gfx *envfx_append_particle_batches(Gfx *gfx, Vtx *vertBuf, s16 *indices, s32 count, Vec3s vertex1,
+                                   Vec3s vertex2, Vec3s vertex3, Vtx *template) {
+    s32 *xPos = gEnvFxParticles.xPos;
+    s32 *yPos = gEnvFxParticles.yPos;
+    s32 *zPos = gEnvFxParticles.zPos;
+    Vtx *vtx = vertBuf;
+    s32 batchSize;
+    s32 i, j;
+
+    for (i = 0; i < count; i += batchSize) {
+        batchSize = MIN(count - i, ENVFX_BATCH_PARTICLES);
+
+        for (j = 0; j < batchSize; j++, vtx += 3) {
+            s32 index = indices[i + j];
+
+            vtx[0] = template[0];
+            vtx[0].v.ob[0] = xPos[index] + vertex1[0];
+            vtx[0].v.ob[1] = yPos[index] + vertex1[1];
+            vtx[0].v.ob[2] = zPos[index] + vertex1[2];
+
+            vtx[1] = template[1];
+            vtx[1].v.ob[0] = xPos[index] + vertex2[0];
+            vtx[1].v.ob[1] = yPos[index] + vertex2[1];
+            vtx[1].v.ob[2] = zPos[index] + vertex2[2];
+
+            vtx[2] = template[2];
+            vtx[2].v.ob[0] = xPos[index] + vertex3[0];
+            vtx[2].v.ob[1] = yPos[index] + vertex3[1];
+            vtx[2].v.ob[2] = zPos[index] + vertex3[2];
+        }
+
+        gSPVertex(gfx++, VIRTUAL_TO_PHYSICAL(vertBuf + i * 3), batchSize * 3, 0);
+
+        for (j = 0; j + 1 < batchSize; j += 2) {
+            gSP2Triangles(gfx++, j * 3, j * 3 + 1, j * 3 + 2, 0, j * 3 + 3, j * 3 + 4, j * 3 + 5, 0);
+        }
+        if (j < batchSize) {
+            gSP1Triangle(gfx++, j * 3, j * 3 + 1, j * 3 + 2, 0);
+        }
     }
 
-    gSPVertex(gfx, VIRTUAL_TO_PHYSICAL(vertBuf), 15, 0);
+    return gfx;
 }
 
 /**
  * Updates positions of snow particles and returns a pointer to a display list
- * drawing all snowflakes.
+ * drawing the snowflakes that are in view.
  */
 Gfx *envfx_update_snow(s32 snowMode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo) {
     s32 i;
     s16 radius, pitch, yaw;
     Vec3s snowCylinderPos;
     struct SnowFlakeVertex vertex1, vertex2, vertex3;
+    s16 visible[ENVFX_MAX_PARTICLES];
+    s32 numVisible = 0;
+    Vtx *vertBuf;
     Gfx *gfxStart;
     Gfx *gfx;
 
@@ -388,13 +521,6 @@ Gfx *envfx_update_snow(s32 snowMode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo)
     vertex2 = gSnowFlakeVertex2;
     vertex3 = gSnowFlakeVertex3;
 
-    gfxStart = (Gfx *) alloc_display_list((gSnowParticleCount * 6 + 3) * sizeof(Gfx));
-    gfx = gfxStart;
-
-    if (gfxStart == NULL) {
-        return NULL;
-    }
-
     envfx_update_snowflake_count(snowMode, marioPos);
 
     // Note: to and from are inverted here, so the resulting vector goes towards the camera
@@ -438,21 +564,30 @@ Gfx *envfx_update_snow(s32 snowMode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo)
 
     rotate_triangle_vertices((s16 *) &vertex1, (s16 *) &vertex2, (s16 *) &vertex3, pitch, yaw);
 
+    // Flakes are 10 units wide, so any that touch the screen are within 8 units
+    envfx_set_view_cone(camFrom, camTo);
+    for (i = 0; i < gSnowParticleCount; i++) {
+        if (envfx_particle_in_view(i, 8.0f)) {
+            visible[numVisible++] = i;
+        }
+    }
+
+    vertBuf = alloc_display_list(numVisible * 3 * sizeof(Vtx));
+    gfxStart = alloc_display_list((numVisible * 2 + 3) * sizeof(Gfx));
+    gfx = gfxStart;
+
+    if (vertBuf == NULL || gfxStart == NULL) {
+        return NULL;
+    }
+
     if (snowMode == ENVFX_SNOW_NORMAL || snowMode == ENVFX_SNOW_BLIZZARD) {
         gSPDisplayList(gfx++, &tiny_bubble_dl_0B006A50); // snowflake with gray edge
     } else if (snowMode == ENVFX_SNOW_WATER) {
         gSPDisplayList(gfx++, &tiny_bubble_dl_0B006CD8); // snowflake with blue edge
     }
 
-    for (i = 0; i < gSnowParticleCount; i += 5) {
-        append_snowflake_vertex_buffer(gfx++, i, (s16 *) &vertex1, (s16 *) &vertex2, (s16 *) &vertex3);
-
-        gSP1Triangle(gfx++, 0, 1, 2, 0);
-        gSP1Triangle(gfx++, 3, 4, 5, 0);
-        gSP1Triangle(gfx++, 6, 7, 8, 0);
-        gSP1Triangle(gfx++, 9, 10, 11, 0);
-        gSP1Triangle(gfx++, 12, 13, 14, 0);
-    }
+    gfx = envfx_append_particle_batches(gfx, vertBuf, visible, numVisible, (s16 *) &vertex1,
+                                        (s16 *) &vertex2, (s16 *) &vertex3, gSnowTempVtx);
 
     gSPDisplayList(gfx++, &tiny_bubble_dl_0B006AB0) gSPEndDisplayList(gfx++);
 
@@ -16,27 +16,48 @@
 #define ENVFX_WHIRLPOOL_BUBBLES 13 // DDD
 #define ENVFX_JETSTREAM_BUBBLES 14 // JRB, DDD (submarine area)
 
-struct EnvFxParticle {
-    s8 isAlive;
-    s16 animFrame; // lava bubbles and flowers have frame animations
-    s32 xPos;
-    s32 yPos;
-    s32 zPos;
-    s32 angleAndDist[2]; // for whirpools, [0] = angle from center, [1] = distance from center
-    s32 unusedBubbleVar; // set to zero for bubbles when respawning, never used elsewhere
-    s32 bubbleY; // for Bubbles, yPos is always set to this
-    u8 filler[24];
+// The largest particle count of any mode, used to size per-frame index lists
+#define ENVFX_MAX_PARTICLES 140
+
+// Particles drawn per gSPVertex, limited by the size of the RSP vertex cache
+#ifdef F3DEX_GBI_SHARED
+#define ENVFX_BATCH_PARTICLES 10
+#else
+#define ENVFX_BATCH_PARTICLES 5
+#endif
+
+/**
+ * State of the environment effect particles, with one array per field so that
+ * the update and vertex loops only read the fields they use. All arrays share
+ * one allocation from gEffectsMemoryPool, made by envfx_alloc_particles.
+ */
+struct EnvFxParticles {
+    s32 *xPos;
+    s32 *yPos;
+    s32 *zPos;
+    s32 *angle; // for bubbles, angle around the source
+    s32 *dist; // for bubbles, distance from the source
+    s32 *bubbleY; // for whirlpool bubbles, yPos before rotating around the whirlpool
+    s16 *animFrame; // lava bubbles and flowers have frame animations
+    s8 *isAlive;
 };
 
 extern s8 gEnvFxMode;
 extern UNUSED s32 D_80330644;
 
-extern struct EnvFxParticle *gEnvFxBuffer;
+extern void *gEnvFxBuffer;
+extern struct EnvFxParticles gEnvFxParticles;
+extern s32 gEnvFxParticleCapacity;
 extern Vec3i gSnowCylinderLastPos;
 extern s16 gSnowParticleCount;
 
 Gfx *envfx_update_particles(s32 mode, Vec3s marioPos, Vec3s camTo, Vec3s camFrom);
 void orbit_from_positions(Vec3s from, Vec3s to, s16 *radius, s16 *pitch, s16 *yaw);
 void rotate_triangle_vertices(Vec3s vertex1, Vec3s vertex2, Vec3s vertex3, s16 pitch, s16 yaw);
+s32 envfx_alloc_particles(s32 count);
+void envfx_set_view_cone(Vec3s camFrom, Vec3s camTo);
+s32 envfx_particle_in_view(s32 index, f32 radius);
+Gfx *envfx_append_particle_batches(Gfx *gfx, Vtx *vertBuf, s16 *indices, s32 count, Vec3s vertex1,
+                                   Vec3s vertex2, Vec3s vertex3, Vtx *template);
 
 #endif // ENVFX_SNOW_H
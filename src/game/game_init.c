@@ -20,6 +20,8 @@
 #include "segment2.h"
 #include "segment_symbols.h"
 #include "rumble_init.h"
+#include "level_prefetch.h"
+#include "demo_bench.h"
 #ifdef HVQM
 #include <hvqm/hvqm.h>
 #endif
@@ -30,6 +32,7 @@
 #include "usb/usb.h"
 #include "usb/debug.h"
 #endif
+#include "usb/trace.h"
 #include <prevent_bss_reordering.h>
 
 // First 3 controller slots
@@ -437,6 +440,15 @@ void select_gfx_pool(void) {
  * - Selects which framebuffer will be rendered and displayed to next time.
  */
 void display_and_vsync(void) {
+#ifdef DEMO_BENCH
+    // Display lists are built but never run, and frames aren't paced.
+    if (gGoddardVblankCallback != NULL) {
+        gGoddardVblankCallback();
+        gGoddardVblankCallback = NULL;
+    }
+    gGlobalTimer++;
+    return;
+#endif
     profiler_log_thread5_time(BEFORE_DISPLAY_LISTS);
     osRecvMesg(&gGfxVblankQueue, &gMainReceivedMesg, OS_MESG_BLOCK);
     if (gGoddardVblankCallback != NULL) {
@@ -596,6 +608,10 @@ void run_demo_inputs(void) {
 void read_controller_inputs(void) {
     s32 i;
 
+#ifdef DEMO_BENCH
+    // Only demos drive the game; between them the controller is left idle.
+    bzero(gControllerPads, sizeof(gControllerPads));
+#else
     // If any controllers are plugged in, update the controller information.
     if (gControllerBits) {
         osRecvMesg(&gSIEventMesgQueue, &gMainReceivedMesg, OS_MESG_BLOCK);
@@ -604,6 +620,7 @@ void read_controller_inputs(void) {
         release_rumble_pak_control();
 #endif
     }
+#endif
     run_demo_inputs();
 
     for (i = 0; i < 2; i++) {
@@ -732,6 +749,12 @@ void thread5_game_loop(UNUSED void *arg) {
 #endif
 #ifdef HVQM
     createHvqmThread();
+#endif
+#ifdef USE_LEVEL_PREFETCH
+    create_thread_10();
+#endif
+#ifdef SAVE_WRITE_THREAD
+    create_thread_11();
 #endif
     save_file_load_all();
 
@@ -745,28 +768,53 @@ void thread5_game_loop(UNUSED void *arg) {
     render_init();
 
     while (TRUE) {
+#ifdef SAVE_WRITE_THREAD
+        // Saves made while the save thread was busy are written once it is idle, even when resetting.
+        save_file_flush_update();
+#endif
         // If the reset timer is active, run the process to reset the game.
         if (gResetTimer != 0) {
             draw_reset_bars();
             continue;
         }
         profiler_log_thread5_time(THREAD5_START);
+        TRACE_BEGIN(TRACE_ID_GAME_LOOP);
 
         // If any controllers are plugged in, start read the data for when
         // read_controller_inputs is called later.
+#ifndef DEMO_BENCH
         if (gControllerBits) {
 #if ENABLE_RUMBLE
             block_until_rumble_pak_free();
 #endif
             osContStartReadData(&gSIEventMesgQueue);
         }
+#endif
 
+        TRACE_BEGIN(TRACE_ID_AUDIO_TICK);
+        DEMO_BENCH_BEGIN(DEMO_BENCH_AUDIO);
+        PROFILER_BEGIN(PROFILER_SCOPE_AUDIO);
         audio_game_loop_tick();
+        PROFILER_END(PROFILER_SCOPE_AUDIO);
+        DEMO_BENCH_END(DEMO_BENCH_AUDIO);
+        TRACE_END(TRACE_ID_AUDIO_TICK);
         select_gfx_pool();
+        TRACE_BEGIN(TRACE_ID_READ_CONTROLLERS);
         read_controller_inputs();
+        TRACE_END(TRACE_ID_READ_CONTROLLERS);
+        TRACE_BEGIN(TRACE_ID_LEVEL_SCRIPT);
         addr = level_script_execute(addr);
+        TRACE_END(TRACE_ID_LEVEL_SCRIPT);
+        TRACE_COUNTER(TRACE_ID_GFX_POOL_FREE, gGfxPoolEnd - (u8 *) gDisplayListHead);
 
+        TRACE_BEGIN(TRACE_ID_DISPLAY_VSYNC);
         display_and_vsync();
+        TRACE_END(TRACE_ID_DISPLAY_VSYNC);
+        TRACE_END(TRACE_ID_GAME_LOOP);
+        TRACE_FLUSH();
+#ifdef DEMO_BENCH
+        demo_bench_frame();
+#endif
 
         // when debug info is enabled, print the "BUF %d" information.
         if (gShowDebugText) {
@@ -114,6 +114,144 @@ u8 gMenuHoldKeyIndex = 0;
 u8 gMenuHoldKeyTimer = 0;
 s32 gDialogResponse = DIALOG_RESPONSE_NONE;
 
+#ifdef TEXT_GFX_CACHE
+/**
+ * Cache of string display lists. The first time a string is printed somewhere,
+ * the commands the printer writes are copied into a cache entry, and the
+ * matrices it creates are allocated in the entry instead of the display list
+ * pool. While the same string keeps being printed at the same place, the
+ * printer only calls the entry's display list.
+ */
+
+// Strings with more characters than this are never cached.
+#define TEXT_GFX_CACHE_MAX_LENGTH 40
+#define TEXT_GFX_CACHE_GFX 128
+#define TEXT_GFX_CACHE_MTX 24
+
+// An entry may still be in use by the frame the RCP is drawing, so it is only
+// reused once it hasn't been printed for this many frames.
+#define TEXT_GFX_CACHE_MIN_AGE 2
+
+enum TextGfxPrinter {
+    TEXT_GFX_GENERIC,
+    TEXT_GFX_MENU,
+    TEXT_GFX_HUD // + hudLUT
+};
+
+struct TextGfxCacheEntry {
+    Gfx gfx[TEXT_GFX_CACHE_GFX];
+    Mtx mtx[TEXT_GFX_CACHE_MTX];
+    u32 lastUsed; // gGlobalTimer
+    s16 x;
+    s16 y;
+    s16 numMtx;
+    u8 printer;
+    u8 valid;
+    u8 str[TEXT_GFX_CACHE_MAX_LENGTH + 1];
+};
+
+static struct TextGfxCacheEntry sTextGfxCache[TEXT_GFX_CACHE_ENTRIES];
+static struct TextGfxCacheEntry *sTextGfxCapture = NULL;
+static Gfx *sTextGfxCaptureStart;
+static s32 sTextGfxCaptureFailed;
+
+static s32 text_gfx_cache_match(struct TextGfxCacheEntry *entry, const u8 *str, s32 length) {
+    s32 i;
+
+    for (i = 0; i < length; i++) {
+        if (entry->str[i] != str[i]) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Look up a string in the cache. If it is there, call its display list and
+ * return TRUE. Otherwise return FALSE, and start copying what the caller prints
+ * into an entry if the string can be cached.
+ */
+static s32 text_gfx_cache_begin(u8 printer, s16 x, s16 y, const u8 *str, u8 terminator) {
+    struct TextGfxCacheEntry *entry;
+    struct TextGfxCacheEntry *oldest = NULL;
+    s32 length = 0;
+    s32 i;
+
+    while (str[length] != terminator) {
+        if (++length > TEXT_GFX_CACHE_MAX_LENGTH) {
+            return FALSE;
+        }
+    }
+
+    for (i = 0; i < TEXT_GFX_CACHE_ENTRIES; i++) {
+        entry = &sTextGfxCache[i];
+        if (entry->valid && entry->printer == printer && entry->x == x && entry->y == y
+            && text_gfx_cache_match(entry, str, length + 1)) {
+            entry->lastUsed = gGlobalTimer;
+            gSPDisplayList(gDisplayListHead++, VIRTUAL_TO_PHYSICAL(entry->gfx));
+            return TRUE;
+        }
+
+        if (gGlobalTimer - entry->lastUsed >= TEXT_GFX_CACHE_MIN_AGE
+            && (oldest == NULL || entry->lastUsed < oldest->lastUsed)) {
+            oldest = entry;
+        }
+    }
+
+    if (oldest != NULL) {
+        oldest->valid = FALSE;
+        oldest->printer = printer;
+        oldest->x = x;
+        oldest->y = y;
+        oldest->numMtx = 0;
+        oldest->lastUsed = gGlobalTimer;
+        bcopy(str, oldest->str, length + 1);
+
+        sTextGfxCapture = oldest;
+        sTextGfxCaptureStart = gDisplayListHead;
+        sTextGfxCaptureFailed = FALSE;
+    }
+
+    return FALSE;
+}
+
+/**
+ * Finish copying a string's display list into its cache entry. If it didn't
+ * fit, the entry stays invalid and will be reused for another string.
+ */
+static void text_gfx_cache_end(void) {
+    struct TextGfxCacheEntry *entry = sTextGfxCapture;
+    s32 count;
+
+    if (entry == NULL) {
+        return;
+    }
+    sTextGfxCapture = NULL;
+
+    count = gDisplayListHead - sTextGfxCaptureStart;
+    if (!sTextGfxCaptureFailed && count < TEXT_GFX_CACHE_GFX) {
+        bcopy(sTextGfxCaptureStart, entry->gfx, count * sizeof(Gfx));
+        gSPEndDisplayList(&entry->gfx[count]);
+        entry->valid = TRUE;
+    }
+}
+#endif
+
+/**
+ * Allocate a matrix for one of the create_dl_*_matrix functions. While a string
+ * is being cached, its matrices are kept in the cache entry.
+ */
+static Mtx *alloc_menu_matrix(void) {
+#ifdef TEXT_GFX_CACHE
+    if (sTextGfxCapture != NULL) {
+        if (sTextGfxCapture->numMtx < TEXT_GFX_CACHE_MTX) {
+            return &sTextGfxCapture->mtx[sTextGfxCapture->numMtx++];
+        }
+        sTextGfxCaptureFailed = TRUE;
+    }
+#endif
+    return (Mtx *) alloc_display_list(sizeof(Mtx));
+}
 
 void create_dl_identity_matrix(void) {
     Mtx *matrix = (Mtx *) alloc_display_list(sizeof(Mtx));
@@ -136,7 +274,7 @@ void create_dl_identity_matrix(void) {
 }
 
 void create_dl_translation_matrix(s8 pushOp, f32 x, f32 y, f32 z) {
-    Mtx *matrix = (Mtx *) alloc_display_list(sizeof(Mtx));
+    Mtx *matrix = alloc_menu_matrix();
 
     if (matrix == NULL) {
         return;
@@ -154,7 +292,7 @@ void create_dl_translation_matrix(s8 pushOp, f32 x, f32 y, f32 z) {
 }
 
 void create_dl_rotation_matrix(s8 pushOp, f32 a, f32 x, f32 y, f32 z) {
-    Mtx *matrix = (Mtx *) alloc_display_list(sizeof(Mtx));
+    Mtx *matrix = alloc_menu_matrix();
 
     if (matrix == NULL) {
         return;
@@ -172,7 +310,7 @@ void create_dl_rotation_matrix(s8 pushOp, f32 a, f32 x, f32 y, f32 z) {
 }
 
 void create_dl_scale_matrix(s8 pushOp, f32 x, f32 y, f32 z) {
-    Mtx *matrix = (Mtx *) alloc_display_list(sizeof(Mtx));
+    Mtx *matrix = alloc_menu_matrix();
 
     if (matrix == NULL) {
         return;
@@ -209,18 +347,11 @@ void create_dl_ortho_matrix(void) {
 #if defined(VERSION_US) || defined(VERSION_EU)
 UNUSED
 #endif
-static u8 *alloc_ia8_text_from_i1(u16 *in, s16 width, s16 height) {
+static void unpack_ia8_text_from_i1(u16 *in, u8 *out, s16 width, s16 height) {
     s32 inPos;
     u16 bitMask;
-    u8 *out;
     s16 outPos = 0;
 
-    out = (u8 *) alloc_display_list((u32) width * (u32) height);
-
-    if (out == NULL) {
-        return NULL;
-    }
-
     for (inPos = 0; inPos < (width * height) / 16; inPos++) {
         bitMask = 0x8000;
 
@@ -235,16 +366,67 @@ static u8 *alloc_ia8_text_from_i1(u16 *in, s16 width, s16 height) {
             outPos++;
         }
     }
+}
+
+#if defined(VERSION_US) || defined(VERSION_EU) || defined(TEXT_GFX_CACHE)
+UNUSED
+#endif
+static u8 *alloc_ia8_text_from_i1(u16 *in, s16 width, s16 height) {
+    u8 *out = (u8 *) alloc_display_list((u32) width * (u32) height);
+
+    if (out == NULL) {
+        return NULL;
+    }
 
+    unpack_ia8_text_from_i1(in, out, width, height);
     return out;
 }
 
+#ifdef VERSION_EU
+static void unpack_ia4_tex_from_i1(u8 *in, u8 *out, s16 width, s16 height);
+#endif
+
+#if defined(TEXT_GFX_CACHE) && !defined(VERSION_US)
+#ifdef VERSION_EU
+#define FONT_GLYPH_SIZE (8 * 8)
+#else
+#define FONT_GLYPH_SIZE (8 * 16)
+#endif
+
+static ALIGNED8 u8 sFontGlyphs[256][FONT_GLYPH_SIZE];
+static u32 sFontGlyphsUnpacked[256 / 32];
+
+/**
+ * Return the unpacked texture of a dialog font character, unpacking it the
+ * first time it is drawn.
+ */
+static void *get_unpacked_font_glyph(u8 c) {
+    void **fontLUT;
+
+    if (!(sFontGlyphsUnpacked[c / 32] & (1 << (c % 32)))) {
+        fontLUT = segmented_to_virtual(main_font_lut);
+#ifdef VERSION_EU
+        unpack_ia4_tex_from_i1(segmented_to_virtual(fontLUT[c]), sFontGlyphs[c], 8, 8);
+#else
+        unpack_ia8_text_from_i1(segmented_to_virtual(fontLUT[c]), sFontGlyphs[c], 8, 16);
+#endif
+        sFontGlyphsUnpacked[c / 32] |= 1 << (c % 32);
+    }
+
+    return sFontGlyphs[c];
+}
+#endif
+
 void render_generic_char(u8 c) {
+#if (defined(VERSION_JP) || defined(VERSION_SH)) && defined(TEXT_GFX_CACHE)
+    void *unpackedTexture = get_unpacked_font_glyph(c);
+#else
     void **fontLUT = segmented_to_virtual(main_font_lut);
     void *packedTexture = segmented_to_virtual(fontLUT[c]);
 #if defined(VERSION_JP) || defined(VERSION_SH)
     void *unpackedTexture = alloc_ia8_text_from_i1(packedTexture, 8, 16);
 #endif
+#endif
 
 #ifndef VERSION_EU
     gDPPipeSync(gDisplayListHead++);
@@ -262,19 +444,11 @@ void render_generic_char(u8 c) {
 }
 
 #ifdef VERSION_EU
-u8 *alloc_ia4_tex_from_i1(u8 *in, s16 width, s16 height) {
-    u32 size = (u32) width * (u32) height;
-    u8 *out;
+static void unpack_ia4_tex_from_i1(u8 *in, u8 *out, s16 width, s16 height) {
     s32 inPos;
     s16 outPos = 0;
     u8 bitMask;
 
-    out = (u8 *) alloc_display_list(size);
-
-    if (out == NULL) {
-        return NULL;
-    }
-
     for (inPos = 0; inPos < (width * height) / 4; inPos++) {
         bitMask = 0x80;
 
@@ -286,14 +460,27 @@ u8 *alloc_ia4_tex_from_i1(u8 *in, s16 width, s16 height) {
             outPos++;
         }
     }
+}
+
+u8 *alloc_ia4_tex_from_i1(u8 *in, s16 width, s16 height) {
+    u8 *out = (u8 *) alloc_display_list((u32) width * (u32) height);
+
+    if (out == NULL) {
+        return NULL;
+    }
 
+    unpack_ia4_tex_from_i1(in, out, width, height);
     return out;
 }
 
 void render_generic_char_at_pos(s16 xPos, s16 yPos, u8 c) {
+#ifdef TEXT_GFX_CACHE
+    void *unpackedTexture = get_unpacked_font_glyph(c);
+#else
     void **fontLUT = segmented_to_virtual(main_font_lut);
     void *packedTexture = segmented_to_virtual(fontLUT[c]);
     void *unpackedTexture = alloc_ia4_tex_from_i1(packedTexture, 8, 8);
+#endif
 
     gDPPipeSync(gDisplayListHead++);
     gDPSetTextureImage(gDisplayListHead++, G_IM_FMT_IA, G_IM_SIZ_16b, 1, VIRTUAL_TO_PHYSICAL(unpackedTexture));
@@ -379,6 +566,12 @@ void print_generic_string(s16 x, s16 y, const u8 *str) {
     s16 yCoord = 240 - y;
 #endif
 
+#ifdef TEXT_GFX_CACHE
+    if (text_gfx_cache_begin(TEXT_GFX_GENERIC, x, y, str, DIALOG_CHAR_TERMINATOR)) {
+        return;
+    }
+#endif
+
 #ifndef VERSION_EU
     create_dl_translation_matrix(MENU_MTX_PUSH, x, y, 0.0f);
 #endif
@@ -512,6 +705,10 @@ void print_generic_string(s16 x, s16 y, const u8 *str) {
 #ifndef VERSION_EU
     gSPPopMatrix(gDisplayListHead++, G_MTX_MODELVIEW);
 #endif
+
+#ifdef TEXT_GFX_CACHE
+    text_gfx_cache_end();
+#endif
 }
 
 #ifdef VERSION_EU
@@ -538,9 +735,16 @@ void print_hud_lut_string(s8 hudLUT, s16 x, s16 y, const u8 *str) {
     void **hudLUT2 = segmented_to_virtual(main_hud_lut); // 0-9 A-Z HUD Color Font
     u32 curX = x;
     u32 curY = y;
+    s32 lastGlyph = -1;
 
     u32 xStride; // X separation
 
+#ifdef TEXT_GFX_CACHE
+    if (text_gfx_cache_begin(TEXT_GFX_HUD + hudLUT, x, y, str, GLOBAR_CHAR_TERMINATOR)) {
+        return;
+    }
+#endif
+
     if (hudLUT == HUD_LUT_JPMENU) {
         xStride = 16;
     } else { // HUD_LUT_GLOBAL
@@ -561,14 +765,17 @@ void print_hud_lut_string(s8 hudLUT, s16 x, s16 y, const u8 *str) {
             case HUD_CHAR_A_UMLAUT:
                 print_hud_char_umlaut(curX, curY, ASCII_TO_DIALOG('A'));
                 curX += xStride;
+                lastGlyph = -1;
                 break;
             case HUD_CHAR_O_UMLAUT:
                 print_hud_char_umlaut(curX, curY, ASCII_TO_DIALOG('O'));
                 curX += xStride;
+                lastGlyph = -1;
                 break;
             case HUD_CHAR_U_UMLAUT:
                 print_hud_char_umlaut(curX, curY, ASCII_TO_DIALOG('U'));
                 curX += xStride;
+                lastGlyph = -1;
                 break;
 #else
             case GLOBAL_CHAR_SPACE:
@@ -577,17 +784,21 @@ void print_hud_lut_string(s8 hudLUT, s16 x, s16 y, const u8 *str) {
 #endif
             default:
 #endif
-                gDPPipeSync(gDisplayListHead++);
+                // The same character twice in a row is still in TMEM.
+                if (str[strPos] != lastGlyph) {
+                    gDPPipeSync(gDisplayListHead++);
 
-                if (hudLUT == HUD_LUT_JPMENU) {
-                    gDPSetTextureImage(gDisplayListHead++, G_IM_FMT_RGBA, G_IM_SIZ_16b, 1, hudLUT1[str[strPos]]);
-                }
+                    if (hudLUT == HUD_LUT_JPMENU) {
+                        gDPSetTextureImage(gDisplayListHead++, G_IM_FMT_RGBA, G_IM_SIZ_16b, 1, hudLUT1[str[strPos]]);
+                    }
 
-                if (hudLUT == HUD_LUT_GLOBAL) {
-                    gDPSetTextureImage(gDisplayListHead++, G_IM_FMT_RGBA, G_IM_SIZ_16b, 1, hudLUT2[str[strPos]]);
-                }
+                    if (hudLUT == HUD_LUT_GLOBAL) {
+                        gDPSetTextureImage(gDisplayListHead++, G_IM_FMT_RGBA, G_IM_SIZ_16b, 1, hudLUT2[str[strPos]]);
+                    }
 
-                gSPDisplayList(gDisplayListHead++, dl_rgba16_load_tex_block);
+                    gSPDisplayList(gDisplayListHead++, dl_rgba16_load_tex_block);
+                    lastGlyph = str[strPos];
+                }
                 gSPTextureRectangle(gDisplayListHead++, curX << 2, curY << 2, (curX + 16) << 2,
                                     (curY + 16) << 2, G_TX_RENDERTILE, 0, 0, 1 << 10, 1 << 10);
 
@@ -597,6 +808,10 @@ void print_hud_lut_string(s8 hudLUT, s16 x, s16 y, const u8 *str) {
 #endif
         strPos++;
     }
+
+#ifdef TEXT_GFX_CACHE
+    text_gfx_cache_end();
+#endif
 }
 
 #ifdef VERSION_EU
@@ -621,6 +836,13 @@ void print_menu_generic_string(s16 x, s16 y, const u8 *str) {
     u32 curX = x;
     u32 curY = y;
     void **fontLUT = segmented_to_virtual(menu_font_lut);
+    s32 lastGlyph = -1;
+
+#ifdef TEXT_GFX_CACHE
+    if (text_gfx_cache_begin(TEXT_GFX_MENU, x, y, str, DIALOG_CHAR_TERMINATOR)) {
+        return;
+    }
+#endif
 
     while (str[strPos] != DIALOG_CHAR_TERMINATOR) {
         switch (str[strPos]) {
@@ -628,14 +850,17 @@ void print_menu_generic_string(s16 x, s16 y, const u8 *str) {
             case DIALOG_CHAR_UPPER_A_UMLAUT:
                 print_menu_char_umlaut(curX, curY, ASCII_TO_DIALOG('A'));
                 curX += gDialogCharWidths[str[strPos]];
+                lastGlyph = -1;
                 break;
             case DIALOG_CHAR_UPPER_U_UMLAUT:
                 print_menu_char_umlaut(curX, curY, ASCII_TO_DIALOG('U'));
                 curX += gDialogCharWidths[str[strPos]];
+                lastGlyph = -1;
                 break;
             case DIALOG_CHAR_UPPER_O_UMLAUT:
                 print_menu_char_umlaut(curX, curY, ASCII_TO_DIALOG('O'));
                 curX += gDialogCharWidths[str[strPos]];
+                lastGlyph = -1;
                 break;
 #else
             case DIALOG_CHAR_DAKUTEN:
@@ -649,9 +874,13 @@ void print_menu_generic_string(s16 x, s16 y, const u8 *str) {
                 curX += 4;
                 break;
             default:
-                gDPSetTextureImage(gDisplayListHead++, G_IM_FMT_IA, G_IM_SIZ_8b, 1, fontLUT[str[strPos]]);
-                gDPLoadSync(gDisplayListHead++);
-                gDPLoadBlock(gDisplayListHead++, G_TX_LOADTILE, 0, 0, 8 * 8 - 1, CALC_DXT(8, G_IM_SIZ_8b_BYTES));
+                // The same character twice in a row is still in TMEM.
+                if (str[strPos] != lastGlyph) {
+                    gDPSetTextureImage(gDisplayListHead++, G_IM_FMT_IA, G_IM_SIZ_8b, 1, fontLUT[str[strPos]]);
+                    gDPLoadSync(gDisplayListHead++);
+                    gDPLoadBlock(gDisplayListHead++, G_TX_LOADTILE, 0, 0, 8 * 8 - 1, CALC_DXT(8, G_IM_SIZ_8b_BYTES));
+                    lastGlyph = str[strPos];
+                }
                 gSPTextureRectangle(gDisplayListHead++, curX << 2, curY << 2, (curX + 8) << 2,
                                     (curY + 8) << 2, G_TX_RENDERTILE, 0, 0, 1 << 10, 1 << 10);
 
@@ -664,6 +893,7 @@ void print_menu_generic_string(s16 x, s16 y, const u8 *str) {
                                         (curX + 6 + 8) << 2, (curY - 7 + 8) << 2, G_TX_RENDERTILE, 0, 0, 1 << 10, 1 << 10);
 
                     mark = DIALOG_MARK_NONE;
+                    lastGlyph = -1;
                 }
 #endif
 #if defined(VERSION_JP) || defined(VERSION_SH)
@@ -674,6 +904,10 @@ void print_menu_generic_string(s16 x, s16 y, const u8 *str) {
         }
         strPos++;
     }
+
+#ifdef TEXT_GFX_CACHE
+    text_gfx_cache_end();
+#endif
 }
 
 void print_credits_string(s16 x, s16 y, const u8 *str) {
@@ -979,7 +1213,7 @@ void change_and_flash_dialog_text_color_lines(s8 colorMode, s8 lineNum) {
             gDPSetEnvColor(gDisplayListHead++, 255, 255, 255, 255);
         } else {
             if (lineNum == gDialogLineNum) {
-                colorFade = (gSineTable[gDialogColorFadeTimer >> 4] * 50.0f) + 200.0f;
+                colorFade = (sins(gDialogColorFadeTimer) * 50.0f) + 200.0f;
                 gDPSetEnvColor(gDisplayListHead++, colorFade, colorFade, colorFade, 255);
             } else {
                 gDPSetEnvColor(gDisplayListHead++, 200, 200, 200, 255);
@@ -1005,9 +1239,13 @@ void render_generic_dialog_char_at_pos(struct DialogEntry *dialog, s16 x, s16 y,
     s16 xCoord = (tmpX + (x / gDialogBoxScale));
     s16 yCoord = (tmpY + (y / gDialogBoxScale));
 
+#ifdef TEXT_GFX_CACHE
+    void *unpackedTexture = get_unpacked_font_glyph(c);
+#else
     void **fontLUT = segmented_to_virtual(main_font_lut);
     void *packedTexture = segmented_to_virtual(fontLUT[c]);
     void *unpackedTexture = alloc_ia4_tex_from_i1(packedTexture, 8, 8);
+#endif
 
     gDPSetTextureImage(gDisplayListHead++, G_IM_FMT_IA, G_IM_SIZ_16b, 1, VIRTUAL_TO_PHYSICAL(unpackedTexture));
     gSPDisplayList(gDisplayListHead++, dl_ia_text_tex_settings);
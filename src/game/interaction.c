@@ -115,6 +115,23 @@ static struct InteractionHandler sInteractionHandlers[] = {
     { INTERACT_TEXT,           interact_text },
 };
 
+/**
+ * For each byte of an interact type mask, the sInteractionHandlers entries it
+ * selects, as a mask with bit i set for entry i. The lowest set bit of the
+ * result is then the highest priority handler to run.
+ */
+static u32 sInteractionHandlerMasks[4][256];
+static u8 sInteractionHandlerMasksReady = FALSE;
+
+/**
+ * Index of the lowest set bit, looked up by multiplying the isolated bit with a
+ * de Bruijn sequence, which puts a distinct pattern in the top five bits.
+ */
+static const u8 sLowestSetBitIndex[32] = {
+    0,  1,  28, 2,  29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4,  8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6,  11, 5,  10, 9,
+};
+
 static u32 sForwardKnockbackActions[][3] = {
     { ACT_SOFT_FORWARD_GROUND_KB, ACT_FORWARD_GROUND_KB, ACT_HARD_FORWARD_GROUND_KB },
     { ACT_FORWARD_AIR_KB,         ACT_FORWARD_AIR_KB,    ACT_HARD_FORWARD_AIR_KB },
@@ -1776,25 +1793,61 @@ void check_kick_or_punch_wall(struct MarioState *m) {
     }
 }
 
+static void init_interaction_handler_masks(void) {
+    s32 i;
+    s32 byte;
+    s32 value;
+
+    for (i = 0; i < ARRAY_COUNT(sInteractionHandlers); i++) {
+        for (byte = 0; byte < 4; byte++) {
+            u32 bits = (sInteractionHandlers[i].interactType >> (byte * 8)) & 0xFF;
+
+            for (value = 0; value < 256; value++) {
+                if (value & bits) {
+                    sInteractionHandlerMasks[byte][value] |= 1 << i;
+                }
+            }
+        }
+    }
+
+    sInteractionHandlerMasksReady = TRUE;
+}
+
+static u32 get_interaction_handler_mask(u32 interactTypes) {
+    return sInteractionHandlerMasks[0][interactTypes & 0xFF]
+         | sInteractionHandlerMasks[1][(interactTypes >> 8) & 0xFF]
+         | sInteractionHandlerMasks[2][(interactTypes >> 16) & 0xFF]
+         | sInteractionHandlerMasks[3][interactTypes >> 24];
+}
+
 void mario_process_interactions(struct MarioState *m) {
     sDelayInvincTimer = FALSE;
     sInvulnerable = (m->action & ACT_FLAG_INVULNERABLE) || m->invincTimer != 0;
 
+    if (!sInteractionHandlerMasksReady) {
+        init_interaction_handler_masks();
+    }
+
     if (!(m->action & ACT_FLAG_INTANGIBLE) && m->collidedObjInteractTypes != 0) {
-        s32 i;
-        for (i = 0; i < ARRAY_COUNT(sInteractionHandlers); i++) {
+        u32 pending = get_interaction_handler_mask(m->collidedObjInteractTypes);
+
+        // Visit the handlers for the collided interact types in table order.
+        while (pending != 0) {
+            s32 i = sLowestSetBitIndex[((pending & -pending) * 0x077CB531) >> 27];
             u32 interactType = sInteractionHandlers[i].interactType;
-            if (m->collidedObjInteractTypes & interactType) {
-                struct Object *object = mario_get_collided_object(m, interactType);
+            struct Object *object = mario_get_collided_object(m, interactType);
 
-                m->collidedObjInteractTypes &= ~interactType;
+            m->collidedObjInteractTypes &= ~interactType;
 
-                if (!(object->oInteractStatus & INT_STATUS_INTERACTED)) {
-                    if (sInteractionHandlers[i].handler(m, interactType, object)) {
-                        break;
-                    }
+            if (!(object->oInteractStatus & INT_STATUS_INTERACTED)) {
+                if (sInteractionHandlers[i].handler(m, interactType, object)) {
+                    break;
                 }
             }
+
+            // A handler can change collidedObjInteractTypes, so look at it again for the
+            // entries after this one.
+            pending = get_interaction_handler_mask(m->collidedObjInteractTypes) & ~((2U << i) - 1);
         }
     }
 
@@ -7,6 +7,7 @@
 #include "engine/math_util.h"
 #include "camera.h"
 #include "envfx_snow.h"
+#include "profiler.h"
 #include "level_geo.h"
 
 /**
@@ -32,7 +33,9 @@ Gfx *geo_envfx_main(s32 callContext, struct GraphNode *node, Mat4 mtxf) {
             vec3f_to_vec3s(camTo, gCurGraphNodeCamera->focus);
             vec3f_to_vec3s(camFrom, gCurGraphNodeCamera->pos);
             vec3f_to_vec3s(marioPos, gPlayerCameraState->pos);
+            PROFILER_BEGIN(PROFILER_SCOPE_ENVFX);
             particleList = envfx_update_particles(snowMode, marioPos, camTo, camFrom);
+            PROFILER_END(PROFILER_SCOPE_ENVFX);
             if (particleList != NULL) {
                 Mtx *mtx = alloc_display_list(sizeof(*mtx));
 
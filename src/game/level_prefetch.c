@@ -0,0 +1,216 @@
+#include <ultra64.h>
+
+#include "sm64.h"
+#include "area.h"
+#include "game_init.h"
+#include "interaction.h"
+#include "level_prefetch.h"
+#include "level_table.h"
+#include "level_update.h"
+#include "memory.h"
+#include "object_list_processor.h"
+#include "segment_symbols.h"
+#include "surface_terrains.h"
+
+#ifdef USE_LEVEL_PREFETCH
+
+/**
+ * Level prefetching. While Mario walks up to a warp or painting that leads to
+ * another level, a low priority thread reads that level's script from ROM and
+ * decompresses the segments it loads into the segment cache. When the warp
+ * happens, load_segment_decompress finds them there. The thread only runs while
+ * the game thread is waiting, so it doesn't cost any frame time.
+ */
+
+// Only the segments loaded before ALLOC_LEVEL_POOL are prefetched, which is
+// where every level script in the game loads them.
+#define LEVEL_SCRIPT_WINDOW_SIZE 0x200
+
+#define LEVEL_CMD_EXIT 0x02
+#define LEVEL_CMD_JUMP 0x05
+#define LEVEL_CMD_RETURN 0x07
+#define LEVEL_CMD_LOAD_YAY0 0x18
+#define LEVEL_CMD_LOAD_YAY0_TEXTURE 0x1A
+#define LEVEL_CMD_ALLOC_LEVEL_POOL 0x1D
+
+struct LevelScriptSegment {
+    u8 *romStart;
+    u8 *romEnd;
+    const LevelScript *entry; // segmented address in segment 0x0E
+};
+
+#define STUB_LEVEL(_0, _1, _2, _3, _4, _5, _6, _7, _8)
+#define DEFINE_LEVEL(_0, _1, _2, folder, _4, _5, _6, _7, _8, _9, _10) \
+    extern const LevelScript level_##folder##_entry[];
+
+#include "levels/level_defines.h"
+
+#undef STUB_LEVEL
+#undef DEFINE_LEVEL
+
+#define STUB_LEVEL(_0, _1, _2, _3, _4, _5, _6, _7, _8) { NULL, NULL, NULL },
+#define DEFINE_LEVEL(_0, _1, _2, folder, _4, _5, _6, _7, _8, _9, _10) \
+    { _##folder##SegmentRomStart, _##folder##SegmentRomEnd, level_##folder##_entry },
+
+static const struct LevelScriptSegment sLevelScriptSegments[] = {
+    #include "levels/level_defines.h"
+};
+
+#undef STUB_LEVEL
+#undef DEFINE_LEVEL
+
+STATIC_ASSERT(ARRAY_COUNT(sLevelScriptSegments) == LEVEL_COUNT - 1,
+              "change this array if you are adding levels");
+
+static OSThread sLevelPrefetchThread;
+static u64 sLevelPrefetchThreadStack[0x2000 / sizeof(u64)];
+static OSMesgQueue sLevelPrefetchMesgQueue;
+static OSMesg sLevelPrefetchMesgBuf[1];
+static ALIGNED16 u8 sLevelScriptWindow[LEVEL_SCRIPT_WINDOW_SIZE];
+
+// Warps, pipes and warp doors
+static const s32 sWarpObjectLists[] = { OBJ_LIST_SURFACE, OBJ_LIST_LEVEL };
+
+static s16 sPrefetchFromLevel = LEVEL_NONE;
+static s16 sPrefetchedLevel = LEVEL_NONE;
+
+/**
+ * Read the start of the level's script from ROM and prefetch every compressed
+ * segment it loads.
+ */
+static void prefetch_level(s32 levelNum) {
+    const struct LevelScriptSegment *script = &sLevelScriptSegments[levelNum - 1];
+    u32 offset = (uintptr_t) script->entry & 0x00FFFFFF;
+    u32 size;
+    u32 pos;
+    u8 cmdSize;
+
+    if (script->romStart == NULL || ((uintptr_t) script->entry >> 24) != 0x0E
+        || offset >= (u32) (script->romEnd - script->romStart)) {
+        return;
+    }
+    size = script->romEnd - script->romStart - offset;
+    if (size > LEVEL_SCRIPT_WINDOW_SIZE) {
+        size = LEVEL_SCRIPT_WINDOW_SIZE;
+    }
+    segment_cache_dma_read(sLevelScriptWindow, script->romStart + offset,
+                           script->romStart + offset + size);
+
+    for (pos = 0; pos + 4 <= size; pos += cmdSize) {
+        cmdSize = sLevelScriptWindow[pos + 1];
+        if (cmdSize < 4 || pos + cmdSize > size) {
+            break;
+        }
+
+        switch (sLevelScriptWindow[pos]) {
+            case LEVEL_CMD_LOAD_YAY0:
+            case LEVEL_CMD_LOAD_YAY0_TEXTURE:
+                segment_cache_prefetch(*(u8 **) &sLevelScriptWindow[pos + 4],
+                                       *(u8 **) &sLevelScriptWindow[pos + 8]);
+                break;
+            case LEVEL_CMD_EXIT:
+            case LEVEL_CMD_JUMP:
+            case LEVEL_CMD_RETURN:
+            case LEVEL_CMD_ALLOC_LEVEL_POOL:
+                return;
+        }
+    }
+}
+
+static void thread10_level_prefetch(UNUSED void *arg) {
+    OSMesg msg;
+
+    while (TRUE) {
+        osRecvMesg(&sLevelPrefetchMesgQueue, &msg, OS_MESG_BLOCK);
+        prefetch_level((uintptr_t) msg);
+    }
+}
+
+void create_thread_10(void) {
+    if (!segment_cache_init()) {
+        return;
+    }
+    osCreateMesgQueue(&sLevelPrefetchMesgQueue, sLevelPrefetchMesgBuf,
+                      ARRAY_COUNT(sLevelPrefetchMesgBuf));
+    osCreateThread(&sLevelPrefetchThread, 10, thread10_level_prefetch, NULL,
+                   sLevelPrefetchThreadStack + ARRAY_COUNT(sLevelPrefetchThreadStack), 5);
+    osStartThread(&sLevelPrefetchThread);
+}
+
+/**
+ * Return the warp node of the painting Mario is standing in front of, or of
+ * the nearest warp object within LEVEL_PREFETCH_RADIUS.
+ */
+static struct WarpNode *find_approached_warp_node(void) {
+    struct Surface *floor = gMarioState->floor;
+    struct ObjectWarpNode *warpNode;
+    struct ObjectNode *listHead;
+    struct Object *obj;
+    struct WarpNode *nearest = NULL;
+    f32 minDistSq = LEVEL_PREFETCH_RADIUS * LEVEL_PREFETCH_RADIUS;
+    f32 dx, dy, dz, distSq;
+    u32 i;
+
+    // The wobble floors in front of a painting are in the same order as the
+    // warp floors behind it. Unused painting warp nodes have an id of 0.
+    if (floor != NULL && gCurrentArea->paintingWarpNodes != NULL
+        && floor->type >= SURFACE_PAINTING_WOBBLE_A6 && floor->type < SURFACE_PAINTING_WARP_D3) {
+        nearest = &gCurrentArea->paintingWarpNodes[floor->type - SURFACE_PAINTING_WOBBLE_A6];
+        return nearest->id != 0 ? nearest : NULL;
+    }
+
+    for (i = 0; i < ARRAY_COUNT(sWarpObjectLists); i++) {
+        listHead = &gObjectLists[sWarpObjectLists[i]];
+        for (obj = (struct Object *) listHead->next; obj != (struct Object *) listHead;
+             obj = (struct Object *) obj->header.next) {
+            if (!(obj->oInteractType & (INTERACT_WARP | INTERACT_WARP_DOOR))) {
+                continue;
+            }
+            dx = obj->oPosX - gMarioState->pos[0];
+            dy = obj->oPosY - gMarioState->pos[1];
+            dz = obj->oPosZ - gMarioState->pos[2];
+            distSq = dx * dx + dy * dy + dz * dz;
+            if (distSq < minDistSq && (warpNode = area_get_warp_node_from_params(obj)) != NULL) {
+                nearest = &warpNode->node;
+                minDistSq = distSq;
+            }
+        }
+    }
+
+    return nearest;
+}
+
+/**
+ * Called every frame during normal play. Every few frames, look for a warp
+ * Mario is approaching and start prefetching its destination level.
+ */
+void level_prefetch_update(void) {
+    struct WarpNode *warpNode;
+    s32 destLevel;
+
+    if (sPrefetchFromLevel != gCurrLevelNum) {
+        sPrefetchFromLevel = gCurrLevelNum;
+        sPrefetchedLevel = LEVEL_NONE;
+    }
+
+    if ((gGlobalTimer & 7) != 0 || gCurrentArea == NULL || !segment_cache_init()) {
+        return;
+    }
+
+    warpNode = find_approached_warp_node();
+    if (warpNode == NULL) {
+        return;
+    }
+
+    destLevel = warpNode->destLevel & 0x7F;
+    if (destLevel < LEVEL_MIN || destLevel > LEVEL_MAX || destLevel == gCurrLevelNum
+        || destLevel == sPrefetchedLevel) {
+        return;
+    }
+
+    if (osSendMesg(&sLevelPrefetchMesgQueue, (OSMesg) (uintptr_t) destLevel, OS_MESG_NOBLOCK) == 0) {
+        sPrefetchedLevel = destLevel;
+    }
+}
+
+#endif
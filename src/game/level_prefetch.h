@@ -0,0 +1,19 @@
+#ifndef LEVEL_PREFETCH_H
+#define LEVEL_PREFETCH_H
+
+#include <PR/ultratypes.h>
+
+#include "config.h"
+#include "memory.h"
+
+// Prefetched segments go into the segment cache, so there is nothing to do without it.
+#if defined(LEVEL_PREFETCH) && defined(USE_SEGMENT_CACHE)
+#define USE_LEVEL_PREFETCH
+#endif
+
+#ifdef USE_LEVEL_PREFETCH
+void create_thread_10(void);
+void level_prefetch_update(void);
+#endif
+
+#endif // LEVEL_PREFETCH_H
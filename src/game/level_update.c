@@ -28,6 +28,7 @@
 #include "level_table.h"
 #include "course_table.h"
 #include "rumble_init.h"
+#include "level_prefetch.h"
 
 #define PLAY_MODE_NORMAL 0
 #define PLAY_MODE_PAUSED 2
@@ -991,6 +992,9 @@ s32 play_mode_normal(void) {
         update_camera(gCurrentArea->camera);
     }
 
+#ifdef USE_LEVEL_PREFETCH
+    level_prefetch_update();
+#endif
     initiate_painting_warp();
     initiate_delayed_warp();
 
@@ -1097,6 +1101,16 @@ s32 play_mode_change_level(void) {
         sTransitionUpdate(&sTransitionTimer);
     }
 
+#ifdef SAVE_WRITE_THREAD
+    // Special warps (save and quit, game over) go back to the title screen,
+    // which reads the save chip, so hold the faded out screen until the save
+    // thread has written everything.
+    if (sTransitionTimer == 0 && sWarpDest.type == WARP_TYPE_NOT_WARPING
+        && save_file_flush_pending()) {
+        return 0;
+    }
+#endif
+
     if (--sTransitionTimer == -1) {
         gHudDisplay.flags = HUD_DISPLAY_NONE;
         sTransitionTimer = 0;
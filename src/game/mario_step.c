@@ -255,7 +255,55 @@ s32 stationary_ground_step(struct MarioState *m) {
     return stepResult;
 }
 
-static s32 perform_ground_quarter_step(struct MarioState *m, Vec3f nextPos) {
+/**
+ * How far outside the swept path the step collision context reaches, for wall pushes.
+ * Searches that still end up outside it take the regular path.
+ */
+#define STEP_COLLISION_PAD 64.0f
+
+/**
+ * Same as resolve_and_return_wall_collisions, searching the step's collision context.
+ */
+static struct Surface *step_resolve_wall_collisions(struct StepCollisionContext *ctx, Vec3f pos,
+                                                    f32 offset, f32 radius) {
+    struct WallCollisionData collisionData;
+    struct Surface *wall = NULL;
+
+    collisionData.x = pos[0];
+    collisionData.y = pos[1];
+    collisionData.z = pos[2];
+    collisionData.radius = radius;
+    collisionData.offsetY = offset;
+
+    if (step_find_wall_collisions(ctx, &collisionData)) {
+        wall = collisionData.walls[collisionData.numWalls - 1];
+    }
+
+    pos[0] = collisionData.x;
+    pos[1] = collisionData.y;
+    pos[2] = collisionData.z;
+
+    return wall;
+}
+
+/**
+ * Gather the surfaces within reach of a step that moves Mario from pos by up to
+ * (dx, dz) horizontally and between dyMin and dyMax vertically.
+ */
+static void init_step_collision(struct StepCollisionContext *ctx, Vec3f pos, f32 dx, f32 dz,
+                                f32 dyMin, f32 dyMax) {
+    f32 minX = pos[0] + (dx < 0.0f ? dx : 0.0f) - STEP_COLLISION_PAD;
+    f32 maxX = pos[0] + (dx > 0.0f ? dx : 0.0f) + STEP_COLLISION_PAD;
+    f32 minZ = pos[2] + (dz < 0.0f ? dz : 0.0f) - STEP_COLLISION_PAD;
+    f32 maxZ = pos[2] + (dz > 0.0f ? dz : 0.0f) + STEP_COLLISION_PAD;
+
+    // Walls are searched up to 150 units above the position.
+    step_collision_init(ctx, minX, pos[1] + dyMin - STEP_COLLISION_PAD, minZ, maxX,
+                        pos[1] + dyMax + 150.0f + STEP_COLLISION_PAD, maxZ, 50.0f);
+}
+
+static s32 perform_ground_quarter_step(struct MarioState *m, struct StepCollisionContext *ctx,
+                                       Vec3f nextPos) {
     UNUSED struct Surface *lowerWall;
     struct Surface *upperWall;
     struct Surface *ceil;
@@ -264,11 +312,11 @@ static s32 perform_ground_quarter_step(struct MarioState *m, Vec3f nextPos) {
     f32 floorHeight;
     f32 waterLevel;
 
-    lowerWall = resolve_and_return_wall_collisions(nextPos, 30.0f, 24.0f);
-    upperWall = resolve_and_return_wall_collisions(nextPos, 60.0f, 50.0f);
+    lowerWall = step_resolve_wall_collisions(ctx, nextPos, 30.0f, 24.0f);
+    upperWall = step_resolve_wall_collisions(ctx, nextPos, 60.0f, 50.0f);
 
-    floorHeight = find_floor(nextPos[0], nextPos[1], nextPos[2], &floor);
-    ceilHeight = vec3f_find_ceil(nextPos, floorHeight, &ceil);
+    floorHeight = step_find_floor(ctx, nextPos[0], nextPos[1], nextPos[2], &floor);
+    ceilHeight = step_find_ceil(ctx, nextPos[0], floorHeight + 80.0f, nextPos[2], &ceil);
 
     waterLevel = find_water_level(nextPos[0], nextPos[2]);
 
@@ -323,13 +371,20 @@ s32 perform_ground_step(struct MarioState *m) {
     s32 i;
     u32 stepResult;
     Vec3f intendedPos;
+    struct StepCollisionContext ctx;
+    // Floors have normal.y <= 1, so the quarter steps add up to at most vel. Allow
+    // for the height to follow slopes as steep as the step is long.
+    f32 slopeRange = (m->vel[0] < 0.0f ? -m->vel[0] : m->vel[0])
+                     + (m->vel[2] < 0.0f ? -m->vel[2] : m->vel[2]);
+
+    init_step_collision(&ctx, m->pos, m->vel[0], m->vel[2], -slopeRange, slopeRange);
 
     for (i = 0; i < 4; i++) {
         intendedPos[0] = m->pos[0] + m->floor->normal.y * (m->vel[0] / 4.0f);
         intendedPos[2] = m->pos[2] + m->floor->normal.y * (m->vel[2] / 4.0f);
         intendedPos[1] = m->pos[1];
 
-        stepResult = perform_ground_quarter_step(m, intendedPos);
+        stepResult = perform_ground_quarter_step(m, &ctx, intendedPos);
         if (stepResult == GROUND_STEP_LEFT_GROUND || stepResult == GROUND_STEP_HIT_WALL_STOP_QSTEPS) {
             break;
         }
@@ -385,7 +440,8 @@ u32 check_ledge_grab(struct MarioState *m, struct Surface *wall, Vec3f intendedP
     return TRUE;
 }
 
-s32 perform_air_quarter_step(struct MarioState *m, Vec3f intendedPos, u32 stepArg) {
+s32 perform_air_quarter_step(struct MarioState *m, struct StepCollisionContext *ctx, Vec3f intendedPos,
+                             u32 stepArg) {
     s16 wallDYaw;
     Vec3f nextPos;
     struct Surface *upperWall;
@@ -398,11 +454,11 @@ s32 perform_air_quarter_step(struct MarioState *m, Vec3f intendedPos, u32 stepAr
 
     vec3f_copy(nextPos, intendedPos);
 
-    upperWall = resolve_and_return_wall_collisions(nextPos, 150.0f, 50.0f);
-    lowerWall = resolve_and_return_wall_collisions(nextPos, 30.0f, 50.0f);
+    upperWall = step_resolve_wall_collisions(ctx, nextPos, 150.0f, 50.0f);
+    lowerWall = step_resolve_wall_collisions(ctx, nextPos, 30.0f, 50.0f);
 
-    floorHeight = find_floor(nextPos[0], nextPos[1], nextPos[2], &floor);
-    ceilHeight = vec3f_find_ceil(nextPos, floorHeight, &ceil);
+    floorHeight = step_find_floor(ctx, nextPos[0], nextPos[1], nextPos[2], &floor);
+    ceilHeight = step_find_ceil(ctx, nextPos[0], floorHeight + 80.0f, nextPos[2], &ceil);
 
     waterLevel = find_water_level(nextPos[0], nextPos[2]);
 
@@ -612,15 +668,19 @@ s32 perform_air_step(struct MarioState *m, u32 stepArg) {
     s32 i;
     s32 quarterStepResult;
     s32 stepResult = AIR_STEP_NONE;
+    struct StepCollisionContext ctx;
 
     m->wall = NULL;
 
+    init_step_collision(&ctx, m->pos, m->vel[0], m->vel[2], m->vel[1] < 0.0f ? m->vel[1] : 0.0f,
+                        m->vel[1] > 0.0f ? m->vel[1] : 0.0f);
+
     for (i = 0; i < 4; i++) {
         intendedPos[0] = m->pos[0] + m->vel[0] / 4.0f;
         intendedPos[1] = m->pos[1] + m->vel[1] / 4.0f;
         intendedPos[2] = m->pos[2] + m->vel[2] / 4.0f;
 
-        quarterStepResult = perform_air_quarter_step(m, intendedPos, stepArg);
+        quarterStepResult = perform_air_quarter_step(m, &ctx, intendedPos, stepArg);
 
         //! On one qf, hit OOB/ceil/wall to store the 2 return value, and continue
         // getting 0s until your last qf. Graze a wall on your last qf, and it will
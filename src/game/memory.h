@@ -3,8 +3,15 @@
 
 #include <PR/ultratypes.h>
 
+#include "config.h"
 #include "types.h"
 
+// The segment cache needs the upper half of an Expansion Pak to itself, and
+// only pays off for compressed segments.
+#if defined(SEGMENT_CACHE) && !defined(USE_EXT_RAM) && !defined(UNCOMPRESSED) && !defined(NO_SEGMENTED_MEMORY)
+#define USE_SEGMENT_CACHE
+#endif
+
 #define MEMORY_POOL_LEFT  0
 #define MEMORY_POOL_RIGHT 1
 
@@ -17,6 +24,19 @@ struct AllocOnlyPool {
 
 struct MemoryPool;
 
+#ifdef DEBUG
+struct MemoryPoolStats {
+    u32 totalSpace;
+    u32 usedSpace;
+    u32 peakUsedSpace;
+    u32 allocCount;
+    u32 failedAllocCount;
+    u32 freeSpace;
+    u32 freeBlockCount;
+    u32 largestFreeBlock;
+};
+#endif
+
 struct OffsetSizePair {
     u32 offset;
     u32 size;
@@ -61,6 +81,11 @@ void *load_to_fixed_pool_addr(u8 *destAddr, u8 *srcStart, u8 *srcEnd);
 void *load_segment_decompress(s32 segment, u8 *srcStart, u8 *srcEnd);
 void *load_segment_decompress_heap(u32 segment, u8 *srcStart, u8 *srcEnd);
 void load_engine_code_segment(void);
+#ifdef USE_SEGMENT_CACHE
+s32 segment_cache_init(void);
+void segment_cache_dma_read(u8 *dest, u8 *srcStart, u8 *srcEnd);
+void segment_cache_prefetch(u8 *srcStart, u8 *srcEnd);
+#endif
 #else
 #define load_segment(...)
 #define load_to_fixed_pool_addr(...)
@@ -76,6 +101,10 @@ struct AllocOnlyPool *alloc_only_pool_resize(struct AllocOnlyPool *pool, u32 siz
 struct MemoryPool *mem_pool_init(u32 size, u32 side);
 void *mem_pool_alloc(struct MemoryPool *pool, u32 size);
 void mem_pool_free(struct MemoryPool *pool, void *addr);
+#ifdef DEBUG
+void mem_pool_get_stats(struct MemoryPool *pool, struct MemoryPoolStats *stats);
+void mem_pool_print_stats(struct MemoryPool *pool, const char *name);
+#endif
 
 void *alloc_display_list(u32 size);
 void setup_dma_table_list(struct DmaHandlerList *list, void *srcAddr, void *buffer);
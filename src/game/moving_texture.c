@@ -4,6 +4,7 @@
 #include "moving_texture.h"
 #include "area.h"
 #include "camera.h"
+#include "game_init.h"
 #include "rendering_graph_node.h"
 #include "engine/math_util.h"
 #include "memory.h"
@@ -103,10 +104,16 @@ struct MovtexObject {
     s32 layer; /// the drawing layer for this mesh
 };
 
+/// Length of the display list generated for a MovtexObject
+#define MOVTEX_LIST_GFX 11
+
 /// Counters to make textures move iff the game is not paused.
 s16 gMovtexCounter = 1;
 s16 gMovtexCounterPrev = 0;
 
+// See moving_texture.h for documentation.
+u32 gMovtexVertsWritten = 0;
+
 // Vertex colors for rectangles. Used to give mist a tint
 #define MOVTEX_VTX_COLOR_DEFAULT 0 // no tint (white vertex colors)
 #define MOVTEX_VTX_COLOR_YELLOW 1  // used for Hazy Maze Cave toxic haze
@@ -395,24 +402,188 @@ struct MovtexQuad {
 s16 gMovetexLastTextureId;
 
 /**
- * Generates and returns a display list for a single MovtexQuad at height y.
+ * Write the 4 vertices of a MovtexQuad at height y.
  */
-Gfx *movtex_gen_from_quad(s16 y, struct MovtexQuad *quad) {
-    s16 rot;
-    s16 rotspeed = quad->rotspeed;
+void movtex_write_quad_verts(Vtx *verts, s16 y, struct MovtexQuad *quad) {
+    s16 rot = quad->rot;
     s16 scale = quad->scale;
-    s16 x1 = quad->x1;
-    s16 z1 = quad->z1;
-    s16 x2 = quad->x2;
-    s16 z2 = quad->z2;
-    s16 x3 = quad->x3;
-    s16 z3 = quad->z3;
-    s16 x4 = quad->x4;
-    s16 z4 = quad->z4;
-    s16 rotDir = quad->rotDir;
     s16 alpha = quad->alpha;
+
+    if (quad->rotDir == ROTATE_CLOCKWISE) {
+        movtex_make_quad_vertex(verts, 0, quad->x1, y, quad->z1, rot, 0, scale, alpha);
+        movtex_make_quad_vertex(verts, 1, quad->x2, y, quad->z2, rot, 16384, scale, alpha);
+        movtex_make_quad_vertex(verts, 2, quad->x3, y, quad->z3, rot, -32768, scale, alpha);
+        movtex_make_quad_vertex(verts, 3, quad->x4, y, quad->z4, rot, -16384, scale, alpha);
+    } else { // ROTATE_COUNTER_CLOCKWISE
+        movtex_make_quad_vertex(verts, 0, quad->x1, y, quad->z1, rot, 0, scale, alpha);
+        movtex_make_quad_vertex(verts, 1, quad->x2, y, quad->z2, rot, -16384, scale, alpha);
+        movtex_make_quad_vertex(verts, 2, quad->x3, y, quad->z3, rot, -32768, scale, alpha);
+        movtex_make_quad_vertex(verts, 3, quad->x4, y, quad->z4, rot, 16384, scale, alpha);
+    }
+    gMovtexVertsWritten += 4;
+}
+
+#ifdef MOVTEX_VERTEX_BUFFERS
+// Most vertices of a quad or mesh each frame only differ from the previous
+// frame in their texture coordinates, so the vertices are kept and only the
+// texture coordinates are written again. Each kept quad or mesh has two copies
+// of its vertices that are drawn on alternating frames, since the copy drawn
+// last frame may still be in use by the RCP.
+
+// Highest vtx_count of a MovtexObject that can be kept
+#define MOVTEX_MESH_BUFFER_VERTS 16
+
+// What a copy of a buffer has to be written with
+#define MOVTEX_BUFFER_KEEP 0      // nothing, it is up to date
+#define MOVTEX_BUFFER_TEXCOORDS 1 // only texture coordinates changed
+#define MOVTEX_BUFFER_ALL 2       // every attribute
+
+struct MovtexBuffer {
+    /// the MovtexQuad or MovtexObject kept in this buffer, NULL if unused
+    void *owner;
+    /// gGlobalTimer of the last frame the buffer was drawn
+    u32 lastUsed;
+    /// texture coordinates (s, t) and shape (y, color) each copy was written with
+    s16 key[2][4];
+    u8 valid[2];
+};
+
+static struct MovtexBuffer sMovtexQuadBuffers[MOVTEX_QUAD_BUFFERS];
+static Vtx sMovtexQuadVerts[MOVTEX_QUAD_BUFFERS][2][4];
+static struct MovtexBuffer sMovtexMeshBuffers[MOVTEX_MESH_BUFFERS];
+static Vtx sMovtexMeshVerts[MOVTEX_MESH_BUFFERS][2][MOVTEX_MESH_BUFFER_VERTS];
+static Gfx sMovtexMeshGfx[MOVTEX_MESH_BUFFERS][2][MOVTEX_LIST_GFX];
+
+/**
+ * Forget all kept quads and meshes. Called when an area is loaded, since the
+ * data of the next area can be loaded at the same addresses.
+ */
+void movtex_clear_buffers(void) {
+    s32 i;
+
+    for (i = 0; i < MOVTEX_QUAD_BUFFERS; i++) {
+        sMovtexQuadBuffers[i].owner = NULL;
+    }
+    for (i = 0; i < MOVTEX_MESH_BUFFERS; i++) {
+        sMovtexMeshBuffers[i].owner = NULL;
+    }
+}
+
+/**
+ * Find the buffer 'owner' is kept in, or take the least recently drawn buffer
+ * that wasn't drawn this frame for it. Return its index, or -1 if every buffer
+ * is in use this frame.
+ */
+static s32 movtex_find_buffer(struct MovtexBuffer *buffers, s32 count, void *owner) {
+    struct MovtexBuffer *oldest = NULL;
+    s32 i;
+
+    for (i = 0; i < count; i++) {
+        if (buffers[i].owner == owner) {
+            return i;
+        }
+        if (buffers[i].lastUsed != gGlobalTimer
+            && (oldest == NULL || buffers[i].lastUsed < oldest->lastUsed)) {
+            oldest = &buffers[i];
+        }
+    }
+
+    if (oldest == NULL) {
+        return -1;
+    }
+    oldest->owner = owner;
+    oldest->valid[0] = FALSE;
+    oldest->valid[1] = FALSE;
+    return oldest - buffers;
+}
+
+/**
+ * Return what the copy of 'buffer' drawn this frame has to be written with to
+ * match 'key', or -1 if it was already drawn this frame with a different key.
+ * The copy is then marked as written with 'key'.
+ */
+static s32 movtex_update_buffer(struct MovtexBuffer *buffer, s16 *key) {
+    s32 copy = gGlobalTimer & 1;
+    s16 *copyKey = buffer->key[copy];
+    s32 update;
+
+    if (!buffer->valid[copy] || copyKey[2] != key[2] || copyKey[3] != key[3]) {
+        update = MOVTEX_BUFFER_ALL;
+    } else if (copyKey[0] != key[0] || copyKey[1] != key[1]) {
+        update = MOVTEX_BUFFER_TEXCOORDS;
+    } else {
+        update = MOVTEX_BUFFER_KEEP;
+    }
+
+    if (update != MOVTEX_BUFFER_KEEP) {
+        // Changing the copy now would also change where it was drawn before.
+        if (buffer->lastUsed == gGlobalTimer) {
+            return -1;
+        }
+        bcopy(key, copyKey, sizeof(buffer->key[copy]));
+        buffer->valid[copy] = TRUE;
+    }
+    buffer->lastUsed = gGlobalTimer;
+    return update;
+}
+
+/**
+ * Write only the texture coordinates of a MovtexQuad's vertices.
+ */
+static void movtex_write_quad_texcoords(Vtx *verts, struct MovtexQuad *quad) {
+    s16 rotOffset = quad->rotDir == ROTATE_CLOCKWISE ? 16384 : -16384;
+    s16 rot = quad->rot;
+    s32 i;
+
+    // Same as in movtex_make_quad_vertex
+    for (i = 0; i < 4; i++) {
+        verts[i].v.tc[0] = 32.0 * (32.0 * quad->scale - 1.0) * sins(rot);
+        verts[i].v.tc[1] = 32.0 * (32.0 * quad->scale - 1.0) * coss(rot);
+        rot += rotOffset;
+    }
+    gMovtexVertsWritten += 4;
+}
+
+/**
+ * Return the kept vertices of a MovtexQuad at height y, updated for this
+ * frame, or NULL if the quad can't be kept.
+ */
+static Vtx *movtex_get_quad_buffer(s16 y, struct MovtexQuad *quad) {
+    s32 index = movtex_find_buffer(sMovtexQuadBuffers, MOVTEX_QUAD_BUFFERS, quad);
+    s16 key[4];
+    Vtx *verts;
+
+    if (index < 0) {
+        return NULL;
+    }
+
+    key[0] = quad->rot;
+    key[1] = 0;
+    key[2] = y;
+    key[3] = gMovtexVtxColor;
+    verts = sMovtexQuadVerts[index][gGlobalTimer & 1];
+    switch (movtex_update_buffer(&sMovtexQuadBuffers[index], key)) {
+        case MOVTEX_BUFFER_ALL:
+            movtex_write_quad_verts(verts, y, quad);
+            break;
+        case MOVTEX_BUFFER_TEXCOORDS:
+            movtex_write_quad_texcoords(verts, quad);
+            break;
+        case MOVTEX_BUFFER_KEEP:
+            break;
+        default:
+            return NULL;
+    }
+    return verts;
+}
+#endif
+
+/**
+ * Generates and returns a display list for a single MovtexQuad at height y.
+ */
+Gfx *movtex_gen_from_quad(s16 y, struct MovtexQuad *quad) {
     s16 textureId = quad->textureId;
-    Vtx *verts = alloc_display_list(4 * sizeof(*verts));
+    Vtx *verts = NULL;
     Gfx *gfxHead;
     Gfx *gfx;
 
@@ -422,24 +593,23 @@ Gfx *movtex_gen_from_quad(s16 y, struct MovtexQuad *quad) {
         gfxHead = alloc_display_list(8 * sizeof(*gfxHead));
     }
 
-    if (gfxHead == NULL || verts == NULL) {
+    if (gfxHead == NULL) {
         return NULL;
     }
     gfx = gfxHead;
     if (gMovtexCounter != gMovtexCounterPrev) {
-        quad->rot += rotspeed;
-    }
-    rot = quad->rot;
-    if (rotDir == ROTATE_CLOCKWISE) {
-        movtex_make_quad_vertex(verts, 0, x1, y, z1, rot, 0, scale, alpha);
-        movtex_make_quad_vertex(verts, 1, x2, y, z2, rot, 16384, scale, alpha);
-        movtex_make_quad_vertex(verts, 2, x3, y, z3, rot, -32768, scale, alpha);
-        movtex_make_quad_vertex(verts, 3, x4, y, z4, rot, -16384, scale, alpha);
-    } else { // ROTATE_COUNTER_CLOCKWISE
-        movtex_make_quad_vertex(verts, 0, x1, y, z1, rot, 0, scale, alpha);
-        movtex_make_quad_vertex(verts, 1, x2, y, z2, rot, -16384, scale, alpha);
-        movtex_make_quad_vertex(verts, 2, x3, y, z3, rot, -32768, scale, alpha);
-        movtex_make_quad_vertex(verts, 3, x4, y, z4, rot, 16384, scale, alpha);
+        quad->rot += quad->rotspeed;
+    }
+
+#ifdef MOVTEX_VERTEX_BUFFERS
+    verts = movtex_get_quad_buffer(y, quad);
+#endif
+    if (verts == NULL) {
+        verts = alloc_display_list(4 * sizeof(*verts));
+        if (verts == NULL) {
+            return NULL;
+        }
+        movtex_write_quad_verts(verts, y, quad);
     }
 
     // Only add commands to change the texture when necessary
@@ -800,23 +970,17 @@ void movtex_write_vertex_index(Vtx *verts, s32 index, s16 *movtexVerts, struct M
 }
 
 /**
- * Generate a displaylist for a MovtexObject.
- * 'attrLayout' is one of MOVTEX_LAYOUT_NOCOLOR and MOVTEX_LAYOUT_COLORED.
+ * Write the vertices and display list of a MovtexObject into 'verts' and 'gfx'.
  */
-Gfx *movtex_gen_list(s16 *movtexVerts, struct MovtexObject *movtexList, s8 attrLayout) {
-    Vtx *verts = alloc_display_list(movtexList->vtx_count * sizeof(*verts));
-    Gfx *gfxHead = alloc_display_list(11 * sizeof(*gfxHead));
-    Gfx *gfx = gfxHead;
+static void movtex_write_list(Vtx *verts, Gfx *gfx, s16 *movtexVerts, struct MovtexObject *movtexList,
+                              s8 attrLayout) {
     s32 i;
 
-    if (verts == NULL || gfxHead == NULL) {
-        return NULL;
-    }
-
     movtex_write_vertex_first(verts, movtexVerts, movtexList, attrLayout);
     for (i = 1; i < movtexList->vtx_count; i++) {
         movtex_write_vertex_index(verts, i, movtexVerts, movtexList, attrLayout);
     }
+    gMovtexVertsWritten += movtexList->vtx_count;
 
     gSPDisplayList(gfx++, movtexList->beginDl);
     gLoadBlockTexture(gfx++, 32, 32, G_IM_FMT_RGBA, gMovtexIdToTexture[movtexList->textureId]);
@@ -824,6 +988,94 @@ Gfx *movtex_gen_list(s16 *movtexVerts, struct MovtexObject *movtexList, s8 attrL
     gSPDisplayList(gfx++, movtexList->triDl);
     gSPDisplayList(gfx++, movtexList->endDl);
     gSPEndDisplayList(gfx);
+}
+
+#ifdef MOVTEX_VERTEX_BUFFERS
+/**
+ * Write only the texture coordinates of a MovtexObject's vertices. Like in
+ * movtex_write_vertex_index, they are offsets from the first vertex.
+ */
+static void movtex_write_list_texcoords(Vtx *verts, s16 *movtexVerts, s32 vtxCount, s8 attrLayout) {
+    s32 stride = attrLayout == MOVTEX_LAYOUT_NOCOLOR ? 5 : 8;
+    s32 attrS = attrLayout == MOVTEX_LAYOUT_NOCOLOR ? MOVTEX_ATTR_NOCOLOR_S : MOVTEX_ATTR_COLORED_S;
+    s16 baseS = movtexVerts[attrS];
+    s16 baseT = movtexVerts[attrS + 1];
+    s32 i;
+
+    verts[0].v.tc[0] = baseS;
+    verts[0].v.tc[1] = baseT;
+    for (i = 1; i < vtxCount; i++) {
+        verts[i].v.tc[0] = baseS + ((movtexVerts[i * stride + attrS] * 32) * 32U);
+        verts[i].v.tc[1] = baseT + ((movtexVerts[i * stride + attrS + 1] * 32) * 32U);
+    }
+    gMovtexVertsWritten += vtxCount;
+}
+
+/**
+ * Return the kept display list of a MovtexObject, updated for this frame, or
+ * NULL if the mesh can't be kept.
+ */
+static Gfx *movtex_get_list_buffer(s16 *movtexVerts, struct MovtexObject *movtexList,
+                                   s8 attrLayout) {
+    s32 attrS = attrLayout == MOVTEX_LAYOUT_NOCOLOR ? MOVTEX_ATTR_NOCOLOR_S : MOVTEX_ATTR_COLORED_S;
+    s32 index;
+    s32 copy = gGlobalTimer & 1;
+    s16 key[4];
+    Vtx *verts;
+    Gfx *gfx;
+
+    if (movtexList->vtx_count > MOVTEX_MESH_BUFFER_VERTS) {
+        return NULL;
+    }
+    index = movtex_find_buffer(sMovtexMeshBuffers, MOVTEX_MESH_BUFFERS, movtexList);
+    if (index < 0) {
+        return NULL;
+    }
+
+    key[0] = movtexVerts[attrS];
+    key[1] = movtexVerts[attrS + 1];
+    key[2] = 0;
+    key[3] = 0;
+    verts = sMovtexMeshVerts[index][copy];
+    gfx = sMovtexMeshGfx[index][copy];
+    switch (movtex_update_buffer(&sMovtexMeshBuffers[index], key)) {
+        case MOVTEX_BUFFER_ALL:
+            movtex_write_list(verts, gfx, movtexVerts, movtexList, attrLayout);
+            break;
+        case MOVTEX_BUFFER_TEXCOORDS:
+            movtex_write_list_texcoords(verts, movtexVerts, movtexList->vtx_count, attrLayout);
+            break;
+        case MOVTEX_BUFFER_KEEP:
+            break;
+        default:
+            return NULL;
+    }
+    return gfx;
+}
+#endif
+
+/**
+ * Generate a displaylist for a MovtexObject.
+ * 'attrLayout' is one of MOVTEX_LAYOUT_NOCOLOR and MOVTEX_LAYOUT_COLORED.
+ */
+Gfx *movtex_gen_list(s16 *movtexVerts, struct MovtexObject *movtexList, s8 attrLayout) {
+    Vtx *verts;
+    Gfx *gfxHead;
+
+#ifdef MOVTEX_VERTEX_BUFFERS
+    gfxHead = movtex_get_list_buffer(movtexVerts, movtexList, attrLayout);
+    if (gfxHead != NULL) {
+        return gfxHead;
+    }
+#endif
+
+    verts = alloc_display_list(movtexList->vtx_count * sizeof(*verts));
+    gfxHead = alloc_display_list(MOVTEX_LIST_GFX * sizeof(*gfxHead));
+    if (verts == NULL || gfxHead == NULL) {
+        return NULL;
+    }
+
+    movtex_write_list(verts, gfxHead, movtexVerts, movtexList, attrLayout);
     return gfxHead;
 }
 
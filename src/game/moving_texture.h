@@ -3,6 +3,7 @@
 
 #include <PR/ultratypes.h>
 
+#include "config.h"
 #include "macros.h"
 #include "types.h"
 
@@ -33,6 +34,9 @@ struct MovtexQuadCollection {
 
 extern f32 gPaintingMarioYEntry;
 
+/// Number of moving texture vertices written since this was last reset
+extern u32 gMovtexVertsWritten;
+
 // Moving texture mesh ids have for bits 8-16 a course identifier.
 // This corresponds to the numbers used in debug level select, except they are
 // re-interpreted as hexadecimal numbers. TTM is course 36, so the id is 0x36
@@ -110,6 +114,9 @@ extern f32 gPaintingMarioYEntry;
 #define MOVTEX_TREADMILL_BIG         (0 | MOVTEX_AREA_TTC)
 #define MOVTEX_TREADMILL_SMALL       (1 | MOVTEX_AREA_TTC)
 
+#ifdef MOVTEX_VERTEX_BUFFERS
+void movtex_clear_buffers(void);
+#endif
 Gfx *geo_wdw_set_initial_water_level(s32 callContext, UNUSED struct GraphNode *node, UNUSED Mat4 mtx);
 Gfx *geo_movtex_pause_control(s32 callContext, UNUSED struct GraphNode *node, UNUSED Mat4 mtx);
 Gfx *geo_movtex_draw_water_regions(s32 callContext, struct GraphNode *node, UNUSED Mat4 mtx);
@@ -529,6 +529,10 @@ struct Object *spawn_object_at_origin(struct Object *parent, UNUSED s32 unusedAr
 
     behaviorAddr = segmented_to_virtual(behavior);
     obj = create_object(behaviorAddr);
+    // Callers expect an object, so a full pool hands out a deactivated stand-in.
+    if (obj == NULL) {
+        obj = create_overflow_object(behaviorAddr);
+    }
 
     obj->parentObj = parent;
     obj->header.gfx.areaIndex = parent->header.gfx.areaIndex;
@@ -865,17 +869,6 @@ struct Object *cur_obj_find_nearest_object_with_behavior(const BehaviorScript *b
     return closestObj;
 }
 
-struct Object *find_unimportant_object(void) {
-    struct ObjectNode *listHead = &gObjectLists[OBJ_LIST_UNIMPORTANT];
-    struct ObjectNode *obj = listHead->next;
-
-    if (listHead == obj) {
-        obj = NULL;
-    }
-
-    return (struct Object *) obj;
-}
-
 s32 count_unimportant_objects(void) {
     struct ObjectNode *listHead = &gObjectLists[OBJ_LIST_UNIMPORTANT];
     struct ObjectNode *obj = listHead->next;
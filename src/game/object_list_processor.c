@@ -480,6 +480,10 @@ void spawn_objects_from_info(UNUSED s32 unused, struct SpawnInfo *spawnInfo) {
         if ((spawnInfo->behaviorArg & (RESPAWN_INFO_DONT_RESPAWN << 8))
             != (RESPAWN_INFO_DONT_RESPAWN << 8)) {
             object = create_object(script);
+            if (object == NULL) {
+                spawnInfo = spawnInfo->next;
+                continue;
+            }
 
             // Behavior parameters are often treated as four separate bytes, but
             // are stored as an s32.
@@ -626,6 +630,8 @@ UNUSED static u16 unused_get_elapsed_time(u64 *cycleCounts, s32 index) {
 void update_objects(UNUSED s32 unused) {
     s64 cycleCounts[30];
 
+    PROFILER_BEGIN(PROFILER_SCOPE_OBJECTS);
+
     cycleCounts[0] = get_current_clock();
 
     gTimeStopState &= ~TIME_STOP_MARIO_OPENED_DOOR;
@@ -683,4 +689,6 @@ void update_objects(UNUSED s32 unused) {
     }
 
     gPrevFrameObjectCount = gObjectCounter;
+
+    PROFILER_END(PROFILER_SCOPE_OBJECTS);
 }
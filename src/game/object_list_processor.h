@@ -4,6 +4,7 @@
 #include <PR/ultratypes.h>
 
 #include "area.h"
+#include "config.h"
 #include "macros.h"
 #include "types.h"
 
@@ -20,11 +21,6 @@
 #define TIME_STOP_ACTIVE            (1 << 6)
 
 
-/**
- * The maximum number of objects that can be loaded at once.
- */
-#define OBJECT_POOL_CAPACITY 240
-
 /**
  * Every object is categorized into an object list, which controls the order
  * they are processed and which objects they can collide with.
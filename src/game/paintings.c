@@ -3,6 +3,7 @@
 #include "sm64.h"
 #include "area.h"
 #include "engine/graph_node.h"
+#include "engine/math_util.h"
 #include "engine/surface_collision.h"
 #include "game_init.h"
 #include "geo_misc.h"
@@ -189,6 +190,44 @@ struct Painting **sPaintingGroups[] = {
 s16 gPaintingUpdateCounter = 1;
 s16 gLastPaintingUpdateCounter = 0;
 
+#ifdef PAINTING_RIPPLE_CACHE
+// Limits of the cached mesh. Larger meshes are generated every frame instead.
+#define PAINTING_CACHE_MAX_VTX 160
+#define PAINTING_CACHE_MAX_TRIS 272
+
+/**
+ * The ripple mesh of the painting that rippled last, kept between frames.
+ *
+ * The offsets into the mesh and neighbor tables are found once, when the first area is loaded. The
+ * distance of each vertex to the ripple origin is only recomputed when the origin, size or dispersion
+ * changes. Each frame only the ripple heights are evaluated, and only the normals of the triangles
+ * around vertices whose height changed are recomputed.
+ */
+struct PaintingMeshCache {
+    /// The painting the mesh belongs to, or NULL if it has to be regenerated
+    struct Painting *owner;
+    /// The ripple parameters the distances were computed with
+    f32 rippleX;
+    f32 rippleY;
+    f32 dispersionFactor;
+    f32 size;
+    /// 0 if the mesh is too large for the cache
+    s16 numVtx;
+    s16 numTris;
+    /// For each vertex, the offset of its entry in seg2_painting_mesh_neighbor_tris
+    s16 neighborEntry[PAINTING_CACHE_MAX_VTX];
+    /// For each vertex, its distance to the ripple origin divided by the dispersion factor
+    f32 rippleDistance[PAINTING_CACHE_MAX_VTX];
+    u8 movable[PAINTING_CACHE_MAX_VTX];
+    u8 vtxDirty[PAINTING_CACHE_MAX_VTX];
+    u8 triDirty[PAINTING_CACHE_MAX_TRIS];
+    struct PaintingMeshVertex mesh[PAINTING_CACHE_MAX_VTX];
+    Vec3f triNorms[PAINTING_CACHE_MAX_TRIS];
+};
+
+static struct PaintingMeshCache sPaintingMeshCache;
+#endif
+
 /**
  * Stop paintings in paintingGroup from rippling if their id is different from *idptr.
  */
@@ -698,6 +737,34 @@ void painting_generate_mesh(struct Painting *painting, s16 *mesh, s16 numTris) {
     }
 }
 
+/**
+ * Calculate the surface normal of triangle `i` in the generated ripple mesh.
+ * See painting_calculate_triangle_normals below for the format of `mesh`.
+ */
+void painting_calculate_triangle_normal(s16 *mesh, s16 numVtx, s16 i) {
+    s16 tri = numVtx * 3 + i * 3 + 2; // Add 2 because of the 2 length entries preceding the list
+    s16 v0 = mesh[tri];
+    s16 v1 = mesh[tri + 1];
+    s16 v2 = mesh[tri + 2];
+
+    f32 x0 = gPaintingMesh[v0].pos[0];
+    f32 y0 = gPaintingMesh[v0].pos[1];
+    f32 z0 = gPaintingMesh[v0].pos[2];
+
+    f32 x1 = gPaintingMesh[v1].pos[0];
+    f32 y1 = gPaintingMesh[v1].pos[1];
+    f32 z1 = gPaintingMesh[v1].pos[2];
+
+    f32 x2 = gPaintingMesh[v2].pos[0];
+    f32 y2 = gPaintingMesh[v2].pos[1];
+    f32 z2 = gPaintingMesh[v2].pos[2];
+
+    // Cross product to find the triangle's normal vector
+    gPaintingTriNorms[i][0] = (y1 - y0) * (z2 - z1) - (z1 - z0) * (y2 - y1);
+    gPaintingTriNorms[i][1] = (z1 - z0) * (x2 - x1) - (x1 - x0) * (z2 - z1);
+    gPaintingTriNorms[i][2] = (x1 - x0) * (y2 - y1) - (y1 - y0) * (x2 - x1);
+}
+
 /**
  * Calculate the surface normals of each triangle in the generated ripple mesh.
  *
@@ -720,27 +787,7 @@ void painting_calculate_triangle_normals(s16 *mesh, s16 numVtx, s16 numTris) {
     if (gPaintingTriNorms == NULL) {
     }
     for (i = 0; i < numTris; i++) {
-        s16 tri = numVtx * 3 + i * 3 + 2; // Add 2 because of the 2 length entries preceding the list
-        s16 v0 = mesh[tri];
-        s16 v1 = mesh[tri + 1];
-        s16 v2 = mesh[tri + 2];
-
-        f32 x0 = gPaintingMesh[v0].pos[0];
-        f32 y0 = gPaintingMesh[v0].pos[1];
-        f32 z0 = gPaintingMesh[v0].pos[2];
-
-        f32 x1 = gPaintingMesh[v1].pos[0];
-        f32 y1 = gPaintingMesh[v1].pos[1];
-        f32 z1 = gPaintingMesh[v1].pos[2];
-
-        f32 x2 = gPaintingMesh[v2].pos[0];
-        f32 y2 = gPaintingMesh[v2].pos[1];
-        f32 z2 = gPaintingMesh[v2].pos[2];
-
-        // Cross product to find each triangle's normal vector
-        gPaintingTriNorms[i][0] = (y1 - y0) * (z2 - z1) - (z1 - z0) * (y2 - y1);
-        gPaintingTriNorms[i][1] = (z1 - z0) * (x2 - x1) - (x1 - x0) * (z2 - z1);
-        gPaintingTriNorms[i][2] = (x1 - x0) * (y2 - y1) - (y1 - y0) * (x2 - x1);
+        painting_calculate_triangle_normal(mesh, numVtx, i);
     }
 }
 
@@ -761,6 +808,50 @@ s8 normalize_component(f32 comp) {
     return rounded;
 }
 
+/**
+ * Approximates the normal of vertex `i` by averaging the normals of the triangles listed at `entry` in
+ * `neighborTris`. See painting_average_vertex_normals below for the table format.
+ *
+ * @return the offset of the next vertex's entry
+ */
+s16 painting_average_vertex_normal(s16 *neighborTris, s16 entry, s16 i) {
+    s16 tri;
+    s16 j;
+    s16 neighbors;
+    f32 nx = 0.0f;
+    f32 ny = 0.0f;
+    f32 nz = 0.0f;
+    f32 nlen;
+
+    // The first number of each entry is the number of adjacent tris
+    neighbors = neighborTris[entry];
+    for (j = 0; j < neighbors; j++) {
+        tri = neighborTris[entry + j + 1];
+        nx += gPaintingTriNorms[tri][0];
+        ny += gPaintingTriNorms[tri][1];
+        nz += gPaintingTriNorms[tri][2];
+    }
+
+    // average the surface normals from each neighboring tri
+    nx /= neighbors;
+    ny /= neighbors;
+    nz /= neighbors;
+    nlen = sqrtf(nx * nx + ny * ny + nz * nz);
+
+    if (nlen == 0.0) {
+        gPaintingMesh[i].norm[0] = 0;
+        gPaintingMesh[i].norm[1] = 0;
+        gPaintingMesh[i].norm[2] = 0;
+    } else {
+        gPaintingMesh[i].norm[0] = normalize_component(nx / nlen);
+        gPaintingMesh[i].norm[1] = normalize_component(ny / nlen);
+        gPaintingMesh[i].norm[2] = normalize_component(nz / nlen);
+    }
+
+    // Move to the next vertex's entry
+    return entry + neighbors + 1;
+}
+
 /**
  * Approximates the painting mesh's vertex normals by averaging the normals of all triangles sharing a
  * vertex. Used for Gouraud lighting.
@@ -778,46 +869,141 @@ s8 normalize_component(f32 comp) {
  */
 void painting_average_vertex_normals(s16 *neighborTris, s16 numVtx) {
     UNUSED s16 unused;
-    s16 tri;
     s16 i;
-    s16 j;
-    s16 neighbors;
     s16 entry = 0;
 
     for (i = 0; i < numVtx; i++) {
-        f32 nx = 0.0f;
-        f32 ny = 0.0f;
-        f32 nz = 0.0f;
-        f32 nlen;
-
-        // The first number of each entry is the number of adjacent tris
-        neighbors = neighborTris[entry];
-        for (j = 0; j < neighbors; j++) {
-            tri = neighborTris[entry + j + 1];
-            nx += gPaintingTriNorms[tri][0];
-            ny += gPaintingTriNorms[tri][1];
-            nz += gPaintingTriNorms[tri][2];
+        entry = painting_average_vertex_normal(neighborTris, entry, i);
+    }
+}
+
+#ifdef PAINTING_RIPPLE_CACHE
+/**
+ * Find each vertex's entry in the neighbor table and which vertices can move. The mesh tables are in
+ * segment 2, which never changes, so this only has to be done once.
+ */
+void painting_init_mesh_cache(void) {
+    struct PaintingMeshCache *cache = &sPaintingMeshCache;
+    s16 *mesh = segmented_to_virtual(seg2_painting_triangle_mesh);
+    s16 *neighborTris = segmented_to_virtual(seg2_painting_mesh_neighbor_tris);
+    s16 numVtx = mesh[0];
+    s16 numTris = mesh[numVtx * 3 + 1];
+    s16 entry = 0;
+    s16 i;
+
+    cache->owner = NULL;
+    if (cache->numVtx != 0 || numVtx > PAINTING_CACHE_MAX_VTX || numTris > PAINTING_CACHE_MAX_TRIS) {
+        return;
+    }
+
+    for (i = 0; i < numVtx; i++) {
+        cache->neighborEntry[i] = entry;
+        entry += neighborTris[entry] + 1;
+
+        cache->mesh[i].pos[0] = mesh[i * 3 + 1];
+        cache->mesh[i].pos[1] = mesh[i * 3 + 2];
+        cache->movable[i] = mesh[i * 3 + 3];
+    }
+
+    cache->numVtx = numVtx;
+    cache->numTris = numTris;
+}
+
+/**
+ * Restart the cached mesh for `painting`: flatten it, mark every normal for recalculation and find
+ * each vertex's distance to the ripple origin, in the units of the painting's rippleTimer.
+ */
+void painting_reset_mesh_cache(struct Painting *painting) {
+    struct PaintingMeshCache *cache = &sPaintingMeshCache;
+    f32 sizeRatio = painting->size / PAINTING_SIZE;
+    f32 dx, dy;
+    s16 i;
+
+    cache->owner = painting;
+    cache->rippleX = painting->rippleX;
+    cache->rippleY = painting->rippleY;
+    cache->dispersionFactor = painting->dispersionFactor;
+    cache->size = painting->size;
+
+    for (i = 0; i < cache->numVtx; i++) {
+        dx = cache->mesh[i].pos[0] * sizeRatio - painting->rippleX;
+        dy = cache->mesh[i].pos[1] * sizeRatio - painting->rippleY;
+        cache->rippleDistance[i] = sqrtf(dx * dx + dy * dy) / painting->dispersionFactor;
+        cache->mesh[i].pos[2] = 0;
+    }
+
+    for (i = 0; i < cache->numTris; i++) {
+        cache->triDirty[i] = TRUE;
+    }
+}
+
+/**
+ * Update the cached mesh to the painting's current ripple state. Same as painting_generate_mesh and
+ * the normal calculations after it, but the cosine comes from the sine table, and the normals are only
+ * recomputed where a vertex moved. Once the ripple stops moving the mesh, nothing is recomputed.
+ */
+void painting_update_mesh_cache(struct Painting *painting, s16 *mesh, s16 *neighborTris) {
+    struct PaintingMeshCache *cache = &sPaintingMeshCache;
+    f32 rippleTimer = painting->rippleTimer;
+    f32 rippleMag = painting->currRippleMag;
+    f32 rippleRate = painting->currRippleRate;
+    f32 cycles;
+    s16 rippleZ;
+    s16 entry;
+    s16 tri;
+    s16 i;
+    s16 j;
+
+    gPaintingMesh = cache->mesh;
+    gPaintingTriNorms = cache->triNorms;
+
+    if (cache->owner != painting || cache->rippleX != painting->rippleX
+        || cache->rippleY != painting->rippleY || cache->dispersionFactor != painting->dispersionFactor
+        || cache->size != painting->size) {
+        painting_reset_mesh_cache(painting);
+    }
+
+    // Ripple heights. Any triangle with a vertex that moved needs a new normal.
+    for (i = 0; i < cache->numVtx; i++) {
+        rippleZ = 0;
+        if (cache->movable[i] && rippleTimer >= cache->rippleDistance[i]) {
+            // Only the fraction of a cycle matters, which also keeps the angle in range
+            cycles = rippleRate * (rippleTimer - cache->rippleDistance[i]);
+            cycles -= (s32) cycles;
+            rippleZ = round_float(rippleMag * coss((s32)(cycles * 65536.0f)));
+        }
+
+        if (rippleZ != cache->mesh[i].pos[2]) {
+            cache->mesh[i].pos[2] = rippleZ;
+
+            entry = cache->neighborEntry[i];
+            for (j = 0; j < neighborTris[entry]; j++) {
+                cache->triDirty[neighborTris[entry + j + 1]] = TRUE;
+            }
+        }
+    }
+
+    // Triangle normals, and the vertices that share those triangles
+    for (i = 0; i < cache->numTris; i++) {
+        if (cache->triDirty[i]) {
+            cache->triDirty[i] = FALSE;
+            painting_calculate_triangle_normal(mesh, cache->numVtx, i);
+
+            tri = cache->numVtx * 3 + i * 3 + 2;
+            cache->vtxDirty[mesh[tri]] = TRUE;
+            cache->vtxDirty[mesh[tri + 1]] = TRUE;
+            cache->vtxDirty[mesh[tri + 2]] = TRUE;
         }
-        // Move to the next vertex's entry
-        entry += neighbors + 1;
-
-        // average the surface normals from each neighboring tri
-        nx /= neighbors;
-        ny /= neighbors;
-        nz /= neighbors;
-        nlen = sqrtf(nx * nx + ny * ny + nz * nz);
-
-        if (nlen == 0.0) {
-            gPaintingMesh[i].norm[0] = 0;
-            gPaintingMesh[i].norm[1] = 0;
-            gPaintingMesh[i].norm[2] = 0;
-        } else {
-            gPaintingMesh[i].norm[0] = normalize_component(nx / nlen);
-            gPaintingMesh[i].norm[1] = normalize_component(ny / nlen);
-            gPaintingMesh[i].norm[2] = normalize_component(nz / nlen);
+    }
+
+    for (i = 0; i < cache->numVtx; i++) {
+        if (cache->vtxDirty[i]) {
+            cache->vtxDirty[i] = FALSE;
+            painting_average_vertex_normal(neighborTris, cache->neighborEntry[i], i);
         }
     }
 }
+#endif
 
 /**
  * Creates a display list that draws the rippling painting, with 'img' mapped to the painting's mesh,
@@ -1012,7 +1198,8 @@ Gfx *painting_ripple_env_mapped(struct Painting *painting) {
 
 /**
  * Generates a mesh, calculates vertex normals for lighting, and renders a rippling painting.
- * The mesh and vertex normals are regenerated and freed every frame.
+ * The mesh and vertex normals are regenerated and freed every frame, unless PAINTING_RIPPLE_CACHE
+ * keeps them.
  */
 Gfx *display_painting_rippling(struct Painting *painting) {
     s16 *mesh = segmented_to_virtual(seg2_painting_triangle_mesh);
@@ -1020,11 +1207,21 @@ Gfx *display_painting_rippling(struct Painting *painting) {
     s16 numVtx = mesh[0];
     s16 numTris = mesh[numVtx * 3 + 1];
     Gfx *dlist = NULL;
+    s32 cached = FALSE;
+
+#ifdef PAINTING_RIPPLE_CACHE
+    if (sPaintingMeshCache.numVtx != 0) {
+        painting_update_mesh_cache(painting, mesh, neighborTris);
+        cached = TRUE;
+    }
+#endif
 
     // Generate the mesh and its lighting data
-    painting_generate_mesh(painting, mesh, numVtx);
-    painting_calculate_triangle_normals(mesh, numVtx, numTris);
-    painting_average_vertex_normals(neighborTris, numVtx);
+    if (!cached) {
+        painting_generate_mesh(painting, mesh, numVtx);
+        painting_calculate_triangle_normals(mesh, numVtx, numTris);
+        painting_average_vertex_normals(neighborTris, numVtx);
+    }
 
     // Map the painting's texture depending on the painting's texture type.
     switch (painting->textureType) {
@@ -1037,8 +1234,10 @@ Gfx *display_painting_rippling(struct Painting *painting) {
     }
 
     // The mesh data is freed every frame.
-    mem_pool_free(gEffectsMemoryPool, gPaintingMesh);
-    mem_pool_free(gEffectsMemoryPool, gPaintingTriNorms);
+    if (!cached) {
+        mem_pool_free(gEffectsMemoryPool, gPaintingMesh);
+        mem_pool_free(gEffectsMemoryPool, gPaintingTriNorms);
+    }
     return dlist;
 }
 
@@ -1272,6 +1471,9 @@ Gfx *geo_painting_update(s32 callContext, UNUSED struct GraphNode *node, UNUSED
     if (callContext != GEO_CONTEXT_RENDER) {
         gLastPaintingUpdateCounter = gAreaUpdateCounter - 1;
         gPaintingUpdateCounter = gAreaUpdateCounter;
+#ifdef PAINTING_RIPPLE_CACHE
+        painting_init_mesh_cache();
+#endif
     } else {
         gLastPaintingUpdateCounter = gPaintingUpdateCounter;
         gPaintingUpdateCounter = gAreaUpdateCounter;
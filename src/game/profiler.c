@@ -6,6 +6,12 @@
 
 s16 gProfilerMode = 0;
 
+#ifdef PROFILER_SCOPES
+#define PROFILER_MODE_COUNT 4
+#else
+#define PROFILER_MODE_COUNT 2
+#endif
+
 // the thread 3 info is logged on the opposite profiler from what is used by
 // the thread4 and 5 loggers. It's likely because the sound thread runs at a
 // much faster rate and shouldn't be flipping the index for the "slower" game
@@ -16,10 +22,264 @@ s16 gCurrentFrameIndex2 = 0;
 
 struct ProfilerFrameData gProfilerFrameData[2];
 
+#ifdef PROFILER_SCOPES
+
+#define PROFILER_MAX_SPANS 48
+
+// Spans of one scope that are closer together than this are merged, so that
+// the hundreds of collision checks in a frame don't use up every span.
+#define PROFILER_SPAN_MERGE_USEC 100
+
+// Rows of the subsystem timeline, from the top.
+#define PROFILER_SCOPE_ROW_Y 184
+#define PROFILER_ROW_SPACING 4
+
+struct ProfilerSpan {
+    /*0x00*/ u8 scope;
+    /*0x04*/ u32 start; // cycles since the frame started
+    /*0x08*/ u32 end;
+};
+
+struct ProfilerScopeFrame {
+    // Cycles from the start of this frame to the start of the next one
+    u32 frameCycles;
+    // Time spent in each scope, including and excluding the scopes nested in it
+    u32 totalCycles[PROFILER_SCOPE_COUNT];
+    u32 selfCycles[PROFILER_SCOPE_COUNT];
+    // The gfxTimes of this frame, in cycles since the frame started
+    u32 gfxCycles[3];
+    s16 numSpans;
+    s8 lastSpan[PROFILER_SCOPE_COUNT];
+    struct ProfilerSpan spans[PROFILER_MAX_SPANS];
+};
+
+struct ProfilerOpenScope {
+    u8 scope;
+    u32 start;
+    u32 childCycles;
+};
+
+static const char *sProfilerScopeNames[PROFILER_SCOPE_COUNT] = {
+    "objects", "collision", "camera", "render", "audio", "dma", "envfx",
+};
+
+static const u16 sProfilerScopeColors[PROFILER_SCOPE_COUNT] = {
+    GPACK_RGBA5551(255, 255, 40, 1),  // objects (yellow)
+    GPACK_RGBA5551(255, 120, 40, 1),  // collision (orange)
+    GPACK_RGBA5551(40, 255, 80, 1),   // camera (green)
+    GPACK_RGBA5551(40, 192, 230, 1),  // render (blue)
+    GPACK_RGBA5551(255, 40, 40, 1),   // audio (red)
+    GPACK_RGBA5551(200, 80, 255, 1),  // dma (purple)
+    GPACK_RGBA5551(255, 150, 200, 1), // envfx (pink)
+};
+
+// The frame being recorded, and the one before it.
+static struct ProfilerScopeFrame sScopeFrames[2];
+static s16 sScopeFrameIndex = 0;
+static u32 sScopeFrameStart;
+static s32 sScopeFrameOpen = FALSE;
+
+// Scopes that are currently running, innermost last. A scope is only pushed
+// when it isn't running already, so there can't be more than one of each.
+static struct ProfilerOpenScope sOpenScopes[PROFILER_SCOPE_COUNT];
+static s32 sNumOpenScopes = 0;
+static u8 sScopeDepth[PROFILER_SCOPE_COUNT];
+
+// Total time of every scope and of the whole frame (the last entry) over the
+// last PROFILER_HISTORY_FRAMES frames.
+static u32 sScopeHistory[PROFILER_HISTORY_FRAMES][PROFILER_SCOPE_COUNT + 1];
+static s32 sScopeHistoryPos = 0;
+static s32 sScopeHistoryCount = 0;
+
+// The last frame that took longer than PROFILER_SPIKE_USEC.
+static struct ProfilerScopeFrame sSpikeFrame;
+static s32 sNumSpikes = 0;
+static s32 sSpikePending = FALSE;
+static s32 sSpikeCooldown = 0;
+
+void profiler_scope_begin(enum ProfilerScope scope) {
+    struct ProfilerOpenScope *open;
+
+    if (sScopeDepth[scope]++ != 0) {
+        return;
+    }
+
+    open = &sOpenScopes[sNumOpenScopes++];
+    open->scope = scope;
+    open->childCycles = 0;
+    open->start = osGetCount();
+}
+
+static void profiler_add_span(struct ProfilerScopeFrame *frame, u8 scope, u32 start, u32 end) {
+    struct ProfilerSpan *span;
+
+    if (frame->lastSpan[scope] >= 0) {
+        span = &frame->spans[frame->lastSpan[scope]];
+        if (start - span->end < OS_USEC_TO_CYCLES(PROFILER_SPAN_MERGE_USEC)) {
+            span->end = end;
+            return;
+        }
+    }
+
+    if (frame->numSpans < PROFILER_MAX_SPANS) {
+        frame->lastSpan[scope] = frame->numSpans;
+        span = &frame->spans[frame->numSpans++];
+        span->scope = scope;
+        span->start = start;
+        span->end = end;
+    }
+}
+
+// Scopes have to end in the reverse order they began in.
+void profiler_scope_end(enum ProfilerScope scope) {
+    struct ProfilerScopeFrame *frame = &sScopeFrames[sScopeFrameIndex];
+    struct ProfilerOpenScope *open;
+    u32 end = osGetCount();
+    u32 elapsed;
+
+    if (--sScopeDepth[scope] != 0) {
+        return;
+    }
+
+    open = &sOpenScopes[--sNumOpenScopes];
+    elapsed = end - open->start;
+    frame->totalCycles[scope] += elapsed;
+    frame->selfCycles[scope] += elapsed - open->childCycles;
+
+    // The parent's self time excludes this scope.
+    if (sNumOpenScopes != 0) {
+        sOpenScopes[sNumOpenScopes - 1].childCycles += elapsed;
+    }
+
+    profiler_add_span(frame, scope, open->start - sScopeFrameStart, end - sScopeFrameStart);
+}
+
+// Cycles from clockBase to clock, floored to 0.
+static u32 profiler_cycles_since(OSTime clockBase, OSTime clock) {
+    return clock > clockBase ? (u32) (clock - clockBase) : 0;
+}
+
+// Get the min, avg and max time in microseconds of a scope, or of the whole frame
+// when scope is PROFILER_SCOPE_COUNT, over the history.
+static void profiler_scope_history_stats(s32 scope, u32 *min, u32 *avg, u32 *max) {
+    u64 sum = 0;
+    u32 cycles;
+    s32 i;
+
+    *min = 0xFFFFFFFF;
+    *max = 0;
+    for (i = 0; i < sScopeHistoryCount; i++) {
+        cycles = sScopeHistory[i][scope];
+        sum += cycles;
+        if (cycles < *min) {
+            *min = cycles;
+        }
+        if (cycles > *max) {
+            *max = cycles;
+        }
+    }
+
+    if (sScopeHistoryCount == 0) {
+        *min = 0;
+    }
+    *min = OS_CYCLES_TO_USEC(*min);
+    *max = OS_CYCLES_TO_USEC(*max);
+    *avg = sScopeHistoryCount != 0 ? OS_CYCLES_TO_USEC(sum / sScopeHistoryCount) : 0;
+}
+
+// Print the captured spike frame and the history leading up to it. With UNF
+// these lines go out over USB.
+static void profiler_export_spike(void) {
+    struct ProfilerScopeFrame *frame = &sSpikeFrame;
+    u32 min, avg, max;
+    s32 i;
+
+    profiler_scope_history_stats(PROFILER_SCOPE_COUNT, &min, &avg, &max);
+    osSyncPrintf("profiler: spike %d frame %d us rsp %d us rdp %d us (frame min %d avg %d max %d us)\n",
+                 sNumSpikes, (u32) OS_CYCLES_TO_USEC(frame->frameCycles),
+                 (u32) OS_CYCLES_TO_USEC(profiler_cycles_since(frame->gfxCycles[TASKS_QUEUED],
+                                                               frame->gfxCycles[RSP_COMPLETE])),
+                 (u32) OS_CYCLES_TO_USEC(profiler_cycles_since(frame->gfxCycles[TASKS_QUEUED],
+                                                               frame->gfxCycles[RDP_COMPLETE])),
+                 min, avg, max);
+
+    for (i = 0; i < PROFILER_SCOPE_COUNT; i++) {
+        profiler_scope_history_stats(i, &min, &avg, &max);
+        osSyncPrintf("profiler: %-9s self %5d total %5d us (min %5d avg %5d max %5d us)\n",
+                     sProfilerScopeNames[i], (u32) OS_CYCLES_TO_USEC(frame->selfCycles[i]),
+                     (u32) OS_CYCLES_TO_USEC(frame->totalCycles[i]), min, avg, max);
+    }
+}
+
+/**
+ * Finish the frame that is being recorded and start the next one. Called when
+ * thread 5 starts a frame, once the game times of that frame have been logged.
+ */
+static void profiler_scope_frame_start(void) {
+    struct ProfilerScopeFrame *frame = &sScopeFrames[sScopeFrameIndex];
+    struct ProfilerFrameData *profiler = &gProfilerFrameData[gCurrentFrameIndex1 ^ 1];
+    u32 *history;
+    u32 now = osGetCount();
+    s32 i;
+
+    if (sScopeFrameOpen) {
+        frame->frameCycles = now - sScopeFrameStart;
+        for (i = 0; i < 3; i++) {
+            frame->gfxCycles[i] = profiler_cycles_since(profiler->gameTimes[THREAD5_START],
+                                                        profiler->gfxTimes[i]);
+        }
+
+        history = sScopeHistory[sScopeHistoryPos];
+        for (i = 0; i < PROFILER_SCOPE_COUNT; i++) {
+            history[i] = frame->totalCycles[i];
+        }
+        history[PROFILER_SCOPE_COUNT] = frame->frameCycles;
+        sScopeHistoryPos = (sScopeHistoryPos + 1) % PROFILER_HISTORY_FRAMES;
+        if (sScopeHistoryCount < PROFILER_HISTORY_FRAMES) {
+            sScopeHistoryCount++;
+        }
+
+        // Printing the report is slow enough to cause a spike of its own, so
+        // don't look for another one until the history has been refilled.
+        if (sSpikeCooldown != 0) {
+            sSpikeCooldown--;
+        } else if (frame->frameCycles > OS_USEC_TO_CYCLES(PROFILER_SPIKE_USEC)) {
+            sSpikeFrame = *frame;
+            sNumSpikes++;
+            sSpikePending = TRUE;
+            sSpikeCooldown = PROFILER_HISTORY_FRAMES;
+        }
+    }
+
+    sScopeFrameIndex ^= 1;
+    frame = &sScopeFrames[sScopeFrameIndex];
+    bzero(frame, sizeof(struct ProfilerScopeFrame));
+    for (i = 0; i < PROFILER_SCOPE_COUNT; i++) {
+        frame->lastSpan[i] = -1;
+    }
+    sScopeFrameStart = now;
+    sScopeFrameOpen = TRUE;
+}
+
+#endif
+
 // log the current osTime to the appropriate idx for current thread5 processes.
 void profiler_log_thread5_time(enum ProfilerGameEvent eventID) {
     gProfilerFrameData[gCurrentFrameIndex1].gameTimes[eventID] = osGetTime();
 
+#ifdef PROFILER_SCOPES
+    if (eventID == THREAD5_START) {
+        profiler_scope_frame_start();
+    }
+
+    // Export a captured spike once this frame's work is done, while the game
+    // thread would otherwise wait for the next frame.
+    if (eventID == THREAD5_END && sSpikePending) {
+        sSpikePending = FALSE;
+        profiler_export_spike();
+    }
+#endif
+
     // event ID 4 is the last profiler event for after swapping
     // buffers: switch the Info after updating.
     if (eventID == THREAD5_END) {
@@ -291,16 +551,70 @@ void draw_profiler_mode_0(void) {
     draw_reference_profiler_bars();
 }
 
-// Draw the Profiler per frame. Toggle the mode if the player presses L while this
+#ifdef PROFILER_SCOPES
+/*
+  Draw Profiler Mode 2 and 3. These modes draw a timeline of one frame with a row
+  per subsystem, starting at the top of the frame. Mode 2 shows the last frame and
+  mode 3 the last frame that took longer than PROFILER_SPIKE_USEC.
+
+  Information:
+
+  (yellow): Object Updates
+  (orange): Collision
+  (green): Camera
+  (blue): Rendering
+  (red): Audio
+  (purple): DMA
+  (pink): Environment effects
+  (white): Time from SP tasks queued to RSP complete
+  (grey): Time from SP tasks queued to RDP complete
+*/
+static void draw_profiler_scopes(struct ProfilerScopeFrame *frame) {
+    struct ProfilerSpan *span;
+    s16 posY = PROFILER_SCOPE_ROW_Y + PROFILER_SCOPE_COUNT * PROFILER_ROW_SPACING;
+    s32 i;
+
+    for (i = 0; i < frame->numSpans; i++) {
+        span = &frame->spans[i];
+        draw_profiler_bar(0, span->start, span->end,
+                          PROFILER_SCOPE_ROW_Y + span->scope * PROFILER_ROW_SPACING,
+                          sProfilerScopeColors[span->scope]);
+    }
+
+    // The RSP and RDP run in parallel with the next frame's game logic, so their
+    // bars show how much of it they overlap.
+    draw_profiler_bar(0, frame->gfxCycles[TASKS_QUEUED], frame->gfxCycles[RSP_COMPLETE], posY,
+                      GPACK_RGBA5551(255, 255, 255, 1));
+    draw_profiler_bar(0, frame->gfxCycles[TASKS_QUEUED], frame->gfxCycles[RDP_COMPLETE],
+                      posY + PROFILER_ROW_SPACING, GPACK_RGBA5551(160, 160, 160, 1));
+
+    draw_reference_profiler_bars();
+}
+#endif
+
+// Draw the Profiler per frame. Cycle the mode if the player presses L while this
 // renderer is active.
 void draw_profiler(void) {
     if (gPlayer1Controller->buttonPressed & L_TRIG) {
-        gProfilerMode ^= 1;
+        gProfilerMode = (gProfilerMode + 1) % PROFILER_MODE_COUNT;
     }
 
-    if (gProfilerMode == 0) {
-        draw_profiler_mode_0();
-    } else {
-        draw_profiler_mode_1();
+    switch (gProfilerMode) {
+        case 0:
+            draw_profiler_mode_0();
+            break;
+        case 1:
+            draw_profiler_mode_1();
+            break;
+#ifdef PROFILER_SCOPES
+        case 2:
+            draw_profiler_scopes(&sScopeFrames[sScopeFrameIndex ^ 1]);
+            break;
+        case 3:
+            if (sNumSpikes != 0) {
+                draw_profiler_scopes(&sSpikeFrame);
+            }
+            break;
+#endif
     }
 }
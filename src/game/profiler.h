@@ -4,6 +4,7 @@
 #include <PR/ultratypes.h>
 #include <PR/os_time.h>
 
+#include "config.h"
 #include "types.h"
 
 extern u64 osClockRate;
@@ -42,6 +43,34 @@ enum ProfilerGfxEvent {
     RDP_COMPLETE
 };
 
+/**
+ * Subsystems timed by PROFILER_BEGIN/PROFILER_END when PROFILER_SCOPES is set.
+ * Scopes may nest: a scope's self time excludes the scopes started inside it,
+ * and a scope that is re-entered while it is already running is only counted
+ * once. Only the game thread may open scopes.
+ */
+enum ProfilerScope {
+    PROFILER_SCOPE_OBJECTS,
+    PROFILER_SCOPE_COLLISION,
+    PROFILER_SCOPE_CAMERA,
+    PROFILER_SCOPE_RENDER,
+    PROFILER_SCOPE_AUDIO,
+    PROFILER_SCOPE_DMA,
+    PROFILER_SCOPE_ENVFX,
+    PROFILER_SCOPE_COUNT
+};
+
+#ifdef PROFILER_SCOPES
+void profiler_scope_begin(enum ProfilerScope scope);
+void profiler_scope_end(enum ProfilerScope scope);
+
+#define PROFILER_BEGIN(scope) profiler_scope_begin(scope)
+#define PROFILER_END(scope) profiler_scope_end(scope)
+#else
+#define PROFILER_BEGIN(scope)
+#define PROFILER_END(scope)
+#endif
+
 void profiler_log_thread5_time(enum ProfilerGameEvent eventID);
 void profiler_log_thread4_time(void);
 void profiler_log_gfx_time(enum ProfilerGfxEvent eventID);
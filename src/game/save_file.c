@@ -14,6 +14,9 @@
 #ifdef SRAM
 #include "sram.h"
 #endif
+#ifdef SAVE_WRITE_THREAD
+#include "save_flush.h"
+#endif
 
 #define ALIGN4(val) (((val) + 0x3) & ~0x3)
 
@@ -77,6 +80,7 @@ static s32 read_eeprom_data(void *buffer, s32 size) {
     return status;
 }
 
+#ifndef SAVE_WRITE_THREAD
 /**
  * Write data to EEPROM.
  * The EEPROM address is computed using the offset of the source address from gSaveBuffer.
@@ -105,6 +109,7 @@ static s32 write_eeprom_data(void *buffer, s32 size) {
     return status;
 }
 #endif
+#endif
 #ifdef SRAM
 /**
  * Read from SRAM to a given address.
@@ -134,6 +139,7 @@ static s32 read_eeprom_data(void *buffer, s32 size) {
     return status;
 }
 
+#ifndef SAVE_WRITE_THREAD
 /**
  * Write data to SRAM.
  * The SRAM address is computed using the offset of the source address from gSaveBuffer.
@@ -162,6 +168,167 @@ static s32 write_eeprom_data(void *buffer, s32 size) {
     return status;
 }
 #endif
+#endif
+#ifdef SAVE_WRITE_THREAD
+#if defined(EEP) && !ENABLE_RUMBLE
+#error "SAVE_WRITE_THREAD writes EEPROM between controller reads, which needs the Rumble Pak lock"
+#endif
+
+/*
+ * With SAVE_WRITE_THREAD, saving only copies the part of gSaveBuffer that
+ * would have been written into sSaveRequestImage, the image the save chip
+ * should hold. Whenever the save thread is idle, the game thread copies it to
+ * sSaveFlushImage and wakes the save thread, which writes the blocks that
+ * differ from sSaveCommittedImage, the copy of what is on the chip. While
+ * sSaveFlushBusy is set, the save thread owns sSaveFlushImage and
+ * sSaveCommittedImage. Each image is only taken once the last one is on the
+ * chip, so a save file's main and backup slots are never both partly written.
+ */
+#define SAVE_IMAGE_SIZE \
+    ((sizeof(struct SaveBuffer) + SAVE_FLUSH_BLOCK_SIZE - 1) & ~(SAVE_FLUSH_BLOCK_SIZE - 1))
+
+// Blocks never hold parts of two slots, so one slot can't be damaged by writing the other.
+STATIC_ASSERT(sizeof(struct SaveFile) % SAVE_FLUSH_BLOCK_SIZE == 0, "save files must fill whole blocks");
+STATIC_ASSERT(sizeof(struct MainMenuSaveData) % SAVE_FLUSH_BLOCK_SIZE == 0, "menu data must fill whole blocks");
+
+static ALIGNED8 u8 sSaveRequestImage[SAVE_IMAGE_SIZE];
+static ALIGNED8 u8 sSaveFlushImage[SAVE_IMAGE_SIZE];
+static ALIGNED8 u8 sSaveCommittedImage[SAVE_IMAGE_SIZE];
+
+static s8 sSaveRequestPending;
+static volatile s8 sSaveFlushBusy;
+
+static OSThread sSaveFlushThread;
+static u64 sSaveFlushThreadStack[0x1000 / sizeof(u64)];
+static OSMesgQueue sSaveFlushMesgQueue;
+static OSMesg sSaveFlushMesgBuf[1];
+
+#ifdef EEP
+// Write one block at a time, so the controllers are never kept waiting for more than one.
+#define SAVE_FLUSH_RUN_BLOCKS 1
+
+static OSTimer sSaveFlushTimer;
+static OSMesgQueue sSaveFlushTimerMesgQueue;
+static OSMesg sSaveFlushTimerMesgBuf[1];
+
+/**
+ * Write a block to EEPROM from the save thread. Try at most 4 times, and return
+ * 0 on success. After each try, wait for the EEPROM to finish writing the
+ * block like osEepromLongWrite does, without holding the serial bus.
+ */
+static s32 write_save_run(u32 offset, u8 *data, UNUSED u32 size) {
+    s32 status = 1;
+
+    if (gEepromProbe != 0) {
+        s32 triesLeft = 4;
+
+        do {
+            block_until_rumble_pak_free();
+            triesLeft--;
+            status = osEepromWrite(&gSIEventMesgQueue, offset / SAVE_FLUSH_BLOCK_SIZE, data);
+            release_rumble_pak_control();
+
+            osSetTimer(&sSaveFlushTimer, OS_USEC_TO_CYCLES(12000), 0, &sSaveFlushTimerMesgQueue, NULL);
+            osRecvMesg(&sSaveFlushTimerMesgQueue, NULL, OS_MESG_BLOCK);
+        } while (triesLeft > 0 && status != 0);
+    }
+
+    return status;
+}
+#endif
+#ifdef SRAM
+#define SAVE_FLUSH_RUN_BLOCKS (SAVE_IMAGE_SIZE / SAVE_FLUSH_BLOCK_SIZE)
+
+/**
+ * Write a range of SRAM from the save thread. Try at most 4 times, and return 0
+ * on success. SRAM is on the parallel bus, so the controllers aren't locked out
+ * while it is written.
+ */
+static s32 write_save_run(u32 offset, u8 *data, u32 size) {
+    s32 status = 1;
+
+    if (gSramProbe != 0) {
+        s32 triesLeft = 4;
+
+        do {
+            triesLeft--;
+            status = nuPiWriteSram(offset, data, size);
+        } while (triesLeft > 0 && status != 0);
+    }
+
+    return status;
+}
+#endif
+
+static void thread11_save_flush(UNUSED void *arg) {
+    OSMesg msg;
+
+    while (TRUE) {
+        osRecvMesg(&sSaveFlushMesgQueue, &msg, OS_MESG_BLOCK);
+        save_flush(sSaveFlushImage, sSaveCommittedImage, SAVE_IMAGE_SIZE, SAVE_FLUSH_RUN_BLOCKS,
+                   write_save_run);
+        sSaveFlushBusy = FALSE;
+    }
+}
+
+void create_thread_11(void) {
+    osCreateMesgQueue(&sSaveFlushMesgQueue, sSaveFlushMesgBuf, ARRAY_COUNT(sSaveFlushMesgBuf));
+#ifdef EEP
+    osCreateMesgQueue(&sSaveFlushTimerMesgQueue, sSaveFlushTimerMesgBuf,
+                      ARRAY_COUNT(sSaveFlushTimerMesgBuf));
+#endif
+    osCreateThread(&sSaveFlushThread, 11, thread11_save_flush, NULL,
+                   sSaveFlushThreadStack + ARRAY_COUNT(sSaveFlushThreadStack), 6);
+    osStartThread(&sSaveFlushThread);
+}
+
+/**
+ * Start the save chip images from what was read at boot. If the read failed,
+ * every block is treated as different so the first flush writes all of them.
+ */
+static void init_save_images(s32 readStatus) {
+    u32 i;
+
+    bcopy(&gSaveBuffer, sSaveRequestImage, sizeof(gSaveBuffer));
+    bcopy(&gSaveBuffer, sSaveCommittedImage, sizeof(gSaveBuffer));
+    if (readStatus != 0) {
+        for (i = 0; i < SAVE_IMAGE_SIZE; i++) {
+            sSaveCommittedImage[i] = ~sSaveRequestImage[i];
+        }
+    }
+}
+
+/**
+ * Hand the latest save image to the save thread if it is idle. Called when
+ * saving and once per frame, to pick up saves made while the thread was busy.
+ */
+void save_file_flush_update(void) {
+    if (sSaveRequestPending && !sSaveFlushBusy) {
+        bcopy(sSaveRequestImage, sSaveFlushImage, SAVE_IMAGE_SIZE);
+        sSaveRequestPending = FALSE;
+        sSaveFlushBusy = TRUE;
+        osSendMesg(&sSaveFlushMesgQueue, NULL, OS_MESG_NOBLOCK);
+    }
+}
+
+/**
+ * Return whether some saved data hasn't been written to the save chip yet.
+ */
+s32 save_file_flush_pending(void) {
+    return sSaveRequestPending || sSaveFlushBusy;
+}
+
+/**
+ * Queue part of gSaveBuffer to be written to the save chip by the save thread.
+ */
+static void write_save_data(void *buffer, s32 size) {
+    bcopy(buffer, &sSaveRequestImage[(u8 *) buffer - (u8 *) &gSaveBuffer], size);
+    sSaveRequestPending = TRUE;
+    save_file_flush_update();
+}
+#else
+#define write_save_data write_eeprom_data
+#endif
 
 
 /**
@@ -215,7 +382,7 @@ static void restore_main_menu_data(s32 srcSlot) {
     bcopy(&gSaveBuffer.menuData[srcSlot], &gSaveBuffer.menuData[destSlot], sizeof(gSaveBuffer.menuData[destSlot]));
 
     // Write destination data to EEPROM
-    write_eeprom_data(&gSaveBuffer.menuData[destSlot], sizeof(gSaveBuffer.menuData[destSlot]));
+    write_save_data(&gSaveBuffer.menuData[destSlot], sizeof(gSaveBuffer.menuData[destSlot]));
 }
 
 static void save_main_menu_data(void) {
@@ -227,7 +394,7 @@ static void save_main_menu_data(void) {
         bcopy(&gSaveBuffer.menuData[0], &gSaveBuffer.menuData[1], sizeof(gSaveBuffer.menuData[1]));
 
         // Write to EEPROM
-        write_eeprom_data(gSaveBuffer.menuData, sizeof(gSaveBuffer.menuData));
+        write_save_data(gSaveBuffer.menuData, sizeof(gSaveBuffer.menuData));
 
         gMainMenuDataModified = FALSE;
     }
@@ -303,8 +470,8 @@ static void restore_save_file_data(s32 fileIndex, s32 srcSlot) {
           sizeof(gSaveBuffer.files[fileIndex][destSlot]));
 
     // Write destination data to EEPROM
-    write_eeprom_data(&gSaveBuffer.files[fileIndex][destSlot],
-                      sizeof(gSaveBuffer.files[fileIndex][destSlot]));
+    write_save_data(&gSaveBuffer.files[fileIndex][destSlot],
+                    sizeof(gSaveBuffer.files[fileIndex][destSlot]));
 }
 
 void save_file_do_save(s32 fileIndex) {
@@ -318,7 +485,7 @@ void save_file_do_save(s32 fileIndex) {
               sizeof(gSaveBuffer.files[fileIndex][1]));
 
         // Write to EEPROM
-        write_eeprom_data(gSaveBuffer.files[fileIndex], sizeof(gSaveBuffer.files[fileIndex]));
+        write_save_data(gSaveBuffer.files[fileIndex], sizeof(gSaveBuffer.files[fileIndex]));
 
         gSaveFileModified = FALSE;
     }
@@ -349,12 +516,20 @@ BAD_RETURN(s32) save_file_copy(s32 srcFileIndex, s32 destFileIndex) {
 void save_file_load_all(void) {
     s32 file;
     s32 validSlots;
+#ifdef SAVE_WRITE_THREAD
+    s32 readStatus;
+#endif
 
     gMainMenuDataModified = FALSE;
     gSaveFileModified = FALSE;
 
     bzero(&gSaveBuffer, sizeof(gSaveBuffer));
+#ifdef SAVE_WRITE_THREAD
+    readStatus = read_eeprom_data(&gSaveBuffer, sizeof(gSaveBuffer));
+    init_save_images(readStatus);
+#else
     read_eeprom_data(&gSaveBuffer, sizeof(gSaveBuffer));
+#endif
 
     // Verify the main menu data and create a backup copy if only one of the slots is valid.
     validSlots = verify_save_block_signature(&gSaveBuffer.menuData[0], sizeof(gSaveBuffer.menuData[0]), MENU_DATA_MAGIC);
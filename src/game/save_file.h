@@ -3,6 +3,7 @@
 
 #include <PR/ultratypes.h>
 
+#include "config.h"
 #include "types.h"
 #include "area.h"
 
@@ -138,6 +139,11 @@ void save_file_do_save(s32 fileIndex);
 void save_file_erase(s32 fileIndex);
 BAD_RETURN(s32) save_file_copy(s32 srcFileIndex, s32 destFileIndex);
 void save_file_load_all(void);
+#ifdef SAVE_WRITE_THREAD
+void create_thread_11(void);
+void save_file_flush_update(void);
+s32 save_file_flush_pending(void);
+#endif
 void save_file_reload(void);
 void save_file_collect_star_or_key(s16 coinScore, s16 starIndex);
 s32 save_file_exists(s32 fileIndex);
@@ -0,0 +1,65 @@
+#include <PR/ultratypes.h>
+
+#include "save_flush.h"
+
+/**
+ * This file writes a save image to the save chip, skipping the blocks that
+ * are already on it. It doesn't depend on the rest of the game, so that
+ * tools/savecheck can test it on the host with a simulated EEPROM.
+ */
+
+/**
+ * Return whether block 'block' of 'image' differs from 'committed'.
+ */
+static s32 save_flush_block_dirty(u8 *image, u8 *committed, u32 block) {
+    u32 i;
+
+    for (i = block * SAVE_FLUSH_BLOCK_SIZE; i < (block + 1) * SAVE_FLUSH_BLOCK_SIZE; i++) {
+        if (image[i] != committed[i]) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * Write the blocks of 'image' that differ from 'committed', the copy of what
+ * is on the save chip, and copy each block into 'committed' once it has been
+ * written. 'size' must be a multiple of SAVE_FLUSH_BLOCK_SIZE.
+ * Neighboring dirty blocks are written together, at most 'maxRunBlocks' at a
+ * time. Blocks are written in ascending order like the whole image would be,
+ * so the main slot of a save file is always written before its backup, and
+ * one of the two holds a complete copy at any point. Blocks that fail to write
+ * stay dirty and are written again by the next flush.
+ * Returns the number of blocks written.
+ */
+u32 save_flush(u8 *image, u8 *committed, u32 size, u32 maxRunBlocks, SaveFlushWriteFunc write) {
+    u32 numBlocks = size / SAVE_FLUSH_BLOCK_SIZE;
+    u32 written = 0;
+    u32 block = 0;
+    u32 start, offset, runSize, i;
+
+    while (block < numBlocks) {
+        if (!save_flush_block_dirty(image, committed, block)) {
+            block++;
+            continue;
+        }
+
+        start = block;
+        do {
+            block++;
+        } while (block < numBlocks && block - start < maxRunBlocks
+                 && save_flush_block_dirty(image, committed, block));
+
+        offset = start * SAVE_FLUSH_BLOCK_SIZE;
+        runSize = (block - start) * SAVE_FLUSH_BLOCK_SIZE;
+        if (write(offset, &image[offset], runSize) == 0) {
+            for (i = offset; i < offset + runSize; i++) {
+                committed[i] = image[i];
+            }
+            written += block - start;
+        }
+    }
+
+    return written;
+}
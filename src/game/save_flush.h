@@ -0,0 +1,17 @@
+#ifndef SAVE_FLUSH_H
+#define SAVE_FLUSH_H
+
+#include <PR/ultratypes.h>
+
+/// Size of an EEPROM block, the unit in which save images are compared
+#define SAVE_FLUSH_BLOCK_SIZE 8
+
+/**
+ * Write 'size' bytes at 'offset' in the save chip from 'data'. Returns 0 on
+ * success.
+ */
+typedef s32 (*SaveFlushWriteFunc)(u32 offset, u8 *data, u32 size);
+
+u32 save_flush(u8 *image, u8 *committed, u32 size, u32 maxRunBlocks, SaveFlushWriteFunc write);
+
+#endif // SAVE_FLUSH_H
@@ -4,6 +4,7 @@
 
 #include "engine/math_util.h"
 #include "engine/surface_collision.h"
+#include "game_init.h"
 #include "geo_misc.h"
 #include "level_table.h"
 #include "memory.h"
@@ -106,6 +107,77 @@ s8 gMarioOnIceOrCarpet;
 s8 sMarioOnFlyingCarpet;
 s16 sSurfaceTypeBelowShadow;
 
+#ifdef SHADOW_CACHE
+// A kept shadow may still be in use by the frame the RCP is drawing, so it is
+// only rewritten once it hasn't been drawn for this many frames.
+#define SHADOW_CACHE_MIN_AGE 2
+
+/**
+ * Everything an object's shadow is made from, apart from the floors below the
+ * outer vertices of 9 vertex shadows.
+ */
+struct ShadowCacheKey {
+    struct Object *obj;
+    struct Surface *floor;
+    f32 pos[3];
+    /* The floor's plane, since the surfaces of moving objects are reused. */
+    f32 floorNormal[3];
+    f32 floorOriginOffset;
+    f32 waterLevel;
+    s16 yaw;
+    s16 shadowScale;
+    u8 solidity;
+    s8 shadowType;
+};
+
+/**
+ * An object's shadow, kept while the object doesn't move.
+ */
+struct ShadowCacheEntry {
+    struct ShadowCacheKey key;
+    /* The shadow was made with `key` and is kept in `verts` and `gfx`. */
+    s8 stored;
+    s8 aboveWaterOrLava;
+    u32 lastUsed;
+    /* Either `gfx` or NULL if there is no shadow. */
+    Gfx *displayList;
+    Vtx verts[9];
+    Gfx gfx[5];
+};
+
+static struct ShadowCacheEntry sShadowCache[SHADOW_CACHE_ENTRIES];
+/* The entry the shadow being made is kept in, if any. */
+static struct ShadowCacheEntry *sShadowCacheStore = NULL;
+
+// See shadow.h for documentation.
+u32 gShadowCacheHits;
+u32 gShadowCacheMisses;
+#endif
+
+/**
+ * Allocate the vertices of a shadow with `count` vertices.
+ */
+Vtx *alloc_shadow_vertices(s32 count) {
+#ifdef SHADOW_CACHE
+    if (sShadowCacheStore != NULL) {
+        return sShadowCacheStore->verts;
+    }
+#endif
+    return alloc_display_list(count * sizeof(Vtx));
+}
+
+/**
+ * Allocate a shadow's display list. See add_shadow_to_display_list().
+ */
+Gfx *alloc_shadow_display_list(void) {
+#ifdef SHADOW_CACHE
+    if (sShadowCacheStore != NULL) {
+        return sShadowCacheStore->gfx;
+    }
+#endif
+    return alloc_display_list(5 * sizeof(Gfx));
+}
+
 /**
  * Let (oldZ, oldX) be the relative coordinates of a point on a rectangle,
  * assumed to be centered at the origin on the standard SM64 X-Z plane. This
@@ -626,8 +698,8 @@ Gfx *create_shadow_player(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale, u8 soli
         return NULL;
     }
 
-    verts = alloc_display_list(9 * sizeof(Vtx));
-    displayList = alloc_display_list(5 * sizeof(Gfx));
+    verts = alloc_shadow_vertices(9);
+    displayList = alloc_shadow_display_list();
     if (verts == NULL || displayList == NULL) {
         return NULL;
     }
@@ -654,8 +726,8 @@ Gfx *create_shadow_circle_9_verts(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale,
         return NULL;
     }
 
-    verts = alloc_display_list(9 * sizeof(Vtx));
-    displayList = alloc_display_list(5 * sizeof(Gfx));
+    verts = alloc_shadow_vertices(9);
+    displayList = alloc_shadow_display_list();
 
     if (verts == NULL || displayList == NULL) {
         return 0;
@@ -680,8 +752,8 @@ Gfx *create_shadow_circle_4_verts(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale,
         return NULL;
     }
 
-    verts = alloc_display_list(4 * sizeof(Vtx));
-    displayList = alloc_display_list(5 * sizeof(Gfx));
+    verts = alloc_shadow_vertices(4);
+    displayList = alloc_shadow_display_list();
 
     if (verts == NULL || displayList == NULL) {
         return 0;
@@ -713,8 +785,8 @@ Gfx *create_shadow_circle_assuming_flat_ground(f32 xPos, f32 yPos, f32 zPos, s16
         distBelowFloor = floorHeight - yPos;
     }
 
-    verts = alloc_display_list(4 * sizeof(Vtx));
-    displayList = alloc_display_list(5 * sizeof(Gfx));
+    verts = alloc_shadow_vertices(4);
+    displayList = alloc_shadow_display_list();
 
     if (verts == NULL || displayList == NULL) {
         return 0;
@@ -734,8 +806,8 @@ Gfx *create_shadow_circle_assuming_flat_ground(f32 xPos, f32 yPos, f32 zPos, s16
  * underneath the shadow is totally flat.
  */
 Gfx *create_shadow_rectangle(f32 halfWidth, f32 halfLength, f32 relY, u8 solidity) {
-    Vtx *verts = alloc_display_list(4 * sizeof(Vtx));
-    Gfx *displayList = alloc_display_list(5 * sizeof(Gfx));
+    Vtx *verts = alloc_shadow_vertices(4);
+    Gfx *displayList = alloc_shadow_display_list();
     f32 frontLeftX, frontLeftZ, frontRightX, frontRightZ, backLeftX, backLeftZ, backRightX, backRightZ;
 
     if (verts == NULL || displayList == NULL) {
@@ -846,6 +918,75 @@ Gfx *create_shadow_hardcoded_rectangle(f32 xPos, f32 yPos, f32 zPos, UNUSED s16
     return create_shadow_rectangle(halfWidth, halfLength, -distFromShadow, solidity);
 }
 
+#ifdef SHADOW_CACHE
+static s32 shadow_cache_key_matches(struct ShadowCacheKey *a, struct ShadowCacheKey *b) {
+    u32 *wordsA = (u32 *) a;
+    u32 *wordsB = (u32 *) b;
+    u32 i;
+
+    for (i = 0; i < sizeof(struct ShadowCacheKey) / sizeof(u32); i++) {
+        if (wordsA[i] != wordsB[i]) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Find the cache entry of the current graph node object's shadow. Entries are
+ * picked by the object's slot in the object pool. Return NULL if the shadow
+ * can't be cached.
+ *
+ * If the entry already holds this exact shadow, it can be drawn as is.
+ * Otherwise, if the entry was made with the same parameters on an earlier
+ * frame, the shadow is about to be made a second time in a row, so it is made
+ * straight into the entry to be kept from now on. Objects that move every frame
+ * never get that far and only cost a key update.
+ */
+static struct ShadowCacheEntry *shadow_cache_find(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale,
+                                                  u8 shadowSolidity, s8 shadowType,
+                                                  struct Surface *floor) {
+    struct Object *obj = (struct Object *) gCurGraphNodeObject;
+    struct ShadowCacheEntry *entry;
+    struct ShadowCacheKey key;
+
+    // Mario's shadow depends on his animation, and objects outside of the
+    // pool (like the mirror Mario) have no slot.
+    if (shadowType == SHADOW_CIRCLE_PLAYER || obj < gObjectPool
+        || obj >= gObjectPool + OBJECT_POOL_CAPACITY) {
+        return NULL;
+    }
+
+    bzero(&key, sizeof(key));
+    key.obj = obj;
+    key.floor = floor;
+    key.pos[0] = xPos;
+    key.pos[1] = yPos;
+    key.pos[2] = zPos;
+    if (floor != NULL) {
+        key.floorNormal[0] = floor->normal.x;
+        key.floorNormal[1] = floor->normal.y;
+        key.floorNormal[2] = floor->normal.z;
+        key.floorOriginOffset = floor->originOffset;
+    }
+    key.waterLevel = find_water_level(xPos, zPos);
+    key.yaw = obj->oFaceAngleYaw;
+    key.shadowScale = shadowScale;
+    key.solidity = shadowSolidity;
+    key.shadowType = shadowType;
+
+    entry = &sShadowCache[(obj - gObjectPool) % SHADOW_CACHE_ENTRIES];
+    if (!shadow_cache_key_matches(&entry->key, &key)) {
+        entry->key = key;
+        entry->stored = FALSE;
+    } else if (!entry->stored && gGlobalTimer - entry->lastUsed >= SHADOW_CACHE_MIN_AGE) {
+        sShadowCacheStore = entry;
+    }
+
+    return entry;
+}
+#endif
+
 /**
  * Create a shadow at the absolute position given, with the given parameters.
  * Return a pointer to the display list representing the shadow.
@@ -854,6 +995,9 @@ Gfx *create_shadow_below_xyz(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale, u8 s
                              s8 shadowType) {
     Gfx *displayList = NULL;
     struct Surface *pfloor;
+#ifdef SHADOW_CACHE
+    struct ShadowCacheEntry *entry;
+#endif
     find_floor(xPos, yPos, zPos, &pfloor);
 
     gShadowAboveWaterOrLava = FALSE;
@@ -865,6 +1009,20 @@ Gfx *create_shadow_below_xyz(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale, u8 s
         }
         sSurfaceTypeBelowShadow = pfloor->type;
     }
+
+#ifdef SHADOW_CACHE
+    entry = shadow_cache_find(xPos, yPos, zPos, shadowScale, shadowSolidity, shadowType, pfloor);
+    if (entry != NULL) {
+        if (entry->stored) {
+            gShadowCacheHits++;
+            gShadowAboveWaterOrLava = entry->aboveWaterOrLava;
+            entry->lastUsed = gGlobalTimer;
+            return entry->displayList;
+        }
+        gShadowCacheMisses++;
+    }
+#endif
+
     switch (shadowType) {
         case SHADOW_CIRCLE_9_VERTS:
             displayList = create_shadow_circle_9_verts(xPos, yPos, zPos, shadowScale, shadowSolidity);
@@ -897,5 +1055,15 @@ Gfx *create_shadow_below_xyz(f32 xPos, f32 yPos, f32 zPos, s16 shadowScale, u8 s
                                                             shadowSolidity, shadowType);
             break;
     }
+
+#ifdef SHADOW_CACHE
+    if (sShadowCacheStore != NULL) {
+        sShadowCacheStore->stored = TRUE;
+        sShadowCacheStore->aboveWaterOrLava = gShadowAboveWaterOrLava;
+        sShadowCacheStore->lastUsed = gGlobalTimer;
+        sShadowCacheStore->displayList = displayList;
+        sShadowCacheStore = NULL;
+    }
+#endif
     return displayList;
 }
@@ -4,6 +4,8 @@
 #include <PR/ultratypes.h>
 #include <PR/gbi.h>
 
+#include "config.h"
+
 /**
  * Shadow types. Shadows are circles, squares, or hardcoded rectangles, and
  * can be composed of either 4 or 9 vertices.
@@ -43,6 +45,15 @@ extern s8 gShadowAboveWaterOrLava;
  */
 extern s8 gMarioOnIceOrCarpet;
 
+#ifdef SHADOW_CACHE
+/**
+ * Number of object shadows drawn from the shadow cache, and number of object
+ * shadows that had to be made, since these were last reset.
+ */
+extern u32 gShadowCacheHits;
+extern u32 gShadowCacheMisses;
+#endif
+
 /**
  * Given the (x, y, z) location of an object, create a shadow below that object
  * with the given initial solidity and "shadowType" (described above).
@@ -124,6 +124,45 @@ u8 sSkyboxColors[][3] = {
  */
 #define SKYBOX_ROWS (8)
 
+/**
+ * The most columns and rows of tiles that can be on screen at once. A screen-sized window
+ * that isn't aligned to the tiles covers parts of 3 tiles in each direction.
+ */
+#define SKYBOX_GRID_COLS (SCREEN_WIDTH / SKYBOX_TILE_WIDTH + 1)
+#define SKYBOX_GRID_ROWS (SCREEN_HEIGHT / SKYBOX_TILE_HEIGHT + 1)
+
+/**
+ * 5 commands for the start and end, plus 7 for each tile
+ */
+#define SKYBOX_DL_SIZE (5 + SKYBOX_GRID_COLS * SKYBOX_GRID_ROWS * 7)
+
+/**
+ * A skybox display list kept from an earlier frame, with the vertices and matrix it uses.
+ *
+ * The tiles only change when the camera turns far enough to bring another tile into view, so the
+ * display list is only rebuilt then. Otherwise only the ortho matrix is updated. Each player has two
+ * of these and alternates between them whenever something changes, so the one the RCP may still be
+ * drawing from the last frame is never written to.
+ */
+struct SkyboxDisplayList {
+    Gfx dl[SKYBOX_DL_SIZE];
+    Vtx vertices[SKYBOX_GRID_COLS * SKYBOX_GRID_ROWS * 4];
+    Mtx ortho;
+    /// The first visible tile, and how many columns and rows of tiles are drawn from there
+    s32 firstTile;
+    s8 numCols;
+    s8 numRows;
+    s8 background;
+    s8 colorIndex;
+    /// The scaled position the ortho matrix was made for
+    s32 scaledX;
+    s32 scaledY;
+    u8 valid;
+};
+
+static struct SkyboxDisplayList sSkyboxDisplayLists[2][2];
+static u8 sSkyboxDisplayListIndex[2];
+
 
 /**
  * Convert the camera's yaw into an x position into the scaled skybox image.
@@ -193,98 +232,148 @@ static s32 get_top_left_tile_idx(s8 player) {
  *                  into an x and y by modulus and division by SKYBOX_COLS. x and y are then scaled by
  *                  SKYBOX_TILE_WIDTH to get a point in world space.
  */
-Vtx *make_skybox_rect(s32 tileIndex, s8 colorIndex) {
-    Vtx *verts = alloc_display_list(4 * sizeof(*verts));
+static void make_skybox_rect(Vtx *verts, s32 tileIndex, s8 colorIndex) {
     s16 x = tileIndex % SKYBOX_COLS * SKYBOX_TILE_WIDTH;
     s16 y = SKYBOX_HEIGHT - tileIndex / SKYBOX_COLS * SKYBOX_TILE_HEIGHT;
 
-    if (verts != NULL) {
-        make_vertex(verts, 0, x, y, -1, 0, 0, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
-                    sSkyboxColors[colorIndex][2], 255);
-        make_vertex(verts, 1, x, y - SKYBOX_TILE_HEIGHT, -1, 0, 31 << 5, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
-                    sSkyboxColors[colorIndex][2], 255);
-        make_vertex(verts, 2, x + SKYBOX_TILE_WIDTH, y - SKYBOX_TILE_HEIGHT, -1, 31 << 5, 31 << 5, sSkyboxColors[colorIndex][0],
-                    sSkyboxColors[colorIndex][1], sSkyboxColors[colorIndex][2], 255);
-        make_vertex(verts, 3, x + SKYBOX_TILE_WIDTH, y, -1, 31 << 5, 0, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
-                    sSkyboxColors[colorIndex][2], 255);
-    } else {
-    }
-    return verts;
+    make_vertex(verts, 0, x, y, -1, 0, 0, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
+                sSkyboxColors[colorIndex][2], 255);
+    make_vertex(verts, 1, x, y - SKYBOX_TILE_HEIGHT, -1, 0, 31 << 5, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
+                sSkyboxColors[colorIndex][2], 255);
+    make_vertex(verts, 2, x + SKYBOX_TILE_WIDTH, y - SKYBOX_TILE_HEIGHT, -1, 31 << 5, 31 << 5, sSkyboxColors[colorIndex][0],
+                sSkyboxColors[colorIndex][1], sSkyboxColors[colorIndex][2], 255);
+    make_vertex(verts, 3, x + SKYBOX_TILE_WIDTH, y, -1, 31 << 5, 0, sSkyboxColors[colorIndex][0], sSkyboxColors[colorIndex][1],
+                sSkyboxColors[colorIndex][2], 255);
 }
 
 /**
- * Draws a 3x3 grid of 32x32 sections of the original skybox image.
+ * Draws the grid of 32x32 sections of the original skybox image that are on screen.
  * The row and column are converted into an index into the skybox's tile list, which is then drawn in
  * world space so that the tiles will rotate with the camera.
  */
-void draw_skybox_tile_grid(Gfx **dlist, s8 background, s8 player, s8 colorIndex) {
+static void draw_skybox_tile_grid(Gfx **dlist, struct SkyboxDisplayList *skybox) {
+    Vtx *vertices = skybox->vertices;
     s32 row;
     s32 col;
 
-    for (row = 0; row < 3; row++) {
-        for (col = 0; col < 3; col++) {
-            s32 tileIndex = sSkyBoxInfo[player].upperLeftTile + row * SKYBOX_COLS + col;
+    for (row = 0; row < skybox->numRows; row++) {
+        for (col = 0; col < skybox->numCols; col++) {
+            s32 tileIndex = skybox->firstTile + row * SKYBOX_COLS + col;
             if (tileIndex >= SKYBOX_ROWS * SKYBOX_COLS) {
                 continue;
             }
 
             const u8 *const texture =
-                (*(SkyboxTexture *) segmented_to_virtual(sSkyboxTextures[background]))[tileIndex];
-            Vtx *vertices = make_skybox_rect(tileIndex, colorIndex);
+                (*(SkyboxTexture *) segmented_to_virtual(sSkyboxTextures[skybox->background]))[tileIndex];
+            make_skybox_rect(vertices, tileIndex, skybox->colorIndex);
 
             gLoadBlockTexture((*dlist)++, 32, 32, G_IM_FMT_RGBA, texture);
             gSPVertex((*dlist)++, VIRTUAL_TO_PHYSICAL(vertices), 4, 0);
             gSPDisplayList((*dlist)++, dl_draw_quad_verts_0123);
+            vertices += 4;
         }
     }
 }
 
-void *create_skybox_ortho_matrix(s8 player) {
-    f32 left = sSkyBoxInfo[player].scaledX;
-    f32 right = sSkyBoxInfo[player].scaledX + SCREEN_WIDTH;
-    f32 bottom = sSkyBoxInfo[player].scaledY - SCREEN_HEIGHT;
-    f32 top = sSkyBoxInfo[player].scaledY;
-    Mtx *mtx = alloc_display_list(sizeof(*mtx));
+/**
+ * Get the window into the scaled skybox image that is on screen.
+ */
+static void get_skybox_ortho_bounds(s8 player, f32 *left, f32 *right, f32 *bottom, f32 *top) {
+    *left = sSkyBoxInfo[player].scaledX;
+    *right = sSkyBoxInfo[player].scaledX + SCREEN_WIDTH;
+    *bottom = sSkyBoxInfo[player].scaledY - SCREEN_HEIGHT;
+    *top = sSkyBoxInfo[player].scaledY;
 
 #ifdef WIDESCREEN
     f32 half_width = (4.0f / 3.0f) / GFX_DIMENSIONS_ASPECT_RATIO * SCREEN_WIDTH / 2;
     f32 center = (sSkyBoxInfo[player].scaledX + SCREEN_WIDTH / 2);
     if (half_width < SCREEN_WIDTH / 2) {
         // A wider screen than 4:3
-        left = center - half_width;
-        right = center + half_width;
+        *left = center - half_width;
+        *right = center + half_width;
     }
 #endif
+}
 
-    if (mtx != NULL) {
-        guOrtho(mtx, left, right, bottom, top, 0.0f, 3.0f, 1.0f);
-    } else {
-    }
+/**
+ * Finds the tiles that overlap the visible window. With a wider screen than 4:3 the window is
+ * narrower than a screen, so fewer columns may be needed.
+ */
+static void get_skybox_visible_tiles(s8 player, s32 *firstTile, s32 *numCols, s32 *numRows) {
+    f32 left, right, bottom, top;
+    s32 firstCol, lastCol, firstRow, lastRow;
+
+    get_skybox_ortho_bounds(player, &left, &right, &bottom, &top);
+
+    firstCol = (s32) left / SKYBOX_TILE_WIDTH;
+    lastCol = ((s32) right + (right > (s32) right) - 1) / SKYBOX_TILE_WIDTH;
+    firstRow = (SKYBOX_HEIGHT - (s32) top) / SKYBOX_TILE_HEIGHT;
+    lastRow = (SKYBOX_HEIGHT - (s32) bottom - 1) / SKYBOX_TILE_HEIGHT;
+
+    // Offset from the upper-left tile, so the wrapping of the tile index stays the same
+    *firstTile = sSkyBoxInfo[player].upperLeftTile
+                 + (firstRow - (SKYBOX_HEIGHT - sSkyBoxInfo[player].scaledY) / SKYBOX_TILE_HEIGHT) * SKYBOX_COLS
+                 + (firstCol - sSkyBoxInfo[player].scaledX / SKYBOX_TILE_WIDTH);
+    *numCols = MIN(lastCol - firstCol + 1, SKYBOX_GRID_COLS);
+    *numRows = MIN(lastRow - firstRow + 1, SKYBOX_GRID_ROWS);
+}
 
-    return mtx;
+static s32 skybox_tiles_match(struct SkyboxDisplayList *skybox, s32 firstTile, s32 numCols, s32 numRows,
+                              s8 background, s8 colorIndex) {
+    return skybox->valid && skybox->firstTile == firstTile && skybox->numCols == numCols
+           && skybox->numRows == numRows && skybox->background == background
+           && skybox->colorIndex == colorIndex;
+}
+
+static void create_skybox_ortho_matrix(s8 player, Mtx *mtx) {
+    f32 left, right, bottom, top;
+
+    get_skybox_ortho_bounds(player, &left, &right, &bottom, &top);
+    guOrtho(mtx, left, right, bottom, top, 0.0f, 3.0f, 1.0f);
 }
 
 /**
- * Creates the skybox's display list, then draws the 3x3 grid of tiles.
+ * Returns the skybox's display list. A display list from an earlier frame is reused when the same
+ * tiles are visible, and only its ortho matrix is updated when the camera has turned.
  */
-Gfx *init_skybox_display_list(s8 player, s8 background, s8 colorIndex) {
-    s32 dlCommandCount = 5 + (3 * 3) * 7; // 5 for the start and end, plus 9 skybox tiles
-    void *skybox = alloc_display_list(dlCommandCount * sizeof(Gfx));
-    Gfx *dlist = skybox;
+static Gfx *init_skybox_display_list(s8 player, s8 background, s8 colorIndex) {
+    struct SkyboxDisplayList *skybox = &sSkyboxDisplayLists[player][sSkyboxDisplayListIndex[player]];
+    s32 firstTile, numCols, numRows;
+    Gfx *dlist;
+
+    get_skybox_visible_tiles(player, &firstTile, &numCols, &numRows);
+
+    if (skybox_tiles_match(skybox, firstTile, numCols, numRows, background, colorIndex)
+        && skybox->scaledX == sSkyBoxInfo[player].scaledX
+        && skybox->scaledY == sSkyBoxInfo[player].scaledY) {
+        return skybox->dl;
+    }
 
-    if (skybox == NULL) {
-        return NULL;
-    } else {
-        Mtx *ortho = create_skybox_ortho_matrix(player);
+    sSkyboxDisplayListIndex[player] ^= 1;
+    skybox = &sSkyboxDisplayLists[player][sSkyboxDisplayListIndex[player]];
 
+    if (!skybox_tiles_match(skybox, firstTile, numCols, numRows, background, colorIndex)) {
+        skybox->firstTile = firstTile;
+        skybox->numCols = numCols;
+        skybox->numRows = numRows;
+        skybox->background = background;
+        skybox->colorIndex = colorIndex;
+        skybox->valid = TRUE;
+
+        dlist = skybox->dl;
         gSPDisplayList(dlist++, dl_skybox_begin);
-        gSPMatrix(dlist++, VIRTUAL_TO_PHYSICAL(ortho), G_MTX_PROJECTION | G_MTX_MUL | G_MTX_NOPUSH);
+        gSPMatrix(dlist++, VIRTUAL_TO_PHYSICAL(&skybox->ortho), G_MTX_PROJECTION | G_MTX_MUL | G_MTX_NOPUSH);
         gSPDisplayList(dlist++, dl_skybox_tile_tex_settings);
-        draw_skybox_tile_grid(&dlist, background, player, colorIndex);
+        draw_skybox_tile_grid(&dlist, skybox);
         gSPDisplayList(dlist++, dl_skybox_end);
         gSPEndDisplayList(dlist);
     }
-    return skybox;
+
+    skybox->scaledX = sSkyBoxInfo[player].scaledX;
+    skybox->scaledY = sSkyBoxInfo[player].scaledY;
+    create_skybox_ortho_matrix(player, &skybox->ortho);
+
+    return skybox->dl;
 }
 
 /**
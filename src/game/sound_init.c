@@ -2,6 +2,7 @@
 
 #include "area.h"
 #include "audio/external.h"
+#include "demo_bench.h"
 #include "engine/graph_node.h"
 #include "engine/math_util.h"
 #include "level_table.h"
@@ -349,10 +350,12 @@ void thread4_sound(UNUSED void *arg) {
         if (gResetTimer < 25) {
             struct SPTask *spTask;
             profiler_log_thread4_time();
+            DEMO_BENCH_BEGIN(DEMO_BENCH_AUDIO_THREAD);
             spTask = create_next_audio_frame_task(); 
             if (spTask != NULL) {
                 dispatch_audio_sptask(spTask);
             }
+            DEMO_BENCH_END(DEMO_BENCH_AUDIO_THREAD);
             profiler_log_thread4_time();
         }
     }
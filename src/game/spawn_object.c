@@ -1,4 +1,4 @@
-#include <PR/ultratypes.h>
+#include <ultra64.h>
 
 #include "audio/external.h"
 #include "engine/geo_layout.h"
@@ -13,6 +13,36 @@
 #include "spawn_object.h"
 #include "types.h"
 
+/**
+ * Free slots that an allocation into each object list has to leave for the
+ * other lists. Unimportant objects that hit their reserve replace the oldest
+ * unimportant object instead of taking a free slot.
+ */
+static const u8 sObjectListReserve[NUM_OBJ_LISTS] = {
+    0,                               // OBJ_LIST_PLAYER
+    0,                               // OBJ_LIST_UNUSED_1
+    0,                               // OBJ_LIST_DESTRUCTIVE
+    0,                               // OBJ_LIST_UNUSED_3
+    0,                               // OBJ_LIST_GENACTOR
+    0,                               // OBJ_LIST_PUSHABLE
+    0,                               // OBJ_LIST_LEVEL
+    0,                               // OBJ_LIST_UNUSED_7
+    0,                               // OBJ_LIST_DEFAULT
+    0,                               // OBJ_LIST_SURFACE
+    0,                               // OBJ_LIST_POLELIKE
+    0,                               // OBJ_LIST_SPAWNER
+    OBJECT_POOL_UNIMPORTANT_RESERVE, // OBJ_LIST_UNIMPORTANT
+};
+
+static s32 sFreeObjectCount = 0;
+
+/**
+ * Stand-in handed out by spawn_object_at_origin when the pool is exhausted.
+ * It is never in an object list, so it is never updated or drawn, and it is
+ * always deactivated, so anything holding on to it sees an unloaded object.
+ */
+static struct Object sOverflowObject;
+
 /**
  * An unused linked list struct that seems to have been replaced by ObjectNode.
  */
@@ -145,6 +175,8 @@ void init_free_object_list(void) {
 
     // End the list
     obj->header.next = NULL;
+
+    sFreeObjectCount = poolLength;
 }
 
 /**
@@ -198,58 +230,39 @@ void unload_object(struct Object *obj) {
     obj->header.gfx.node.flags &= ~GRAPH_RENDER_ACTIVE;
 
     deallocate_object(&gFreeObjectList, &obj->header);
+    sFreeObjectCount++;
 }
 
 /**
- * Attempt to allocate a new object slot into the given object list, freeing
- * an unimportant object if necessary. If this is not possible, hang using an
- * infinite loop.
+ * Return the object to unload when the pool is full. Objects are appended to
+ * the end of their list, so the head of the unimportant list is always the
+ * oldest unimportant object. The object currently updating is skipped, since
+ * it may be the one spawning.
  */
-struct Object *allocate_object(struct ObjectNode *objList) {
-    s32 i;
-    struct Object *obj = try_allocate_object(objList, &gFreeObjectList);
+static struct Object *get_eviction_candidate(void) {
+    struct ObjectNode *listHead = &gObjectLists[OBJ_LIST_UNIMPORTANT];
+    struct ObjectNode *obj = listHead->next;
 
-    // The object list is full if the newly created pointer is NULL.
-    // If this happens, we first attempt to unload unimportant objects
-    // in order to finish allocating the object.
-    if (obj == NULL) {
-        // Look for an unimportant object to kick out.
-        struct Object *unimportantObj = find_unimportant_object();
-
-        // If no unimportant object exists, then the object pool is exhausted.
-        if (unimportantObj == NULL) {
-            // We've met with a terrible fate.
-            while (TRUE) {
-            }
-        } else {
-            // If an unimportant object does exist, unload it and take its slot.
-            unload_object(unimportantObj);
-            obj = try_allocate_object(objList, &gFreeObjectList);
-            if (gCurrentObject == obj) {
-                //! Uh oh, the unimportant object was in the middle of
-                //  updating! This could cause some interesting logic errors,
-                //  but I don't know of any unimportant objects that spawn
-                //  other objects.
-            }
-        }
+    if ((struct Object *) obj == gCurrentObject) {
+        obj = obj->next;
     }
 
-    // Initialize object fields
+    return obj != listHead ? (struct Object *) obj : NULL;
+}
 
+/**
+ * Reset the fields of a newly allocated object.
+ */
+static void init_object_fields(struct Object *obj) {
     obj->activeFlags = ACTIVE_FLAG_ACTIVE | ACTIVE_FLAG_UNK8;
     obj->parentObj = obj;
     obj->prevObj = NULL;
     obj->collidedObjInteractTypes = 0;
     obj->numCollidedObjs = 0;
 
+    bzero(&obj->rawData, sizeof(obj->rawData));
 #if IS_64_BIT
-    for (i = 0; i < 0x50; i++) {
-        obj->rawData.asS32[i] = 0;
-        obj->ptrData.asVoidPtr[i] = NULL;
-    }
-#else
-    // -O2 needs everything until = on the same line
-    for (i = 0; i < 0x50; i++) obj->rawData.asS32[i] = 0;
+    bzero(&obj->ptrData, sizeof(obj->ptrData));
 #endif
 
     obj->unused1 = 0;
@@ -289,6 +302,31 @@ struct Object *allocate_object(struct ObjectNode *objList) {
     obj->header.gfx.pos[1] = -10000.0f;
     obj->header.gfx.pos[2] = -10000.0f;
     obj->header.gfx.throwMatrix = NULL;
+}
+
+/**
+ * Attempt to allocate a new object slot into the given object list, unloading
+ * the oldest unimportant object if the list's reserve is reached or the pool
+ * is full. Return NULL if no slot can be made free.
+ */
+struct Object *allocate_object(struct ObjectNode *objList) {
+    struct Object *obj = NULL;
+    struct Object *evictedObj;
+
+    if (sFreeObjectCount > sObjectListReserve[objList - gObjectLists]) {
+        obj = try_allocate_object(objList, &gFreeObjectList);
+    }
+
+    if (obj == NULL) {
+        if ((evictedObj = get_eviction_candidate()) == NULL) {
+            return NULL;
+        }
+        unload_object(evictedObj);
+        obj = try_allocate_object(objList, &gFreeObjectList);
+    }
+
+    sFreeObjectCount--;
+    init_object_fields(obj);
 
     return obj;
 }
@@ -309,6 +347,7 @@ static void snap_object_to_floor(struct Object *obj) {
 
 /**
  * Spawn an object at the origin with the behavior script at virtual address bhvScript.
+ * Return NULL if the object pool is exhausted.
  */
 struct Object *create_object(const BehaviorScript *bhvScript) {
     s32 objListIndex;
@@ -326,6 +365,9 @@ struct Object *create_object(const BehaviorScript *bhvScript) {
 
     objList = &gObjectLists[objListIndex];
     obj = allocate_object(objList);
+    if (obj == NULL) {
+        return NULL;
+    }
 
     obj->curBhvCommand = bhvScript;
     obj->behavior = behavior;
@@ -352,6 +394,21 @@ struct Object *create_object(const BehaviorScript *bhvScript) {
     return obj;
 }
 
+/**
+ * Return the stand-in object for a spawn that failed because the object pool
+ * is exhausted, for callers that expect a valid object.
+ */
+struct Object *create_overflow_object(const BehaviorScript *bhvScript) {
+    struct Object *obj = &sOverflowObject;
+
+    init_object_fields(obj);
+    obj->activeFlags = ACTIVE_FLAG_DEACTIVATED;
+    obj->curBhvCommand = bhvScript;
+    obj->behavior = bhvScript;
+
+    return obj;
+}
+
 /**
  * Mark an object to be unloaded at the end of the frame.
  */
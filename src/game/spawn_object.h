@@ -7,6 +7,7 @@ void init_free_object_list(void);
 void clear_object_lists(struct ObjectNode *objLists);
 void unload_object(struct Object *obj);
 struct Object *create_object(const BehaviorScript *bhvScript);
+struct Object *create_overflow_object(const BehaviorScript *bhvScript);
 void mark_obj_for_deletion(struct Object *obj);
 
 #endif // SPAWN_OBJECT_H
@@ -1,4 +1,5 @@
 #include <PR/ultratypes.h>
+#include <PR/os_convert.h>
 
 #include "debug_utils.h"
 #include "gd_memory.h"
@@ -11,159 +12,201 @@
  * goddard's heap. However, the actual, useable allocation functions
  * are `gd_malloc()`, `gd_malloc_perm()`, and `gd_malloc_temp()`, as
  * well as `gd_free()`. This file is for managing the underlying memory
- * block lists.
+ * blocks.
+ *
+ * Every block starts with an inline `GMemBlock` header, so allocating does
+ * not need any separate list metadata, and freeing finds the block straight
+ * from the pointer. Free blocks are kept in buckets by size: bucket `i` holds
+ * blocks of [8 << i, 16 << i) bytes and the last bucket holds everything
+ * larger. Since every block in a bucket is smaller than every block in the
+ * buckets above it, a best fit search only has to look at the first bucket
+ * that contains a block of a suitable size and permanence.
+ *
+ * Every memory range added with `gd_add_mem_to_heap` is a heap with its own
+ * buckets, and a request only looks at the heaps of its permanence. The
+ * temporary heaps are borrowed from the Z-buffer and framebuffers, which the
+ * game draws over once the head has loaded, so the headers and free lists in
+ * them can't be trusted after that. Permanent requests never touch them, and
+ * the statistics are counted as blocks are allocated and freed instead of
+ * being read back from the headers.
  */
 
+#define GMEM_MIN_FREE_SIZE (sizeof(struct GMemBlock) - GMEM_BLOCK_HEADER_SIZE)
+#define GMEM_BUCKET_COUNT 16
+#define GMEM_MAX_HEAPS 4
+
+/// A memory range added with `gd_add_mem_to_heap`. It ends with a used block
+/// of size zero so no block merges past it.
+struct GMemHeap {
+    struct GMemBlock *freeBuckets[GMEM_BUCKET_COUNT];
+    u32 freeBucketMask;
+    u8 permanence;
+    u32 usedSize;
+    u32 usedEntries;
+    u32 freeSize;
+    u32 freeEntries;
+    u16 bucketEntries[GMEM_BUCKET_COUNT];
+};
+
 /* bss */
-static struct GMemBlock *sFreeBlockListHead;
-static struct GMemBlock *sUsedBlockListHead;
-static struct GMemBlock *sEmptyBlockListHead;
+static struct GMemHeap sHeaps[GMEM_MAX_HEAPS];
+static s32 sHeapCount;
+
+static u32 sAllocCount;
+static u32 sFailedAllocCount;
+static u32 sFreeCount;
+static u32 sAllocTime;
+static u32 sFreeTime;
 
 /* Forward Declarations */
-void empty_mem_block(struct GMemBlock *);
-struct GMemBlock *into_free_memblock(struct GMemBlock *);
-struct GMemBlock *make_mem_block(u32, u8);
-u32 print_list_stats(struct GMemBlock *, s32, s32);
+u32 print_list_stats(s32 blockType, s32 permanence);
+
+#define NEXT_MEM_BLOCK(block) \
+    ((struct GMemBlock *) ((u8 *) (block) + GMEM_BLOCK_HEADER_SIZE + (block)->size))
+
+static u32 mem_bucket_index(u32 size) {
+    u32 bucket = 0;
+
+    size >>= 4;
+    while (size != 0 && bucket < GMEM_BUCKET_COUNT - 1) {
+        size >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
 
 /**
- * Empty a `GMemBlock` into a default state. This empty block
- * doesn't point to any data, nor does it have any size. The
- * block is removed from whatever list is was in, and is added
- * to the empty block list.
+ * Turn `block` into a free block and add it to its size bucket.
  */
-void empty_mem_block(struct GMemBlock *block) {
+static void add_free_memblock(struct GMemBlock *block) {
+    struct GMemHeap *heap = &sHeaps[block->heap];
+    u32 bucket = mem_bucket_index(block->size);
+
+    block->blockType = G_MEM_BLOCK_FREE;
+    block->bucket = bucket;
+    block->prev = NULL;
+    block->next = heap->freeBuckets[bucket];
     if (block->next != NULL) {
-        block->next->prev = block->prev;
+        block->next->prev = block;
     }
+    heap->freeBuckets[bucket] = block;
+    heap->freeBucketMask |= 1 << bucket;
+    heap->freeSize += block->size;
+    heap->freeEntries++;
+    heap->bucketEntries[bucket]++;
+}
+
+/**
+ * Remove a free `block` from its size bucket.
+ */
+static void remove_free_memblock(struct GMemBlock *block) {
+    struct GMemHeap *heap = &sHeaps[block->heap];
 
     if (block->prev != NULL) {
         block->prev->next = block->next;
+    } else {
+        heap->freeBuckets[block->bucket] = block->next;
+        if (block->next == NULL) {
+            heap->freeBucketMask &= ~(1 << block->bucket);
+        }
     }
-
-    switch (block->blockType) {
-        case G_MEM_BLOCK_FREE:
-            if (block->prev == NULL) {
-                sFreeBlockListHead = block->next;
-            }
-            break;
-        case G_MEM_BLOCK_USED:
-            if (block->prev == NULL) {
-                sUsedBlockListHead = block->next;
-            }
-            break;
-    }
-
-    block->next = sEmptyBlockListHead;
     if (block->next != NULL) {
-        sEmptyBlockListHead->prev = block;
+        block->next->prev = block->prev;
     }
-
-    sEmptyBlockListHead = block;
-    block->prev = NULL;
-    block->ptr = NULL;
-    block->size = 0;
+    heap->freeSize -= block->size;
+    heap->freeEntries--;
+    heap->bucketEntries[block->bucket]--;
 }
 
 /**
- * Transform a `GMemBlock` into a free block that points to memory available
- * for allocation.
+ * Free memory allocated on the goddard heap. The block is merged with the
+ * block after it if that is free and has the same permanence.
  *
- * @returns pointer to the free `GMemBlock` */
-struct GMemBlock *into_free_memblock(struct GMemBlock *block) {
-    struct GMemBlock *freeBlock;
-    void *ptr;
-    u8 permanence;
-    u32 space;
+ * @param ptr pointer to heap allocated memory
+ * @returns size of memory freed
+ * @retval  0    `ptr` did not point to a valid memory block
+ */
+u32 gd_free_mem(void *ptr) {
+    struct GMemBlock *block = (struct GMemBlock *) ((u8 *) ptr - GMEM_BLOCK_HEADER_SIZE);
+    struct GMemBlock *nextBlock;
+    u32 bytesFreed;
+    s32 startTime = gd_get_ostime();
 
-    ptr = block->ptr;
-    space = block->size;
-    permanence = block->permFlag;
+    if (block->blockType != G_MEM_BLOCK_USED) {
+        fatal_printf("Free() Not a valid memory block");
+        return 0;
+    }
 
-    empty_mem_block(block);
-    freeBlock = make_mem_block(G_MEM_BLOCK_FREE, permanence);
-    freeBlock->ptr = ptr;
-    freeBlock->size = space;
-    freeBlock->permFlag = permanence;
+    bytesFreed = block->size;
+    sHeaps[block->heap].usedSize -= block->size;
+    sHeaps[block->heap].usedEntries--;
+    nextBlock = NEXT_MEM_BLOCK(block);
+    if (nextBlock->blockType == G_MEM_BLOCK_FREE && nextBlock->permFlag == block->permFlag) {
+        remove_free_memblock(nextBlock);
+        block->size += GMEM_BLOCK_HEADER_SIZE + nextBlock->size;
+    }
+    add_free_memblock(block);
 
-    return freeBlock;
+    sFreeCount++;
+    sFreeTime += gd_get_ostime() - startTime;
+    return bytesFreed;
 }
 
 /**
- * Allocate a new `GMemBlock` structure of the given type and permanence.
- * It does not assign any heap space to the new block.
- *
- * @param blockType either `G_MEM_BLOCK_FREE` or `G_MEM_BLOCK_USED`
- * @param permFlag  some sort of permanence value, where setting one the upper
- *                  four bits imply a permanent block, while setting one the lower
- *                  four bits imply a temporary block
- * @returns a pointer to the new `GMemBlock`
+ * Find the smallest free block of at least `size` bytes in `heap` that shares
+ * a permanence bit with `permanence`.
  */
-struct GMemBlock *make_mem_block(u32 blockType, u8 permFlag) {
-    struct GMemBlock *newMemBlock;
-
-    if (sEmptyBlockListHead == NULL) {
-        sEmptyBlockListHead = (struct GMemBlock *) gd_allocblock(sizeof(struct GMemBlock));
+static struct GMemBlock *find_best_fit_in_heap(struct GMemHeap *heap, u32 size, u8 permanence) {
+    struct GMemBlock *foundBlock = NULL;
+    struct GMemBlock *curBlock;
+    u32 bucket;
+    u32 mask;
 
-        if (sEmptyBlockListHead == NULL) {
-            fatal_printf("MakeMemBlock() unable to allocate");
+    for (bucket = mem_bucket_index(size); bucket < GMEM_BUCKET_COUNT; bucket++) {
+        mask = heap->freeBucketMask >> bucket;
+        if (mask == 0) {
+            break;
+        }
+        if (!(mask & 1)) {
+            continue;
         }
 
-        sEmptyBlockListHead->next = NULL;
-        sEmptyBlockListHead->prev = NULL;
-    }
-
-    newMemBlock = sEmptyBlockListHead;
-    if ((sEmptyBlockListHead = newMemBlock->next) != NULL) {
-        newMemBlock->next->prev = NULL;
-    }
-
-    switch (blockType) {
-        case G_MEM_BLOCK_FREE:
-            newMemBlock->next = sFreeBlockListHead;
-            if (newMemBlock->next != NULL) {
-                sFreeBlockListHead->prev = newMemBlock;
-            }
-            sFreeBlockListHead = newMemBlock;
-            break;
-        case G_MEM_BLOCK_USED:
-            newMemBlock->next = sUsedBlockListHead;
-            if (newMemBlock->next != NULL) {
-                sUsedBlockListHead->prev = newMemBlock;
+        for (curBlock = heap->freeBuckets[bucket]; curBlock != NULL; curBlock = curBlock->next) {
+            if ((curBlock->permFlag & permanence) && curBlock->size >= size) {
+                if (curBlock->size == size) {
+                    return curBlock;
+                }
+                if (foundBlock == NULL || curBlock->size < foundBlock->size) {
+                    foundBlock = curBlock;
+                }
             }
-            sUsedBlockListHead = newMemBlock;
+        }
+        if (foundBlock != NULL) {
             break;
-        default:
-            fatal_printf("unkown memblock type");
+        }
     }
-    newMemBlock->prev = NULL;
-    newMemBlock->blockType = (u8) blockType;
-    newMemBlock->permFlag = permFlag;
-
-    return newMemBlock;
+    return foundBlock;
 }
 
 /**
- * Free memory allocated on the goddard heap.
- *
- * @param ptr pointer to heap allocated memory
- * @returns size of memory freed
- * @retval  0    `ptr` did not point to a valid memory block
+ * Find the smallest free block of at least `size` bytes in the heaps of
+ * `permanence`.
  */
-u32 gd_free_mem(void *ptr) {
-    register struct GMemBlock *curBlock;
-    u32 bytesFreed;
-    register u8 *targetBlock = ptr;
+static struct GMemBlock *find_best_fit(u32 size, u8 permanence) {
+    struct GMemBlock *foundBlock = NULL;
+    struct GMemBlock *curBlock;
+    s32 i;
 
-    for (curBlock = sUsedBlockListHead; curBlock != NULL; curBlock = curBlock->next) {
-        if (targetBlock == curBlock->ptr) {
-            bytesFreed = curBlock->size;
-            into_free_memblock(curBlock);
-            return bytesFreed;
+    for (i = 0; i < sHeapCount; i++) {
+        if (!(sHeaps[i].permanence & permanence)) {
+            continue;
+        }
+        curBlock = find_best_fit_in_heap(&sHeaps[i], size, permanence);
+        if (curBlock != NULL && (foundBlock == NULL || curBlock->size < foundBlock->size)) {
+            foundBlock = curBlock;
         }
     }
-
-    fatal_printf("Free() Not a valid memory block");
-    return 0;
+    return foundBlock;
 }
 
 /**
@@ -174,50 +217,37 @@ u32 gd_free_mem(void *ptr) {
  * @retval NULL could not fulfill the request
  */
 void *gd_request_mem(u32 size, u8 permanence) {
-    struct GMemBlock *foundBlock = NULL;
-    struct GMemBlock *curBlock;
-    struct GMemBlock *newBlock;
+    struct GMemBlock *foundBlock;
+    struct GMemBlock *rest;
+    s32 startTime = gd_get_ostime();
 
-    newBlock = make_mem_block(G_MEM_BLOCK_USED, permanence);
-    curBlock = sFreeBlockListHead;
-
-    while (curBlock != NULL) {
-        if (curBlock->permFlag & permanence) {
-            if (curBlock->size == size) {
-                foundBlock = curBlock;
-                break;
-            } else {
-                if (curBlock->size > size) {
-                    if (foundBlock != NULL) { /* find closest sized block */
-                        if (curBlock->size < foundBlock->size) {
-                            foundBlock = curBlock;
-                        }
-                    } else {
-                        foundBlock = curBlock;
-                    }
-                }
-            }
-        }
-        curBlock = curBlock->next;
+    if (size < GMEM_MIN_FREE_SIZE) {
+        size = GMEM_MIN_FREE_SIZE;
     }
 
+    foundBlock = find_best_fit(size, permanence);
     if (foundBlock == NULL) {
+        sFailedAllocCount++;
         return NULL;
     }
 
-    if (foundBlock->size > size) { /* split free block */
-        newBlock->ptr = foundBlock->ptr;
-        newBlock->size = size;
-
-        foundBlock->size -= size;
-        foundBlock->ptr += size;
-    } else if (foundBlock->size == size) { /* recycle whole free block */
-        newBlock->ptr = foundBlock->ptr;
-        newBlock->size = size;
-        empty_mem_block(foundBlock);
+    remove_free_memblock(foundBlock);
+    if (foundBlock->size >= size + GMEM_BLOCK_HEADER_SIZE + GMEM_MIN_FREE_SIZE) { /* split free block */
+        rest = (struct GMemBlock *) ((u8 *) foundBlock + GMEM_BLOCK_HEADER_SIZE + size);
+        rest->size = foundBlock->size - size - GMEM_BLOCK_HEADER_SIZE;
+        rest->permFlag = foundBlock->permFlag;
+        rest->heap = foundBlock->heap;
+        add_free_memblock(rest);
+        foundBlock->size = size;
     }
-
-    return newBlock->ptr;
+    foundBlock->blockType = G_MEM_BLOCK_USED;
+    foundBlock->permFlag = permanence;
+    sHeaps[foundBlock->heap].usedSize += foundBlock->size;
+    sHeaps[foundBlock->heap].usedEntries++;
+
+    sAllocCount++;
+    sAllocTime += gd_get_ostime() - startTime;
+    return (u8 *) foundBlock + GMEM_BLOCK_HEADER_SIZE;
 }
 
 /**
@@ -226,52 +256,83 @@ void *gd_request_mem(u32 size, u8 permanence) {
  * @returns `GMemBlock` that contains info about the new heap memory
  */
 struct GMemBlock *gd_add_mem_to_heap(u32 size, void *addr, u8 permanence) {
+    struct GMemHeap *heap;
     struct GMemBlock *newBlock;
+    struct GMemBlock *endBlock;
+    s32 i;
     /* eight-byte align the new block's data stats */
     size = (size - 8) & ~7;
     addr = (void *)(((uintptr_t) addr + 8) & ~7);
 
-    newBlock = make_mem_block(G_MEM_BLOCK_FREE, permanence);
-    newBlock->ptr = addr;
-    newBlock->size = size;
+    if (sHeapCount >= GMEM_MAX_HEAPS) {
+        fatal_printf("gd_add_mem_to_heap(): too many heaps");
+    }
 
+    heap = &sHeaps[sHeapCount];
+    for (i = 0; i < GMEM_BUCKET_COUNT; i++) {
+        heap->freeBuckets[i] = NULL;
+        heap->bucketEntries[i] = 0;
+    }
+    heap->freeBucketMask = 0;
+    heap->permanence = permanence;
+    heap->usedSize = 0;
+    heap->usedEntries = 0;
+    heap->freeSize = 0;
+    heap->freeEntries = 0;
+
+    newBlock = (struct GMemBlock *) addr;
+    newBlock->size = size - 2 * GMEM_BLOCK_HEADER_SIZE;
+    newBlock->permFlag = permanence;
+    newBlock->heap = sHeapCount;
+    add_free_memblock(newBlock);
+
+    endBlock = NEXT_MEM_BLOCK(newBlock);
+    endBlock->size = 0;
+    endBlock->blockType = G_MEM_BLOCK_USED;
+    endBlock->permFlag = 0;
+    endBlock->heap = sHeapCount;
+
+    sHeapCount++;
     return newBlock;
 }
 
 /**
- * NULL the various `GMemBlock` list heads
+ * Clear the heap list and statistics
  */
 void init_mem_block_lists(void) {
-    sFreeBlockListHead = NULL;
-    sUsedBlockListHead = NULL;
-    sEmptyBlockListHead = NULL;
+    sHeapCount = 0;
+
+    sAllocCount = 0;
+    sFailedAllocCount = 0;
+    sFreeCount = 0;
+    sAllocTime = 0;
+    sFreeTime = 0;
 }
 
 /**
- * Print information (size, entries) about the `GMemBlock` list. It can print
- * information for individual blocks as well as summary info for the entry list.
+ * Print information (size, entries) about all blocks of the given type and
+ * permanence.
  *
- * @param block          `GMemBlock` to start reading the list
- * @param printBlockInfo If `TRUE`, print information about every block
- *                       in the list
+ * @param blockType      `G_MEM_BLOCK_FREE` or `G_MEM_BLOCK_USED`
  * @param permanence     Limit info printed to blocks with this permanence
  * @returns number of entries
  */
-u32 print_list_stats(struct GMemBlock *block, s32 printBlockInfo, s32 permanence) {
+u32 print_list_stats(s32 blockType, s32 permanence) {
     u32 entries = 0;
     u32 totalSize = 0;
+    s32 i;
 
-    while (block != NULL) {
-        if (block->permFlag & permanence) {
-            entries++;
-            if (printBlockInfo) {
-                gd_printf("     %6.2fk (%d bytes)\n",
-                          (f32) block->size / 1024.0, //? 1024.0f
-                          block->size);
-            }
-            totalSize += block->size;
+    for (i = 0; i < sHeapCount; i++) {
+        if (!(sHeaps[i].permanence & permanence)) {
+            continue;
+        }
+        if (blockType == G_MEM_BLOCK_USED) {
+            entries += sHeaps[i].usedEntries;
+            totalSize += sHeaps[i].usedSize;
+        } else {
+            entries += sHeaps[i].freeEntries;
+            totalSize += sHeaps[i].freeSize;
         }
-        block = block->next;
     }
 
     gd_printf("Total %6.2fk (%d bytes) in %d entries\n",
@@ -282,33 +343,43 @@ u32 print_list_stats(struct GMemBlock *block, s32 printBlockInfo, s32 permanence
 }
 
 /**
- * Print summary information about all used, free, and empty
- * `GMemBlock`s.
+ * Print summary information about all used and free blocks, the free
+ * buckets, and the number and time of allocations.
  */
 void mem_stats(void) {
-    struct GMemBlock *list;
+    u32 entries;
+    s32 i;
+    s32 j;
 
     gd_printf("Perm Used blocks:\n");
-    list = sUsedBlockListHead;
-    print_list_stats(list, FALSE, PERM_G_MEM_BLOCK);
+    print_list_stats(G_MEM_BLOCK_USED, PERM_G_MEM_BLOCK);
     gd_printf("\n");
 
     gd_printf("Perm Free blocks:\n");
-    list = sFreeBlockListHead;
-    print_list_stats(list, FALSE, PERM_G_MEM_BLOCK);
+    print_list_stats(G_MEM_BLOCK_FREE, PERM_G_MEM_BLOCK);
     gd_printf("\n");
 
     gd_printf("Temp Used blocks:\n");
-    list = sUsedBlockListHead;
-    print_list_stats(list, FALSE, TEMP_G_MEM_BLOCK);
+    print_list_stats(G_MEM_BLOCK_USED, TEMP_G_MEM_BLOCK);
     gd_printf("\n");
 
     gd_printf("Temp Free blocks:\n");
-    list = sFreeBlockListHead;
-    print_list_stats(list, FALSE, TEMP_G_MEM_BLOCK);
+    print_list_stats(G_MEM_BLOCK_FREE, TEMP_G_MEM_BLOCK);
+    gd_printf("\n");
+
+    gd_printf("Free buckets:\n");
+    for (i = 0; i < GMEM_BUCKET_COUNT; i++) {
+        entries = 0;
+        for (j = 0; j < sHeapCount; j++) {
+            entries += sHeaps[j].bucketEntries[i];
+        }
+        if (entries != 0) {
+            gd_printf("     %d+ bytes: %d entries\n", 8 << i, entries);
+        }
+    }
     gd_printf("\n");
 
-    gd_printf("Empty blocks:\n");
-    list = sEmptyBlockListHead;
-    print_list_stats(list, FALSE, PERM_G_MEM_BLOCK | TEMP_G_MEM_BLOCK);
+    gd_printf("Allocs: %d (%d failed) in %dus\n", sAllocCount, sFailedAllocCount,
+              (u32) OS_CYCLES_TO_USEC(sAllocTime));
+    gd_printf("Frees: %d in %dus\n", sFreeCount, (u32) OS_CYCLES_TO_USEC(sFreeTime));
 }
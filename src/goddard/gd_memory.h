@@ -3,16 +3,21 @@
 
 #include <PR/ultratypes.h>
 
-/// A structure that holds information about memory allocation on goddard's heap.
+/// Header stored inline in front of every block of goddard's heap.
 struct GMemBlock {
-    /* 0x00 */ u8 *ptr;
-    /* 0x04 */ u32 size;
-    /* 0x08 */ u8 blockType;
-    /* 0x09 */ u8 permFlag; ///< Permanent (upper four bits) or Temporary (lower four bits)
-    /* 0x0C */ struct GMemBlock *next;
-    /* 0x10 */ struct GMemBlock *prev;
+    /* 0x00 */ u32 size;     ///< Bytes of memory following the header
+    /* 0x04 */ u8 blockType;
+    /* 0x05 */ u8 permFlag;  ///< Permanent (upper four bits) or Temporary (lower four bits)
+    /* 0x06 */ u8 bucket;    ///< Free list bucket, only valid while free
+    /* 0x07 */ u8 heap;      ///< Index of the heap the block belongs to
+    // Free list links; these occupy the start of the block's memory and are
+    // only valid while the block is free.
+    /* 0x08 */ struct GMemBlock *next;
+    /* 0x0C */ struct GMemBlock *prev;
 };
 
+#define GMEM_BLOCK_HEADER_SIZE 8
+
 /// Block list types for `GMemBlock.blockType`. Note that Empty Blocks don't have
 /// a specific value.
 enum GMemBlockTypes {
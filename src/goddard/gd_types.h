@@ -25,6 +25,8 @@ struct GdAnimTransform {
 
 typedef f32 Mat4f[4][4];
 
+struct GdSkinCache;
+
 struct GdColour {
     f32 r, g, b;
 };
@@ -347,7 +349,8 @@ struct ObjNet {
     /* 0x200 */ struct GdVec3f unk200;
     /* 0x20C */ struct ObjGroup *unk20C;
     /* 0x210 */ s32 ctrlType;     // has no purpose
-    /* 0x214 */ u8  filler2[8];
+    /* 0x214 */ struct GdSkinCache *skinCache; // see build_net_skin_cache
+    /* 0x218 */ u8  filler2[4];
     /* 0x21C */ struct ObjGroup *unk21C;
 }; /* sizeof = 0x220 */
 
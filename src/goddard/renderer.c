@@ -2941,7 +2941,8 @@ void gd_init(void) {
     s8 *data; // 2c
 
     imin("gd_init");
-    i = (u32)(sMemBlockPoolSize - DOUBLE_SIZE_ON_64_BIT(0x3E800));
+    // Heap blocks keep their headers inline, so the whole block pool can be heap.
+    i = (u32)(sMemBlockPoolSize - sMemBlockPoolUsed);
     data = gd_allocblock(i);
     gd_add_mem_to_heap(i, data, 0x10);
     sAlpha = (u16) 0xff;
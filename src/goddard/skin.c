@@ -22,6 +22,294 @@ struct ObjNet *gGdSkinNet; // @ 801BAAF0
 static s32 D_801BAAF4;
 static s32 sNetCount; // @ 801BAAF8
 
+/**
+ * Flat copy of the per-frame skinning work of a net, built once by
+ * `build_net_skin_cache` after the net's weights have been resolved, so that
+ * `move_net` and `convert_net_verts` run over arrays instead of walking
+ * `ObjGroup` lists, `ObjWeight` objects and `VtxLink` chains.
+ */
+struct GdSkinCache {
+    // Net type 2: vertices reset to their scaled initial position every frame
+    s32 scaledCount;
+    struct GdVec3f **scaledPos;
+    f32 *scaledX;
+    f32 *scaledY;
+    f32 *scaledZ;
+    // Net type 4: joints and their positive weights, in joint order
+    s32 jointCount;
+    struct ObjJoint **joints;
+    s32 *jointWeightEnd;
+    struct GdVec3f **weightPos;
+    f32 *weightX;
+    f32 *weightY;
+    f32 *weightZ;
+    f32 *weightVal;
+    // `Vtx` entries of the shape, updated with position and normal
+    s32 vnCount;
+    struct GdVec3f **vnPos;
+    Vtx **vnVtx;
+    u8 *vnNormal;
+    // `Vtx` entries of the scaled vertices, updated with position only
+    s32 vtxCount;
+    struct GdVec3f **vtxPos;
+    Vtx **vtxVtx;
+};
+
+static struct GdSkinCache *sBuildCache;
+static s32 sBuildJointCount;
+static s32 sBuildWeightCount;
+
+static void count_joint_weights(struct ObjJoint *joint) {
+    register struct ListNode *link;
+
+    sBuildJointCount++;
+    if (joint->weightGrp != NULL) {
+        for (link = joint->weightGrp->firstMember; link != NULL; link = link->next) {
+            if (((struct ObjWeight *) link->obj)->weightVal > 0.0) { //? 0.0f
+                sBuildWeightCount++;
+            }
+        }
+    }
+}
+
+static void add_joint_weights(struct ObjJoint *joint) {
+    register struct ListNode *link;
+    struct ObjWeight *weight;
+    struct GdSkinCache *cache = sBuildCache;
+
+    if (joint->weightGrp != NULL) {
+        for (link = joint->weightGrp->firstMember; link != NULL; link = link->next) {
+            weight = (struct ObjWeight *) link->obj;
+            if (weight->weightVal > 0.0) { //? 0.0f
+                cache->weightPos[sBuildWeightCount] = &weight->vtx->pos;
+                cache->weightX[sBuildWeightCount] = weight->vec20.x;
+                cache->weightY[sBuildWeightCount] = weight->vec20.y;
+                cache->weightZ[sBuildWeightCount] = weight->vec20.z;
+                cache->weightVal[sBuildWeightCount] = weight->weightVal;
+                sBuildWeightCount++;
+            }
+        }
+    }
+    cache->joints[sBuildJointCount] = joint;
+    cache->jointWeightEnd[sBuildJointCount] = sBuildWeightCount;
+    sBuildJointCount++;
+}
+
+static s32 count_gbi_verts(struct ObjGroup *grp) {
+    register struct ListNode *link;
+    register struct VtxLink *vtxlink;
+    s32 count = 0;
+
+    for (link = grp->firstMember; link != NULL; link = link->next) {
+        for (vtxlink = ((struct ObjVertex *) link->obj)->gbiVerts; vtxlink != NULL;
+             vtxlink = vtxlink->prev) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static void add_gbi_verts(struct ObjGroup *grp, struct GdVec3f **pos, Vtx **vtx, u8 *normal) {
+    register struct ListNode *link;
+    register struct VtxLink *vtxlink;
+    struct ObjVertex *objVtx;
+
+    for (link = grp->firstMember; link != NULL; link = link->next) {
+        objVtx = (struct ObjVertex *) link->obj;
+        for (vtxlink = objVtx->gbiVerts; vtxlink != NULL; vtxlink = vtxlink->prev) {
+            *pos++ = &objVtx->pos;
+            *vtx++ = vtxlink->data;
+            if (normal != NULL) {
+                *normal++ = (u8)(objVtx->normal.x * 255.0f);
+                *normal++ = (u8)(objVtx->normal.y * 255.0f);
+                *normal++ = (u8)(objVtx->normal.z * 255.0f);
+            }
+        }
+    }
+}
+
+/**
+ * Build (or rebuild) the `GdSkinCache` of a net. All arrays share a single
+ * permanent heap allocation.
+ */
+void build_net_skin_cache(struct ObjNet *net) {
+    struct GdSkinCache *cache;
+    struct ObjShape *shape = net->shapePtr;
+    register struct ListNode *link;
+    struct ObjVertex *vtx;
+    s32 scaledCount = 0;
+    s32 vnCount = 0;
+    s32 vtxCount = 0;
+    u32 size;
+    u8 *mem;
+    s32 i;
+
+    if (net->skinCache != NULL) {
+        gd_free(net->skinCache);
+        net->skinCache = NULL;
+    }
+
+    sBuildJointCount = 0;
+    sBuildWeightCount = 0;
+    if (net->netType == 4 && net->unk1C8 != NULL) {
+        apply_to_obj_types_in_group(OBJ_TYPE_JOINTS, (applyproc_t) count_joint_weights, net->unk1C8);
+    }
+    if (net->netType == 2 && shape != NULL && shape->scaledVtxGroup != NULL) {
+        for (link = shape->scaledVtxGroup->firstMember; link != NULL; link = link->next) {
+            scaledCount++;
+        }
+        vtxCount = count_gbi_verts(shape->scaledVtxGroup);
+    }
+    if (shape != NULL && shape->unk30) {
+        vnCount = count_gbi_verts(shape->vtxGroup);
+    }
+
+    size = ((sizeof(struct GdSkinCache) + 7) & ~7)
+           + scaledCount * (sizeof(struct GdVec3f *) + 3 * sizeof(f32))
+           + sBuildJointCount * (sizeof(struct ObjJoint *) + sizeof(s32))
+           + sBuildWeightCount * (sizeof(struct GdVec3f *) + 4 * sizeof(f32))
+           + vnCount * (sizeof(struct GdVec3f *) + sizeof(Vtx *) + 3 * sizeof(u8))
+           + vtxCount * (sizeof(struct GdVec3f *) + sizeof(Vtx *));
+    mem = gd_malloc_perm(size);
+    if (mem == NULL) {
+        // fall back to walking the object lists
+        return;
+    }
+
+    cache = (struct GdSkinCache *) mem;
+    mem += ((sizeof(struct GdSkinCache) + 7) & ~7);
+#define CACHE_ARRAY(field, count)              \
+    cache->field = (void *) mem;               \
+    mem += (count) * sizeof(*cache->field);
+
+    // pointers and floats first so the u8 normals come last
+    cache->scaledCount = scaledCount;
+    CACHE_ARRAY(scaledPos, scaledCount);
+    CACHE_ARRAY(scaledX, scaledCount);
+    CACHE_ARRAY(scaledY, scaledCount);
+    CACHE_ARRAY(scaledZ, scaledCount);
+    cache->jointCount = sBuildJointCount;
+    CACHE_ARRAY(joints, sBuildJointCount);
+    CACHE_ARRAY(jointWeightEnd, sBuildJointCount);
+    CACHE_ARRAY(weightPos, sBuildWeightCount);
+    CACHE_ARRAY(weightX, sBuildWeightCount);
+    CACHE_ARRAY(weightY, sBuildWeightCount);
+    CACHE_ARRAY(weightZ, sBuildWeightCount);
+    CACHE_ARRAY(weightVal, sBuildWeightCount);
+    cache->vnCount = vnCount;
+    CACHE_ARRAY(vnPos, vnCount);
+    CACHE_ARRAY(vnVtx, vnCount);
+    cache->vtxCount = vtxCount;
+    CACHE_ARRAY(vtxPos, vtxCount);
+    CACHE_ARRAY(vtxVtx, vtxCount);
+    CACHE_ARRAY(vnNormal, vnCount * 3);
+#undef CACHE_ARRAY
+
+    if (scaledCount != 0) {
+        i = 0;
+        for (link = shape->scaledVtxGroup->firstMember; link != NULL; link = link->next) {
+            vtx = (struct ObjVertex *) link->obj;
+            cache->scaledPos[i] = &vtx->pos;
+            // same as scale_verts()
+            if (vtx->scaleFactor != 0.0f) {
+                cache->scaledX[i] = vtx->initPos.x * vtx->scaleFactor;
+                cache->scaledY[i] = vtx->initPos.y * vtx->scaleFactor;
+                cache->scaledZ[i] = vtx->initPos.z * vtx->scaleFactor;
+            } else {
+                cache->scaledX[i] = cache->scaledY[i] = cache->scaledZ[i] = 0.0f;
+            }
+            i++;
+        }
+        add_gbi_verts(shape->scaledVtxGroup, cache->vtxPos, cache->vtxVtx, NULL);
+    }
+
+    if (sBuildJointCount != 0) {
+        sBuildCache = cache;
+        sBuildJointCount = 0;
+        sBuildWeightCount = 0;
+        apply_to_obj_types_in_group(OBJ_TYPE_JOINTS, (applyproc_t) add_joint_weights, net->unk1C8);
+    }
+
+    if (vnCount != 0) {
+        add_gbi_verts(shape->vtxGroup, cache->vnPos, cache->vnVtx, cache->vnNormal);
+    }
+
+    net->skinCache = cache;
+}
+
+/**
+ * Cached form of `move_skin`: reset scaled vertices to their scaled positions.
+ */
+static void move_skin_cached(struct GdSkinCache *cache) {
+    register s32 i;
+    register struct GdVec3f *pos;
+
+    for (i = 0; i < cache->scaledCount; i++) {
+        pos = cache->scaledPos[i];
+        pos->x = cache->scaledX[i];
+        pos->y = cache->scaledY[i];
+        pos->z = cache->scaledZ[i];
+    }
+}
+
+/**
+ * Cached form of applying `func_80181894` to every joint of a bones net: add
+ * each weighted, joint transformed offset to its vertex.
+ */
+static void move_bonesnet_cached(struct GdSkinCache *cache) {
+    register s32 i = 0;
+    register s32 end;
+    register f32 x, y, z, w;
+    register struct GdVec3f *pos;
+    Mat4f *mtx;
+    s32 j;
+
+    for (j = 0; j < cache->jointCount; j++) {
+        mtx = &cache->joints[j]->matE8;
+        for (end = cache->jointWeightEnd[j]; i < end; i++) {
+            x = cache->weightX[i];
+            y = cache->weightY[i];
+            z = cache->weightZ[i];
+            w = cache->weightVal[i];
+            pos = cache->weightPos[i];
+            // same operation order as gd_rotate_and_translate_vec3f
+            pos->x += ((*mtx)[0][0] * x + (*mtx)[1][0] * y + (*mtx)[2][0] * z + (*mtx)[3][0]) * w;
+            pos->y += ((*mtx)[0][1] * x + (*mtx)[1][1] * y + (*mtx)[2][1] * z + (*mtx)[3][1]) * w;
+            pos->z += ((*mtx)[0][2] * x + (*mtx)[1][2] * y + (*mtx)[2][2] * z + (*mtx)[3][2]) * w;
+        }
+    }
+}
+
+/**
+ * Cached form of `convert_gd_verts_to_Vn` and `convert_gd_verts_to_Vtx`.
+ */
+static void convert_net_verts_cached(struct GdSkinCache *cache) {
+    register s32 i;
+    register struct GdVec3f *pos;
+    register Vtx *vn;
+    register u8 *normal = cache->vnNormal;
+
+    for (i = 0; i < cache->vnCount; i++) {
+        pos = cache->vnPos[i];
+        vn = cache->vnVtx[i];
+        vn->n.ob[0] = (s16) pos->x;
+        vn->n.ob[1] = (s16) pos->y;
+        vn->n.ob[2] = (s16) pos->z;
+        vn->n.n[0] = normal[0];
+        vn->n.n[1] = normal[1];
+        vn->n.n[2] = normal[2];
+        normal += 3;
+    }
+
+    for (i = 0; i < cache->vtxCount; i++) {
+        pos = cache->vtxPos[i];
+        vn = cache->vtxVtx[i];
+        vn->v.ob[0] = (s16) pos->x;
+        vn->v.ob[1] = (s16) pos->y;
+        vn->v.ob[2] = (s16) pos->z;
+    }
+}
+
 /* 2406E0 -> 240894 */
 void compute_net_bounding_box(struct ObjNet *net) {
     reset_bounding_box();
@@ -235,7 +523,9 @@ void move_bonesnet(struct ObjNet *net) {
 
     imin("move_bonesnet");
     gd_set_identity_mat4(&D_801B9DC8);
-    if ((sp24 = net->unk1C8) != NULL) {
+    if (net->skinCache != NULL) {
+        move_bonesnet_cached(net->skinCache);
+    } else if ((sp24 = net->unk1C8) != NULL) {
         apply_to_obj_types_in_group(OBJ_TYPE_JOINTS, (applyproc_t) func_801913C0, sp24);
     }
     imout();
@@ -383,6 +673,11 @@ void convert_gd_verts_to_Vtx(struct ObjGroup *grp) {
 
 /* 241BCC -> 241CA0; orig name: Proc801933FC */
 void convert_net_verts(struct ObjNet *net) {
+    if (net->skinCache != NULL) {
+        convert_net_verts_cached(net->skinCache);
+        return;
+    }
+
     if (net->shapePtr != NULL) {
         if (net->shapePtr->unk30) {
             convert_gd_verts_to_Vn(net->shapePtr->vtxGroup);
@@ -436,7 +731,11 @@ void move_net(struct ObjNet *net) {
             break;
         case 2:
             restart_timer("move_skin");
-            move_skin(net);
+            if (net->skinCache != NULL) {
+                move_skin_cached(net->skinCache);
+            } else {
+                move_skin(net);
+            }
             split_timer("move_skin");
             break;
         case 3:
@@ -488,6 +787,7 @@ void func_80193848(struct ObjGroup *group) {
     apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) func_80192294, group);
     apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) func_801922FC, group);
     apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) func_8019373C, group);
+    apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) build_net_skin_cache, group);
 }
 
 /* 24208C -> 2422E0; not called; orig name: func_801938BC */
@@ -15,6 +15,7 @@ struct ObjNet *make_net(UNUSED s32 a0, struct ObjShape *shapedata, struct ObjGro
 void convert_net_verts(struct ObjNet *net);
 void move_nets(struct ObjGroup *group);
 void func_80193848(struct ObjGroup *group);
+void build_net_skin_cache(struct ObjNet *net);
 void reset_net_count(void);
 
 #endif // GD_SKIN_H
@@ -0,0 +1,482 @@
+#include <PR/ultratypes.h>
+
+#include "fastinflate.h"
+
+/*
+ * One-shot raw DEFLATE (RFC 1951) decoder used by expand_gzip.
+ *
+ * Unlike zlib's inflate this never keeps a window: the entire output buffer is
+ * addressable, so matches are copied directly out of it. Huffman codes are
+ * decoded through a single table lookup (plus one subtable hop for long codes)
+ * whose entries already carry the length/distance base and extra bit count.
+ * The primary tables are sized to stay inside the VR4300's 8KB data cache.
+ */
+
+// Table entry layout:
+//   bits  0-3: code bits consumed at this level
+//   bits  4-7: extra bits that follow the code, or the subtable index width
+//   bits  8-9: entry kind
+//   bit    10: invalid code
+//   bits 16-31: literal byte, length/distance base or subtable offset
+#define ENTRY(value, kind, extra, nbits) (((u32)(value) << 16) | ((kind) << 8) | ((extra) << 4) | (nbits))
+#define ENTRY_NBITS(e) ((e) & 0xF)
+#define ENTRY_EXTRA(e) (((e) >> 4) & 0xF)
+#define ENTRY_KIND(e) (((e) >> 8) & 0x3)
+#define ENTRY_VALUE(e) ((e) >> 16)
+#define ENTRY_INVALID 0x400
+
+#define KIND_LITERAL 0
+#define KIND_BASE 1
+#define KIND_END 2
+#define KIND_SUBTABLE 3
+
+#define MAX_CODE_BITS 15
+
+// Primary table widths and worst-case table sizes (including subtables)
+// for those widths, as computed by zlib's examples/enough.c
+#define LITLEN_TABLE_BITS 9
+#define LITLEN_ENOUGH 852
+#define DIST_TABLE_BITS 6
+#define DIST_ENOUGH 592
+#define CODELEN_TABLE_BITS 7
+#define CODELEN_ENOUGH 128
+
+#define NUM_LITLEN_SYMS 288
+#define NUM_DIST_SYMS 32
+#define NUM_CODELEN_SYMS 19
+
+enum TableType {
+    TABLE_LITLEN,
+    TABLE_DIST,
+    TABLE_CODELEN,
+};
+
+static const u16 sLengthBase[29] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+
+static const u8 sLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+    2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+
+static const u16 sDistBase[30] = {
+    1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+
+static const u8 sDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+// Order in which code length code lengths are stored in a dynamic block header
+static const u8 sCodeLengthOrder[NUM_CODELEN_SYMS] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+static u32 sLitlenTable[LITLEN_ENOUGH];
+static u32 sDistTable[DIST_ENOUGH];
+static u32 sCodelenTable[CODELEN_ENOUGH];
+static u8 sLengths[NUM_LITLEN_SYMS + NUM_DIST_SYMS];
+static u8 sTablesAreFixed = FALSE;
+
+/**
+ * Return the decode table entry (without code bits) for a symbol.
+ */
+static u32 symbol_entry(enum TableType type, u32 sym) {
+    switch (type) {
+        case TABLE_LITLEN:
+            if (sym < 256) {
+                return ENTRY(sym, KIND_LITERAL, 0, 0);
+            } else if (sym == 256) {
+                return ENTRY(0, KIND_END, 0, 0);
+            } else if (sym < 257 + 29) {
+                return ENTRY(sLengthBase[sym - 257], KIND_BASE, sLengthExtra[sym - 257], 0);
+            }
+            break;
+        case TABLE_DIST:
+            if (sym < 30) {
+                return ENTRY(sDistBase[sym], KIND_BASE, sDistExtra[sym], 0);
+            }
+            break;
+        case TABLE_CODELEN:
+            return ENTRY(sym, KIND_LITERAL, 0, 0);
+    }
+    return ENTRY_INVALID;
+}
+
+/**
+ * Build a decode table for the canonical Huffman code described by 'lengths'.
+ * Codes longer than 'tableBits' get a subtable appended after the primary
+ * table, sized the same way zlib's inflate_table does.
+ * Returns FALSE if the code is over-subscribed or the tables would overflow.
+ */
+static s32 build_decode_table(u32 *table, u32 tableBits, u32 maxEntries, enum TableType type,
+                              const u8 *lengths, u32 numSyms) {
+    u16 count[MAX_CODE_BITS + 1];
+    u16 offsets[MAX_CODE_BITS + 1];
+    u16 sorted[NUM_LITLEN_SYMS];
+    u32 primarySize = 1 << tableBits;
+    u32 next = primarySize;
+    u32 curPrefix = 0xFFFFFFFF;
+    u32 subBase = 0;
+    u32 subBits = 0;
+    u32 code = 0;
+    s32 left = 1;
+    u32 len;
+    u32 sym;
+    u32 i;
+
+    for (len = 0; len <= MAX_CODE_BITS; len++) {
+        count[len] = 0;
+    }
+    for (sym = 0; sym < numSyms; sym++) {
+        count[lengths[sym]]++;
+    }
+    count[0] = 0;
+
+    for (len = 1; len <= MAX_CODE_BITS; len++) {
+        left = (left << 1) - count[len];
+        if (left < 0) {
+            return FALSE;
+        }
+    }
+
+    offsets[1] = 0;
+    for (len = 1; len < MAX_CODE_BITS; len++) {
+        offsets[len + 1] = offsets[len] + count[len];
+    }
+    for (sym = 0; sym < numSyms; sym++) {
+        if (lengths[sym] != 0) {
+            sorted[offsets[lengths[sym]]++] = sym;
+        }
+    }
+
+    // unused slots of an incomplete code decode as errors
+    for (i = 0; i < primarySize; i++) {
+        table[i] = ENTRY_INVALID;
+    }
+
+    i = 0;
+    for (len = 1; len <= MAX_CODE_BITS; len++) {
+        while (count[len] != 0) {
+            u32 entry = symbol_entry(type, sorted[i++]);
+            u32 rev = 0;
+            u32 c = code;
+            u32 j;
+
+            // DEFLATE packs codes MSB first into an LSB first bit stream
+            for (j = 0; j < len; j++) {
+                rev = (rev << 1) | (c & 1);
+                c >>= 1;
+            }
+
+            if (len <= tableBits) {
+                for (j = rev; j < primarySize; j += 1 << len) {
+                    table[j] = entry | len;
+                }
+            } else {
+                if ((rev & (primarySize - 1)) != curPrefix) {
+                    // size the subtable from the codes that are still to be placed
+                    subBits = len - tableBits;
+                    left = 1 << subBits;
+                    while (subBits + tableBits < MAX_CODE_BITS) {
+                        left -= count[subBits + tableBits];
+                        if (left <= 0) {
+                            break;
+                        }
+                        subBits++;
+                        left <<= 1;
+                    }
+                    if (next + (1 << subBits) > maxEntries) {
+                        return FALSE;
+                    }
+                    curPrefix = rev & (primarySize - 1);
+                    table[curPrefix] = ENTRY(next, KIND_SUBTABLE, subBits, tableBits);
+                    subBase = next;
+                    next += 1 << subBits;
+                    for (j = subBase; j < next; j++) {
+                        table[j] = ENTRY_INVALID;
+                    }
+                }
+                for (j = rev >> tableBits; j < (1U << subBits); j += 1 << (len - tableBits)) {
+                    table[subBase + j] = entry | (len - tableBits);
+                }
+            }
+
+            count[len]--;
+            code++;
+        }
+        code <<= 1;
+    }
+
+    return TRUE;
+}
+
+static void build_fixed_tables(void) {
+    u32 i;
+
+    for (i = 0; i < 144; i++) {
+        sLengths[i] = 8;
+    }
+    for (; i < 256; i++) {
+        sLengths[i] = 9;
+    }
+    for (; i < 280; i++) {
+        sLengths[i] = 7;
+    }
+    for (; i < NUM_LITLEN_SYMS; i++) {
+        sLengths[i] = 8;
+    }
+    build_decode_table(sLitlenTable, LITLEN_TABLE_BITS, LITLEN_ENOUGH, TABLE_LITLEN, sLengths, NUM_LITLEN_SYMS);
+
+    for (i = 0; i < NUM_DIST_SYMS; i++) {
+        sLengths[i] = 5;
+    }
+    build_decode_table(sDistTable, DIST_TABLE_BITS, DIST_ENOUGH, TABLE_DIST, sLengths, NUM_DIST_SYMS);
+}
+
+/*
+ * Bit buffer helpers. While at least 4 input bytes are left, the buffer is
+ * refilled with one little endian word load, shifted in above the bits it
+ * already holds. Only the whole bytes that fit are counted as consumed, which
+ * leaves 24 to 31 bits, enough for a litlen code plus its extra bits or a
+ * distance code. The bits of the word that don't fit are the same input bits
+ * the next refill loads again, so they may stay in the buffer. Near the end of
+ * the input it falls back to a byte at a time; bytes past the end read as
+ * zero, and overruns are detected once the block is finished.
+ */
+#define LOAD_LE32(p) ((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((u32)(p)[3] << 24))
+#define REFILL()                                                    \
+    if (inEnd - in >= 4) {                                          \
+        bitbuf |= LOAD_LE32(in) << bitcnt;                          \
+        in += (31 - bitcnt) >> 3;                                   \
+        bitcnt |= 24;                                               \
+    } else {                                                        \
+        while (bitcnt <= 24) {                                      \
+            bitbuf |= (u32)(in < inEnd ? *in : 0) << bitcnt;        \
+            in++;                                                   \
+            bitcnt += 8;                                            \
+        }                                                           \
+    }
+#define PEEK(n) (bitbuf & ((1U << (n)) - 1))
+#define CONSUME(n)                                                  \
+    {                                                               \
+        bitbuf >>= (n);                                             \
+        bitcnt -= (n);                                              \
+    }
+#define OVERRUN() (in > inEnd && (u32)(in - inEnd) * 8 > bitcnt)
+
+/**
+ * Look up the next symbol in 'table', following a subtable link if needed,
+ * and consume its code bits. Needs at least 15 bits in the buffer.
+ */
+#define DECODE(entry, table, tableBits)                             \
+    {                                                               \
+        entry = table[PEEK(tableBits)];                             \
+        if (ENTRY_KIND(entry) == KIND_SUBTABLE) {                   \
+            CONSUME(tableBits);                                     \
+            entry = table[ENTRY_VALUE(entry) + PEEK(ENTRY_EXTRA(entry))]; \
+        }                                                           \
+        CONSUME(ENTRY_NBITS(entry));                                \
+    }
+
+int fast_inflate(const unsigned char *in, unsigned char *out, unsigned int inLength, unsigned int outLength) {
+    const u8 *inEnd = in + inLength;
+    u8 *outStart = out;
+    u8 *outEnd = out + outLength;
+    u32 bitbuf = 0;
+    u32 bitcnt = 0;
+    u32 final;
+    u32 i;
+
+    do {
+        REFILL();
+        final = PEEK(1);
+        CONSUME(1);
+
+        switch (PEEK(2)) {
+            case 0: {
+                // stored block: drop to a byte boundary, then hand the buffered bytes back
+                u32 len;
+
+                CONSUME(2);
+                CONSUME(bitcnt & 7);
+                in -= bitcnt >> 3;
+                bitbuf = 0;
+                bitcnt = 0;
+                if (inEnd - in < 4) {
+                    return FASTINFLATE_ERR_INPUT;
+                }
+                len = in[0] | (in[1] << 8);
+                if (len != (u32)((in[2] | (in[3] << 8)) ^ 0xFFFF)) {
+                    return FASTINFLATE_ERR_DATA;
+                }
+                in += 4;
+                if (len > (u32)(inEnd - in)) {
+                    return FASTINFLATE_ERR_INPUT;
+                }
+                if (len > (u32)(outEnd - out)) {
+                    return FASTINFLATE_ERR_OUTPUT;
+                }
+                while (len-- != 0) {
+                    *out++ = *in++;
+                }
+                continue;
+            }
+            case 1:
+                CONSUME(2);
+                if (!sTablesAreFixed) {
+                    build_fixed_tables();
+                    sTablesAreFixed = TRUE;
+                }
+                break;
+            case 2: {
+                u32 numLitlen;
+                u32 numDist;
+                u32 numCodelen;
+                u32 entry;
+
+                CONSUME(2);
+                numLitlen = PEEK(5) + 257;
+                CONSUME(5);
+                numDist = PEEK(5) + 1;
+                CONSUME(5);
+                numCodelen = PEEK(4) + 4;
+                CONSUME(4);
+                if (numLitlen > 286 || numDist > 30) {
+                    return FASTINFLATE_ERR_DATA;
+                }
+
+                for (i = 0; i < NUM_CODELEN_SYMS; i++) {
+                    sLengths[sCodeLengthOrder[i]] = 0;
+                }
+                for (i = 0; i < numCodelen; i++) {
+                    REFILL();
+                    sLengths[sCodeLengthOrder[i]] = PEEK(3);
+                    CONSUME(3);
+                }
+                if (!build_decode_table(sCodelenTable, CODELEN_TABLE_BITS, CODELEN_ENOUGH, TABLE_CODELEN,
+                                        sLengths, NUM_CODELEN_SYMS)) {
+                    return FASTINFLATE_ERR_DATA;
+                }
+
+                // literal/length and distance code lengths share one run-length coded sequence
+                i = 0;
+                while (i < numLitlen + numDist) {
+                    u32 sym;
+                    u32 repeat;
+                    u8 value;
+
+                    REFILL();
+                    entry = sCodelenTable[PEEK(CODELEN_TABLE_BITS)];
+                    if (entry & ENTRY_INVALID) {
+                        return FASTINFLATE_ERR_DATA;
+                    }
+                    CONSUME(ENTRY_NBITS(entry));
+                    sym = ENTRY_VALUE(entry);
+
+                    if (sym < 16) {
+                        sLengths[i++] = sym;
+                        continue;
+                    }
+                    if (sym == 16) {
+                        if (i == 0) {
+                            return FASTINFLATE_ERR_DATA;
+                        }
+                        value = sLengths[i - 1];
+                        repeat = 3 + PEEK(2);
+                        CONSUME(2);
+                    } else if (sym == 17) {
+                        value = 0;
+                        repeat = 3 + PEEK(3);
+                        CONSUME(3);
+                    } else {
+                        value = 0;
+                        repeat = 11 + PEEK(7);
+                        CONSUME(7);
+                    }
+                    if (i + repeat > numLitlen + numDist) {
+                        return FASTINFLATE_ERR_DATA;
+                    }
+                    while (repeat-- != 0) {
+                        sLengths[i++] = value;
+                    }
+                }
+                if (sLengths[256] == 0) {
+                    return FASTINFLATE_ERR_DATA;
+                }
+
+                sTablesAreFixed = FALSE;
+                if (!build_decode_table(sLitlenTable, LITLEN_TABLE_BITS, LITLEN_ENOUGH, TABLE_LITLEN,
+                                        sLengths, numLitlen)
+                    || !build_decode_table(sDistTable, DIST_TABLE_BITS, DIST_ENOUGH, TABLE_DIST,
+                                           sLengths + numLitlen, numDist)) {
+                    return FASTINFLATE_ERR_DATA;
+                }
+                break;
+            }
+            default:
+                return FASTINFLATE_ERR_DATA;
+        }
+
+        // compressed block
+        for (;;) {
+            u32 entry;
+            u32 len;
+            u32 dist;
+            u8 *src;
+
+            REFILL();
+            DECODE(entry, sLitlenTable, LITLEN_TABLE_BITS);
+            if (entry & ENTRY_INVALID) {
+                return FASTINFLATE_ERR_DATA;
+            }
+            if (ENTRY_KIND(entry) == KIND_LITERAL) {
+                if (out == outEnd) {
+                    return FASTINFLATE_ERR_OUTPUT;
+                }
+                *out++ = ENTRY_VALUE(entry);
+                continue;
+            }
+            if (ENTRY_KIND(entry) == KIND_END) {
+                break;
+            }
+
+            len = ENTRY_VALUE(entry) + PEEK(ENTRY_EXTRA(entry));
+            CONSUME(ENTRY_EXTRA(entry));
+
+            REFILL();
+            DECODE(entry, sDistTable, DIST_TABLE_BITS);
+            if (entry & ENTRY_INVALID) {
+                return FASTINFLATE_ERR_DATA;
+            }
+            if (bitcnt < ENTRY_EXTRA(entry)) {
+                REFILL();
+            }
+            dist = ENTRY_VALUE(entry) + PEEK(ENTRY_EXTRA(entry));
+            CONSUME(ENTRY_EXTRA(entry));
+
+            if (dist > (u32)(out - outStart)) {
+                return FASTINFLATE_ERR_DATA;
+            }
+            if (len > (u32)(outEnd - out)) {
+                return FASTINFLATE_ERR_OUTPUT;
+            }
+
+            // byte copy so overlapping matches replicate correctly
+            src = out - dist;
+            do {
+                *out++ = *src++;
+            } while (--len != 0);
+        }
+
+        if (OVERRUN()) {
+            return FASTINFLATE_ERR_INPUT;
+        }
+    } while (!final);
+
+    return out - outStart;
+}
@@ -0,0 +1,19 @@
+#ifndef FASTINFLATE_H
+#define FASTINFLATE_H
+
+/*
+ * One-shot raw DEFLATE decoder.
+ *
+ * Decodes the whole stream at 'in' straight into 'out' in a single call.
+ * Since the complete output is always in memory, matches are copied from the
+ * output buffer itself and no sliding window or inflate_state is needed.
+ *
+ * Returns the number of bytes written, or a negative FASTINFLATE_* error.
+ */
+#define FASTINFLATE_ERR_DATA    -1 /* malformed stream */
+#define FASTINFLATE_ERR_OUTPUT  -2 /* output would exceed outLength */
+#define FASTINFLATE_ERR_INPUT   -3 /* stream runs past inLength */
+
+int fast_inflate(const unsigned char *in, unsigned char *out, unsigned int inLength, unsigned int outLength);
+
+#endif // FASTINFLATE_H
@@ -1,5 +1,9 @@
 #include "zlib.h"
+#ifndef GZIP_ZLIB_INFLATE
+#include "fastinflate.h"
+#endif
 
+#ifdef GZIP_ZLIB_INFLATE
 /*
  * Local functions for allocating memory
  *
@@ -31,6 +35,7 @@ static void myfree(voidpf opaque, void *address)
 {
     gzip_mem_next = 0;
 }
+#endif
 
 /*
  * Returns -ve value for error, or number of output bytes for success
@@ -38,6 +43,9 @@ static void myfree(voidpf opaque, void *address)
 int
 expand_gzip(char *in, char *outbuf, unsigned int inLength, unsigned int outbufLength)
 {
+#ifndef GZIP_ZLIB_INFLATE
+    return fast_inflate((unsigned char *)in, (unsigned char *)outbuf, inLength, outbufLength);
+#else
     int err;
     z_stream d_stream; /* decompression stream */
 
@@ -70,5 +78,5 @@ expand_gzip(char *in, char *outbuf, unsigned int inLength, unsigned int outbufLe
     }
 
     return d_stream.total_out;
-
+#endif
 }
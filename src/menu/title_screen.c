@@ -38,7 +38,12 @@ static s16 sPlayMarioGreeting = TRUE;
 static s16 sPlayMarioGameOver = TRUE;
 #endif
 
+#ifdef DEMO_BENCH
+// The demo benchmark starts each demo right away.
+#define PRESS_START_DEMO_TIMER 1
+#else
 #define PRESS_START_DEMO_TIMER 800
+#endif
 
 /**
  * Run the demo timer on the PRESS START screen after a number of frames.
@@ -70,6 +75,9 @@ s32 run_level_id_or_demo(s32 level) {
                 level = (s8)((struct DemoInput *) gDemoInputsBuf.bufTarget)->timer;
                 gCurrSaveFileNum = 1;
                 gCurrActNum = 1;
+#ifdef DEMO_BENCH
+                sDemoCountdown = 0;
+#endif
             }
         } else { // activity was detected, so reset the demo countdown.
             sDemoCountdown = 0;
@@ -0,0 +1,62 @@
+#include <ultra64.h>
+
+#include "debug.h"
+#include "trace.h"
+
+#ifdef UNF_TRACE
+
+// Double buffered so a packet can still be in flight while the next frame records.
+static struct TracePacket sTracePackets[2];
+static struct TracePacket *sTraceCur = &sTracePackets[0];
+static u16 sTraceFrame = 0;
+static u16 sTraceDropped = 0;
+
+/**
+ * Append an event to the current frame. The last two slots are kept for the
+ * markers written by trace_flush(); events past them are counted as dropped.
+ */
+void trace_event(u8 type, u8 id, u16 value) {
+    struct TraceEvent *event;
+
+    if (sTraceCur->count >= TRACE_MAX_EVENTS - 2) {
+        sTraceDropped++;
+        return;
+    }
+
+    event = &sTraceCur->events[sTraceCur->count++];
+    event->time = osGetCount();
+    event->type = type;
+    event->id = id;
+    event->value = value;
+}
+
+/**
+ * Close the current frame and send it as one raw binary USB packet.
+ */
+void trace_flush(void) {
+    struct TracePacket *packet = sTraceCur;
+    struct TraceEvent *event;
+
+    if (sTraceDropped != 0) {
+        event = &packet->events[packet->count++];
+        event->time = osGetCount();
+        event->type = TRACE_TYPE_COUNTER;
+        event->id = TRACE_ID_DROPPED_EVENTS;
+        event->value = sTraceDropped;
+        sTraceDropped = 0;
+    }
+
+    event = &packet->events[packet->count++];
+    event->time = osGetCount();
+    event->type = TRACE_TYPE_FRAME;
+    event->id = TRACE_ID_NONE;
+    event->value = sTraceFrame++;
+
+    packet->magic = TRACE_MAGIC;
+    debug_dumpbinary(packet, TRACE_PACKET_HEADER_SIZE + packet->count * sizeof(struct TraceEvent));
+
+    sTraceCur = (packet == &sTracePackets[0]) ? &sTracePackets[1] : &sTracePackets[0];
+    sTraceCur->count = 0;
+}
+
+#endif
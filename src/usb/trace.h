@@ -0,0 +1,73 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <PR/ultratypes.h>
+
+/**
+ * Binary event trace over UNFLoader.
+ *
+ * Events are 8-byte records (CPU count, type, id, 16-bit value) appended to a
+ * per-frame buffer without any formatting, and sent as a single raw binary
+ * USB packet by trace_flush() once per frame. tools/unftrace converts the
+ * captured packets into Chrome trace JSON that can be opened in Perfetto.
+ *
+ * Only the game thread may record events. Enabled with UNFTRACE=1; otherwise
+ * the macros compile to nothing.
+ */
+
+// Each packet starts with TRACE_MAGIC and the number of events that follow.
+#define TRACE_MAGIC 0x54524331 // "TRC1"
+#define TRACE_MAX_EVENTS 512
+
+enum TraceEventType {
+    TRACE_TYPE_BEGIN = 1,
+    TRACE_TYPE_END,
+    TRACE_TYPE_COUNTER,
+    TRACE_TYPE_FRAME,
+};
+
+// Values are part of the capture format. unftrace -n reads names from this file.
+enum TraceId {
+    TRACE_ID_NONE = 0,
+    TRACE_ID_GAME_LOOP = 1,
+    TRACE_ID_AUDIO_TICK = 2,
+    TRACE_ID_READ_CONTROLLERS = 3,
+    TRACE_ID_LEVEL_SCRIPT = 4,
+    TRACE_ID_DISPLAY_VSYNC = 5,
+    TRACE_ID_GFX_POOL_FREE = 6,
+    TRACE_ID_DROPPED_EVENTS = 7,
+    TRACE_ID_USER = 32,
+};
+
+struct TraceEvent {
+    /* 0x00 */ u32 time;
+    /* 0x04 */ u8 type;
+    /* 0x05 */ u8 id;
+    /* 0x06 */ u16 value;
+}; // size = 0x08
+
+// Only the header and the recorded events are sent.
+struct TracePacket {
+    /* 0x00 */ u32 magic;
+    /* 0x04 */ u32 count;
+    /* 0x08 */ struct TraceEvent events[TRACE_MAX_EVENTS];
+};
+
+#define TRACE_PACKET_HEADER_SIZE 0x08
+
+#ifdef UNF_TRACE
+void trace_event(u8 type, u8 id, u16 value);
+void trace_flush(void);
+
+#define TRACE_BEGIN(id) trace_event(TRACE_TYPE_BEGIN, (id), 0)
+#define TRACE_END(id) trace_event(TRACE_TYPE_END, (id), 0)
+#define TRACE_COUNTER(id, value) trace_event(TRACE_TYPE_COUNTER, (id), (value))
+#define TRACE_FLUSH() trace_flush()
+#else
+#define TRACE_BEGIN(id)
+#define TRACE_END(id)
+#define TRACE_COUNTER(id, value)
+#define TRACE_FLUSH()
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,447 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ultra64.h>
+#include "sm64.h"
+#include "types.h"
+#include "level_misc_macros.h"
+#include "special_preset_names.h"
+#include "surface_terrains.h"
+#include "object_fields.h"
+#include "engine/surface_collision.h"
+#include "engine/surface_load.h"
+#include "game/object_list_processor.h"
+
+#define COLLISIONVERIFY_VERSION "0.1"
+
+#define DEFAULT_STEPS 50000
+#define OBJECTS_PER_LEVEL 8
+
+// The same padding and wall reach as init_step_collision in src/game/mario_step.c.
+#define STEP_COLLISION_PAD 64.0f
+
+#include "levels/bob/areas/1/collision.inc.c"
+#include "levels/wf/areas/1/collision.inc.c"
+#include "levels/ccm/areas/1/collision.inc.c"
+#include "levels/ttc/areas/1/collision.inc.c"
+#include "levels/bitfs/areas/1/collision.inc.c"
+#include "levels/ssl/areas/1/collision.inc.c"
+#include "levels/castle_inside/areas/1/collision.inc.c"
+
+#include "levels/bob/seesaw_platform/collision.inc.c"
+#include "levels/wf/sliding_platform/collision.inc.c"
+#include "levels/ttc/rotating_hexagon/collision.inc.c"
+#include "levels/ttc/large_treadmill/collision.inc.c"
+
+// Ten copies of a wall facing +x at x = 0, placed as an object at the origin. A position
+// just in front of it is pushed up to 500 units, far out of the bounds of its step.
+static const Collision sStackedWallsObject[] = {
+   COL_INIT(),
+   COL_VERTEX_INIT(4),
+   COL_VERTEX(0,    0, -1000),
+   COL_VERTEX(0,    0,  1000),
+   COL_VERTEX(0, 1000,  1000),
+   COL_VERTEX(0, 1000, -1000),
+   COL_TRI_INIT(SURFACE_DEFAULT, 20),
+   COL_TRI(0, 2, 1), COL_TRI(0, 3, 2), COL_TRI(0, 2, 1), COL_TRI(0, 3, 2),
+   COL_TRI(0, 2, 1), COL_TRI(0, 3, 2), COL_TRI(0, 2, 1), COL_TRI(0, 3, 2),
+   COL_TRI(0, 2, 1), COL_TRI(0, 3, 2), COL_TRI(0, 2, 1), COL_TRI(0, 3, 2),
+   COL_TRI(0, 2, 1), COL_TRI(0, 3, 2), COL_TRI(0, 2, 1), COL_TRI(0, 3, 2),
+   COL_TRI(0, 2, 1), COL_TRI(0, 3, 2), COL_TRI(0, 2, 1), COL_TRI(0, 3, 2),
+   COL_TRI_STOP(),
+   COL_END(),
+};
+
+// A floor with a stack of four walls facing +x at x = 0 under the object's, and walls
+// facing -x at x = 520, where the object's walls push positions to.
+static const Collision sStackedWallsLevel[] = {
+   COL_INIT(),
+   COL_VERTEX_INIT(12),
+   COL_VERTEX(-2000,    0, -2000),
+   COL_VERTEX( 2000,    0, -2000),
+   COL_VERTEX( 2000,    0,  2000),
+   COL_VERTEX(-2000,    0,  2000),
+   COL_VERTEX(  520,    0, -1000),
+   COL_VERTEX(  520,    0,  1000),
+   COL_VERTEX(  520, 1000,  1000),
+   COL_VERTEX(  520, 1000, -1000),
+   COL_VERTEX(    0,    0, -1000),
+   COL_VERTEX(    0,    0,  1000),
+   COL_VERTEX(    0, 1000,  1000),
+   COL_VERTEX(    0, 1000, -1000),
+   COL_TRI_INIT(SURFACE_DEFAULT, 12),
+   COL_TRI(0, 3, 2), COL_TRI(0, 2, 1),
+   COL_TRI(4, 5, 6), COL_TRI(4, 6, 7),
+   COL_TRI(8, 10, 9), COL_TRI(8, 11, 10), COL_TRI(8, 10, 9), COL_TRI(8, 11, 10),
+   COL_TRI(8, 10, 9), COL_TRI(8, 11, 10), COL_TRI(8, 10, 9), COL_TRI(8, 11, 10),
+   COL_TRI_STOP(),
+   COL_END(),
+};
+
+struct Level {
+   const char *name;
+   const Collision *collision;
+   const Collision *object; // placed at the origin instead of random objects
+};
+
+static const struct Level sLevels[] = {
+   { "bob",           bob_seg7_collision_level,            NULL },
+   { "wf",            wf_seg7_collision_070102D8,          NULL },
+   { "ccm",           ccm_seg7_area_1_collision,           NULL },
+   { "ttc",           ttc_seg7_collision_level,            NULL },
+   { "bitfs",         bitfs_seg7_collision_level,          NULL },
+   { "ssl",           ssl_seg7_area_1_collision,           NULL },
+   { "castle_inside", inside_castle_seg7_area_1_collision, NULL },
+   { "stacked_walls", sStackedWallsLevel,                  sStackedWallsObject },
+};
+
+// Object collision models placed on the levels as dynamic surfaces.
+static const Collision *const sObjectModels[] = {
+   bob_seg7_collision_bridge,
+   wf_seg7_collision_sliding_brick_platform,
+   ttc_seg7_collision_07015584,
+   ttc_seg7_collision_070152B4,
+};
+
+typedef struct
+{
+   long steps;
+   long queries;
+   long fallbacks;
+   long mismatches;
+} verify_state;
+
+// Stand-ins for the parts of the game surface_load.c and surface_collision.c use.
+struct Object *gCurrentObject;
+struct NumTimesCalled gNumCalls;
+s32 gSurfaceNodesAllocated;
+s32 gSurfacesAllocated;
+s32 gNumStaticSurfaceNodes;
+s32 gNumStaticSurfaces;
+struct Object *gMarioObject;
+struct MarioState *gMarioState;
+u32 gTimeStopState;
+s32 gNumFindFloorMisses;
+s16 gCheckingSurfaceCollisionsForCamera;
+s16 gFindFloorIncludeSurfaceIntangible;
+s16 *gEnvironmentRegions;
+s32 gEnvironmentLevels[20];
+s16 gCCMEnteredSlide;
+const BehaviorScript bhvDddWarp[1];
+
+static struct Object sObject;
+static u32 sRandomState = 1;
+
+void *main_pool_alloc(u32 size, UNUSED u32 side)
+{
+   return calloc(1, size);
+}
+
+void *segmented_to_virtual(const void *addr)
+{
+   return (void *) addr;
+}
+
+// Special objects and water boxes come after the level's triangles, stop there.
+void spawn_special_objects(UNUSED s16 areaIndex, s16 **specialObjList)
+{
+   static s16 end = TERRAIN_LOAD_END;
+
+   *specialObjList = &end;
+}
+
+void spawn_macro_objects(UNUSED s16 areaIndex, UNUSED s16 *macroObjList)
+{
+}
+
+void spawn_macro_objects_hardcoded(UNUSED s16 areaIndex, UNUSED s16 *macroObjList)
+{
+}
+
+f32 dist_between_objects(UNUSED struct Object *obj1, UNUSED struct Object *obj2)
+{
+   return 0.0f;
+}
+
+void set_text_array_x_y(UNUSED s32 xOffset, UNUSED s32 yOffset)
+{
+}
+
+void print_debug_top_down_mapinfo(UNUSED const char *str, UNUSED s32 number)
+{
+}
+
+void reset_red_coins_collected(void)
+{
+}
+
+// Objects are only turned around the y axis and moved.
+void obj_build_transform_from_pos_and_angle(struct Object *obj, s16 posIndex, s16 angleIndex)
+{
+   f32 yaw = obj->rawData.asS32[angleIndex + 1] * (M_PI / 0x8000);
+
+   memset(obj->transform, 0, sizeof(obj->transform));
+   obj->transform[0][0] = cosf(yaw);
+   obj->transform[0][2] = -sinf(yaw);
+   obj->transform[1][1] = 1.0f;
+   obj->transform[2][0] = sinf(yaw);
+   obj->transform[2][2] = cosf(yaw);
+   obj->transform[3][0] = obj->rawData.asF32[posIndex + 0];
+   obj->transform[3][1] = obj->rawData.asF32[posIndex + 1];
+   obj->transform[3][2] = obj->rawData.asF32[posIndex + 2];
+   obj->transform[3][3] = 1.0f;
+}
+
+void obj_apply_scale_to_matrix(UNUSED struct Object *obj, Mat4 dst, Mat4 src)
+{
+   memcpy(dst, src, sizeof(Mat4));
+}
+
+static u32 random_next(void)
+{
+   sRandomState = sRandomState * 1103515245 + 12345;
+   return sRandomState >> 8;
+}
+
+// Uniform in [-range, range].
+static f32 random_range(f32 range)
+{
+   return ((random_next() & 0xFFFF) / 32767.5f - 1.0f) * range;
+}
+
+static struct Surface *random_static_surface(void)
+{
+   return &sSurfacePool[random_next() % gNumStaticSurfaces];
+}
+
+static void load_object(const Collision *model, f32 x, f32 y, f32 z, s16 yaw)
+{
+   memset(&sObject, 0, sizeof(sObject));
+   sObject.oPosX = x;
+   sObject.oPosY = y;
+   sObject.oPosZ = z;
+   sObject.oFaceAngleYaw = yaw;
+   sObject.oCollisionDistance = 10000.0f;
+   sObject.oDrawingDistance = 10000.0f;
+   sObject.collisionData = (void *) model;
+   gCurrentObject = &sObject;
+   load_object_collision_model();
+   gCurrentObject = NULL;
+}
+
+static void load_objects(const struct Level *level)
+{
+   struct Surface *surf;
+   u32 i;
+
+   clear_dynamic_surfaces();
+
+   if (level->object != NULL) {
+      load_object(level->object, 0.0f, 0.0f, 0.0f, 0);
+      return;
+   }
+
+   for (i = 0; i < OBJECTS_PER_LEVEL; i++) {
+      surf = random_static_surface();
+      load_object(sObjectModels[i % ARRAY_COUNT(sObjectModels)], surf->vertex1[0] + random_range(300.0f),
+                  surf->vertex1[1] + random_range(200.0f), surf->vertex1[2] + random_range(300.0f),
+                  (s16) random_next());
+   }
+}
+
+static void report(verify_state *state, const char *what, f32 x, f32 y, f32 z)
+{
+   if (state->mismatches < 20) {
+      printf("Mismatch: %s at (%.2f, %.2f, %.2f)\n", what, x, y, z);
+   }
+   state->mismatches++;
+}
+
+static void compare_floor(verify_state *state, struct StepCollisionContext *ctx, f32 x, f32 y, f32 z,
+                          f32 *floorHeight)
+{
+   struct Surface *stepFloor, *floor;
+   f32 stepHeight = step_find_floor(ctx, x, y, z, &stepFloor);
+   f32 height = find_floor(x, y, z, &floor);
+
+   if (stepFloor != floor || memcmp(&stepHeight, &height, sizeof(f32)) != 0) {
+      report(state, "floor", x, y, z);
+   }
+   *floorHeight = height;
+   state->queries++;
+}
+
+static void compare_ceil(verify_state *state, struct StepCollisionContext *ctx, f32 x, f32 y, f32 z)
+{
+   struct Surface *stepCeil, *ceil;
+   f32 stepHeight = step_find_ceil(ctx, x, y, z, &stepCeil);
+   f32 height = find_ceil(x, y, z, &ceil);
+
+   if (stepCeil != ceil || memcmp(&stepHeight, &height, sizeof(f32)) != 0) {
+      report(state, "ceiling", x, y, z);
+   }
+   state->queries++;
+}
+
+// Compare a wall search, then move pos to where it pushed the position.
+static void compare_walls(verify_state *state, struct StepCollisionContext *ctx, Vec3f pos, f32 offsetY,
+                          f32 radius)
+{
+   struct WallCollisionData stepData, data;
+   s32 stepCount, count;
+   s32 i;
+
+   memset(&stepData, 0, sizeof(stepData));
+   stepData.x = pos[0];
+   stepData.y = pos[1];
+   stepData.z = pos[2];
+   stepData.offsetY = offsetY;
+   stepData.radius = radius;
+   data = stepData;
+
+   stepCount = step_find_wall_collisions(ctx, &stepData);
+   count = find_wall_collisions(&data);
+
+   if (stepCount != count || stepData.numWalls != data.numWalls
+       || memcmp(&stepData.x, &data.x, sizeof(f32)) != 0
+       || memcmp(&stepData.y, &data.y, sizeof(f32)) != 0
+       || memcmp(&stepData.z, &data.z, sizeof(f32)) != 0) {
+      report(state, "walls", pos[0], pos[1], pos[2]);
+   } else {
+      for (i = 0; i < data.numWalls; i++) {
+         if (stepData.walls[i] != data.walls[i]) {
+            report(state, "wall order", pos[0], pos[1], pos[2]);
+            break;
+         }
+      }
+   }
+
+   pos[0] = data.x;
+   pos[1] = data.y;
+   pos[2] = data.z;
+   state->queries++;
+}
+
+// One step of up to four quarter steps, making the queries perform_ground_step and
+// perform_air_step make through the context.
+static void verify_step(verify_state *state)
+{
+   struct StepCollisionContext ctx;
+   struct Surface *surf = random_static_surface();
+   Vec3f pos, vel, nextPos;
+   f32 minX, maxX, minZ, maxZ, dyMin, dyMax;
+   f32 floorHeight;
+   s32 air = random_next() & 1;
+   s32 i;
+
+   pos[0] = surf->vertex1[0] + random_range(400.0f);
+   pos[1] = surf->vertex1[1] + random_range(300.0f);
+   pos[2] = surf->vertex1[2] + random_range(400.0f);
+   vel[0] = random_range(150.0f);
+   vel[1] = air ? random_range(100.0f) : 0.0f;
+   vel[2] = random_range(150.0f);
+
+   if (air) {
+      dyMin = vel[1] < 0.0f ? vel[1] : 0.0f;
+      dyMax = vel[1] > 0.0f ? vel[1] : 0.0f;
+   } else {
+      dyMin = -100.0f;
+      dyMax = 100.0f;
+   }
+
+   minX = pos[0] + (vel[0] < 0.0f ? vel[0] : 0.0f) - STEP_COLLISION_PAD;
+   maxX = pos[0] + (vel[0] > 0.0f ? vel[0] : 0.0f) + STEP_COLLISION_PAD;
+   minZ = pos[2] + (vel[2] < 0.0f ? vel[2] : 0.0f) - STEP_COLLISION_PAD;
+   maxZ = pos[2] + (vel[2] > 0.0f ? vel[2] : 0.0f) + STEP_COLLISION_PAD;
+   step_collision_init(&ctx, minX, pos[1] + dyMin - STEP_COLLISION_PAD, minZ, maxX,
+                       pos[1] + dyMax + 150.0f + STEP_COLLISION_PAD, maxZ, 50.0f);
+   if (!ctx.valid) {
+      state->fallbacks++;
+   }
+
+   for (i = 0; i < 4; i++) {
+      // Stray a little from the straight line so some searches fall outside the context.
+      nextPos[0] = pos[0] + vel[0] / 4.0f + random_range(8.0f);
+      nextPos[1] = pos[1] + vel[1] / 4.0f + random_range(8.0f);
+      nextPos[2] = pos[2] + vel[2] / 4.0f + random_range(8.0f);
+
+      if (air) {
+         compare_walls(state, &ctx, nextPos, 150.0f, 50.0f);
+         compare_walls(state, &ctx, nextPos, 30.0f, 50.0f);
+      } else {
+         compare_walls(state, &ctx, nextPos, 30.0f, 24.0f);
+         compare_walls(state, &ctx, nextPos, 60.0f, 50.0f);
+      }
+      // A radius larger than the context was built for.
+      if ((random_next() & 7) == 0) {
+         compare_walls(state, &ctx, nextPos, 60.0f, 70.0f);
+      }
+
+      compare_floor(state, &ctx, nextPos[0], nextPos[1], nextPos[2], &floorHeight);
+      compare_ceil(state, &ctx, nextPos[0], floorHeight + 80.0f, nextPos[2]);
+
+      pos[0] = nextPos[0];
+      pos[1] = nextPos[1];
+      pos[2] = nextPos[2];
+   }
+
+   state->steps++;
+}
+
+static void print_usage(void)
+{
+   fprintf(stderr,
+         "Usage: collisionverify [-n STEPS]\n"
+         "\n"
+         "collisionverify v" COLLISIONVERIFY_VERSION ": check that the step collision context in\n"
+         "src/engine/surface_collision.c finds the same floors, ceilings and walls as find_floor,\n"
+         "find_ceil and find_wall_collisions, on level and object collision from the repo\n"
+         "\n"
+         "Optional arguments:\n"
+         " -n STEPS random Mario steps per level (default: %d)\n",
+         DEFAULT_STEPS);
+}
+
+int main(int argc, char *argv[])
+{
+   verify_state state;
+   long steps = DEFAULT_STEPS;
+   long n;
+   u32 i;
+
+   for (i = 1; i < (u32) argc; i++) {
+      if (argv[i][0] == '-' && argv[i][1] == 'n' && i + 1 < (u32) argc) {
+         steps = strtol(argv[++i], NULL, 0);
+      } else {
+         print_usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (steps <= 0) {
+      print_usage();
+      return EXIT_FAILURE;
+   }
+
+   memset(&state, 0, sizeof(state));
+   alloc_surface_pools();
+
+   for (i = 0; i < ARRAY_COUNT(sLevels); i++) {
+      load_area_terrain(0, (s16 *) sLevels[i].collision, NULL, NULL);
+      for (n = 0; n < steps; n++) {
+         // Move the objects around every so often.
+         if (n % 1000 == 0) {
+            load_objects(&sLevels[i]);
+         }
+         verify_step(&state);
+      }
+      printf("%-14s %5d surfaces, %4d of them on objects\n", sLevels[i].name, gSurfacesAllocated,
+             gSurfacesAllocated - gNumStaticSurfaces);
+   }
+
+   printf("%ld steps, %ld queries compared, %ld steps outside the context, %ld mismatches\n",
+          state.steps, state.queries, state.fallbacks, state.mismatches);
+
+   return state.mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,1040 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ultra64.h>
+#include "sm64.h"
+#include "types.h"
+#include "dialog_ids.h"
+#include "level_misc_macros.h"
+#include "level_table.h"
+#include "special_preset_names.h"
+#include "surface_terrains.h"
+#include "object_fields.h"
+#include "audio/external.h"
+#include "engine/graph_node.h"
+#include "engine/math_util.h"
+#include "engine/surface_collision.h"
+#include "engine/surface_load.h"
+#include "game/area.h"
+#include "game/behavior_actions.h"
+#include "game/camera.h"
+#include "game/debug.h"
+#include "game/game_init.h"
+#include "game/ingame_menu.h"
+#include "game/interaction.h"
+#include "game/level_update.h"
+#include "game/macro_special_objects.h"
+#include "game/mario.h"
+#include "game/mario_misc.h"
+#include "game/memory.h"
+#include "game/obj_behaviors.h"
+#include "game/object_helpers.h"
+#include "game/object_list_processor.h"
+#include "game/print.h"
+#include "game/rumble_init.h"
+#include "game/save_file.h"
+#include "game/sound_init.h"
+
+#define DEMOREPLAY_VERSION "0.1"
+
+#define DEFAULT_FRAMES 1800
+#define MAX_DEMO_INPUTS 1024
+#define MARIO_ANIM_BUFFER_SIZE 0x8000
+
+#define FNV_OFFSET_BASIS 0x811C9DC5
+#define FNV_PRIME 0x01000193
+
+// Special objects aren't simulated. Every entry is padded to the longest form, so that
+// spawn_special_objects below can step over them to the water boxes behind.
+#undef SPECIAL_OBJECT
+#undef SPECIAL_OBJECT_WITH_YAW
+#undef SPECIAL_OBJECT_WITH_YAW_AND_PARAM
+#define SPECIAL_OBJECT(preset, posX, posY, posZ) preset, posX, posY, posZ, 0, 0
+#define SPECIAL_OBJECT_WITH_YAW(preset, posX, posY, posZ, yaw) preset, posX, posY, posZ, yaw, 0
+#define SPECIAL_OBJECT_WITH_YAW_AND_PARAM(preset, posX, posY, posZ, yaw, param) \
+   preset, posX, posY, posZ, yaw, param
+#define SPECIAL_OBJECT_LENGTH 6
+
+#include "levels/bbh/areas/1/collision.inc.c"
+#include "levels/bitdw/areas/1/collision.inc.c"
+#include "levels/ccm/areas/1/collision.inc.c"
+#include "levels/hmc/areas/1/collision.inc.c"
+#include "levels/jrb/areas/1/collision.inc.c"
+#include "levels/pss/areas/1/collision.inc.c"
+#include "levels/wf/areas/1/collision.inc.c"
+
+// The levels of the demos, with the object Mario enters the first area from (warp node
+// 0x0A in the level's script).
+struct Level {
+   const char *name;
+   s16 levelNum;
+   const Collision *collision;
+   s16 pos[3];
+   s16 yaw;
+   u32 action;
+};
+
+static const struct Level sLevels[] = {
+   { "bbh",   LEVEL_BBH,   bbh_seg7_collision_level,   {   666,   796,  5350 }, 180, ACT_SPAWN_SPIN_AIRBORNE },
+   { "bitdw", LEVEL_BITDW, bitdw_seg7_collision_level, { -7443, -2153,  3886 },  90, ACT_SPAWN_NO_SPIN_AIRBORNE },
+   { "ccm",   LEVEL_CCM,   ccm_seg7_area_1_collision,  { -1512,  3560, -2305 }, 140, ACT_SPAWN_SPIN_AIRBORNE },
+   { "hmc",   LEVEL_HMC,   hmc_seg7_collision_level,   { -7152,  3161,  7181 }, 135, ACT_SPAWN_SPIN_AIRBORNE },
+   { "jrb",   LEVEL_JRB,   jrb_seg7_area_1_collision,  { -6750,  2126,  1482 },  90, ACT_SPAWN_SPIN_AIRBORNE },
+   { "pss",   LEVEL_PSS,   pss_seg7_collision,         {  5632,  6751, -5631 }, 270, ACT_SPAWN_NO_SPIN_AIRBORNE },
+   { "wf",    LEVEL_WF,    wf_seg7_collision_070102D8, {  2600,  1256,  5120 },  90, ACT_SPAWN_SPIN_AIRBORNE },
+};
+
+enum Timer {
+   TIMER_INPUT,
+   TIMER_MARIO,
+   TIMER_ANIMATION,
+   TIMER_COUNT
+};
+
+static const char *const sTimerNames[TIMER_COUNT] = {
+   "input",
+   "mario",
+   "animation",
+};
+
+struct Demo {
+   char name[64];
+   const struct Level *level;
+   struct DemoInput inputs[MAX_DEMO_INPUTS];
+   u32 numInputs;
+};
+
+typedef struct
+{
+   long frames;
+   long floors;
+   long ceils;
+   long walls;
+   long warps;
+   double seconds[TIMER_COUNT];
+   u32 hash;
+} replay_state;
+
+// Stand-ins for the parts of the game the Mario code uses. Graphics, audio, dialogs, the
+// camera and every object other than Mario are left out.
+struct Controller gControllers[3];
+struct Controller *gPlayer1Controller = &gControllers[0];
+struct MarioState gMarioStates[1];
+struct MarioState *gMarioState = &gMarioStates[0];
+struct MarioBodyState gBodyStates[2];
+struct PlayerCameraState gPlayerCameraState[2];
+struct SpawnInfo gPlayerSpawnInfos[1];
+struct SpawnInfo *gMarioSpawnInfo = &gPlayerSpawnInfos[0];
+struct DmaHandlerList gMarioAnimsBuf;
+struct HudDisplay gHudDisplay;
+struct Area *gCurrentArea;
+struct Camera *gCamera;
+struct Object *gCurrentObject;
+struct Object *gMarioObject;
+struct Object *gCutsceneFocus;
+struct NumTimesCalled gNumCalls;
+struct GraphNodeRoot *gCurGraphNodeRoot;
+struct GraphNodeMasterList *gCurGraphNodeMasterList;
+struct GraphNodePerspective *gCurGraphNodeCamFrustum;
+struct GraphNodeCamera *gCurGraphNodeCamera;
+struct GraphNodeObject *gCurGraphNodeObject;
+struct GraphNode gObjParentGraphNode;
+s16 gCurrLevelNum;
+s16 gCurrCourseNum;
+s16 gCurrAreaIndex;
+s16 gCurrSaveFileNum = 1;
+struct CreditsEntry *gCurrCreditsEntry;
+u8 gLastCompletedCourseNum;
+u8 gLastCompletedStarNum;
+s8 gNeverEnteredCastle;
+s8 gDebugLevelSelect;
+s8 gShowDebugText;
+u8 gSpecialTripleJump;
+s32 gDialogResponse;
+s16 gCameraMovementFlags;
+s16 gCheckingSurfaceCollisionsForCamera;
+s16 gFindFloorIncludeSurfaceIntangible;
+s16 gCCMEnteredSlide;
+s16 *gEnvironmentRegions;
+s32 gEnvironmentLevels[20];
+s32 gNumFindFloorMisses;
+s32 gSurfaceNodesAllocated;
+s32 gSurfacesAllocated;
+s32 gNumStaticSurfaceNodes;
+s32 gNumStaticSurfaces;
+s32 gRumblePakTimer;
+s16 gSaveOptSelectIndex;
+u32 gTimeStopState;
+u32 gAudioRandom;
+u32 gGlobalTimer;
+u16 gAreaUpdateCounter;
+s8 gPaintingMarioYEntry;
+f32 gGlobalSoundSource[3];
+
+const BehaviorScript bhvBobomb[1];
+const BehaviorScript bhvBowser[1];
+const BehaviorScript bhvBowserKeyCourseExit[1];
+const BehaviorScript bhvBowserKeyUnlockDoor[1];
+const BehaviorScript bhvCarrySomething3[1];
+const BehaviorScript bhvCarrySomething4[1];
+const BehaviorScript bhvCarrySomething5[1];
+const BehaviorScript bhvCelebrationStar[1];
+const BehaviorScript bhvDddWarp[1];
+const BehaviorScript bhvEndPeach[1];
+const BehaviorScript bhvEndToad[1];
+const BehaviorScript bhvGiantPole[1];
+const BehaviorScript bhvJumpingBox[1];
+const BehaviorScript bhvKoopaShellUnderwater[1];
+const BehaviorScript bhvMetalCap[1];
+const BehaviorScript bhvNormalCap[1];
+const BehaviorScript bhvSparkleSpawn[1];
+const BehaviorScript bhvStarKeyCollectionPuffSpawner[1];
+const BehaviorScript bhvStaticObject[1];
+const BehaviorScript bhvTree[1];
+const BehaviorScript bhvUnlockDoorStar[1];
+const BehaviorScript bhvVanishCap[1];
+const BehaviorScript bhvWingCap[1];
+const Collision warp_pipe_seg3_collision_03009AC8[1];
+
+static struct Area sArea;
+static struct Camera sCamera;
+static struct Object sMarioObject;
+static struct Object sSpawnedObject;
+static OSContPad sControllerPad;
+static u8 sMarioAnimBuffer[MARIO_ANIM_BUFFER_SIZE];
+static struct DemoInput *sCurrDemoInput;
+static s32 sWarpPending;
+static u32 sRandomState = 1;
+
+void *main_pool_alloc(u32 size, UNUSED u32 side)
+{
+   return calloc(1, size);
+}
+
+void *alloc_only_pool_alloc(UNUSED struct AllocOnlyPool *pool, s32 size)
+{
+   return calloc(1, size);
+}
+
+void *segmented_to_virtual(const void *addr)
+{
+   return (void *) addr;
+}
+
+void *virtual_to_segmented(UNUSED u32 segment, const void *addr)
+{
+   return (void *) addr;
+}
+
+// setup_dma_table_list and load_patchable_table in src/boot/memory.c, with memcpy in
+// place of DMA.
+void setup_dma_table_list(struct DmaHandlerList *list, void *srcAddr, void *buffer)
+{
+   u32 count = ((struct DmaTable *) srcAddr)->count;
+   u32 size = sizeof(struct DmaTable) + (count - 1) * sizeof(struct OffsetSizePair);
+
+   list->dmaTable = malloc(size);
+   memcpy(list->dmaTable, srcAddr, size);
+   list->dmaTable->srcAddr = srcAddr;
+   list->currentAddr = NULL;
+   list->bufTarget = buffer;
+}
+
+s32 load_patchable_table(struct DmaHandlerList *list, s32 index)
+{
+   struct DmaTable *table = list->dmaTable;
+   u8 *addr;
+
+   if ((u32) index >= table->count) {
+      return FALSE;
+   }
+   addr = table->srcAddr + table->anim[index].offset;
+   if (list->currentAddr == addr) {
+      return FALSE;
+   }
+   memcpy(list->bufTarget, addr, table->anim[index].size);
+   list->currentAddr = addr;
+   return TRUE;
+}
+
+void spawn_special_objects(UNUSED s16 areaIndex, s16 **specialObjList)
+{
+   *specialObjList += get_special_objects_size(*specialObjList);
+}
+
+u32 get_special_objects_size(s16 *data)
+{
+   return 1 + *data * SPECIAL_OBJECT_LENGTH;
+}
+
+void spawn_macro_objects(UNUSED s16 areaIndex, UNUSED s16 *macroObjList)
+{
+}
+
+void spawn_macro_objects_hardcoded(UNUSED s16 areaIndex, UNUSED s16 *macroObjList)
+{
+}
+
+// Objects spawned by Mario (particles, his cap, stars) all share one object that is
+// never updated.
+struct Object *spawn_object(struct Object *parent, UNUSED s32 model, const BehaviorScript *behavior)
+{
+   memset(&sSpawnedObject, 0, sizeof(sSpawnedObject));
+   sSpawnedObject.parentObj = parent;
+   sSpawnedObject.behavior = behavior;
+   sSpawnedObject.oPosX = parent->oPosX;
+   sSpawnedObject.oPosY = parent->oPosY;
+   sSpawnedObject.oPosZ = parent->oPosZ;
+   return &sSpawnedObject;
+}
+
+struct Object *spawn_object_abs_with_rot(struct Object *parent, UNUSED s16 uselessArg, u32 model,
+                                         const BehaviorScript *behavior, s16 x, s16 y, s16 z,
+                                         UNUSED s16 rx, UNUSED s16 ry, UNUSED s16 rz)
+{
+   struct Object *obj = spawn_object(parent, model, behavior);
+
+   obj->oPosX = x;
+   obj->oPosY = y;
+   obj->oPosZ = z;
+   return obj;
+}
+
+void bhv_spawn_star_no_level_exit(UNUSED u32 sp20)
+{
+}
+
+void spawn_default_star(UNUSED f32 sp20, UNUSED f32 sp24, UNUSED f32 sp28)
+{
+}
+
+void spawn_wind_particles(UNUSED s16 pitch, UNUSED s16 yaw)
+{
+}
+
+void obj_mark_for_deletion(struct Object *obj)
+{
+   obj->activeFlags = ACTIVE_FLAG_DEACTIVATED;
+}
+
+void obj_scale(struct Object *obj, f32 scale)
+{
+   obj->header.gfx.scale[0] = scale;
+   obj->header.gfx.scale[1] = scale;
+   obj->header.gfx.scale[2] = scale;
+}
+
+void obj_set_held_state(struct Object *obj, const BehaviorScript *heldBehavior)
+{
+   obj->parentObj = gMarioObject;
+   obj->curBhvCommand = heldBehavior;
+}
+
+f32 dist_between_objects(struct Object *obj1, struct Object *obj2)
+{
+   f32 dx = obj1->oPosX - obj2->oPosX;
+   f32 dy = obj1->oPosY - obj2->oPosY;
+   f32 dz = obj1->oPosZ - obj2->oPosZ;
+
+   return sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+void obj_build_transform_from_pos_and_angle(UNUSED struct Object *obj, UNUSED s16 posIndex,
+                                            UNUSED s16 angleIndex)
+{
+}
+
+void obj_apply_scale_to_matrix(UNUSED struct Object *obj, Mat4 dst, Mat4 src)
+{
+   memcpy(dst, src, sizeof(Mat4));
+}
+
+void cur_obj_init_animation_with_sound(UNUSED s32 animIndex)
+{
+}
+
+s32 cur_obj_check_if_near_animation_end(void)
+{
+   return TRUE;
+}
+
+void enable_time_stop(void)
+{
+   gTimeStopState |= TIME_STOP_ENABLED;
+}
+
+void disable_time_stop(void)
+{
+   gTimeStopState &= ~TIME_STOP_ENABLED;
+}
+
+void guMtxF2L(UNUSED float mf[4][4], UNUSED Mtx *m)
+{
+}
+
+// Warps aren't followed. Mario starts over at the level's entry instead (see
+// replay_demo).
+s16 level_trigger_warp(UNUSED struct MarioState *m, UNUSED s32 warpOp)
+{
+   sWarpPending = TRUE;
+   return 0;
+}
+
+u16 level_control_timer(UNUSED s32 timerOp)
+{
+   return 0;
+}
+
+void fade_into_special_warp(UNUSED u32 arg, UNUSED u32 color)
+{
+}
+
+void load_level_init_text(UNUSED u32 arg)
+{
+}
+
+void play_transition(UNUSED s16 transType, UNUSED s16 time, UNUSED u8 red, UNUSED u8 green,
+                     UNUSED u8 blue)
+{
+}
+
+void override_viewport_and_clip(UNUSED Vp *a, UNUSED Vp *b, UNUSED u8 c, UNUSED u8 d, UNUSED u8 e)
+{
+}
+
+void set_camera_mode(UNUSED struct Camera *c, UNUSED s16 mode, UNUSED s16 frames)
+{
+}
+
+void set_camera_shake_from_hit(UNUSED s16 shake)
+{
+}
+
+s32 trigger_cutscene_dialog(UNUSED s32 trigger)
+{
+   return 0;
+}
+
+f32 camera_approach_f32_symmetric(f32 value, f32 target, f32 increment)
+{
+   if (value < target) {
+      value = value + increment < target ? value + increment : target;
+   } else {
+      value = value - increment > target ? value - increment : target;
+   }
+   return value;
+}
+
+void create_dialog_box(UNUSED s16 dialog)
+{
+}
+
+void create_dialog_box_with_var(UNUSED s16 dialog, UNUSED s32 dialogVar)
+{
+}
+
+void create_dialog_inverted_box(UNUSED s16 dialog)
+{
+}
+
+void create_dialog_box_with_response(UNUSED s16 dialog)
+{
+}
+
+s16 get_dialog_id(void)
+{
+   return DIALOG_NONE;
+}
+
+void set_menu_mode(UNUSED s16 mode)
+{
+}
+
+void set_cutscene_message(UNUSED s16 xOffset, UNUSED s16 yOffset, UNUSED s16 msgIndex,
+                          UNUSED s16 msgDuration)
+{
+}
+
+void reset_cutscene_msg_fade(void)
+{
+}
+
+void dl_rgba16_begin_cutscene_msg_fade(void)
+{
+}
+
+void dl_rgba16_stop_cutscene_msg_fade(void)
+{
+}
+
+void print_credits_str_ascii(UNUSED s16 x, UNUSED s16 y, UNUSED const char *str)
+{
+}
+
+void print_text_fmt_int(UNUSED s32 x, UNUSED s32 y, UNUSED const char *str, UNUSED s32 n)
+{
+}
+
+void set_text_array_x_y(UNUSED s32 xOffset, UNUSED s32 yOffset)
+{
+}
+
+void print_debug_top_down_mapinfo(UNUSED const char *str, UNUSED s32 number)
+{
+}
+
+void reset_red_coins_collected(void)
+{
+}
+
+u32 save_file_get_flags(void)
+{
+   return 0;
+}
+
+void save_file_set_flags(UNUSED u32 flags)
+{
+}
+
+void save_file_clear_flags(UNUSED u32 flags)
+{
+}
+
+s32 save_file_get_cap_pos(UNUSED Vec3s capPos)
+{
+   return FALSE;
+}
+
+void save_file_set_cap_pos(UNUSED s16 x, UNUSED s16 y, UNUSED s16 z)
+{
+}
+
+s32 save_file_get_total_star_count(UNUSED s32 fileIndex, UNUSED s32 minCourse, UNUSED s32 maxCourse)
+{
+   return 0;
+}
+
+void save_file_collect_star_or_key(UNUSED s16 coinScore, UNUSED s16 starIndex)
+{
+}
+
+void save_file_do_save(UNUSED s32 fileIndex)
+{
+}
+
+void play_sound(UNUSED s32 soundBits, UNUSED f32 *pos)
+{
+}
+
+void stop_sound(UNUSED u32 soundBits, UNUSED f32 *pos)
+{
+}
+
+void set_sound_moving_speed(UNUSED u8 bank, UNUSED u8 speed)
+{
+}
+
+void sound_banks_enable(UNUSED u8 player, UNUSED u16 bankMask)
+{
+}
+
+void seq_player_lower_volume(UNUSED u8 player, UNUSED u16 fadeDuration, UNUSED u8 percentage)
+{
+}
+
+void seq_player_unlower_volume(UNUSED u8 player, UNUSED u16 fadeDuration)
+{
+}
+
+void play_music(UNUSED u8 player, UNUSED u16 seqArgs, UNUSED u16 fadeTimer)
+{
+}
+
+void drop_queued_background_music(void)
+{
+}
+
+void play_course_clear(void)
+{
+}
+
+void play_peachs_jingle(void)
+{
+}
+
+void raise_background_noise(UNUSED s32 a)
+{
+}
+
+void lower_background_noise(UNUSED s32 a)
+{
+}
+
+void disable_background_sound(void)
+{
+}
+
+void enable_background_sound(void)
+{
+}
+
+void play_cutscene_music(UNUSED u16 seqArgs)
+{
+}
+
+void play_infinite_stairs_music(void)
+{
+}
+
+void play_shell_music(void)
+{
+}
+
+void stop_shell_music(void)
+{
+}
+
+void play_cap_music(UNUSED u16 seqArgs)
+{
+}
+
+void fadeout_cap_music(void)
+{
+}
+
+void stop_cap_music(void)
+{
+}
+
+void fadeout_level_music(UNUSED s16 fadeTimer)
+{
+}
+
+void queue_rumble_data(UNUSED s16 a0, UNUSED s16 a1)
+{
+}
+
+void func_sh_8024C89C(UNUSED s16 a0)
+{
+}
+
+u8 is_rumble_finished_and_queue_empty(void)
+{
+   return TRUE;
+}
+
+void reset_rumble_timers(void)
+{
+}
+
+void reset_rumble_timers_2(UNUSED s32 a0)
+{
+}
+
+void func_sh_8024CA04(void)
+{
+}
+
+static void print_usage(void)
+{
+   fprintf(stderr,
+         "Usage: demoreplay [-n FRAMES] [-v] [DEMO.bin ...]\n"
+         "\n"
+         "demoreplay v" DEMOREPLAY_VERSION ": replay demo inputs through Mario's code from src/game\n"
+         "on the collision of the demo's level, and report frames per second, the time per frame\n"
+         "of each part of the update and a hash of Mario's state over all frames\n"
+         "\n"
+         "Demos are read from the .bin files in assets/demos. Without any, a made up demo of\n"
+         "random inputs is replayed on each level.\n"
+         "\n"
+         "Optional arguments:\n"
+         " -n FRAMES frames of each made up demo (default: %d)\n"
+         " -v        print the hash after every frame\n",
+         DEFAULT_FRAMES);
+}
+
+static double now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static u32 random_next(void)
+{
+   sRandomState = sRandomState * 1103515245 + 12345;
+   return sRandomState >> 8;
+}
+
+static const struct Level *find_level(s32 levelNum)
+{
+   u32 i;
+
+   for (i = 0; i < ARRAY_COUNT(sLevels); i++) {
+      if (sLevels[i].levelNum == levelNum) {
+         return &sLevels[i];
+      }
+   }
+   return NULL;
+}
+
+// A demo file holds the level number in the timer of its first entry, followed by the
+// inputs, and ends with an entry whose timer is 0.
+static int read_demo(struct Demo *demo, const char *path)
+{
+   FILE *f = fopen(path, "rb");
+   struct DemoInput header;
+   size_t count;
+
+   if (f == NULL) {
+      perror(path);
+      return 0;
+   }
+   count = fread(&header, sizeof(header), 1, f);
+   demo->numInputs = fread(demo->inputs, sizeof(demo->inputs[0]), MAX_DEMO_INPUTS - 1, f);
+   fclose(f);
+
+   if (count != 1 || demo->numInputs == 0) {
+      fprintf(stderr, "%s: not a demo\n", path);
+      return 0;
+   }
+   demo->level = find_level((s8) header.timer);
+   if (demo->level == NULL) {
+      fprintf(stderr, "%s: no collision for level %d\n", path, (s8) header.timer);
+      return 0;
+   }
+   // Make sure the demo ends even if the file was cut short.
+   demo->inputs[demo->numInputs++].timer = 0;
+   snprintf(demo->name, sizeof(demo->name), "%s", path);
+   return 1;
+}
+
+// Runs of random stick positions and A, B and Z presses, for about the given number of
+// frames.
+static void make_demo(struct Demo *demo, const struct Level *level, long frames)
+{
+   struct DemoInput *input;
+   u32 r;
+
+   memset(demo, 0, sizeof(*demo));
+   demo->level = level;
+   snprintf(demo->name, sizeof(demo->name), "%s", level->name);
+
+   while (frames > 0 && demo->numInputs < MAX_DEMO_INPUTS - 1) {
+      input = &demo->inputs[demo->numInputs++];
+      r = random_next();
+      input->timer = 1 + r % 40;
+      input->rawStickX = (r & 0x100) ? (s8) (random_next() % 161 - 80) : 0;
+      input->rawStickY = (r & 0x200) ? (s8) (random_next() % 161 - 80) : 80;
+      input->buttonMask = (random_next() >> 4) & 0xE0;
+      frames -= input->timer;
+   }
+   demo->inputs[demo->numInputs++].timer = 0;
+}
+
+static void start_level(const struct Level *level)
+{
+   load_area_terrain(0, (s16 *) level->collision, NULL, NULL);
+
+   memset(&sArea, 0, sizeof(sArea));
+   memset(&sCamera, 0, sizeof(sCamera));
+   sArea.index = 1;
+   sArea.flags = 1;
+   sArea.terrainData = (s16 *) level->collision;
+   sArea.camera = &sCamera;
+   // The camera stays behind Mario's starting direction, so pushing the stick up walks
+   // away from it.
+   sCamera.yaw = DEGREES(level->yaw) + 0x8000;
+   gCurrentArea = &sArea;
+   gCamera = &sCamera;
+   gCurrLevelNum = level->levelNum;
+   gCurrCourseNum = COURSE_NONE;
+   gCurrAreaIndex = 1;
+}
+
+// Mario's part of load_mario_area and init_mario_after_warp in level_update.c: put him at
+// the level's entry and start the action of its warp object.
+static void spawn_mario(const struct Level *level)
+{
+   memset(gPlayerSpawnInfos, 0, sizeof(gPlayerSpawnInfos));
+   vec3s_set(gMarioSpawnInfo->startPos, level->pos[0], level->pos[1], level->pos[2]);
+   vec3s_set(gMarioSpawnInfo->startAngle, 0, DEGREES(level->yaw), 0);
+   gMarioSpawnInfo->areaIndex = 1;
+
+   memset(&sMarioObject, 0, sizeof(sMarioObject));
+   sMarioObject.activeFlags = ACTIVE_FLAG_ACTIVE;
+   sMarioObject.header.gfx.node.type = GRAPH_NODE_TYPE_OBJECT;
+   geo_obj_init_spawninfo(&sMarioObject.header.gfx, gMarioSpawnInfo);
+   geo_obj_init(&sMarioObject.header.gfx, NULL, sMarioObject.header.gfx.pos,
+                sMarioObject.header.gfx.angle);
+   gMarioObject = &sMarioObject;
+   gCurrentObject = &sMarioObject;
+
+   memset(gMarioStates, 0, sizeof(gMarioStates));
+   memset(gBodyStates, 0, sizeof(gBodyStates));
+   memset(gPlayerCameraState, 0, sizeof(gPlayerCameraState));
+   memset(gControllers, 0, sizeof(gControllers));
+   memset(&sControllerPad, 0, sizeof(sControllerPad));
+   gControllers[0].controllerData = &sControllerPad;
+   gMarioAnimsBuf.currentAddr = NULL;
+
+   init_mario_from_save_file();
+   init_mario();
+   set_mario_action(gMarioState, level->action, 0);
+}
+
+// run_demo_inputs and read_controller_inputs in game_init.c.
+static void read_demo_input(void)
+{
+   struct Controller *controller = &gControllers[0];
+
+   sControllerPad.stick_x = sCurrDemoInput->rawStickX;
+   sControllerPad.stick_y = sCurrDemoInput->rawStickY;
+   sControllerPad.button =
+       ((sCurrDemoInput->buttonMask & 0xF0) << 8) + (sCurrDemoInput->buttonMask & 0xF);
+   if (--sCurrDemoInput->timer == 0) {
+      sCurrDemoInput++;
+   }
+
+   controller->rawStickX = sControllerPad.stick_x;
+   controller->rawStickY = sControllerPad.stick_y;
+   controller->buttonPressed = sControllerPad.button & (sControllerPad.button ^ controller->buttonDown);
+   controller->buttonDown = sControllerPad.button;
+
+   // adjust_analog_stick
+   controller->stickX = 0;
+   controller->stickY = 0;
+   if (controller->rawStickX <= -8) {
+      controller->stickX = controller->rawStickX + 6;
+   }
+   if (controller->rawStickX >= 8) {
+      controller->stickX = controller->rawStickX - 6;
+   }
+   if (controller->rawStickY <= -8) {
+      controller->stickY = controller->rawStickY + 6;
+   }
+   if (controller->rawStickY >= 8) {
+      controller->stickY = controller->rawStickY - 6;
+   }
+   controller->stickMag =
+       sqrtf(controller->stickX * controller->stickX + controller->stickY * controller->stickY);
+   if (controller->stickMag > 64) {
+      controller->stickX *= 64 / controller->stickMag;
+      controller->stickY *= 64 / controller->stickMag;
+      controller->stickMag = 64;
+   }
+}
+
+// bhv_mario_update and copy_mario_state_to_object in object_list_processor.c.
+static void update_mario(void)
+{
+   gCurrentObject = gMarioObject;
+   gMarioObject->oMarioParticleFlags = execute_mario_action(gMarioObject);
+
+   gMarioObject->oVelX = gMarioState->vel[0];
+   gMarioObject->oVelY = gMarioState->vel[1];
+   gMarioObject->oVelZ = gMarioState->vel[2];
+   gMarioObject->oPosX = gMarioState->pos[0];
+   gMarioObject->oPosY = gMarioState->pos[1];
+   gMarioObject->oPosZ = gMarioState->pos[2];
+   gMarioObject->oMoveAnglePitch = gMarioObject->header.gfx.angle[0];
+   gMarioObject->oMoveAngleYaw = gMarioObject->header.gfx.angle[1];
+   gMarioObject->oMoveAngleRoll = gMarioObject->header.gfx.angle[2];
+   gMarioObject->oFaceAnglePitch = gMarioObject->header.gfx.angle[0];
+   gMarioObject->oFaceAngleYaw = gMarioObject->header.gfx.angle[1];
+   gMarioObject->oFaceAngleRoll = gMarioObject->header.gfx.angle[2];
+   gMarioObject->oAngleVelPitch = gMarioState->angleVel[0];
+   gMarioObject->oAngleVelYaw = gMarioState->angleVel[1];
+   gMarioObject->oAngleVelRoll = gMarioState->angleVel[2];
+}
+
+// The animation step of geo_process_object in rendering_graph_node.c, the only part of
+// drawing Mario that changes his state.
+static void update_mario_animation(void)
+{
+   struct GraphNodeObject *node = &gMarioObject->header.gfx;
+
+   if ((node->node.flags & GRAPH_RENDER_ACTIVE) && node->animInfo.curAnim != NULL) {
+      if (node->node.flags & GRAPH_RENDER_HAS_ANIMATION) {
+         node->animInfo.animFrame =
+             geo_update_animation_frame(&node->animInfo, &node->animInfo.animFrameAccelAssist);
+      }
+      node->animInfo.animTimer = gAreaUpdateCounter;
+   }
+}
+
+static u32 hash_bytes(u32 hash, const void *data, size_t size)
+{
+   const u8 *bytes = data;
+
+   while (size-- != 0) {
+      hash = (hash ^ *bytes++) * FNV_PRIME;
+   }
+   return hash;
+}
+
+// Everything in MarioState but the pointers, which differ from run to run.
+static u32 hash_mario(u32 hash)
+{
+   struct MarioState *m = gMarioState;
+   struct AnimInfo *anim = &gMarioObject->header.gfx.animInfo;
+   struct {
+      u32 action, actionArg, flags, particleFlags;
+      u16 input, actionState, actionTimer;
+      s16 faceAngle[3], angleVel[3], health, animID, animFrame;
+      f32 pos[3], vel[3], forwardVel, floorHeight, ceilHeight, waterLevel, peakHeight;
+   } state;
+
+   memset(&state, 0, sizeof(state));
+   state.action = m->action;
+   state.actionArg = m->actionArg;
+   state.flags = m->flags;
+   state.particleFlags = m->particleFlags;
+   state.input = m->input;
+   state.actionState = m->actionState;
+   state.actionTimer = m->actionTimer;
+   vec3s_copy(state.faceAngle, m->faceAngle);
+   vec3s_copy(state.angleVel, m->angleVel);
+   state.health = m->health;
+   state.animID = anim->animID;
+   state.animFrame = anim->animFrame;
+   vec3f_copy(state.pos, m->pos);
+   vec3f_copy(state.vel, m->vel);
+   state.forwardVel = m->forwardVel;
+   state.floorHeight = m->floorHeight;
+   state.ceilHeight = m->ceilHeight;
+   state.waterLevel = m->waterLevel;
+   state.peakHeight = m->peakHeight;
+   return hash_bytes(hash, &state, sizeof(state));
+}
+
+static void replay_demo(struct Demo *demo, replay_state *state, int verbose)
+{
+   double start, end;
+   long frames = 0;
+
+   start_level(demo->level);
+   spawn_mario(demo->level);
+   sCurrDemoInput = demo->inputs;
+   sWarpPending = FALSE;
+   memset(state, 0, sizeof(*state));
+   state->hash = FNV_OFFSET_BASIS;
+
+   while (sCurrDemoInput->timer != 0) {
+      memset(&gNumCalls, 0, sizeof(gNumCalls));
+
+      start = now();
+      read_demo_input();
+      end = now();
+      state->seconds[TIMER_INPUT] += end - start;
+
+      start = end;
+      gAreaUpdateCounter++;
+      update_mario();
+      end = now();
+      state->seconds[TIMER_MARIO] += end - start;
+
+      start = end;
+      update_mario_animation();
+      end = now();
+      state->seconds[TIMER_ANIMATION] += end - start;
+
+      if (sWarpPending) {
+         sWarpPending = FALSE;
+         spawn_mario(demo->level);
+         state->warps++;
+      }
+
+      gGlobalTimer++;
+      frames++;
+      state->floors += gNumCalls.floor;
+      state->ceils += gNumCalls.ceil;
+      state->walls += gNumCalls.wall;
+      state->hash = hash_mario(state->hash);
+      if (verbose) {
+         printf("%s frame %ld hash %08x\n", demo->name, frames, state->hash);
+      }
+   }
+   state->frames = frames;
+}
+
+static void print_result(const struct Demo *demo, const replay_state *state)
+{
+   double total = 0.0;
+   u32 i;
+
+   for (i = 0; i < TIMER_COUNT; i++) {
+      total += state->seconds[i];
+   }
+   printf("%-8s level %2d  %5ld frames  hash %08x  %9.0f fps\n", demo->name, demo->level->levelNum,
+          state->frames, state->hash, total > 0.0 ? state->frames / total : 0.0);
+   for (i = 0; i < TIMER_COUNT; i++) {
+      printf("  %-10s %8.3f us/frame\n", sTimerNames[i], state->seconds[i] * 1e6 / state->frames);
+   }
+   printf("  %-10s %8.2f floors %6.2f ceilings %6.2f walls per frame, %ld warps\n", "queries",
+          (double) state->floors / state->frames, (double) state->ceils / state->frames,
+          (double) state->walls / state->frames, state->warps);
+}
+
+int main(int argc, char *argv[])
+{
+   static struct Demo demo;
+   replay_state state;
+   const char **files;
+   long frames = DEFAULT_FRAMES;
+   long totalFrames = 0;
+   double totalSeconds = 0.0;
+   int verbose = 0;
+   int failed = 0;
+   u32 numFiles = 0;
+   u32 numDemos;
+   u32 i, j;
+
+   files = calloc(argc, sizeof(*files));
+   for (i = 1; i < (u32) argc; i++) {
+      if (argv[i][0] == '-' && argv[i][1] == 'n' && i + 1 < (u32) argc) {
+         frames = strtol(argv[++i], NULL, 0);
+      } else if (argv[i][0] == '-' && argv[i][1] == 'v') {
+         verbose = 1;
+      } else if (argv[i][0] != '-') {
+         files[numFiles++] = argv[i];
+      } else {
+         print_usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (frames <= 0) {
+      print_usage();
+      return EXIT_FAILURE;
+   }
+
+   alloc_surface_pools();
+   setup_dma_table_list(&gMarioAnimsBuf, gMarioAnims, sMarioAnimBuffer);
+
+   numDemos = numFiles != 0 ? numFiles : ARRAY_COUNT(sLevels);
+   for (i = 0; i < numDemos; i++) {
+      if (numFiles == 0) {
+         make_demo(&demo, &sLevels[i], frames);
+      } else if (!read_demo(&demo, files[i])) {
+         failed = 1;
+         continue;
+      }
+
+      replay_demo(&demo, &state, verbose);
+      print_result(&demo, &state);
+      totalFrames += state.frames;
+      for (j = 0; j < TIMER_COUNT; j++) {
+         totalSeconds += state.seconds[j];
+      }
+   }
+
+   printf("%ld frames, %.0f frames per second\n", totalFrames,
+          totalSeconds > 0.0 ? totalFrames / totalSeconds : 0.0);
+
+   free(files);
+   return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
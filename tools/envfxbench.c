@@ -0,0 +1,534 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ultra64.h>
+#include "types.h"
+#include "surface_terrains.h"
+#include "engine/graph_node.h"
+#include "engine/surface_collision.h"
+#include "engine/trig.h"
+#include "game/envfx_snow.h"
+#include "game/envfx_bubbles.h"
+#include "envfxbench_vanilla.h"
+
+#include "trig_tables.inc.c"
+
+#define ENVFXBENCH_VERSION "0.2"
+
+#define DEFAULT_FRAMES 200000
+#define DISPLAY_LIST_SIZE 0x10000
+
+// Update loops in envfx_snow.c and envfx_bubbles.c that have no header declaration.
+void envfx_update_snow_normal(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ);
+void envfx_update_snow_water(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ);
+void envfx_update_snow_blizzard(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ);
+void envfx_update_flower(Vec3s centerPos);
+void envfx_update_lava(Vec3s centerPos);
+void envfx_update_whirlpool(void);
+void envfx_update_jetstream(void);
+
+// Stand-ins for the parts of the game the envfx code calls.
+u32 gGlobalTimer;
+struct MemoryPool *gEffectsMemoryPool;
+f32 gGlobalSoundSource[3];
+struct GraphNodePerspective *gCurGraphNodeCamFrustum;
+
+Gfx tiny_bubble_dl_0B006A50[1];
+Gfx tiny_bubble_dl_0B006AB0[1];
+Gfx tiny_bubble_dl_0B006CD8[1];
+Gfx tiny_bubble_dl_0B006D38[1];
+Gfx tiny_bubble_dl_0B006D68[1];
+const u8 *const flower_bubbles_textures_ptr_0B002008[6];
+const u8 *const lava_bubble_ptr_0B006020[9];
+const u8 *const bubble_ptr_0B006848[1];
+
+static struct GraphNodePerspective sFrustum;
+static struct Surface sLavaFloor;
+static u16 sRandomSeed16;
+static u64 sDisplayList[DISPLAY_LIST_SIZE / sizeof(u64)];
+static u32 sDisplayListUsed;
+
+// Written by every timed loop so the results can't be optimized away.
+static volatile s32 g_sink;
+
+// The same generator as random_u16 in behavior_script.c.
+u16 random_u16(void)
+{
+   u16 temp1, temp2;
+
+   if (sRandomSeed16 == 22026) {
+      sRandomSeed16 = 0;
+   }
+
+   temp1 = (sRandomSeed16 & 0x00FF) << 8;
+   temp1 = temp1 ^ sRandomSeed16;
+
+   sRandomSeed16 = ((temp1 & 0x00FF) << 8) + ((temp1 & 0xFF00) >> 8);
+
+   temp1 = ((temp1 & 0x00FF) << 1) ^ sRandomSeed16;
+   temp2 = (temp1 >> 1) ^ 0xFF80;
+
+   if ((temp1 & 1) == 0) {
+      if (temp2 == 43605) {
+         sRandomSeed16 = 0;
+      } else {
+         sRandomSeed16 = temp2 ^ 0x1FF4;
+      }
+   } else {
+      sRandomSeed16 = temp2 ^ 0x8180;
+   }
+
+   return sRandomSeed16;
+}
+
+f32 random_float(void)
+{
+   f32 rnd = random_u16();
+   return rnd / (double) 0x10000;
+}
+
+void *mem_pool_alloc(UNUSED struct MemoryPool *pool, u32 size)
+{
+   return malloc(size);
+}
+
+void mem_pool_free(UNUSED struct MemoryPool *pool, void *addr)
+{
+   free(addr);
+}
+
+void *alloc_display_list(u32 size)
+{
+   void *ptr;
+
+   size = (size + 7) & ~7;
+   if (sDisplayListUsed + size > DISPLAY_LIST_SIZE) {
+      return NULL;
+   }
+   ptr = (u8 *) sDisplayList + sDisplayListUsed;
+   sDisplayListUsed += size;
+   return ptr;
+}
+
+void *segmented_to_virtual(const void *addr)
+{
+   return (void *) addr;
+}
+
+s16 get_dialog_id(void)
+{
+   return -1;
+}
+
+void play_sound(UNUSED s32 soundBits, UNUSED f32 *pos)
+{
+}
+
+// Water 10000 units up, so underwater snow is at its maximum.
+f32 find_water_level(UNUSED f32 x, UNUSED f32 z)
+{
+   return 10000.0f;
+}
+
+// A flat lava floor at y = 0, so every lava bubble lands on it.
+f32 find_floor(UNUSED f32 x, UNUSED f32 y, UNUSED f32 z, struct Surface **pfloor)
+{
+   *pfloor = &sLavaFloor;
+   return 0.0f;
+}
+
+f32 find_floor_height_and_data(UNUSED f32 x, UNUSED f32 y, UNUSED f32 z, struct FloorGeometry **floorGeo)
+{
+   *floorGeo = NULL;
+   return 0.0f;
+}
+
+static void print_usage(void)
+{
+   fprintf(stderr,
+         "Usage: envfxbench [-n FRAMES]\n"
+         "\n"
+         "envfxbench v" ENVFXBENCH_VERSION ": time the particle update and view cone culling loops of\n"
+         "src/game/envfx_snow.c and envfx_bubbles.c for each environment effect against the vanilla\n"
+         "code, and check that both move the same particles\n"
+         "\n"
+         "Optional arguments:\n"
+         " -n FRAMES frames per effect (default: %d)\n",
+         DEFAULT_FRAMES);
+}
+
+struct EnvFxMode {
+   const char *name;
+   s32 mode;
+   f32 cullRadius; // the radius envfx_update_snow and envfx_update_bubble_particles cull with
+};
+
+static const struct EnvFxMode sModes[] = {
+   { "snow",           ENVFX_SNOW_NORMAL,         8.0f },
+   { "snow water",     ENVFX_SNOW_WATER,          8.0f },
+   { "snow blizzard",  ENVFX_SNOW_BLIZZARD,       8.0f },
+   { "flowers",        ENVFX_FLOWERS,            75.0f },
+   { "lava bubbles",   ENVFX_LAVA_BUBBLES,      150.0f },
+   { "whirlpool",      ENVFX_WHIRLPOOL_BUBBLES,  60.0f },
+   { "jet stream",     ENVFX_JETSTREAM_BUBBLES,  60.0f },
+};
+
+// The camera circles the origin 1500 units away and looks at a point that moves around it,
+// so particles keep leaving the snow cylinder and the view.
+static void camera_at(u32 frame, Vec3s marioPos, Vec3s camFrom, Vec3s camTo)
+{
+   s16 yaw = frame * 0x80;
+
+   camTo[0] = sins(frame * 0x35) * 800.0f;
+   camTo[1] = 300 + sins(frame * 0x51) * 200.0f;
+   camTo[2] = coss(frame * 0x35) * 800.0f;
+   camFrom[0] = camTo[0] + sins(yaw) * 1500.0f;
+   camFrom[1] = camTo[1] + 400;
+   camFrom[2] = camTo[2] + coss(yaw) * 1500.0f;
+   marioPos[0] = camTo[0];
+   marioPos[1] = camTo[1] - 300;
+   marioPos[2] = camTo[2];
+}
+
+// The snow cylinder in front of the camera, like envfx_update_snow places it.
+static void snow_cylinder_at(s32 mode, Vec3s camFrom, Vec3s camTo, Vec3s pos)
+{
+   s16 radius, pitch, yaw;
+   s16 distance = mode == ENVFX_SNOW_WATER ? 500 : 250;
+
+   orbit_from_positions(camTo, camFrom, &radius, &pitch, &yaw);
+   radius = radius > distance ? radius - distance : 1;
+   pos[0] = camTo[0] + radius * coss(pitch) * sins(yaw);
+   pos[1] = camTo[1] + radius * sins(pitch);
+   pos[2] = camTo[2] + radius * coss(pitch) * coss(yaw);
+}
+
+static void update_particles(s32 mode, Vec3s camFrom, Vec3s camTo)
+{
+   Vec3s pos;
+
+   switch (mode) {
+      case ENVFX_SNOW_NORMAL:
+         snow_cylinder_at(mode, camFrom, camTo, pos);
+         envfx_update_snow_normal(pos[0], pos[1], pos[2]);
+         break;
+      case ENVFX_SNOW_WATER:
+         snow_cylinder_at(mode, camFrom, camTo, pos);
+         envfx_update_snow_water(pos[0], pos[1], pos[2]);
+         break;
+      case ENVFX_SNOW_BLIZZARD:
+         snow_cylinder_at(mode, camFrom, camTo, pos);
+         envfx_update_snow_blizzard(pos[0], pos[1], pos[2]);
+         break;
+      case ENVFX_FLOWERS:
+         envfx_update_flower(camTo);
+         break;
+      case ENVFX_LAVA_BUBBLES:
+         envfx_update_lava(camTo);
+         break;
+      case ENVFX_WHIRLPOOL_BUBBLES:
+         envfx_update_whirlpool();
+         break;
+      case ENVFX_JETSTREAM_BUBBLES:
+         envfx_update_jetstream();
+         break;
+   }
+}
+
+static void update_particles_vanilla(s32 mode, Vec3s camFrom, Vec3s camTo)
+{
+   Vec3s pos;
+
+   switch (mode) {
+      case ENVFX_SNOW_NORMAL:
+         snow_cylinder_at(mode, camFrom, camTo, pos);
+         vanilla_envfx_update_snow_normal(pos[0], pos[1], pos[2]);
+         break;
+      case ENVFX_SNOW_WATER:
+         snow_cylinder_at(mode, camFrom, camTo, pos);
+         vanilla_envfx_update_snow_water(pos[0], pos[1], pos[2]);
+         break;
+      case ENVFX_SNOW_BLIZZARD:
+         snow_cylinder_at(mode, camFrom, camTo, pos);
+         vanilla_envfx_update_snow_blizzard(pos[0], pos[1], pos[2]);
+         break;
+      case ENVFX_FLOWERS:
+         vanilla_envfx_update_flower(camTo);
+         break;
+      case ENVFX_LAVA_BUBBLES:
+         vanilla_envfx_update_lava(camTo);
+         break;
+      case ENVFX_WHIRLPOOL_BUBBLES:
+         vanilla_envfx_update_whirlpool();
+         break;
+      case ENVFX_JETSTREAM_BUBBLES:
+         vanilla_envfx_update_jetstream();
+         break;
+   }
+}
+
+static s32 cull_particles(s32 count, f32 radius, Vec3s camFrom, Vec3s camTo)
+{
+   s32 visible = 0;
+   s32 i;
+
+   envfx_set_view_cone(camFrom, camTo);
+   for (i = 0; i < count; i++) {
+      visible += envfx_particle_in_view(i, radius);
+   }
+   return visible;
+}
+
+static double seconds(clock_t start)
+{
+   return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static Gfx *update_frame(s32 vanilla, s32 mode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo)
+{
+   sDisplayListUsed = 0;
+   if (vanilla) {
+      return vanilla_envfx_update_particles(mode, marioPos, camTo, camFrom);
+   }
+   return envfx_update_particles(mode, marioPos, camTo, camFrom);
+}
+
+// Start an effect the way the game does, and give the whirlpool and jet stream a source.
+static void start_mode(s32 vanilla, s32 mode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo)
+{
+   s16 *config = vanilla ? vanilla_gEnvFxBubbleConfig : gEnvFxBubbleConfig;
+
+   update_frame(vanilla, mode, marioPos, camFrom, camTo);
+
+   config[ENVFX_STATE_SRC_X] = 0;
+   config[ENVFX_STATE_SRC_Y] = 0;
+   config[ENVFX_STATE_SRC_Z] = 0;
+   config[ENVFX_STATE_DEST_X] = 0;
+   config[ENVFX_STATE_DEST_Y] = -800;
+   config[ENVFX_STATE_DEST_Z] = 0;
+   config[ENVFX_STATE_PARTICLECOUNT] = 60;
+   config[ENVFX_STATE_PITCH] = 0x800;
+   config[ENVFX_STATE_YAW] = 0x2000;
+
+   // The first frame with the config sets the bubble count.
+   update_frame(vanilla, mode, marioPos, camFrom, camTo);
+
+   // Normal snow starts with a few flakes. Time it with all of them.
+   if (mode == ENVFX_SNOW_NORMAL) {
+      if (vanilla) {
+         vanilla_gSnowParticleCount = ENVFX_MAX_PARTICLES;
+      } else {
+         gSnowParticleCount = ENVFX_MAX_PARTICLES;
+      }
+   }
+}
+
+static void stop_mode(s32 vanilla, Vec3s marioPos, Vec3s camFrom, Vec3s camTo)
+{
+   update_frame(vanilla, ENVFX_MODE_NONE, marioPos, camFrom, camTo);
+}
+
+// Compare the particles of the new code with those of the vanilla code, and print the
+// first difference if print is set. Returns the number of particles that differ.
+// Only lava bubbles still store isAlive. The other effects respawn every particle that
+// isn't alive in the same update, so vanilla's flag was always set afterwards.
+static s32 compare_particles(const struct EnvFxMode *envfx, u32 frame, s32 count, s32 print)
+{
+   s32 differ = 0;
+   s32 i;
+
+   for (i = 0; i < count; i++) {
+      const struct EnvFxParticle *old = &vanilla_gEnvFxBuffer[i];
+
+      if ((envfx->mode == ENVFX_LAVA_BUBBLES && gEnvFxParticles.isAlive[i] != old->isAlive)
+          || gEnvFxParticles.animFrame[i] != old->animFrame
+          || gEnvFxParticles.xPos[i] != old->xPos || gEnvFxParticles.yPos[i] != old->yPos
+          || gEnvFxParticles.zPos[i] != old->zPos || gEnvFxParticles.angle[i] != old->angleAndDist[0]
+          || gEnvFxParticles.dist[i] != old->angleAndDist[1] || gEnvFxParticles.bubbleY[i] != old->bubbleY) {
+         if (print && differ == 0) {
+            fprintf(stderr, "%s: frame %u particle %d differs: alive %d/%d frame %d/%d pos %d %d %d/%d %d %d\n",
+                    envfx->name, frame, i, gEnvFxParticles.isAlive[i], old->isAlive,
+                    gEnvFxParticles.animFrame[i], old->animFrame, gEnvFxParticles.xPos[i],
+                    gEnvFxParticles.yPos[i], gEnvFxParticles.zPos[i], old->xPos, old->yPos, old->zPos);
+         }
+         differ++;
+      }
+   }
+   return differ;
+}
+
+// Run the new and the vanilla code side by side from the same random seed and check that
+// they hold the same particles after every frame. Returns the number of frames that differ.
+static u32 verify_mode(const struct EnvFxMode *envfx, u32 frames)
+{
+   Vec3s marioPos, camFrom, camTo;
+   u16 seed, newSeed;
+   u32 mismatches = 0;
+   s32 count;
+   u32 frame;
+
+   camera_at(0, marioPos, camFrom, camTo);
+   sRandomSeed16 = 0;
+   start_mode(FALSE, envfx->mode, marioPos, camFrom, camTo);
+   newSeed = sRandomSeed16;
+   sRandomSeed16 = 0;
+   start_mode(TRUE, envfx->mode, marioPos, camFrom, camTo);
+
+   for (frame = 0; frame < frames; frame++) {
+      gGlobalTimer = frame;
+      camera_at(frame, marioPos, camFrom, camTo);
+
+      seed = sRandomSeed16;
+      sRandomSeed16 = newSeed;
+      update_frame(FALSE, envfx->mode, marioPos, camFrom, camTo);
+      newSeed = sRandomSeed16;
+      sRandomSeed16 = seed;
+      update_frame(TRUE, envfx->mode, marioPos, camFrom, camTo);
+
+      count = envfx->mode < ENVFX_BUBBLE_START ? gSnowParticleCount : gEnvFxParticleCapacity;
+      if (newSeed != sRandomSeed16 || gSnowParticleCount != vanilla_gSnowParticleCount
+          || compare_particles(envfx, frame, count, mismatches == 0) != 0) {
+         if (mismatches == 0 && newSeed != sRandomSeed16) {
+            fprintf(stderr, "%s: frame %u random seed differs: %u/%u\n", envfx->name, frame, newSeed,
+                    sRandomSeed16);
+         }
+         mismatches++;
+      }
+   }
+
+   stop_mode(FALSE, marioPos, camFrom, camTo);
+   stop_mode(TRUE, marioPos, camFrom, camTo);
+   return mismatches;
+}
+
+// Time the update loop of the new or the vanilla code on its own.
+static double time_update(s32 vanilla, const struct EnvFxMode *envfx, u32 frames)
+{
+   Vec3s marioPos, camFrom, camTo;
+   clock_t start;
+   double time;
+   u32 frame;
+
+   sRandomSeed16 = 0;
+   camera_at(0, marioPos, camFrom, camTo);
+   start_mode(vanilla, envfx->mode, marioPos, camFrom, camTo);
+
+   start = clock();
+   for (frame = 0; frame < frames; frame++) {
+      gGlobalTimer = frame;
+      camera_at(frame, marioPos, camFrom, camTo);
+      if (vanilla) {
+         update_particles_vanilla(envfx->mode, camFrom, camTo);
+      } else {
+         update_particles(envfx->mode, camFrom, camTo);
+      }
+   }
+   time = seconds(start);
+   stop_mode(vanilla, marioPos, camFrom, camTo);
+   return time;
+}
+
+// Time whole frames of the new or the vanilla code, including the vertices and display list.
+static double time_frames(s32 vanilla, const struct EnvFxMode *envfx, u32 frames)
+{
+   Vec3s marioPos, camFrom, camTo;
+   clock_t start;
+   double time;
+   u32 frame;
+
+   sRandomSeed16 = 0;
+   camera_at(0, marioPos, camFrom, camTo);
+   start_mode(vanilla, envfx->mode, marioPos, camFrom, camTo);
+
+   start = clock();
+   for (frame = 0; frame < frames; frame++) {
+      gGlobalTimer = frame;
+      camera_at(frame, marioPos, camFrom, camTo);
+      g_sink = update_frame(vanilla, envfx->mode, marioPos, camFrom, camTo) != NULL;
+   }
+   time = seconds(start);
+   stop_mode(vanilla, marioPos, camFrom, camTo);
+   return time;
+}
+
+// Returns the number of frames where the new code's particles differ from the vanilla ones.
+static u32 bench_mode(const struct EnvFxMode *envfx, u32 frames)
+{
+   Vec3s marioPos, camFrom, camTo;
+   double updateTime, vanillaUpdateTime, cullTime, frameTime, vanillaFrameTime;
+   u32 mismatches;
+   s32 count;
+   long visible = 0;
+   clock_t start;
+   u32 frame;
+
+   mismatches = verify_mode(envfx, frames);
+
+   vanillaUpdateTime = time_update(TRUE, envfx, frames);
+   updateTime = time_update(FALSE, envfx, frames);
+
+   // The cull loop on its own, over the particles left by a run of the update loop
+   sRandomSeed16 = 0;
+   camera_at(0, marioPos, camFrom, camTo);
+   start_mode(FALSE, envfx->mode, marioPos, camFrom, camTo);
+   count = envfx->mode < ENVFX_BUBBLE_START ? gSnowParticleCount : gEnvFxParticleCapacity;
+   for (frame = 0; frame < frames; frame++) {
+      gGlobalTimer = frame;
+      camera_at(frame, marioPos, camFrom, camTo);
+      update_particles(envfx->mode, camFrom, camTo);
+   }
+
+   start = clock();
+   for (frame = 0; frame < frames; frame++) {
+      camera_at(frame, marioPos, camFrom, camTo);
+      visible += cull_particles(count, envfx->cullRadius, camFrom, camTo);
+   }
+   cullTime = seconds(start);
+   stop_mode(FALSE, marioPos, camFrom, camTo);
+
+   vanillaFrameTime = time_frames(TRUE, envfx, frames);
+   frameTime = time_frames(FALSE, envfx, frames);
+
+   printf("%-14s %3d particles %5.1f visible  update %7.1f ns (vanilla %7.1f ns)  cull %7.1f ns  "
+          "frame %7.1f ns (vanilla %7.1f ns)  %s\n",
+          envfx->name, count, (double) visible / frames, updateTime * 1e9 / frames,
+          vanillaUpdateTime * 1e9 / frames, cullTime * 1e9 / frames, frameTime * 1e9 / frames,
+          vanillaFrameTime * 1e9 / frames, mismatches ? "MISMATCH" : "ok");
+   return mismatches;
+}
+
+int main(int argc, char *argv[])
+{
+   long frames = DEFAULT_FRAMES;
+   u32 mismatches = 0;
+   u32 i;
+
+   for (i = 1; i < (u32) argc; i++) {
+      if (argv[i][0] == '-' && argv[i][1] == 'n' && i + 1 < (u32) argc) {
+         frames = strtol(argv[++i], NULL, 0);
+      } else {
+         print_usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (frames <= 0) {
+      print_usage();
+      return EXIT_FAILURE;
+   }
+
+   sFrustum.fov = 45.0f;
+   gCurGraphNodeCamFrustum = &sFrustum;
+   sLavaFloor.type = SURFACE_BURNING;
+
+   for (i = 0; i < sizeof(sModes) / sizeof(sModes[0]); i++) {
+      mismatches += bench_mode(&sModes[i], frames);
+   }
+
+   if (mismatches != 0) {
+      fprintf(stderr, "%u frames differ from the vanilla code\n", mismatches);
+      return EXIT_FAILURE;
+   }
+   return EXIT_SUCCESS;
+}
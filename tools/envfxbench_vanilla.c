@@ -0,0 +1,1118 @@
+// envfx_snow.c and envfx_bubbles.c as they were before the particles were split into
+// per-field arrays, for envfxbench to time against and to check the new code against.
+// Every global is renamed with a vanilla_ prefix so both versions link into one program.
+#include <ultra64.h>
+
+#include "sm64.h"
+#include "dialog_ids.h"
+#include "game/game_init.h"
+#include "game/memory.h"
+#include "game/ingame_menu.h"
+#include "game/envfx_snow.h"
+#include "game/envfx_bubbles.h"
+#include "engine/surface_collision.h"
+#include "engine/math_util.h"
+#include "engine/behavior_script.h"
+#include "audio/external.h"
+#include "textures.h"
+#include "envfxbench_vanilla.h"
+
+#define gEnvFxBuffer                    vanilla_gEnvFxBuffer
+#define gSnowCylinderLastPos            vanilla_gSnowCylinderLastPos
+#define gSnowParticleCount              vanilla_gSnowParticleCount
+#define gSnowParticleMaxCount           vanilla_gSnowParticleMaxCount
+#define gEnvFxMode                      vanilla_gEnvFxMode
+#define D_80330644                      vanilla_D_80330644
+#define gSnowTempVtx                    vanilla_gSnowTempVtx
+#define gSnowFlakeVertex1               vanilla_gSnowFlakeVertex1
+#define gSnowFlakeVertex2               vanilla_gSnowFlakeVertex2
+#define gSnowFlakeVertex3               vanilla_gSnowFlakeVertex3
+#define envfx_init_snow                 vanilla_envfx_init_snow
+#define envfx_update_snowflake_count    vanilla_envfx_update_snowflake_count
+#define envfx_cleanup_snow              vanilla_envfx_cleanup_snow
+#define orbit_from_positions            vanilla_orbit_from_positions
+#define pos_from_orbit                  vanilla_pos_from_orbit
+#define envfx_is_snowflake_alive        vanilla_envfx_is_snowflake_alive
+#define envfx_update_snow_normal        vanilla_envfx_update_snow_normal
+#define envfx_update_snow_blizzard      vanilla_envfx_update_snow_blizzard
+#define envfx_update_snow_water         vanilla_envfx_update_snow_water
+#define rotate_triangle_vertices        vanilla_rotate_triangle_vertices
+#define append_snowflake_vertex_buffer  vanilla_append_snowflake_vertex_buffer
+#define envfx_update_snow               vanilla_envfx_update_snow
+#define envfx_update_particles          vanilla_envfx_update_particles
+#define gEnvFxBubbleConfig              vanilla_gEnvFxBubbleConfig
+#define D_80330690                      vanilla_D_80330690
+#define D_80330694                      vanilla_D_80330694
+#define gBubbleTempVtx                  vanilla_gBubbleTempVtx
+#define particle_is_laterally_close     vanilla_particle_is_laterally_close
+#define random_flower_offset            vanilla_random_flower_offset
+#define envfx_update_flower             vanilla_envfx_update_flower
+#define envfx_set_lava_bubble_position  vanilla_envfx_set_lava_bubble_position
+#define envfx_update_lava               vanilla_envfx_update_lava
+#define envfx_rotate_around_whirlpool   vanilla_envfx_rotate_around_whirlpool
+#define envfx_is_whirlpool_bubble_alive vanilla_envfx_is_whirlpool_bubble_alive
+#define envfx_update_whirlpool          vanilla_envfx_update_whirlpool
+#define envfx_is_jestream_bubble_alive  vanilla_envfx_is_jestream_bubble_alive
+#define envfx_update_jetstream          vanilla_envfx_update_jetstream
+#define envfx_init_bubble               vanilla_envfx_init_bubble
+#define envfx_bubbles_update_switch     vanilla_envfx_bubbles_update_switch
+#define envfx_set_bubble_texture        vanilla_envfx_set_bubble_texture
+#define envfx_update_bubble_particles   vanilla_envfx_update_bubble_particles
+#define envfx_set_max_bubble_particles  vanilla_envfx_set_max_bubble_particles
+#define envfx_update_bubbles            vanilla_envfx_update_bubbles
+
+// From the old envfx_snow.h and envfx_bubbles.h
+extern struct EnvFxParticle *gEnvFxBuffer;
+extern s16 gEnvFxBubbleConfig[10];
+
+Gfx *envfx_update_particles(s32 mode, Vec3s marioPos, Vec3s camTo, Vec3s camFrom);
+Gfx *envfx_update_bubbles(s32 mode, Vec3s marioPos, Vec3s camTo, Vec3s camFrom);
+void orbit_from_positions(Vec3s from, Vec3s to, s16 *radius, s16 *pitch, s16 *yaw);
+void rotate_triangle_vertices(Vec3s vertex1, Vec3s vertex2, Vec3s vertex3, s16 pitch, s16 yaw);
+
+//
+// envfx_snow.c
+//
+
+/**
+ * This file contains the function that handles 'environment effects',
+ * which are particle effects related to the level type that, unlike
+ * object-based particle effects, are rendered more efficiently by manually
+ * generating display lists instead of drawing each particle separately.
+ * This file implements snow effects, while in 'envfx_bubbles.c' the
+ * implementation for flowers (unused), lava bubbles and jet stream bubbles
+ * can be found.
+ * The main entry point for envfx is at the bottom of this file, which is
+ * called from geo_envfx_main in level_geo.c
+ */
+
+// Might be duplicate
+struct SnowFlakeVertex {
+    s16 x;
+    s16 y;
+    s16 z;
+};
+
+struct EnvFxParticle *gEnvFxBuffer;
+Vec3i gSnowCylinderLastPos;
+s16 gSnowParticleCount;
+s16 gSnowParticleMaxCount;
+
+/* DATA */
+s8 gEnvFxMode = ENVFX_MODE_NONE;
+UNUSED s32 D_80330644 = 0;
+
+/// Template for a snow particle triangle
+Vtx gSnowTempVtx[3] = { { { { -5, 5, 0 }, 0, { 0, 0 }, { 0x7F, 0x7F, 0x7F, 0xFF } } },
+                        { { { -5, -5, 0 }, 0, { 0, 960 }, { 0x7F, 0x7F, 0x7F, 0xFF } } },
+                        { { { 5, 5, 0 }, 0, { 960, 0 }, { 0x7F, 0x7F, 0x7F, 0xFF } } } };
+
+// Change these to make snowflakes smaller or bigger
+struct SnowFlakeVertex gSnowFlakeVertex1 = { -5, 5, 0 };
+struct SnowFlakeVertex gSnowFlakeVertex2 = { -5, -5, 0 };
+struct SnowFlakeVertex gSnowFlakeVertex3 = { 5, 5, 0 };
+
+/**
+ * Initialize snow particles by allocating a buffer for storing their state
+ * and setting a start amount.
+ */
+s32 envfx_init_snow(s32 mode) {
+    switch (mode) {
+        case ENVFX_MODE_NONE:
+            return FALSE;
+
+        case ENVFX_SNOW_NORMAL:
+            gSnowParticleMaxCount = 140;
+            gSnowParticleCount = 5;
+            break;
+
+        case ENVFX_SNOW_WATER:
+            gSnowParticleMaxCount = 30;
+            gSnowParticleCount = 30;
+            break;
+
+        case ENVFX_SNOW_BLIZZARD:
+            gSnowParticleMaxCount = 140;
+            gSnowParticleCount = 140;
+            break;
+    }
+
+    gEnvFxBuffer = mem_pool_alloc(gEffectsMemoryPool,
+                                  gSnowParticleMaxCount * sizeof(struct EnvFxParticle));
+    if (gEnvFxBuffer == NULL) {
+        return FALSE;
+    }
+
+    bzero(gEnvFxBuffer, gSnowParticleMaxCount * sizeof(struct EnvFxParticle));
+
+    gEnvFxMode = mode;
+    return TRUE;
+}
+
+/**
+ * Update the amount of snow particles on screen.
+ * Normal snow starts with few flakes and slowly increases to the maximum.
+ * For water snow, this is dependent on how deep underwater you are.
+ * Blizzard snows starts at the maximum amount and doesn't change.
+ */
+void envfx_update_snowflake_count(s32 mode, Vec3s marioPos) {
+    s32 globalTimer = gGlobalTimer;
+    f32 waterLevel;
+
+    switch (mode) {
+        case ENVFX_SNOW_NORMAL:
+            if (gSnowParticleMaxCount > gSnowParticleCount) {
+                if (!(globalTimer & 63)) {
+                    gSnowParticleCount += 5;
+                }
+            }
+            break;
+
+        case ENVFX_SNOW_WATER:
+            waterLevel = find_water_level(marioPos[0], marioPos[2]);
+
+            gSnowParticleCount =
+                (((s32)((waterLevel - 400.0f - (f32) marioPos[1]) * 0.001) << 0x10) >> 0x10) * 5;
+
+            if (gSnowParticleCount < 0) {
+                gSnowParticleCount = 0;
+            }
+
+            if (gSnowParticleCount > gSnowParticleMaxCount) {
+                gSnowParticleCount = gSnowParticleMaxCount;
+            }
+
+            break;
+
+        case ENVFX_SNOW_BLIZZARD:
+            break;
+    }
+}
+
+/**
+ * Deallocate the buffer storing snow particles and set the environment effect
+ * to none.
+ */
+void envfx_cleanup_snow(void *snowParticleArray) {
+    if (gEnvFxMode != ENVFX_MODE_NONE) {
+        if (snowParticleArray) {
+            mem_pool_free(gEffectsMemoryPool, snowParticleArray);
+        }
+        gEnvFxMode = ENVFX_MODE_NONE;
+    }
+}
+
+/**
+ * Given two points, return the vector from one to the other represented
+ * as Euler angles and a length
+ */
+void orbit_from_positions(Vec3s from, Vec3s to, s16 *radius, s16 *pitch, s16 *yaw) {
+    f32 dx = to[0] - from[0];
+    f32 dy = to[1] - from[1];
+    f32 dz = to[2] - from[2];
+
+    *radius = (s16) sqrtf(dx * dx + dy * dy + dz * dz);
+    *pitch = atan2s(sqrtf(dx * dx + dz * dz), dy);
+    *yaw = atan2s(dz, dx);
+}
+
+/**
+ * Calculate the 'result' vector as the position of the 'origin' vector
+ * with a vector added represented by radius, pitch and yaw.
+ */
+void pos_from_orbit(Vec3s origin, Vec3s result, s16 radius, s16 pitch, s16 yaw) {
+    result[0] = origin[0] + radius * coss(pitch) * sins(yaw);
+    result[1] = origin[1] + radius * sins(pitch);
+    result[2] = origin[2] + radius * coss(pitch) * coss(yaw);
+}
+
+/**
+ * Check whether the snowflake with the given index is inside view, where
+ * 'view' is a cylinder of radius 300 and height 400 centered at the input
+ * x, y and z.
+ */
+s32 envfx_is_snowflake_alive(s32 index, s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ) {
+    s32 x = (gEnvFxBuffer + index)->xPos;
+    s32 y = (gEnvFxBuffer + index)->yPos;
+    s32 z = (gEnvFxBuffer + index)->zPos;
+
+    if (sqr(x - snowCylinderX) + sqr(z - snowCylinderZ) > sqr(300)) {
+        return FALSE;
+    }
+
+    if ((y < snowCylinderY - 201) || (snowCylinderY + 201 < y)) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Update the position of each snowflake. Snowflakes wiggle by having a
+ * random value added to their position each frame. If snowflakes get out
+ * of view (where view = a small cylinder in front of the camera) their
+ * position is reset to somewhere in view.
+ * Since the cylinder of snow is so close to the camera, snow flakes would
+ * move out of view very quickly when the camera moves. To mitigate this,
+ * a portion of the difference between the previous and current snowCylinder
+ * position is added to snowflakes to keep them in view for longer. That's
+ * why the snow looks a bit off in 3d, it's a lot closer than you'd think
+ * but appears to be further by means of hacky position updates. This might
+ * have been done because larger, further away snowflakes are occluded easily
+ * by level geometry, wasting many particles.
+ */
+void envfx_update_snow_normal(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ) {
+    s32 i;
+    s32 deltaX = snowCylinderX - gSnowCylinderLastPos[0];
+    s32 deltaY = snowCylinderY - gSnowCylinderLastPos[1];
+    s32 deltaZ = snowCylinderZ - gSnowCylinderLastPos[2];
+
+    for (i = 0; i < gSnowParticleCount; i++) {
+        (gEnvFxBuffer + i)->isAlive =
+            envfx_is_snowflake_alive(i, snowCylinderX, snowCylinderY, snowCylinderZ);
+        if (!(gEnvFxBuffer + i)->isAlive) {
+            (gEnvFxBuffer + i)->xPos =
+                400.0f * random_float() - 200.0f + snowCylinderX + (s16)(deltaX * 2);
+            (gEnvFxBuffer + i)->zPos =
+                400.0f * random_float() - 200.0f + snowCylinderZ + (s16)(deltaZ * 2);
+            (gEnvFxBuffer + i)->yPos = 200.0f * random_float() + snowCylinderY;
+            (gEnvFxBuffer + i)->isAlive = TRUE;
+        } else {
+            (gEnvFxBuffer + i)->xPos += random_float() * 2 - 1.0f + (s16)(deltaX / 1.2);
+            (gEnvFxBuffer + i)->yPos -= 2 -(s16)(deltaY * 0.8);
+            (gEnvFxBuffer + i)->zPos += random_float() * 2 - 1.0f + (s16)(deltaZ / 1.2);
+        }
+    }
+
+    gSnowCylinderLastPos[0] = snowCylinderX;
+    gSnowCylinderLastPos[1] = snowCylinderY;
+    gSnowCylinderLastPos[2] = snowCylinderZ;
+}
+
+/**
+ * Unused function. Basically a copy-paste of envfx_update_snow_normal,
+ * but an extra 20 units is added to each snowflake x and snowflakes can
+ * respawn in y-range [-200, 200] instead of [0, 200] relative to snowCylinderY
+ * They also fall a bit faster (with vertical speed -5 instead of -2).
+ */
+void envfx_update_snow_blizzard(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ) {
+    s32 i;
+    s32 deltaX = snowCylinderX - gSnowCylinderLastPos[0];
+    s32 deltaY = snowCylinderY - gSnowCylinderLastPos[1];
+    s32 deltaZ = snowCylinderZ - gSnowCylinderLastPos[2];
+
+    for (i = 0; i < gSnowParticleCount; i++) {
+        (gEnvFxBuffer + i)->isAlive =
+            envfx_is_snowflake_alive(i, snowCylinderX, snowCylinderY, snowCylinderZ);
+        if (!(gEnvFxBuffer + i)->isAlive) {
+            (gEnvFxBuffer + i)->xPos =
+                400.0f * random_float() - 200.0f + snowCylinderX + (s16)(deltaX * 2);
+            (gEnvFxBuffer + i)->zPos =
+                400.0f * random_float() - 200.0f + snowCylinderZ + (s16)(deltaZ * 2);
+            (gEnvFxBuffer + i)->yPos = 400.0f * random_float() - 200.0f + snowCylinderY;
+            (gEnvFxBuffer + i)->isAlive = TRUE;
+        } else {
+            (gEnvFxBuffer + i)->xPos += random_float() * 2 - 1.0f + (s16)(deltaX / 1.2) + 20.0f;
+            (gEnvFxBuffer + i)->yPos -= 5 -(s16)(deltaY * 0.8);
+            (gEnvFxBuffer + i)->zPos += random_float() * 2 - 1.0f + (s16)(deltaZ / 1.2);
+        }
+    }
+
+    gSnowCylinderLastPos[0] = snowCylinderX;
+    gSnowCylinderLastPos[1] = snowCylinderY;
+    gSnowCylinderLastPos[2] = snowCylinderZ;
+}
+
+/*! Unused function. Checks whether a position is laterally within 3000 units
+ *  to the point (x: 3380, z: -520). Considering there is an unused blizzard
+ *  snow mode, this could have been used to check whether Mario is in a
+ *  'blizzard area'. In Cool Cool Mountain and Snowman's Land the area lies
+ *  near the starting point and doesn't seem meaningful. Notably, the point is
+ *  close to the entrance of SL, so maybe there were plans for an extra hint to
+ *  find it. The radius of 3000 units is quite large for that though, covering
+ *  more than half of the mirror room.
+ */
+UNUSED static s32 is_in_mystery_snow_area(s32 x, UNUSED s32 y, s32 z) {
+    if (sqr(x - 3380) + sqr(z + 520) < sqr(3000)) {
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/**
+ * Update the position of underwater snow particles. Since they are stationary,
+ * they merely jump back into view when they are out of view.
+ */
+void envfx_update_snow_water(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ) {
+    s32 i;
+
+    for (i = 0; i < gSnowParticleCount; i++) {
+        (gEnvFxBuffer + i)->isAlive =
+            envfx_is_snowflake_alive(i, snowCylinderX, snowCylinderY, snowCylinderZ);
+        if (!(gEnvFxBuffer + i)->isAlive) {
+            (gEnvFxBuffer + i)->xPos = 400.0f * random_float() - 200.0f + snowCylinderX;
+            (gEnvFxBuffer + i)->zPos = 400.0f * random_float() - 200.0f + snowCylinderZ;
+            (gEnvFxBuffer + i)->yPos = 400.0f * random_float() - 200.0f + snowCylinderY;
+            (gEnvFxBuffer + i)->isAlive = TRUE;
+        }
+    }
+}
+
+/**
+ * Rotates the input vertices according to the give pitch and yaw. This
+ * is needed for billboarding of particles.
+ */
+void rotate_triangle_vertices(Vec3s vertex1, Vec3s vertex2, Vec3s vertex3, s16 pitch, s16 yaw) {
+    f32 cosPitch = coss(pitch);
+    f32 sinPitch = sins(pitch);
+    f32 cosMYaw = coss(-yaw);
+    f32 sinMYaw = sins(-yaw);
+
+    Vec3f v1, v2, v3;
+
+    v1[0] = vertex1[0];
+    v1[1] = vertex1[1];
+    v1[2] = vertex1[2];
+
+    v2[0] = vertex2[0];
+    v2[1] = vertex2[1];
+    v2[2] = vertex2[2];
+
+    v3[0] = vertex3[0];
+    v3[1] = vertex3[1];
+    v3[2] = vertex3[2];
+
+    vertex1[0] = v1[0] * cosMYaw + v1[1] * (sinPitch * sinMYaw) + v1[2] * (-sinMYaw * cosPitch);
+    vertex1[1] = v1[1] * cosPitch + v1[2] * sinPitch;
+    vertex1[2] = v1[0] * sinMYaw + v1[1] * (-sinPitch * cosMYaw) + v1[2] * (cosPitch * cosMYaw);
+
+    vertex2[0] = v2[0] * cosMYaw + v2[1] * (sinPitch * sinMYaw) + v2[2] * (-sinMYaw * cosPitch);
+    vertex2[1] = v2[1] * cosPitch + v2[2] * sinPitch;
+    vertex2[2] = v2[0] * sinMYaw + v2[1] * (-sinPitch * cosMYaw) + v2[2] * (cosPitch * cosMYaw);
+
+    vertex3[0] = v3[0] * cosMYaw + v3[1] * (sinPitch * sinMYaw) + v3[2] * (-sinMYaw * cosPitch);
+    vertex3[1] = v3[1] * cosPitch + v3[2] * sinPitch;
+    vertex3[2] = v3[0] * sinMYaw + v3[1] * (-sinPitch * cosMYaw) + v3[2] * (cosPitch * cosMYaw);
+}
+
+/**
+ * Append 15 vertices to 'gfx', which is enough for 5 snowflakes starting at
+ * 'index' in the buffer. The 3 input vertices represent the rotated triangle
+ * around (0,0,0) that will be translated to snowflake positions to draw the
+ * snowflake image.
+ */
+void append_snowflake_vertex_buffer(Gfx *gfx, s32 index, Vec3s vertex1, Vec3s vertex2, Vec3s vertex3) {
+    s32 i = 0;
+    Vtx *vertBuf = (Vtx *) alloc_display_list(15 * sizeof(Vtx));
+
+    if (vertBuf == NULL) {
+        return;
+    }
+
+    for (i = 0; i < 15; i += 3) {
+        vertBuf[i] = gSnowTempVtx[0];
+        (vertBuf + i)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex1[0];
+        (vertBuf + i)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex1[1];
+        (vertBuf + i)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex1[2];
+
+        vertBuf[i + 1] = gSnowTempVtx[1];
+        (vertBuf + i + 1)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex2[0];
+        (vertBuf + i + 1)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex2[1];
+        (vertBuf + i + 1)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex2[2];
+
+        vertBuf[i + 2] = gSnowTempVtx[2];
+        (vertBuf + i + 2)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex3[0];
+        (vertBuf + i + 2)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex3[1];
+        (vertBuf + i + 2)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex3[2];
+    }
+
+    gSPVertex(gfx, VIRTUAL_TO_PHYSICAL(vertBuf), 15, 0);
+}
+
+/**
+ * Updates positions of snow particles and returns a pointer to a display list
+ * drawing all snowflakes.
+ */
+Gfx *envfx_update_snow(s32 snowMode, Vec3s marioPos, Vec3s camFrom, Vec3s camTo) {
+    s32 i;
+    s16 radius, pitch, yaw;
+    Vec3s snowCylinderPos;
+    struct SnowFlakeVertex vertex1, vertex2, vertex3;
+    Gfx *gfxStart;
+    Gfx *gfx;
+
+    vertex1 = gSnowFlakeVertex1;
+    vertex2 = gSnowFlakeVertex2;
+    vertex3 = gSnowFlakeVertex3;
+
+    gfxStart = (Gfx *) alloc_display_list((gSnowParticleCount * 6 + 3) * sizeof(Gfx));
+    gfx = gfxStart;
+
+    if (gfxStart == NULL) {
+        return NULL;
+    }
+
+    envfx_update_snowflake_count(snowMode, marioPos);
+
+    // Note: to and from are inverted here, so the resulting vector goes towards the camera
+    orbit_from_positions(camTo, camFrom, &radius, &pitch, &yaw);
+
+    switch (snowMode) {
+        case ENVFX_SNOW_NORMAL:
+            // ensure the snow cylinder is no further than 250 units in front
+            // of the camera, and no closer than 1 unit.
+            if (radius > 250) {
+                radius -= 250;
+            } else {
+                radius = 1;
+            }
+
+            pos_from_orbit(camTo, snowCylinderPos, radius, pitch, yaw);
+            envfx_update_snow_normal(snowCylinderPos[0], snowCylinderPos[1], snowCylinderPos[2]);
+            break;
+
+        case ENVFX_SNOW_WATER:
+            if (radius > 500) {
+                radius -= 500;
+            } else {
+                radius = 1;
+            }
+
+            pos_from_orbit(camTo, snowCylinderPos, radius, pitch, yaw);
+            envfx_update_snow_water(snowCylinderPos[0], snowCylinderPos[1], snowCylinderPos[2]);
+            break;
+        case ENVFX_SNOW_BLIZZARD:
+            if (radius > 250) {
+                radius -= 250;
+            } else {
+                radius = 1;
+            }
+
+            pos_from_orbit(camTo, snowCylinderPos, radius, pitch, yaw);
+            envfx_update_snow_blizzard(snowCylinderPos[0], snowCylinderPos[1], snowCylinderPos[2]);
+            break;
+    }
+
+    rotate_triangle_vertices((s16 *) &vertex1, (s16 *) &vertex2, (s16 *) &vertex3, pitch, yaw);
+
+    if (snowMode == ENVFX_SNOW_NORMAL || snowMode == ENVFX_SNOW_BLIZZARD) {
+        gSPDisplayList(gfx++, &tiny_bubble_dl_0B006A50); // snowflake with gray edge
+    } else if (snowMode == ENVFX_SNOW_WATER) {
+        gSPDisplayList(gfx++, &tiny_bubble_dl_0B006CD8); // snowflake with blue edge
+    }
+
+    for (i = 0; i < gSnowParticleCount; i += 5) {
+        append_snowflake_vertex_buffer(gfx++, i, (s16 *) &vertex1, (s16 *) &vertex2, (s16 *) &vertex3);
+
+        gSP1Triangle(gfx++, 0, 1, 2, 0);
+        gSP1Triangle(gfx++, 3, 4, 5, 0);
+        gSP1Triangle(gfx++, 6, 7, 8, 0);
+        gSP1Triangle(gfx++, 9, 10, 11, 0);
+        gSP1Triangle(gfx++, 12, 13, 14, 0);
+    }
+
+    gSPDisplayList(gfx++, &tiny_bubble_dl_0B006AB0) gSPEndDisplayList(gfx++);
+
+    return gfxStart;
+}
+
+/**
+ * Updates the environment effects (snow, flowers, bubbles)
+ * and returns a display list drawing them.
+ */
+Gfx *envfx_update_particles(s32 mode, Vec3s marioPos, Vec3s camTo, Vec3s camFrom) {
+    Gfx *gfx;
+
+    if (get_dialog_id() != DIALOG_NONE) {
+        return NULL;
+    }
+
+    if (gEnvFxMode != ENVFX_MODE_NONE && gEnvFxMode != mode) {
+        mode = ENVFX_MODE_NONE;
+    }
+
+    if (mode >= ENVFX_BUBBLE_START) {
+        gfx = envfx_update_bubbles(mode, marioPos, camTo, camFrom);
+        return gfx;
+    }
+
+    if (gEnvFxMode == ENVFX_MODE_NONE && !envfx_init_snow(mode)) {
+        return NULL;
+    }
+
+    switch (mode) {
+        case ENVFX_MODE_NONE:
+            envfx_cleanup_snow(gEnvFxBuffer);
+            return NULL;
+
+        case ENVFX_SNOW_NORMAL:
+            gfx = envfx_update_snow(1, marioPos, camFrom, camTo);
+            break;
+
+        case ENVFX_SNOW_WATER:
+            gfx = envfx_update_snow(2, marioPos, camFrom, camTo);
+            break;
+
+        case ENVFX_SNOW_BLIZZARD:
+            gfx = envfx_update_snow(3, marioPos, camFrom, camTo);
+            break;
+
+        default:
+            return NULL;
+    }
+
+    return gfx;
+}
+
+//
+// envfx_bubbles.c
+//
+
+/**
+ * This file implements environment effects that are not snow:
+ * Flowers (unused), lava bubbles and jet stream/whirlpool bubbles.
+ * Refer to 'envfx_snow.c' for more info about environment effects.
+ * Note that the term 'bubbles' is used as a collective name for
+ * effects in this file even though flowers aren't bubbles. For the
+ * sake of concise naming, flowers fall under bubbles.
+ */
+
+s16 gEnvFxBubbleConfig[10];
+static Gfx *sGfxCursor; // points to end of display list for bubble particles
+static s32 sBubbleParticleCount;
+static s32 sBubbleParticleMaxCount;
+
+UNUSED s32 D_80330690 = 0;
+UNUSED s32 D_80330694 = 0;
+
+/// Template for a bubble particle triangle
+Vtx_t gBubbleTempVtx[3] = {
+    { { 0, 0, 0 }, 0, { 1544, 964 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
+    { { 0, 0, 0 }, 0, { 522, -568 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
+    { { 0, 0, 0 }, 0, { -498, 964 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
+};
+
+/**
+ * Check whether the particle with the given index is
+ * laterally within distance of point (x, z). Used to
+ * kill flower and bubble particles.
+ */
+s32 particle_is_laterally_close(s32 index, s32 x, s32 z, s32 distance) {
+    s32 xPos = (gEnvFxBuffer + index)->xPos;
+    s32 zPos = (gEnvFxBuffer + index)->zPos;
+
+    if (sqr(xPos - x) + sqr(zPos - z) > sqr(distance)) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Generate a uniform random number in range [-2000, -1000[ or [1000, 2000[
+ * Used to position flower particles
+ */
+s32 random_flower_offset(void) {
+    s32 result = random_float() * 2000.0f - 1000.0f;
+    if (result < 0) {
+        result -= 1000;
+    } else {
+        result += 1000;
+    }
+
+    return result;
+}
+
+/**
+ * Update flower particles. Flowers are scattered randomly in front of the
+ * camera, and can land on any ground
+ */
+void envfx_update_flower(Vec3s centerPos) {
+    s32 i;
+    struct FloorGeometry *floorGeo; // unused
+    s32 globalTimer = gGlobalTimer;
+
+    s16 centerX = centerPos[0];
+    UNUSED s16 centerY = centerPos[1];
+    s16 centerZ = centerPos[2];
+
+    for (i = 0; i < sBubbleParticleMaxCount; i++) {
+        (gEnvFxBuffer + i)->isAlive = particle_is_laterally_close(i, centerX, centerZ, 3000);
+        if (!(gEnvFxBuffer + i)->isAlive) {
+            (gEnvFxBuffer + i)->xPos = random_flower_offset() + centerX;
+            (gEnvFxBuffer + i)->zPos = random_flower_offset() + centerZ;
+            (gEnvFxBuffer + i)->yPos = find_floor_height_and_data((gEnvFxBuffer + i)->xPos, 10000.0f,
+                                                                  (gEnvFxBuffer + i)->zPos, &floorGeo);
+            (gEnvFxBuffer + i)->isAlive = TRUE;
+            (gEnvFxBuffer + i)->animFrame = random_float() * 5.0f;
+        } else if (!(globalTimer & 3)) {
+            (gEnvFxBuffer + i)->animFrame += 1;
+            if ((gEnvFxBuffer + i)->animFrame > 5) {
+                (gEnvFxBuffer + i)->animFrame = 0;
+            }
+        }
+    }
+}
+
+/**
+ * Update the position of a lava bubble to be somewhere around centerPos
+ * Uses find_floor to find the height of lava, if no floor or a non-lava
+ * floor is found the bubble y is set to -10000, which is why you can see
+ * occasional lava bubbles far below the course in Lethal Lava Land.
+ * In the second Bowser fight arena, the visual lava is above the lava
+ * floor so lava-bubbles are not normally visible, only if you bring the
+ * camera below the lava plane.
+ */
+void envfx_set_lava_bubble_position(s32 index, Vec3s centerPos) {
+    struct Surface *surface;
+    s16 floorY;
+
+    s16 centerX = centerPos[0];
+    s16 centerY = centerPos[1];
+    s16 centerZ = centerPos[2];
+
+    (gEnvFxBuffer + index)->xPos = random_float() * 6000.0f - 3000.0f + centerX;
+    (gEnvFxBuffer + index)->zPos = random_float() * 6000.0f - 3000.0f + centerZ;
+
+    if ((gEnvFxBuffer + index)->xPos > 8000) {
+        (gEnvFxBuffer + index)->xPos = 16000 - (gEnvFxBuffer + index)->xPos;
+    }
+    if ((gEnvFxBuffer + index)->xPos < -8000) {
+        (gEnvFxBuffer + index)->xPos = -16000 - (gEnvFxBuffer + index)->xPos;
+    }
+
+    if ((gEnvFxBuffer + index)->zPos > 8000) {
+        (gEnvFxBuffer + index)->zPos = 16000 - (gEnvFxBuffer + index)->zPos;
+    }
+    if ((gEnvFxBuffer + index)->zPos < -8000) {
+        (gEnvFxBuffer + index)->zPos = -16000 - (gEnvFxBuffer + index)->zPos;
+    }
+
+    floorY =
+        find_floor((gEnvFxBuffer + index)->xPos, centerY + 500, (gEnvFxBuffer + index)->zPos, &surface);
+    if (surface == NULL) {
+        (gEnvFxBuffer + index)->yPos = FLOOR_LOWER_LIMIT_MISC;
+        return;
+    }
+
+    if (surface->type == SURFACE_BURNING) {
+        (gEnvFxBuffer + index)->yPos = floorY;
+    } else {
+        (gEnvFxBuffer + index)->yPos = FLOOR_LOWER_LIMIT_MISC;
+    }
+}
+
+/**
+ * Update lava bubble animation and give the bubble a new position if the
+ * animation is over.
+ */
+void envfx_update_lava(Vec3s centerPos) {
+    s32 i;
+    s32 globalTimer = gGlobalTimer;
+    s8 chance;
+
+    UNUSED s16 centerX = centerPos[0];
+    UNUSED s16 centerY = centerPos[1];
+    UNUSED s16 centerZ = centerPos[2];
+
+    for (i = 0; i < sBubbleParticleMaxCount; i++) {
+        if (!(gEnvFxBuffer + i)->isAlive) {
+            envfx_set_lava_bubble_position(i, centerPos);
+            (gEnvFxBuffer + i)->isAlive = TRUE;
+        } else if (!(globalTimer & 1)) {
+            (gEnvFxBuffer + i)->animFrame += 1;
+            if ((gEnvFxBuffer + i)->animFrame > 8) {
+                (gEnvFxBuffer + i)->isAlive = FALSE;
+                (gEnvFxBuffer + i)->animFrame = 0;
+            }
+        }
+    }
+
+    if ((chance = (s32)(random_float() * 16.0f)) == 8) {
+        play_sound(SOUND_GENERAL_QUIET_BUBBLE2, gGlobalSoundSource);
+    }
+}
+
+/**
+ * Rotate the input x, y and z around the rotation origin of the whirlpool
+ * according to the pitch and yaw of the whirlpool.
+ */
+void envfx_rotate_around_whirlpool(s32 *x, s32 *y, s32 *z) {
+    s32 vecX = *x - gEnvFxBubbleConfig[ENVFX_STATE_DEST_X];
+    s32 vecY = *y - gEnvFxBubbleConfig[ENVFX_STATE_DEST_Y];
+    s32 vecZ = *z - gEnvFxBubbleConfig[ENVFX_STATE_DEST_Z];
+    f32 cosPitch = coss(gEnvFxBubbleConfig[ENVFX_STATE_PITCH]);
+    f32 sinPitch = sins(gEnvFxBubbleConfig[ENVFX_STATE_PITCH]);
+    f32 cosMYaw = coss(-gEnvFxBubbleConfig[ENVFX_STATE_YAW]);
+    f32 sinMYaw = sins(-gEnvFxBubbleConfig[ENVFX_STATE_YAW]);
+
+    f32 rotatedX = vecX * cosMYaw - sinMYaw * cosPitch * vecY - sinPitch * sinMYaw * vecZ;
+    f32 rotatedY = vecX * sinMYaw + cosPitch * cosMYaw * vecY - sinPitch * cosMYaw * vecZ;
+    f32 rotatedZ = vecY * sinPitch + cosPitch * vecZ;
+
+    *x = gEnvFxBubbleConfig[ENVFX_STATE_DEST_X] + (s32) rotatedX;
+    *y = gEnvFxBubbleConfig[ENVFX_STATE_DEST_Y] + (s32) rotatedY;
+    *z = gEnvFxBubbleConfig[ENVFX_STATE_DEST_Z] + (s32) rotatedZ;
+}
+
+/**
+ * Check whether a whirlpool bubble is alive. A bubble respawns when it is too
+ * low or close to the center.
+ */
+s32 envfx_is_whirlpool_bubble_alive(s32 index) {
+    UNUSED u8 filler[4];
+
+    if ((gEnvFxBuffer + index)->bubbleY < gEnvFxBubbleConfig[ENVFX_STATE_DEST_Y] - 100) {
+        return FALSE;
+    }
+
+    if ((gEnvFxBuffer + index)->angleAndDist[1] < 10) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Update whirlpool particles. Whirlpool particles start high and far from
+ * the center and get sucked into the sink in a spiraling motion.
+ */
+void envfx_update_whirlpool(void) {
+    s32 i;
+
+    for (i = 0; i < sBubbleParticleMaxCount; i++) {
+        (gEnvFxBuffer + i)->isAlive = envfx_is_whirlpool_bubble_alive(i);
+        if (!(gEnvFxBuffer + i)->isAlive) {
+            (gEnvFxBuffer + i)->angleAndDist[1] = random_float() * 1000.0f;
+            (gEnvFxBuffer + i)->angleAndDist[0] = random_float() * 65536.0f;
+            (gEnvFxBuffer + i)->xPos =
+                gEnvFxBubbleConfig[ENVFX_STATE_SRC_X]
+                + sins((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
+            (gEnvFxBuffer + i)->zPos =
+                gEnvFxBubbleConfig[ENVFX_STATE_SRC_Z]
+                + coss((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
+            (gEnvFxBuffer + i)->bubbleY =
+                gEnvFxBubbleConfig[ENVFX_STATE_SRC_Y] + (random_float() * 100.0f - 50.0f);
+            (gEnvFxBuffer + i)->yPos = (i + gEnvFxBuffer)->bubbleY;
+            (gEnvFxBuffer + i)->unusedBubbleVar = 0;
+            (gEnvFxBuffer + i)->isAlive = TRUE;
+
+            envfx_rotate_around_whirlpool(&(gEnvFxBuffer + i)->xPos, &(gEnvFxBuffer + i)->yPos,
+                                          &(gEnvFxBuffer + i)->zPos);
+        } else {
+            (gEnvFxBuffer + i)->angleAndDist[1] -= 40;
+            (gEnvFxBuffer + i)->angleAndDist[0] +=
+                (s16)(3000 - (gEnvFxBuffer + i)->angleAndDist[1] * 2) + 0x400;
+            (gEnvFxBuffer + i)->xPos =
+                gEnvFxBubbleConfig[ENVFX_STATE_SRC_X]
+                + sins((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
+            (gEnvFxBuffer + i)->zPos =
+                gEnvFxBubbleConfig[ENVFX_STATE_SRC_Z]
+                + coss((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
+            (gEnvFxBuffer + i)->bubbleY -= 40 - ((s16)(gEnvFxBuffer + i)->angleAndDist[1] / 100);
+            (gEnvFxBuffer + i)->yPos = (i + gEnvFxBuffer)->bubbleY;
+
+            envfx_rotate_around_whirlpool(&(gEnvFxBuffer + i)->xPos, &(gEnvFxBuffer + i)->yPos,
+                                          &(gEnvFxBuffer + i)->zPos);
+        }
+    }
+}
+
+/**
+ * Check whether a jet stream bubble should respawn. Happens if it is laterally
+ * 1000 units away from the source or 1500 units above it.
+ */
+s32 envfx_is_jestream_bubble_alive(s32 index) {
+    UNUSED u8 filler[4];
+
+    if (!particle_is_laterally_close(index, gEnvFxBubbleConfig[ENVFX_STATE_SRC_X],
+                                     gEnvFxBubbleConfig[ENVFX_STATE_SRC_Z], 1000)
+        || gEnvFxBubbleConfig[ENVFX_STATE_SRC_Y] + 1500 < (gEnvFxBuffer + index)->yPos) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Update the positions of jet stream bubble particles.
+ * They move up and outwards.
+ */
+void envfx_update_jetstream(void) {
+    s32 i;
+
+    for (i = 0; i < sBubbleParticleMaxCount; i++) {
+        (gEnvFxBuffer + i)->isAlive = envfx_is_jestream_bubble_alive(i);
+        if (!(gEnvFxBuffer + i)->isAlive) {
+            (gEnvFxBuffer + i)->angleAndDist[1] = random_float() * 300.0f;
+            (gEnvFxBuffer + i)->angleAndDist[0] = random_u16();
+            (gEnvFxBuffer + i)->xPos =
+                gEnvFxBubbleConfig[ENVFX_STATE_SRC_X]
+                + sins((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
+            (gEnvFxBuffer + i)->zPos =
+                gEnvFxBubbleConfig[ENVFX_STATE_SRC_Z]
+                + coss((gEnvFxBuffer + i)->angleAndDist[0]) * (gEnvFxBuffer + i)->angleAndDist[1];
+            (gEnvFxBuffer + i)->yPos =
+                gEnvFxBubbleConfig[ENVFX_STATE_SRC_Y] + (random_float() * 400.0f - 200.0f);
+        } else {
+            (gEnvFxBuffer + i)->angleAndDist[1] += 10;
+            (gEnvFxBuffer + i)->xPos += sins((gEnvFxBuffer + i)->angleAndDist[0]) * 10.0f;
+            (gEnvFxBuffer + i)->zPos += coss((gEnvFxBuffer + i)->angleAndDist[0]) * 10.0f;
+            (gEnvFxBuffer + i)->yPos -= ((gEnvFxBuffer + i)->angleAndDist[1] / 30) - 50;
+        }
+    }
+}
+
+/**
+ * Initialize bubble (or flower) effect by allocating a buffer to store
+ * the state of each particle and setting the initial and max count.
+ * Analogous to init_snow_particles, but for bubbles.
+ */
+s32 envfx_init_bubble(s32 mode) {
+    s32 i;
+
+    switch (mode) {
+        case ENVFX_MODE_NONE:
+            return FALSE;
+
+        case ENVFX_FLOWERS:
+            sBubbleParticleCount = 30;
+            sBubbleParticleMaxCount = 30;
+            break;
+
+        case ENVFX_LAVA_BUBBLES:
+            sBubbleParticleCount = 15;
+            sBubbleParticleMaxCount = 15;
+            break;
+
+        case ENVFX_WHIRLPOOL_BUBBLES:
+            sBubbleParticleCount = 60;
+            break;
+
+        case ENVFX_JETSTREAM_BUBBLES:
+            sBubbleParticleCount = 60;
+            break;
+    }
+
+    gEnvFxBuffer = mem_pool_alloc(gEffectsMemoryPool,
+                                  sBubbleParticleCount * sizeof(struct EnvFxParticle));
+    if (gEnvFxBuffer == NULL) {
+        return FALSE;
+    }
+
+    bzero(gEnvFxBuffer, sBubbleParticleCount * sizeof(struct EnvFxParticle));
+    bzero(gEnvFxBubbleConfig, sizeof(gEnvFxBubbleConfig));
+
+    switch (mode) {
+        case ENVFX_LAVA_BUBBLES:
+            for (i = 0; i < sBubbleParticleCount; i++) {
+                (gEnvFxBuffer + i)->animFrame = random_float() * 7.0f;
+            }
+            break;
+    }
+
+    gEnvFxMode = mode;
+    return TRUE;
+}
+
+/**
+ * Update particles depending on mode.
+ * Also sets the given vertices to the correct shape for each mode,
+ * though they are not being rotated yet.
+ */
+void envfx_bubbles_update_switch(s32 mode, Vec3s camTo, Vec3s vertex1, Vec3s vertex2, Vec3s vertex3) {
+    switch (mode) {
+        case ENVFX_FLOWERS:
+            envfx_update_flower(camTo);
+            vertex1[0] = 50;  vertex1[1] = 0;  vertex1[2] = 0;
+            vertex2[0] = 0;   vertex2[1] = 75; vertex2[2] = 0;
+            vertex3[0] = -50; vertex3[1] = 0;  vertex3[2] = 0;
+            break;
+
+        case ENVFX_LAVA_BUBBLES:
+            envfx_update_lava(camTo);
+            vertex1[0] = 100;  vertex1[1] = 0;   vertex1[2] = 0;
+            vertex2[0] = 0;    vertex2[1] = 150; vertex2[2] = 0;
+            vertex3[0] = -100; vertex3[1] = 0;   vertex3[2] = 0;
+            break;
+
+        case ENVFX_WHIRLPOOL_BUBBLES:
+            envfx_update_whirlpool();
+            vertex1[0] = 40;  vertex1[1] = 0;  vertex1[2] = 0;
+            vertex2[0] = 0;   vertex2[1] = 60; vertex2[2] = 0;
+            vertex3[0] = -40; vertex3[1] = 0;  vertex3[2] = 0;
+            break;
+
+        case ENVFX_JETSTREAM_BUBBLES:
+            envfx_update_jetstream();
+            vertex1[0] = 40;  vertex1[1] = 0;  vertex1[2] = 0;
+            vertex2[0] = 0;   vertex2[1] = 60; vertex2[2] = 0;
+            vertex3[0] = -40; vertex3[1] = 0;  vertex3[2] = 0;
+            break;
+    }
+}
+
+/**
+ * Append 15 vertices to 'gfx', which is enough for 5 bubbles starting at
+ * 'index'. The 3 input vertices represent the rotated triangle around (0,0,0)
+ * that will be translated to bubble positions to draw the bubble image
+ */
+void append_bubble_vertex_buffer(Gfx *gfx, s32 index, Vec3s vertex1, Vec3s vertex2, Vec3s vertex3,
+                                 Vtx *template) {
+    s32 i = 0;
+    Vtx *vertBuf = alloc_display_list(15 * sizeof(Vtx));
+
+    if (vertBuf == NULL) {
+        return;
+    }
+
+    for (i = 0; i < 15; i += 3) {
+        vertBuf[i] = template[0];
+        (vertBuf + i)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex1[0];
+        (vertBuf + i)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex1[1];
+        (vertBuf + i)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex1[2];
+
+        vertBuf[i + 1] = template[1];
+        (vertBuf + i + 1)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex2[0];
+        (vertBuf + i + 1)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex2[1];
+        (vertBuf + i + 1)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex2[2];
+
+        vertBuf[i + 2] = template[2];
+        (vertBuf + i + 2)->v.ob[0] = (gEnvFxBuffer + (index + i / 3))->xPos + vertex3[0];
+        (vertBuf + i + 2)->v.ob[1] = (gEnvFxBuffer + (index + i / 3))->yPos + vertex3[1];
+        (vertBuf + i + 2)->v.ob[2] = (gEnvFxBuffer + (index + i / 3))->zPos + vertex3[2];
+    }
+
+    gSPVertex(gfx, VIRTUAL_TO_PHYSICAL(vertBuf), 15, 0);
+}
+
+/**
+ * Appends to the enfvx display list a command setting the appropriate texture
+ * for a specific particle. The display list is not passed as parameter but uses
+ * the global sGfxCursor instead.
+ */
+void envfx_set_bubble_texture(s32 mode, s16 index) {
+    void **imageArr = NULL;
+    s16 frame = (gEnvFxBuffer + index)->animFrame;
+
+    switch (mode) {
+        case ENVFX_FLOWERS:
+            imageArr = segmented_to_virtual(&flower_bubbles_textures_ptr_0B002008);
+            frame = (gEnvFxBuffer + index)->animFrame;
+            break;
+
+        case ENVFX_LAVA_BUBBLES:
+            imageArr = segmented_to_virtual(&lava_bubble_ptr_0B006020);
+            frame = (gEnvFxBuffer + index)->animFrame;
+            break;
+
+        case ENVFX_WHIRLPOOL_BUBBLES:
+        case ENVFX_JETSTREAM_BUBBLES:
+            imageArr = segmented_to_virtual(&bubble_ptr_0B006848);
+            frame = 0;
+            break;
+    }
+
+    gDPSetTextureImage(sGfxCursor++, G_IM_FMT_RGBA, G_IM_SIZ_16b, 1, *(imageArr + frame));
+    gSPDisplayList(sGfxCursor++, &tiny_bubble_dl_0B006D68);
+}
+
+/**
+ * Updates the bubble particle positions, then generates and returns a display
+ * list drawing them.
+ */
+Gfx *envfx_update_bubble_particles(s32 mode, UNUSED Vec3s marioPos, Vec3s camFrom, Vec3s camTo) {
+    s32 i;
+    s16 radius, pitch, yaw;
+
+    Vec3s vertex1;
+    Vec3s vertex2;
+    Vec3s vertex3;
+
+    Gfx *gfxStart = alloc_display_list(((sBubbleParticleMaxCount / 5) * 10 + sBubbleParticleMaxCount + 3)
+                                       * sizeof(Gfx));
+    if (gfxStart == NULL) {
+        return NULL;
+    }
+
+    sGfxCursor = gfxStart;
+
+    orbit_from_positions(camTo, camFrom, &radius, &pitch, &yaw);
+    envfx_bubbles_update_switch(mode, camTo, vertex1, vertex2, vertex3);
+    rotate_triangle_vertices(vertex1, vertex2, vertex3, pitch, yaw);
+
+    gSPDisplayList(sGfxCursor++, &tiny_bubble_dl_0B006D38);
+
+    for (i = 0; i < sBubbleParticleMaxCount; i += 5) {
+        gDPPipeSync(sGfxCursor++);
+        envfx_set_bubble_texture(mode, i);
+        append_bubble_vertex_buffer(sGfxCursor++, i, vertex1, vertex2, vertex3, (Vtx *) gBubbleTempVtx);
+        gSP1Triangle(sGfxCursor++, 0, 1, 2, 0);
+        gSP1Triangle(sGfxCursor++, 3, 4, 5, 0);
+        gSP1Triangle(sGfxCursor++, 6, 7, 8, 0);
+        gSP1Triangle(sGfxCursor++, 9, 10, 11, 0);
+        gSP1Triangle(sGfxCursor++, 12, 13, 14, 0);
+    }
+
+    gSPDisplayList(sGfxCursor++, &tiny_bubble_dl_0B006AB0);
+    gSPEndDisplayList(sGfxCursor++);
+
+    return gfxStart;
+}
+
+/**
+ * Set the maximum particle count from the gEnvFxBubbleConfig variable,
+ * which is set by the whirlpool or jet stream behavior.
+ */
+void envfx_set_max_bubble_particles(s32 mode) {
+    switch (mode) {
+        case ENVFX_WHIRLPOOL_BUBBLES:
+            sBubbleParticleMaxCount = gEnvFxBubbleConfig[ENVFX_STATE_PARTICLECOUNT];
+            break;
+        case ENVFX_JETSTREAM_BUBBLES:
+            sBubbleParticleMaxCount = gEnvFxBubbleConfig[ENVFX_STATE_PARTICLECOUNT];
+            break;
+    }
+}
+
+/**
+ * Update bubble-like environment effects. Assumes the mode is larger than 10,
+ * lower modes are snow effects which are updated in a different function.
+ * Returns a display list drawing the particles.
+ */
+Gfx *envfx_update_bubbles(s32 mode, Vec3s marioPos, Vec3s camTo, Vec3s camFrom) {
+    Gfx *gfx;
+
+    if (gEnvFxMode == ENVFX_MODE_NONE && !envfx_init_bubble(mode)) {
+        return NULL;
+    }
+
+    envfx_set_max_bubble_particles(mode);
+
+    if (sBubbleParticleMaxCount == 0) {
+        return NULL;
+    }
+
+    switch (mode) {
+        case ENVFX_FLOWERS:
+            gfx = envfx_update_bubble_particles(ENVFX_FLOWERS, marioPos, camFrom, camTo);
+            break;
+
+        case ENVFX_LAVA_BUBBLES:
+            gfx = envfx_update_bubble_particles(ENVFX_LAVA_BUBBLES, marioPos, camFrom, camTo);
+            break;
+
+        case ENVFX_WHIRLPOOL_BUBBLES:
+            gfx = envfx_update_bubble_particles(ENVFX_WHIRLPOOL_BUBBLES, marioPos, camFrom, camTo);
+            break;
+
+        case ENVFX_JETSTREAM_BUBBLES:
+            gfx = envfx_update_bubble_particles(ENVFX_JETSTREAM_BUBBLES, marioPos, camFrom, camTo);
+            break;
+
+        default:
+            return NULL;
+    }
+
+    return gfx;
+}
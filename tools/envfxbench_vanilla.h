@@ -0,0 +1,35 @@
+#ifndef ENVFXBENCH_VANILLA_H_
+#define ENVFXBENCH_VANILLA_H_
+
+#include <ultra64.h>
+#include "types.h"
+
+// The particle struct envfx_snow.h had before the per-field arrays
+struct EnvFxParticle {
+   s8 isAlive;
+   s16 animFrame; // lava bubbles and flowers have frame animations
+   s32 xPos;
+   s32 yPos;
+   s32 zPos;
+   s32 angleAndDist[2]; // for whirpools, [0] = angle from center, [1] = distance from center
+   s32 unusedBubbleVar; // set to zero for bubbles when respawning, never used elsewhere
+   s32 bubbleY; // for Bubbles, yPos is always set to this
+   u8 filler[24];
+};
+
+// envfx_snow.c and envfx_bubbles.c as they were, in envfxbench_vanilla.c
+extern struct EnvFxParticle *vanilla_gEnvFxBuffer;
+extern s8 vanilla_gEnvFxMode;
+extern s16 vanilla_gSnowParticleCount;
+extern s16 vanilla_gEnvFxBubbleConfig[10];
+
+Gfx *vanilla_envfx_update_particles(s32 mode, Vec3s marioPos, Vec3s camTo, Vec3s camFrom);
+void vanilla_envfx_update_snow_normal(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ);
+void vanilla_envfx_update_snow_water(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ);
+void vanilla_envfx_update_snow_blizzard(s32 snowCylinderX, s32 snowCylinderY, s32 snowCylinderZ);
+void vanilla_envfx_update_flower(Vec3s centerPos);
+void vanilla_envfx_update_lava(Vec3s centerPos);
+void vanilla_envfx_update_whirlpool(void);
+void vanilla_envfx_update_jetstream(void);
+
+#endif // ENVFXBENCH_VANILLA_H_
@@ -0,0 +1,384 @@
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ultra64.h>
+#include "gd_types.h"
+#include "gd_main.h"
+#include "gd_memory.h"
+#include "debug_utils.h"
+#include "draw_objects.h"
+#include "objects.h"
+#include "renderer.h"
+#include "shape_helper.h"
+#include "skin.h"
+#include "dynlist_proc.h"
+
+// gd_main.h stubs printf out for the goddard sources.
+#undef printf
+
+#define GDSKINBENCH_VERSION "0.1"
+
+#define DEFAULT_FRAMES 20000
+#define VTX_POOL_SIZE 0x8000
+
+// How often the benchmark holds A down, so the head also runs its "follow the cursor" states.
+#define DRAG_PERIOD 1500
+#define DRAG_FRAMES 400
+
+// Every Vtx the shape display lists were built with. convert_net_verts writes the skinned
+// positions into these, so hashing the pool after each frame covers the whole output.
+static Vtx sVtxPool[VTX_POOL_SIZE];
+static u32 sVtxCount;
+static s32 sDlCount;
+
+static struct ObjCamera *sSceneCamera;
+static struct ObjView *sSceneView;
+static s32 sNetCount;
+static s32 sCachedNetCount;
+
+// Stand-ins for renderer.c, which needs the textures and the display list buffers of the game.
+s32 gGdFrameBufNum;
+
+f64 gd_sin_d(f64 x)
+{
+   return sinf(x);
+}
+
+f64 gd_cos_d(f64 x)
+{
+   return cosf(x);
+}
+
+f64 gd_sqrt_d(f64 x)
+{
+   if (x < 1.0e-7) {
+      return 0.0;
+   }
+   return sqrtf(x);
+}
+
+void gd_printf(const char *format, ...)
+{
+   va_list args;
+
+   va_start(args, format);
+   vfprintf(stderr, format, args);
+   va_end(args);
+}
+
+void gd_exit(UNUSED s32 code)
+{
+   fprintf(stderr, "gdskinbench: goddard exited\n");
+   exit(EXIT_FAILURE);
+}
+
+void *gd_malloc(u32 size, UNUSED u8 perm)
+{
+   return calloc(1, size);
+}
+
+void *gd_malloc_perm(u32 size)
+{
+   return gd_malloc(size, PERM_G_MEM_BLOCK);
+}
+
+void *gd_malloc_temp(u32 size)
+{
+   return gd_malloc(size, TEMP_G_MEM_BLOCK);
+}
+
+void gd_free(void *ptr)
+{
+   free(ptr);
+}
+
+u32 get_alloc_mem_amt(void)
+{
+   return 0;
+}
+
+s32 gd_get_ostime(void)
+{
+   return 0;
+}
+
+f32 get_time_scale(void)
+{
+   return 1.0f;
+}
+
+struct GdObj *load_dynlist(struct DynList *dynlist)
+{
+   return proc_dynlist(dynlist);
+}
+
+Vtx *gd_dl_make_vertex(f32 x, f32 y, f32 z, f32 alpha)
+{
+   Vtx *vtx;
+
+   if (sVtxCount >= VTX_POOL_SIZE) {
+      fprintf(stderr, "gdskinbench: more than %d vertices\n", VTX_POOL_SIZE);
+      exit(EXIT_FAILURE);
+   }
+   vtx = &sVtxPool[sVtxCount++];
+   vtx->n.ob[0] = (s16) x;
+   vtx->n.ob[1] = (s16) y;
+   vtx->n.ob[2] = (s16) z;
+   vtx->n.a = (u8)(alpha * 255.0f);
+   return vtx;
+}
+
+s32 gd_startdisplist(UNUSED s32 memarea)
+{
+   return ++sDlCount;
+}
+
+s32 gd_enddlsplist_parent(void)
+{
+   return sDlCount;
+}
+
+s32 create_mtl_gddl(UNUSED s32 mtlType)
+{
+   return ++sDlCount;
+}
+
+s32 setup_view_buffers(UNUSED const char *name, UNUSED struct ObjView *view, UNUSED s32 ulx,
+                       UNUSED s32 uly, UNUSED s32 lrx, UNUSED s32 lry)
+{
+   return 0;
+}
+
+s32 gd_getproperty(UNUSED s32 prop, UNUSED void *arg1)
+{
+   return FALSE;
+}
+
+s32 gd_dl_material_lighting(UNUSED s32 id, UNUSED struct GdColour *colour, UNUSED s32 material)
+{
+   return 0;
+}
+
+s32 get_cur_pickbuf_offset(UNUSED s16 *arg0)
+{
+   return 0;
+}
+
+void gd_setproperty(UNUSED enum GdProperty prop, UNUSED f32 f1, UNUSED f32 f2, UNUSED f32 f3) { }
+void gd_draw_rect(UNUSED f32 ulx, UNUSED f32 uly, UNUSED f32 lrx, UNUSED f32 lry) { }
+void gd_draw_border_rect(UNUSED f32 ulx, UNUSED f32 uly, UNUSED f32 lrx, UNUSED f32 lry) { }
+void gd_dl_set_fill(UNUSED struct GdColour *colour) { }
+void draw_indexed_dl(UNUSED s32 dlNum, UNUSED s32 gfxIdx) { }
+void stash_current_gddl(void) { }
+void pop_gddl_stash(void) { }
+void gd_dl_load_matrix(UNUSED Mat4f *mtx) { }
+void gd_dl_push_matrix(void) { }
+void gd_dl_pop_matrix(void) { }
+void gd_dl_mul_trans_matrix(UNUSED f32 x, UNUSED f32 y, UNUSED f32 z) { }
+void gd_dl_load_trans_matrix(UNUSED f32 x, UNUSED f32 y, UNUSED f32 z) { }
+void gd_dl_scale(UNUSED f32 x, UNUSED f32 y, UNUSED f32 z) { }
+void func_8019F2C4(UNUSED f32 arg0, UNUSED s8 arg1) { }
+void gd_dl_lookat(UNUSED struct ObjCamera *cam, UNUSED f32 arg1, UNUSED f32 arg2, UNUSED f32 arg3,
+                  UNUSED f32 arg4, UNUSED f32 arg5, UNUSED f32 arg6, UNUSED f32 arg7) { }
+void check_tri_display(UNUSED s32 vtxcount) { }
+void func_8019FEF0(void) { }
+void gd_dl_make_triangle(UNUSED f32 x1, UNUSED f32 y1, UNUSED f32 z1, UNUSED f32 x2, UNUSED f32 y2,
+                         UNUSED f32 z2, UNUSED f32 x3, UNUSED f32 y3, UNUSED f32 z3) { }
+void func_801A0038(void) { }
+void gd_dl_flush_vertices(void) { }
+void set_render_alpha(UNUSED f32 arg0) { }
+void set_light_id(UNUSED s32 index) { }
+void set_light_num(UNUSED s32 n) { }
+void branch_to_gddl(UNUSED s32 dlNum) { }
+void gd_dl_hilite(UNUSED s32 idx, UNUSED struct ObjCamera *cam, UNUSED struct GdVec3f *arg2,
+                  UNUSED struct GdVec3f *arg3, UNUSED struct GdVec3f *arg4,
+                  UNUSED struct GdColour *colour) { }
+void set_Vtx_norm_buf_1(UNUSED struct GdVec3f *norm) { }
+void set_Vtx_norm_buf_2(UNUSED struct GdVec3f *norm) { }
+void set_vtx_tc_buf(UNUSED f32 tcS, UNUSED f32 tcT) { }
+void set_gd_mtx_parameters(UNUSED s32 params) { }
+void gd_set_one_cycle(void) { }
+void gddl_is_loading_stub_dl(UNUSED s32 dlLoad) { }
+void start_view_dl(UNUSED struct ObjView *view) { }
+void border_active_view(void) { }
+void gd_shading(UNUSED s32 model) { }
+void gd_create_ortho_matrix(UNUSED f32 l, UNUSED f32 r, UNUSED f32 b, UNUSED f32 t, UNUSED f32 n,
+                            UNUSED f32 f) { }
+void gd_create_perspective_matrix(UNUSED f32 fovy, UNUSED f32 aspect, UNUSED f32 near,
+                                  UNUSED f32 far) { }
+void func_801A4438(UNUSED f32 x, UNUSED f32 y, UNUSED f32 z) { }
+void stub_draw_label_text(UNUSED char *s) { }
+void set_active_view(UNUSED struct ObjView *v) { }
+void init_pick_buf(UNUSED s16 *buf, UNUSED s32 len) { }
+void store_in_pickbuf(UNUSED s16 data) { }
+
+static void print_usage(void)
+{
+   fprintf(stderr,
+         "Usage: gdskinbench [-n FRAMES]\n"
+         "\n"
+         "gdskinbench v" GDSKINBENCH_VERSION ": load the Mario head from dynlist_mario_master, animate it\n"
+         "with and without the net skin caches of src/goddard/skin.c, check that both give the\n"
+         "same vertices every frame and time the two\n"
+         "\n"
+         "Optional arguments:\n"
+         " -n FRAMES frames to animate (default: %d)\n",
+         DEFAULT_FRAMES);
+}
+
+static double seconds(clock_t start)
+{
+   return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static u32 hash_vertices(void)
+{
+   const u8 *data = (const u8 *) sVtxPool;
+   u32 size = sVtxCount * sizeof(Vtx);
+   u32 hash = 2166136261u;
+   u32 i;
+
+   for (i = 0; i < size; i++) {
+      hash = (hash ^ data[i]) * 16777619u;
+   }
+   return hash;
+}
+
+static void find_camera(struct ObjCamera *cam)
+{
+   sSceneCamera = cam;
+}
+
+static void count_net(struct ObjNet *net)
+{
+   sNetCount++;
+   if (net->skinCache != NULL) {
+      sCachedNetCount++;
+   }
+}
+
+static void drop_skin_cache(struct ObjNet *net)
+{
+   net->skinCache = NULL;
+}
+
+// Load the head the way gd_init, load_shapes2, setup_stars and gdm_maketestdl do.
+static void load_scene(s32 cached)
+{
+   remove_all_memtrackers();
+   null_obj_lists();
+   remove_all_timers();
+   sVtxCount = 0;
+   sDlCount = 0;
+   memset(&gGdCtrl, 0, sizeof(gGdCtrl));
+   gGdCtrl.csrX = 160;
+   gGdCtrl.csrY = 120;
+
+   load_shapes2();
+   gShapeRedStar = make_shape(0, "redstar");
+   gShapeSilverStar = make_shape(0, "silverstar");
+   gShapeRedSpark = make_shape(0, "sspark");
+   gShapeSilverSpark = make_shape(0, "rspark");
+
+   load_mario_head(animate_mario_head_normal);
+   sSceneView = make_view("mscene", (VIEW_DRAW | VIEW_ALLOC_ZBUF | VIEW_MOVEMENT), 1, 0, 0, 320,
+                          240, gMarioFaceGrp);
+   sSceneView->lights = gGdLightGroup;
+
+   sSceneCamera = NULL;
+   apply_to_obj_types_in_group(OBJ_TYPE_CAMERAS, (applyproc_t) find_camera, gMarioFaceGrp);
+   sSceneView->activeCam = sSceneCamera;
+   if (sSceneCamera != NULL) {
+      sSceneCamera->unk18C = sSceneView;
+   }
+
+   if (!cached) {
+      apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) drop_skin_cache, gMarioFaceGrp);
+   }
+   sNetCount = 0;
+   sCachedNetCount = 0;
+   apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) count_net, gMarioFaceGrp);
+}
+
+// Run the frames as update_view and gd_vblank do, hashing the vertices after each one.
+static void run_frames(u32 frames, u32 *hashes, double *moveTime, double *convertTime)
+{
+   clock_t start;
+   u32 frame;
+
+   *moveTime = 0.0;
+   *convertTime = 0.0;
+   for (frame = 0; frame < frames; frame++) {
+      gGdCtrl.dragging = (frame % DRAG_PERIOD) >= DRAG_PERIOD - DRAG_FRAMES;
+      gGdCtrl.csrX = 160 + (s32)(100.0f * sinf(frame * 0.02f));
+      gGdCtrl.csrY = 120 + (s32)(60.0f * cosf(frame * 0.03f));
+
+      start = clock();
+      gViewUpdateCamera = sSceneCamera;
+      proc_view_movement(sSceneView);
+      *moveTime += seconds(start);
+
+      start = clock();
+      apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) convert_net_verts, gMarioFaceGrp);
+      *convertTime += seconds(start);
+
+      hashes[frame] = hash_vertices();
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   long frames = DEFAULT_FRAMES;
+   double listMove, listConvert, cacheMove, cacheConvert;
+   u32 *listHashes, *cacheHashes;
+   u32 i;
+
+   for (i = 1; i < (u32) argc; i++) {
+      if (argv[i][0] == '-' && argv[i][1] == 'n' && i + 1 < (u32) argc) {
+         frames = strtol(argv[++i], NULL, 0);
+      } else {
+         print_usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (frames <= 0) {
+      print_usage();
+      return EXIT_FAILURE;
+   }
+
+   listHashes = malloc(frames * sizeof(u32));
+   cacheHashes = malloc(frames * sizeof(u32));
+   if (listHashes == NULL || cacheHashes == NULL) {
+      fprintf(stderr, "gdskinbench: out of memory\n");
+      return EXIT_FAILURE;
+   }
+
+   load_scene(FALSE);
+   run_frames(frames, listHashes, &listMove, &listConvert);
+
+   load_scene(TRUE);
+   run_frames(frames, cacheHashes, &cacheMove, &cacheConvert);
+
+   printf("%d nets (%d cached), %u vertices, %ld frames\n", sNetCount, sCachedNetCount, sVtxCount,
+          frames);
+   printf("lists  move %8.1f ns  convert %8.1f ns\n", listMove * 1e9 / frames,
+          listConvert * 1e9 / frames);
+   printf("cached move %8.1f ns  convert %8.1f ns\n", cacheMove * 1e9 / frames,
+          cacheConvert * 1e9 / frames);
+
+   for (i = 0; i < (u32) frames; i++) {
+      if (listHashes[i] != cacheHashes[i]) {
+         printf("vertices differ at frame %u\n", i);
+         return EXIT_FAILURE;
+      }
+   }
+   printf("vertices match\n");
+
+   free(listHashes);
+   free(cacheHashes);
+   return EXIT_SUCCESS;
+}
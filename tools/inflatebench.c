@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <PR/ultratypes.h>
+#include "zlib.h"
+#include "fastinflate.h"
+
+#define INFLATEBENCH_VERSION "0.1"
+
+#define DEFAULT_REPEATS 20
+
+// gzip header bytes that gziprules.mk strips before the DEFLATE stream
+#define GZIP_HEADER_SIZE 10
+
+static void print_usage(void)
+{
+   fprintf(stderr,
+         "Usage: inflatebench [-n REPEATS] FILE...\n"
+         "\n"
+         "inflatebench v" INFLATEBENCH_VERSION ": decode gzip segments with fast_inflate and with zlib's inflate\n"
+         "(inflate_fast), check that both give the same bytes and compare their speed\n"
+         "\n"
+         "Each FILE is a .szp segment from a COMPRESS=gzip build, or any other file, which is compressed\n"
+         "with 'gzip -9 -n' like the ROM build does\n"
+         "\n"
+         "Optional arguments:\n"
+         " -n REPEATS times each segment is decoded by each decoder (default: %d)\n",
+         DEFAULT_REPEATS);
+}
+
+static double seconds(clock_t start)
+{
+   return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static unsigned char *read_stream(FILE *f, long *size)
+{
+   unsigned char *data = NULL;
+   long capacity = 0;
+   size_t got;
+
+   *size = 0;
+   do {
+      if (*size == capacity) {
+         capacity = capacity ? capacity * 2 : 0x10000;
+         data = realloc(data, capacity);
+         if (!data) {
+            fprintf(stderr, "Out of memory\n");
+            exit(EXIT_FAILURE);
+         }
+      }
+      got = fread(data + *size, 1, capacity - *size, f);
+      *size += got;
+   } while (got != 0);
+   return data;
+}
+
+// Load a segment as the ROM holds it: the raw DEFLATE stream and its decompressed size.
+static unsigned char *load_segment(const char *path, long *compSize, long *size)
+{
+   const char *ext = strrchr(path, '.');
+   unsigned char *data;
+   char command[1024];
+   FILE *f;
+
+   if (ext && !strcmp(ext, ".szp")) {
+      f = fopen(path, "rb");
+      if (!f) {
+         perror(path);
+         return NULL;
+      }
+      data = read_stream(f, compSize);
+      fclose(f);
+      if (*compSize < 4) {
+         fprintf(stderr, "%s: too short for a .szp segment\n", path);
+         free(data);
+         return NULL;
+      }
+      // filesizer stores the decompressed size big endian in the last 4 bytes
+      *size = ((long)data[*compSize - 4] << 24) | (data[*compSize - 3] << 16)
+            | (data[*compSize - 2] << 8) | data[*compSize - 1];
+      return data;
+   }
+
+   f = fopen(path, "rb");
+   if (!f) {
+      perror(path);
+      return NULL;
+   }
+   free(read_stream(f, size));
+   fclose(f);
+
+   if (strchr(path, '\'') || strlen(path) > sizeof(command) - 32) {
+      fprintf(stderr, "%s: unsupported file name\n", path);
+      return NULL;
+   }
+   sprintf(command, "gzip -c -9 -n '%s'", path);
+   f = popen(command, "r");
+   if (!f) {
+      perror("gzip");
+      return NULL;
+   }
+   data = read_stream(f, compSize);
+   if (pclose(f) != 0 || *compSize < GZIP_HEADER_SIZE) {
+      fprintf(stderr, "%s: gzip failed\n", path);
+      free(data);
+      return NULL;
+   }
+   *compSize -= GZIP_HEADER_SIZE;
+   memmove(data, data + GZIP_HEADER_SIZE, *compSize);
+   return data;
+}
+
+static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size)
+{
+   return calloc(items, size);
+}
+
+static void zlib_free(voidpf opaque, voidpf address)
+{
+   free(address);
+}
+
+// Decode like expand_gzip does with GZIPDEC=zlib.
+static int zlib_inflate(unsigned char *in, unsigned char *out, long inLength, long outLength)
+{
+   z_stream stream;
+   int err;
+
+   memset(&stream, 0, sizeof(stream));
+   stream.zalloc = zlib_alloc;
+   stream.zfree = zlib_free;
+   stream.next_in = in;
+   stream.avail_in = inLength;
+   stream.next_out = out;
+   stream.avail_out = outLength;
+
+   err = inflateInit2(&stream, -MAX_WBITS);
+   if (err != Z_OK) {
+      return err;
+   }
+   err = inflate(&stream, Z_FINISH);
+   inflateEnd(&stream);
+   if (err != Z_OK && err != Z_STREAM_END) {
+      return err;
+   }
+   return stream.total_out;
+}
+
+int main(int argc, char *argv[])
+{
+   long repeats = DEFAULT_REPEATS;
+   double totalFast = 0;
+   double totalZlib = 0;
+   long totalComp = 0;
+   long totalSize = 0;
+   int failures = 0;
+   int files = 0;
+   int i;
+
+   for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+      if (argv[i][1] == 'n' && argv[i][2] == '\0' && i + 1 < argc) {
+         repeats = strtol(argv[++i], NULL, 0);
+      } else {
+         print_usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (i == argc || repeats <= 0) {
+      print_usage();
+      return EXIT_FAILURE;
+   }
+
+   printf("%-48s %8s %8s %10s %10s\n", "segment", "size", "comp", "fast MB/s", "zlib MB/s");
+   for (; i < argc; i++) {
+      unsigned char *fastOut;
+      unsigned char *zlibOut;
+      unsigned char *in;
+      long compSize;
+      long size;
+      double fastTime;
+      double zlibTime;
+      clock_t start;
+      int fastLen = 0;
+      int zlibLen = 0;
+      long r;
+
+      in = load_segment(argv[i], &compSize, &size);
+      if (!in) {
+         failures++;
+         continue;
+      }
+      fastOut = malloc(size + 1);
+      zlibOut = malloc(size + 1);
+      if (!fastOut || !zlibOut) {
+         fprintf(stderr, "Out of memory\n");
+         return EXIT_FAILURE;
+      }
+
+      start = clock();
+      for (r = 0; r < repeats; r++) {
+         fastLen = fast_inflate(in, fastOut, compSize, size);
+      }
+      fastTime = seconds(start);
+
+      start = clock();
+      for (r = 0; r < repeats; r++) {
+         zlibLen = zlib_inflate(in, zlibOut, compSize, size);
+      }
+      zlibTime = seconds(start);
+
+      if (fastLen != size || zlibLen != size || memcmp(fastOut, zlibOut, size)) {
+         fprintf(stderr, "%s: fast_inflate returned %d, inflate returned %d, expected %ld%s\n", argv[i],
+                 fastLen, zlibLen, size,
+                 fastLen == size && zlibLen == size ? ", and the bytes differ" : "");
+         failures++;
+      } else {
+         printf("%-48s %8ld %8ld %10.1f %10.1f\n", argv[i], size, compSize,
+                size * repeats / 1e6 / fastTime, size * repeats / 1e6 / zlibTime);
+         totalFast += fastTime;
+         totalZlib += zlibTime;
+         totalComp += compSize;
+         totalSize += size;
+         files++;
+      }
+
+      free(in);
+      free(fastOut);
+      free(zlibOut);
+   }
+
+   if (files > 0) {
+      printf("%-48s %8ld %8ld %10.1f %10.1f  (%.2fx)\n", "total", totalSize, totalComp,
+             totalSize * repeats / 1e6 / totalFast, totalSize * repeats / 1e6 / totalZlib,
+             totalZlib / totalFast);
+   }
+   return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
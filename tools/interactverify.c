@@ -0,0 +1,622 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Included rather than linked so the reference loop below can call the same static handlers.
+#include "game/interaction.c"
+
+#include "trig_tables.inc.c"
+
+#define INTERACTVERIFY_VERSION "0.1"
+
+#define DEFAULT_CASES 200000
+#define MAX_OBJECTS 4
+#define MAX_SPAWNED 8
+#define MAX_CALLS 32
+
+// A call from a handler to the rest of the game, with its first argument.
+struct Call {
+   const char *name;
+   s32 arg;
+};
+
+// Everything the handlers read or write, so that one collision set can be replayed
+// from the same starting point through both loops and the results compared whole.
+struct Scene {
+   struct MarioState mario;
+   struct Object marioObj;
+   struct MarioBodyState bodyState;
+   struct Area area;
+   struct Camera camera;
+   struct Surface floor;
+   struct Object usedObj;
+   struct Object objects[MAX_OBJECTS];
+   struct Object spawned[MAX_SPAWNED];
+   s32 numSpawned;
+   struct HudDisplay hud;
+   u32 saveFlags;
+   s16 courseNum;
+   u8 delayInvincTimer;
+   s16 invulnerable;
+   u8 displayingDoorText;
+   u8 justTeleported;
+   u8 pssSlideStarted;
+   struct Call calls[MAX_CALLS];
+   s32 numCalls;
+};
+
+// One object of a collision set, placed relative to Mario.
+struct SetObject {
+   u32 interactType;
+   u32 interactionSubtype;
+   s16 dx, dy, dz;
+   s32 damageOrCoinValue;
+};
+
+struct CollisionSet {
+   const char *name;
+   const struct SetObject *objects;
+   s32 numObjects;
+};
+
+typedef struct
+{
+   long cases;
+   long calls;
+   long mismatches;
+} verify_state;
+
+// Stand-ins for the parts of the game interaction.c uses. Each one that has an effect
+// outside the scene is logged, so that the order of the effects is compared as well.
+struct MarioState *gMarioState;
+struct HudDisplay gHudDisplay;
+s16 gCurrCourseNum;
+s16 gCurrSaveFileNum = 1;
+u32 gGlobalTimer = 1000;
+
+const BehaviorScript bhvBowser[1];
+const BehaviorScript bhvCarrySomething3[1];
+const BehaviorScript bhvCarrySomething4[1];
+const BehaviorScript bhvCarrySomething5[1];
+const BehaviorScript bhvKoopaShellUnderwater[1];
+const BehaviorScript bhvMetalCap[1];
+const BehaviorScript bhvNormalCap[1];
+const BehaviorScript bhvStarKeyCollectionPuffSpawner[1];
+const BehaviorScript bhvVanishCap[1];
+const BehaviorScript bhvWingCap[1];
+const Collision warp_pipe_seg3_collision_03009AC8[1];
+
+static struct Scene sScene;
+static u32 sRandomState = 1;
+
+static void log_call(const char *name, s32 arg)
+{
+   if (sScene.numCalls < MAX_CALLS) {
+      sScene.calls[sScene.numCalls].name = name;
+      sScene.calls[sScene.numCalls].arg = arg;
+   }
+   sScene.numCalls++;
+}
+
+u32 set_mario_action(struct MarioState *m, u32 action, u32 actionArg)
+{
+   log_call("set_mario_action", action);
+   m->prevAction = m->action;
+   m->action = action;
+   m->actionArg = actionArg;
+   m->actionState = 0;
+   m->actionTimer = 0;
+   return TRUE;
+}
+
+s32 drop_and_set_mario_action(struct MarioState *m, u32 action, u32 actionArg)
+{
+   mario_stop_riding_and_holding(m);
+   return set_mario_action(m, action, actionArg);
+}
+
+void mario_set_forward_vel(struct MarioState *m, f32 forwardVel)
+{
+   m->forwardVel = forwardVel;
+   m->slideVelX = sins(m->faceAngle[1]) * m->forwardVel;
+   m->slideVelZ = coss(m->faceAngle[1]) * m->forwardVel;
+   m->vel[0] = m->slideVelX;
+   m->vel[2] = m->slideVelZ;
+}
+
+void update_mario_sound_and_camera(UNUSED struct MarioState *m)
+{
+   log_call("update_mario_sound_and_camera", 0);
+}
+
+void play_sound(s32 soundBits, UNUSED f32 *pos)
+{
+   log_call("play_sound", soundBits);
+}
+
+void play_cap_music(u16 seqArgs)
+{
+   log_call("play_cap_music", seqArgs);
+}
+
+void play_shell_music(void)
+{
+   log_call("play_shell_music", 0);
+}
+
+void stop_shell_music(void)
+{
+   log_call("stop_shell_music", 0);
+}
+
+void fadeout_level_music(s16 fadeTimer)
+{
+   log_call("fadeout_level_music", fadeTimer);
+}
+
+void drop_queued_background_music(void)
+{
+   log_call("drop_queued_background_music", 0);
+}
+
+void queue_rumble_data(s16 a0, UNUSED s16 a1)
+{
+   log_call("queue_rumble_data", a0);
+}
+
+void set_camera_mode(UNUSED struct Camera *c, s16 mode, UNUSED s16 frames)
+{
+   log_call("set_camera_mode", mode);
+}
+
+void set_camera_shake_from_hit(s16 shake)
+{
+   log_call("set_camera_shake_from_hit", shake);
+}
+
+s16 level_trigger_warp(UNUSED struct MarioState *m, s32 warpOp)
+{
+   log_call("level_trigger_warp", warpOp);
+   return 0;
+}
+
+u16 level_control_timer(s32 timerOp)
+{
+   log_call("level_control_timer", timerOp);
+   return 0;
+}
+
+u32 save_file_get_flags(void)
+{
+   return sScene.saveFlags;
+}
+
+void save_file_set_flags(u32 flags)
+{
+   sScene.saveFlags |= flags;
+}
+
+void save_file_clear_flags(u32 flags)
+{
+   sScene.saveFlags &= ~flags;
+}
+
+s32 save_file_get_total_star_count(UNUSED s32 fileIndex, UNUSED s32 minCourse, UNUSED s32 maxCourse)
+{
+   return 70;
+}
+
+void save_file_collect_star_or_key(s16 coinScore, UNUSED s16 starIndex)
+{
+   log_call("save_file_collect_star_or_key", coinScore);
+}
+
+void save_file_set_cap_pos(s16 x, UNUSED s16 y, UNUSED s16 z)
+{
+   log_call("save_file_set_cap_pos", x);
+}
+
+struct Object *spawn_object(UNUSED struct Object *parent, s32 model, UNUSED const BehaviorScript *behavior)
+{
+   log_call("spawn_object", model);
+   if (sScene.numSpawned < MAX_SPAWNED) {
+      return &sScene.spawned[sScene.numSpawned++];
+   }
+   return &sScene.spawned[MAX_SPAWNED - 1];
+}
+
+void spawn_default_star(f32 x, UNUSED f32 y, UNUSED f32 z)
+{
+   log_call("spawn_default_star", (s32) x);
+}
+
+void bhv_spawn_star_no_level_exit(u32 params)
+{
+   log_call("bhv_spawn_star_no_level_exit", params);
+}
+
+void obj_set_held_state(struct Object *obj, UNUSED const BehaviorScript *heldBehavior)
+{
+   log_call("obj_set_held_state", obj->oHeldState);
+}
+
+BAD_RETURN(s32) init_bully_collision_data(struct BullyCollisionData *data, f32 posX, f32 posZ,
+                                          f32 forwardVel, s16 yaw, f32 conversionRatio, f32 radius)
+{
+   data->posX = posX;
+   data->posZ = posZ;
+   data->velX = forwardVel * sins(yaw);
+   data->velZ = forwardVel * coss(yaw);
+   data->conversionRatio = conversionRatio;
+   data->radius = radius;
+}
+
+void transfer_bully_speed(struct BullyCollisionData *obj1, struct BullyCollisionData *obj2)
+{
+   obj1->velX = obj2->velX;
+   obj1->velZ = obj2->velZ;
+}
+
+f32 find_floor(UNUSED f32 x, UNUSED f32 y, UNUSED f32 z, struct Surface **pfloor)
+{
+   *pfloor = &sScene.floor;
+   return sScene.mario.floorHeight;
+}
+
+s32 f32_find_wall_collision(UNUSED f32 *xPtr, UNUSED f32 *yPtr, UNUSED f32 *zPtr, UNUSED f32 offsetY,
+                            UNUSED f32 radius)
+{
+   return 0;
+}
+
+struct Surface *resolve_and_return_wall_collisions(UNUSED Vec3f pos, UNUSED f32 offset, UNUSED f32 radius)
+{
+   return NULL;
+}
+
+void *segmented_to_virtual(const void *addr)
+{
+   return (void *) addr;
+}
+
+void *virtual_to_segmented(UNUSED u32 segment, const void *addr)
+{
+   return (void *) addr;
+}
+
+// The loop mario_process_interactions used before the dispatch masks, which tests every
+// handler table entry in order. Kept as the reference the dispatch is checked against.
+static void process_interactions_in_table_order(struct MarioState *m)
+{
+   sDelayInvincTimer = FALSE;
+   sInvulnerable = (m->action & ACT_FLAG_INVULNERABLE) || m->invincTimer != 0;
+
+   if (!(m->action & ACT_FLAG_INTANGIBLE) && m->collidedObjInteractTypes != 0) {
+      s32 i;
+      for (i = 0; i < ARRAY_COUNT(sInteractionHandlers); i++) {
+         u32 interactType = sInteractionHandlers[i].interactType;
+         if (m->collidedObjInteractTypes & interactType) {
+            struct Object *object = mario_get_collided_object(m, interactType);
+
+            m->collidedObjInteractTypes &= ~interactType;
+
+            if (!(object->oInteractStatus & INT_STATUS_INTERACTED)) {
+               if (sInteractionHandlers[i].handler(m, interactType, object)) {
+                  break;
+               }
+            }
+         }
+      }
+   }
+
+   if (m->invincTimer > 0 && !sDelayInvincTimer) {
+      m->invincTimer--;
+   }
+
+   check_kick_or_punch_wall(m);
+   m->flags &= ~MARIO_PUNCHING & ~MARIO_KICKING & ~MARIO_TRIPPING;
+
+   if (!(m->marioObj->collidedObjInteractTypes & (INTERACT_WARP_DOOR | INTERACT_DOOR))) {
+      sDisplayingDoorText = FALSE;
+   }
+   if (!(m->marioObj->collidedObjInteractTypes & INTERACT_WARP)) {
+      sJustTeleported = FALSE;
+   }
+}
+
+// Collision sets like the ones Mario runs into in the levels. Mario collides with at most
+// four objects a frame, see detect_object_collisions in object_collision.c.
+static const struct SetObject sCoinRow[] = {
+   { INTERACT_COIN,       0,  40,  0,  10, 1 },
+   { INTERACT_COIN,       0, -30,  0,  20, 1 },
+   { INTERACT_COIN,       0,  10, 40, -20, 2 },
+   { INTERACT_WATER_RING, 0,   0, 60,  30, 0 },
+};
+
+static const struct SetObject sEnemyCluster[] = {
+   { INTERACT_BOUNCE_TOP, INT_SUBTYPE_TWIRL_BOUNCE,        30, 60,  10, 1 },
+   { INTERACT_DAMAGE,     INT_SUBTYPE_DELAY_INVINCIBILITY, 20, 10, -50, 2 },
+   { INTERACT_KOOPA,      0,                               50,  0,   0, 1 },
+   { INTERACT_BULLY,      0,                              -20,  0, -30, 0 },
+};
+
+static const struct SetObject sEnemiesFromBelow[] = {
+   { INTERACT_HIT_FROM_BELOW, 0,                    0, -60,  0, 1 },
+   { INTERACT_BOUNCE_TOP2,    0,                  -40,   0, 20, 1 },
+   { INTERACT_FLAME,          0,                   10,   0, 10, 1 },
+   { INTERACT_SHOCK,          INT_SUBTYPE_BIG_KNOCKBACK, 0, 20, -20, 1 },
+};
+
+static const struct SetObject sDoorAndSign[] = {
+   { INTERACT_DOOR,        0,                 0,   0, 60, 0 },
+   { INTERACT_WARP_DOOR,   0,                40,   0, 60, 0 },
+   { INTERACT_TEXT,        INT_SUBTYPE_SIGN, -60,  0,  0, 0 },
+   { INTERACT_STAR_OR_KEY, 0,                 0, 100,  0, 0 },
+};
+
+static const struct SetObject sWarps[] = {
+   { INTERACT_WARP,           INT_SUBTYPE_FADING_WARP, 0, 0, -40, 0 },
+   { INTERACT_BBH_ENTRANCE,   0,                      30, 0,   0, 0 },
+   { INTERACT_CANNON_BASE,    0,                     -30, 0,   0, 0 },
+   { INTERACT_IGLOO_BARRIER,  0,                       0, 0,  30, 0 },
+};
+
+static const struct SetObject sGrabAndPole[] = {
+   { INTERACT_GRABBABLE,   INT_SUBTYPE_KICKABLE, 30, 0,  0, 0 },
+   { INTERACT_POLE,        0,                   -30, 0,  0, 0 },
+   { INTERACT_CAP,         0,                     0, 0, 30, 0 },
+   { INTERACT_KOOPA_SHELL, 0,                    20, 0, 20, 0 },
+};
+
+static const struct SetObject sWinds[] = {
+   { INTERACT_TORNADO,       0,  0, 0,   0, 0 },
+   { INTERACT_WHIRLPOOL,     0, 40, 0,   0, 0 },
+   { INTERACT_STRONG_WIND,   0,  0, 0,  40, 0 },
+   { INTERACT_SNUFIT_BULLET, 0, 20, 80, 20, 1 },
+};
+
+static const struct SetObject sOthers[] = {
+   { INTERACT_CLAM_OR_BUBBA, 0,                        0,  0, 40, 2 },
+   { INTERACT_MR_BLIZZARD,   0,                      -40,  0,  0, 1 },
+   { INTERACT_HOOT,          0,                        0, 50,  0, 0 },
+   { INTERACT_BREAKABLE,     INT_SUBTYPE_BIG_KNOCKBACK, -20, 0, -20, 0 },
+};
+
+static const struct CollisionSet sCollisionSets[] = {
+   { "coin row",            sCoinRow,          ARRAY_COUNT(sCoinRow) },
+   { "enemy cluster",       sEnemyCluster,     ARRAY_COUNT(sEnemyCluster) },
+   { "enemies from below",  sEnemiesFromBelow, ARRAY_COUNT(sEnemiesFromBelow) },
+   { "door and sign",       sDoorAndSign,      ARRAY_COUNT(sDoorAndSign) },
+   { "warps",               sWarps,            ARRAY_COUNT(sWarps) },
+   { "grab and pole",       sGrabAndPole,      ARRAY_COUNT(sGrabAndPole) },
+   { "winds",               sWinds,            ARRAY_COUNT(sWinds) },
+   { "others",              sOthers,           ARRAY_COUNT(sOthers) },
+};
+
+// Actions covering the ground, air, water, attacking, holding and intangible cases.
+static const u32 sMarioActions[] = {
+   ACT_IDLE, ACT_WALKING, ACT_JUMP, ACT_FREEFALL, ACT_GROUND_POUND, ACT_PUNCHING, ACT_DIVE,
+   ACT_SLIDE_KICK, ACT_JUMP_KICK, ACT_TWIRLING, ACT_WATER_IDLE, ACT_HOLD_IDLE,
+   ACT_RIDING_SHELL_GROUND, ACT_BUTT_SLIDE, ACT_LONG_JUMP, ACT_IN_CANNON,
+};
+
+static const BehaviorScript *const sBehaviors[] = {
+   NULL, bhvBowser, bhvKoopaShellUnderwater, bhvNormalCap, bhvMetalCap, bhvWingCap, bhvVanishCap,
+};
+
+static u32 random_next(void)
+{
+   sRandomState = sRandomState * 1103515245 + 12345;
+   return sRandomState >> 8;
+}
+
+static f32 random_range(f32 range)
+{
+   return ((random_next() & 0xFFFF) / 32767.5f - 1.0f) * range;
+}
+
+static void init_scene_mario(u32 action)
+{
+   struct MarioState *m = &sScene.mario;
+
+   m->marioObj = &sScene.marioObj;
+   m->marioBodyState = &sScene.bodyState;
+   m->area = &sScene.area;
+   m->area->camera = &sScene.camera;
+   m->floor = &sScene.floor;
+   // The object Mario last used, which interact_hoot reads the release time of.
+   m->usedObj = &sScene.usedObj;
+   m->usedObj->oHootMarioReleaseTime = gGlobalTimer - (random_next() & 63);
+   m->action = action;
+   m->flags = MARIO_NORMAL_CAP | MARIO_CAP_ON_HEAD;
+   m->health = 0x880;
+   m->numLives = 4;
+   m->pos[0] = random_range(1000.0f);
+   m->pos[1] = random_range(500.0f);
+   m->pos[2] = random_range(1000.0f);
+   m->floorHeight = m->pos[1] - (random_next() & 1) * 100.0f;
+   m->vel[1] = random_range(50.0f);
+   m->forwardVel = random_range(60.0f);
+   m->faceAngle[1] = (s16) random_next();
+   m->input = random_next() & 0xFFFF;
+   m->invincTimer = (random_next() & 3) == 0 ? 30 : 0;
+   if ((random_next() & 3) == 0) {
+      m->flags |= MARIO_VANISH_CAP << (random_next() % 3);
+   }
+   if ((random_next() & 3) == 0) {
+      m->flags |= MARIO_PUNCHING << (random_next() % 3);
+   }
+
+   sScene.marioObj.hitboxRadius = 37.0f;
+   sScene.marioObj.hitboxHeight = 160.0f;
+   sScene.floor.type = random_next() % 0x30;
+   sScene.area.camera->defMode = 1;
+   sScene.courseNum = 1 + random_next() % 15;
+   sScene.saveFlags = random_next();
+}
+
+static void add_object(s32 interactType, u32 subtype, f32 dx, f32 dy, f32 dz, s32 value)
+{
+   struct MarioState *m = &sScene.mario;
+   struct Object *obj;
+
+   if (m->marioObj->numCollidedObjs >= MAX_OBJECTS) {
+      return;
+   }
+
+   obj = &sScene.objects[m->marioObj->numCollidedObjs];
+   obj->oInteractType = interactType;
+   obj->oInteractionSubtype = subtype;
+   obj->oDamageOrCoinValue = value;
+   obj->oPosX = m->pos[0] + dx;
+   obj->oPosY = m->pos[1] + dy;
+   obj->oPosZ = m->pos[2] + dz;
+   obj->oMoveAngleYaw = (s16) random_next();
+   obj->hitboxRadius = 50.0f + (random_next() & 63);
+   obj->hitboxHeight = 50.0f + (random_next() & 127);
+   obj->hurtboxRadius = obj->hitboxRadius;
+   obj->hurtboxHeight = obj->hitboxHeight;
+   obj->behavior = sBehaviors[random_next() % ARRAY_COUNT(sBehaviors)];
+   if ((random_next() & 7) == 0) {
+      obj->oInteractStatus = INT_STATUS_INTERACTED;
+   }
+
+   m->marioObj->collidedObjs[m->marioObj->numCollidedObjs++] = obj;
+   m->collidedObjInteractTypes |= interactType;
+   m->marioObj->collidedObjInteractTypes |= interactType;
+}
+
+static void load_scene(const struct Scene *scene)
+{
+   sScene = *scene;
+   gMarioState = &sScene.mario;
+   gHudDisplay = sScene.hud;
+   gCurrCourseNum = sScene.courseNum;
+   sDelayInvincTimer = sScene.delayInvincTimer;
+   sInvulnerable = sScene.invulnerable;
+   sDisplayingDoorText = sScene.displayingDoorText;
+   sJustTeleported = sScene.justTeleported;
+   sPssSlideStarted = sScene.pssSlideStarted;
+}
+
+static void save_scene(struct Scene *scene)
+{
+   sScene.hud = gHudDisplay;
+   sScene.courseNum = gCurrCourseNum;
+   sScene.delayInvincTimer = sDelayInvincTimer;
+   sScene.invulnerable = sInvulnerable;
+   sScene.displayingDoorText = sDisplayingDoorText;
+   sScene.justTeleported = sJustTeleported;
+   sScene.pssSlideStarted = sPssSlideStarted;
+   *scene = sScene;
+}
+
+// Replay the scene in sScene through both loops and compare everything they changed.
+static void verify_scene(verify_state *state, const char *name)
+{
+   static struct Scene start, dispatched, scanned;
+
+   save_scene(&start);
+
+   mario_process_interactions(&sScene.mario);
+   save_scene(&dispatched);
+
+   load_scene(&start);
+   process_interactions_in_table_order(&sScene.mario);
+   save_scene(&scanned);
+
+   if (memcmp(&dispatched, &scanned, sizeof(struct Scene)) != 0) {
+      if (state->mismatches < 20) {
+         printf("Mismatch: %s, action 0x%08X, interact types 0x%08X: %d vs %d calls, action 0x%08X vs 0x%08X\n",
+                name, start.mario.action, start.mario.collidedObjInteractTypes, dispatched.numCalls,
+                scanned.numCalls, dispatched.mario.action, scanned.mario.action);
+      }
+      state->mismatches++;
+   }
+
+   state->calls += scanned.numCalls;
+   state->cases++;
+}
+
+static void verify_collision_set(verify_state *state, const struct CollisionSet *set)
+{
+   u32 a, i;
+
+   for (a = 0; a < ARRAY_COUNT(sMarioActions); a++) {
+      memset(&sScene, 0, sizeof(sScene));
+      init_scene_mario(sMarioActions[a]);
+      for (i = 0; i < (u32) set->numObjects; i++) {
+         add_object(set->objects[i].interactType, set->objects[i].interactionSubtype,
+                    set->objects[i].dx, set->objects[i].dy, set->objects[i].dz,
+                    set->objects[i].damageOrCoinValue);
+      }
+      load_scene(&sScene);
+      verify_scene(state, set->name);
+   }
+}
+
+// A random set of up to four objects of any interact type.
+static void verify_random_set(verify_state *state)
+{
+   s32 count = 1 + random_next() % MAX_OBJECTS;
+   s32 i;
+
+   memset(&sScene, 0, sizeof(sScene));
+   init_scene_mario(sMarioActions[random_next() % ARRAY_COUNT(sMarioActions)]);
+   for (i = 0; i < count; i++) {
+      add_object(sInteractionHandlers[random_next() % ARRAY_COUNT(sInteractionHandlers)].interactType,
+                 random_next() & 0xFFFF, random_range(100.0f), random_range(150.0f), random_range(100.0f),
+                 random_next() % 4);
+   }
+   load_scene(&sScene);
+   verify_scene(state, "random set");
+}
+
+static void print_usage(void)
+{
+   fprintf(stderr,
+         "Usage: interactverify [-n CASES]\n"
+         "\n"
+         "interactverify v" INTERACTVERIFY_VERSION ": replay collision sets through the interaction\n"
+         "dispatch of mario_process_interactions in src/game/interaction.c and through a scan of\n"
+         "the whole handler table, and check that both have the same outcome\n"
+         "\n"
+         "Optional arguments:\n"
+         " -n CASES random collision sets to replay (default: %d)\n",
+         DEFAULT_CASES);
+}
+
+int main(int argc, char *argv[])
+{
+   verify_state state;
+   long cases = DEFAULT_CASES;
+   long n;
+   u32 i;
+
+   for (i = 1; i < (u32) argc; i++) {
+      if (argv[i][0] == '-' && argv[i][1] == 'n' && i + 1 < (u32) argc) {
+         cases = strtol(argv[++i], NULL, 0);
+      } else {
+         print_usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (cases < 0) {
+      print_usage();
+      return EXIT_FAILURE;
+   }
+
+   memset(&state, 0, sizeof(state));
+
+   for (i = 0; i < ARRAY_COUNT(sCollisionSets); i++) {
+      verify_collision_set(&state, &sCollisionSets[i]);
+   }
+   for (n = 0; n < cases; n++) {
+      verify_random_set(&state);
+   }
+
+   printf("%ld collision sets replayed, %ld calls from the handlers compared, %ld mismatches\n",
+          state.cases, state.calls, state.mismatches);
+
+   return state.mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
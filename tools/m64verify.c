@@ -0,0 +1,447 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ultra64.h>
+#include "internal.h"
+#include "heap.h"
+#include "load.h"
+#include "seqdecode.h"
+
+// utils.h has its own versions of these
+#undef MIN
+#undef MAX
+#undef ALIGN
+#include "utils.h"
+
+#define M64VERIFY_VERSION "0.1"
+
+#define DEFAULT_MAX_STEPS 4096
+
+// Layer script position, followed command by command to stop before a call to the real
+// interpreter that would overflow the layer's call stack, read past the sequence or never return.
+typedef struct
+{
+   int enabled;
+   int depth;
+   unsigned int pc;            // byte offset of the next command
+   unsigned int stack[4];      // byte offsets
+   unsigned char remLoopIters[4];
+} script_model;
+
+typedef struct
+{
+   unsigned char *data;
+   unsigned int length;
+   int max_steps;
+   long entries;
+   long translated;
+   long commands;
+   long writes;
+   long mismatches;
+} verify_state;
+
+// Defined in seqplayer.c without a header declaration.
+void seq_channel_layer_process_script(struct SequenceChannelLayer *layer);
+
+// Stand-ins for the parts of the audio engine seqplayer.c uses. Layers never get a note, and
+// bank 0 has one instrument so layer_setinstr and notes find it.
+struct SequencePlayer gSequencePlayers[SEQUENCE_PLAYERS];
+struct SequenceChannel gSequenceChannels[SEQUENCE_CHANNELS];
+struct SequenceChannelLayer gSequenceLayers[SEQUENCE_LAYERS];
+struct SequenceChannel gSequenceChannelNone;
+struct AudioListItem gLayerFreeList;
+struct SoundMultiPool gBankLoadedPool;
+struct CtlEntry *gCtlEntries;
+struct AdsrEnvelope gDefaultEnvelope[3];
+u8 gDefaultShortNoteVelocityTable[16];
+u8 gDefaultShortNoteDurationTable[16];
+f32 gNoteFrequencies[128];
+f32 gPitchBendFrequencyScale[256];
+u8 gBankLoadStatus[64];
+u8 gSeqLoadStatus[256];
+ALSeqFile *gAlTbl;
+u8 *gAlBankSets;
+s32 gAudioErrorFlags;
+s8 gAudioUpdatesPerFrame = 4;
+s16 gTempoInternalToExternal = 0x2580;
+
+struct Note *alloc_note(UNUSED struct SequenceChannelLayer *seqLayer)
+{
+   return NULL;
+}
+
+void seq_channel_layer_note_decay(UNUSED struct SequenceChannelLayer *seqLayer) { }
+void init_synthetic_wave(UNUSED struct Note *note, UNUSED struct SequenceChannelLayer *seqLayer) { }
+void note_vibrato_init(UNUSED struct Note *note) { }
+void init_note_lists(UNUSED struct NotePool *pool) { }
+void note_pool_clear(UNUSED struct NotePool *pool) { }
+void note_pool_fill(UNUSED struct NotePool *pool, UNUSED s32 count) { }
+void process_notes(void) { }
+void reclaim_notes(void) { }
+void sequence_player_process_sound(UNUSED struct SequencePlayer *seqPlayer) { }
+void patch_audio_bank(UNUSED struct AudioBank *mem, UNUSED u8 *offset, UNUSED u32 numInstruments,
+                      UNUSED u32 numDrums) { }
+void osCreateMesgQueue(UNUSED OSMesgQueue *mq, UNUSED OSMesg *msg, UNUSED s32 count) { }
+void audio_dma_partial_copy_async(UNUSED uintptr_t *devAddr, UNUSED u8 **vAddr, UNUSED ssize_t *remaining,
+                                  UNUSED OSMesgQueue *queue, UNUSED OSIoMesg *mesg) { }
+
+void *get_bank_or_seq(UNUSED struct SoundMultiPool *arg0, UNUSED s32 arg1, UNUSED s32 id)
+{
+   return NULL;
+}
+
+static struct Instrument sInstrument;
+static struct Instrument *sInstruments[1] = { &sInstrument };
+static struct CtlEntry sCtlEntry;
+static u8 sVelocityTable[16];
+static u8 sDurationTable[16];
+
+// Each entry point runs on one layer reading bytes and one running predecoded ops.
+static struct SequencePlayer sPlayer;
+static struct SequenceChannel sChannel;
+static struct SequenceChannelLayer sByteLayer;
+static struct SequenceChannelLayer sOpLayer;
+
+static void print_usage(void)
+{
+   ERROR("Usage: m64verify [-e OFFSET] [-s STEPS] [-v] SEQUENCE.m64\n"
+         "\n"
+         "m64verify v" M64VERIFY_VERSION ": check predecoded layer scripts (M64PREDECODE=1) against the byte interpreter\n"
+         "\n"
+         "Optional arguments:\n"
+         " -e OFFSET    only check the layer script at OFFSET (default: try every offset)\n"
+         " -s STEPS     commands to replay per entry point (default: %d)\n"
+         " -v           verbose progress output\n"
+         "\n"
+         "File arguments:\n"
+         " SEQUENCE.m64 assembled sequence\n",
+         DEFAULT_MAX_STEPS);
+}
+
+static void audio_init(void)
+{
+   int i;
+
+   for (i = 0; i < 128; i++) {
+      gNoteFrequencies[i] = 0.25f + i / 32.0f;
+   }
+   for (i = 0; i < 16; i++) {
+      sVelocityTable[i] = 0x10 + i * 7;
+      sDurationTable[i] = 0x80 - i * 5;
+   }
+
+   sInstrument.loaded = 1;
+   sInstrument.normalRangeLo = 0x30;
+   sInstrument.normalRangeHi = 0x50;
+   sInstrument.releaseRate = 0x20;
+   sInstrument.envelope = &gDefaultEnvelope[0];
+   sInstrument.lowNotesSound.tuning = 0.5f;
+   sInstrument.normalNotesSound.tuning = 1.0f;
+   sInstrument.highNotesSound.tuning = 2.0f;
+   sCtlEntry.numInstruments = 1;
+   sCtlEntry.instruments = sInstruments;
+   gCtlEntries = &sCtlEntry;
+   gBankLoadedPool.persistent.pool.start = (u8 *) &sInstrument;
+   gBankLoadedPool.persistent.pool.size = sizeof(sInstrument);
+
+   sPlayer.enabled = TRUE;
+   sPlayer.tempo = 120 * 48;
+   sPlayer.transposition = 1;
+   sPlayer.shortNoteVelocityTable = sVelocityTable;
+   sPlayer.shortNoteDurationTable = sDurationTable;
+
+   sChannel.enabled = TRUE;
+   sChannel.hasInstrument = TRUE;
+   sChannel.instOrWave = 1;
+   sChannel.instrument = &sInstrument;
+   sChannel.transposition = 2;
+   sChannel.seqPlayer = &sPlayer;
+}
+
+// set up a layer the way seq_channel_set_layer and the channel's setlayer command do
+static void layer_init(struct SequenceChannelLayer *layer, u8 *pc, struct M64LayerOp *op)
+{
+   memset(layer, 0, sizeof(*layer));
+   layer->enabled = TRUE;
+   layer->seqChannel = &sChannel;
+   layer->noteDuration = 0x80;
+   layer->freqScale = 1.0f;
+   layer->velocitySquare = 0.0f;
+   layer->pan = 0.5f;
+   layer->scriptState.pc = pc;
+   layer->op = op;
+}
+
+static void model_init(script_model *m, unsigned int offset)
+{
+   memset(m, 0, sizeof(*m));
+   m->enabled = 1;
+   m->pc = offset;
+}
+
+// follow the commands the next seq_channel_layer_process_script call reads, up to its note or
+// delay; fails where the game would overflow, read past the sequence or loop forever
+static int model_call(verify_state *state, script_model *m, int largeNotes, int *steps)
+{
+   struct M64LayerOp cmd;
+
+   for (;;) {
+      if (++*steps > state->max_steps) {
+         return -1;
+      }
+      if (m64_decode_layer_op(&cmd, state->data, state->length, m->pc, largeNotes) != 0) {
+         return -1;
+      }
+      m->pc += cmd.len & M64_OP_LEN_MASK;
+      state->commands++;
+
+      switch (cmd.cmd) {
+         case 0xff:
+            if (m->depth == 0) {
+               m->enabled = 0;
+               return 0;
+            }
+            m->pc = m->stack[--m->depth];
+            break;
+         case 0xfc:
+            if (m->depth >= 4) {
+               return -1;
+            }
+            m->stack[m->depth++] = m->pc;
+            m->pc = cmd.value;
+            break;
+         case 0xf8:
+            if (m->depth >= 4) {
+               return -1;
+            }
+            m->remLoopIters[m->depth] = cmd.arg0;
+            m->stack[m->depth++] = m->pc;
+            break;
+         case 0xf7:
+            if (m->depth == 0) {
+               return -1;
+            }
+            if (--m->remLoopIters[m->depth - 1] != 0) {
+               m->pc = m->stack[m->depth - 1];
+            } else {
+               m->depth--;
+            }
+            break;
+         case 0xfb:
+            m->pc = cmd.value;
+            break;
+         default:
+            if (cmd.cmd <= 0xc0) {
+               return 0;
+            }
+            break;
+      }
+   }
+}
+
+// Copy a layer with its script position as byte pointers, whether it runs bytes or ops.
+static void layer_position(struct SequenceChannelLayer *dst, const struct SequenceChannelLayer *src,
+                           u8 *data)
+{
+   int i;
+
+   memcpy(dst, src, sizeof(*dst));
+   if (dst->op != NULL) {
+      dst->scriptState.pc = data + dst->op->offset;
+      for (i = 0; i < dst->scriptState.depth; i++) {
+         dst->scriptState.stack[i] = data + ((struct M64LayerOp *) dst->scriptState.stack[i])->offset;
+      }
+      dst->op = NULL;
+   }
+   // popped entries are dead
+   for (i = dst->scriptState.depth; i < 4; i++) {
+      dst->scriptState.stack[i] = NULL;
+      dst->scriptState.remLoopIters[i] = 0;
+   }
+}
+
+static int compare(verify_state *state, unsigned int entry, int largeNotes, int call,
+                   const script_model *m)
+{
+   struct SequenceChannelLayer ref, dec;
+
+   layer_position(&ref, &sByteLayer, state->data);
+   layer_position(&dec, &sOpLayer, state->data);
+   // an ended layer is left where it was by the ops and after its layer_end by the bytes
+   if (!ref.enabled && !dec.enabled) {
+      dec.scriptState.pc = ref.scriptState.pc;
+   }
+   if (memcmp(&ref, &dec, sizeof(ref)) == 0
+       && (!ref.enabled || ref.scriptState.pc == state->data + m->pc)) {
+      return 0;
+   }
+   ERROR("Mismatch: entry 0x%04X largeNotes %d after %d calls: pc 0x%04X vs 0x%04X, depth %d vs %d, delay %d vs %d\n",
+         entry, largeNotes, call, (unsigned int)(ref.scriptState.pc - state->data),
+         (unsigned int)(dec.scriptState.pc - state->data), ref.scriptState.depth,
+         dec.scriptState.depth, ref.delay, dec.delay);
+   state->mismatches++;
+   return -1;
+}
+
+// simulate chan_writeseq on every operand byte of the entry's ops and check the table follows the data
+static void check_writes(verify_state *state, struct M64LayerOpTable *table, unsigned int first)
+{
+   unsigned int i, b;
+
+   for (i = first; i < table->count && !table->stale; i++) {
+      struct M64LayerOp *op = &table->ops[i];
+      unsigned int len = op->len & M64_OP_LEN_MASK;
+      for (b = 1; b < len && !table->stale; b++) {
+         unsigned int offset = op->offset + b;
+         unsigned char saved = state->data[offset];
+         struct M64LayerOp decoded;
+
+         state->data[offset] = saved + 1;
+         m64_layer_ops_write(table, offset);
+         if (!table->stale) {
+            m64_decode_layer_op(&decoded, state->data, state->length, op->offset, op->len & M64_OP_LARGE_NOTES);
+            if (decoded.cmd != op->cmd || decoded.len != op->len || decoded.arg0 != op->arg0
+                || decoded.arg1 != op->arg1 || decoded.value != op->value) {
+               ERROR("Mismatch: write to 0x%04X not applied to op at 0x%04X\n", offset, op->offset);
+               state->mismatches++;
+            }
+         }
+         state->data[offset] = saved;
+         if (!table->stale) {
+            m64_layer_ops_write(table, offset);
+         }
+         state->writes++;
+      }
+   }
+}
+
+static void verify_entry(verify_state *state, struct M64LayerOpTable *table, unsigned int entry, int largeNotes)
+{
+   script_model m;
+   struct M64LayerOp *op;
+   unsigned int first = table->count;
+   int steps = 0;
+   int call;
+
+   state->entries++;
+   if (table->full) {
+      m64_layer_ops_init(table, table->ops, table->index, table->capacity, state->data, state->length);
+      first = 0;
+   }
+   // as seq_channel_layer_start_ops does when a channel starts the layer
+   op = m64_layer_ops_translate(table, entry, largeNotes);
+   if (op == NULL) {
+      return;
+   }
+   state->translated++;
+
+   sChannel.largeNotes = largeNotes;
+   layer_init(&sByteLayer, state->data + entry, NULL);
+   layer_init(&sOpLayer, state->data + entry, op);
+   model_init(&m, entry);
+   for (call = 1; m.enabled; call++) {
+      // garbage entry points may overflow the call stack; the game would too, so stop there
+      if (model_call(state, &m, largeNotes, &steps) != 0) {
+         break;
+      }
+      sByteLayer.delay = 0;
+      sOpLayer.delay = 0;
+      seq_channel_layer_process_script(&sByteLayer);
+      seq_channel_layer_process_script(&sOpLayer);
+      if (compare(state, entry, largeNotes, call, &m) != 0) {
+         return;
+      }
+   }
+
+   check_writes(state, table, first);
+   if (table->stale) {
+      m64_layer_ops_init(table, table->ops, table->index, table->capacity, state->data, state->length);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   verify_state state;
+   struct M64LayerOpTable *table = &sPlayer.layerOps;
+   struct M64LayerOp *ops;
+   u16 *op_index;
+   long entry = -1;
+   long length;
+   unsigned int offset;
+   int largeNotes;
+   int i;
+
+   memset(&state, 0, sizeof(state));
+   state.max_steps = DEFAULT_MAX_STEPS;
+
+   for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+      switch (argv[i][1]) {
+         case 'e':
+            if (++i >= argc) {
+               print_usage();
+               return EXIT_FAILURE;
+            }
+            entry = strtol(argv[i], NULL, 0);
+            break;
+         case 's':
+            if (++i >= argc) {
+               print_usage();
+               return EXIT_FAILURE;
+            }
+            state.max_steps = strtol(argv[i], NULL, 0);
+            break;
+         case 'v':
+            g_verbosity = 1;
+            break;
+         default:
+            print_usage();
+            return EXIT_FAILURE;
+      }
+   }
+   if (i != argc - 1) {
+      print_usage();
+      return EXIT_FAILURE;
+   }
+
+   length = read_file(argv[i], &state.data);
+   if (length < 0) {
+      ERROR("Error reading sequence \"%s\"\n", argv[i]);
+      return EXIT_FAILURE;
+   }
+   if (length > 0x10000) {
+      ERROR("Sequence \"%s\" is larger than 64 KiB\n", argv[i]);
+      return EXIT_FAILURE;
+   }
+   state.length = length;
+   audio_init();
+   sPlayer.seqData = state.data;
+
+   ops = malloc(M64_LAYER_OPS_PER_PLAYER * sizeof(*ops));
+   op_index = malloc(M64_LAYER_OPS_PER_PLAYER * sizeof(*op_index));
+   if (!ops || !op_index) {
+      ERROR("Out of memory\n");
+      return EXIT_FAILURE;
+   }
+
+   for (largeNotes = 0; largeNotes <= 1; largeNotes++) {
+      m64_layer_ops_init(table, ops, op_index, M64_LAYER_OPS_PER_PLAYER, state.data, state.length);
+      if (entry >= 0) {
+         verify_entry(&state, table, entry, largeNotes);
+      } else {
+         for (offset = 0; offset < state.length; offset++) {
+            verify_entry(&state, table, offset, largeNotes);
+         }
+      }
+      INFO("largeNotes %d: %ld of %ld entry points translated\n", largeNotes, state.translated, state.entries);
+   }
+
+   printf("%ld entry points, %ld translated, %ld commands and %ld writes compared, %ld mismatches\n",
+          state.entries, state.translated, state.commands, state.writes, state.mismatches);
+
+   free(ops);
+   free(op_index);
+   free(state.data);
+
+   return state.mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
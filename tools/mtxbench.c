@@ -0,0 +1,456 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ultra64.h>
+#include "math_util.h"
+
+#define MTXBENCH_VERSION "0.1"
+
+#define DEFAULT_ITERATIONS 5000000
+#define SAMPLES 1024
+
+// Inputs for the checks and the timed loops.
+static Mat4 g_parents[SAMPLES];
+static Mat4 g_locals[SAMPLES];
+static Vec3f g_translations[SAMPLES];
+static Vec3s g_rotations[SAMPLES];
+static Vec3s g_points[SAMPLES];
+
+// Written by every timed loop so the calls can't be optimized away.
+static volatile f32 g_sink_f;
+static volatile s32 g_sink_s;
+
+// math_util.c uses these, but none of the kernels checked here do.
+Vec3f gVec3fZero = { 0.0f, 0.0f, 0.0f };
+
+struct Surface;
+f32 find_floor(UNUSED f32 x, UNUSED f32 y, UNUSED f32 z, struct Surface **floor)
+{
+   *floor = NULL;
+   return -11000.0f;
+}
+
+// The libultra version, which math_util.c calls for mtxf_to_mtx with AVOID_UB.
+void guMtxF2L(float mf[4][4], Mtx *m)
+{
+   s32 *ai = (s32 *) &m->m[0][0];
+   s32 *af = (s32 *) &m->m[2][0];
+   s32 e1, e2;
+   int i, j;
+
+   for (i = 0; i < 4; i++) {
+      for (j = 0; j < 2; j++) {
+         e1 = (s32)(mf[i][j * 2] * 65536.0f);
+         e2 = (s32)(mf[i][j * 2 + 1] * 65536.0f);
+         *(ai++) = (e1 & 0xFFFF0000) | ((e2 >> 16) & 0xFFFF);
+         *(af++) = ((e1 << 16) & 0xFFFF0000) | (e2 & 0xFFFF);
+      }
+   }
+}
+
+static void print_usage(void)
+{
+   fprintf(stderr,
+         "Usage: mtxbench [-n ITERATIONS]\n"
+         "\n"
+         "mtxbench v" MTXBENCH_VERSION ": check the fused matrix kernels in src/engine/math_util.c against the\n"
+         "rotate, multiply and convert sequence they replace, and time both\n"
+         "\n"
+         "Optional arguments:\n"
+         " -n ITERATIONS calls per kernel for the timings (default: %d)\n",
+         DEFAULT_ITERATIONS);
+}
+
+// mtxf_mul as it was before the fused kernels.
+static void mtxf_mul_old(Mat4 dest, Mat4 a, Mat4 b)
+{
+   Mat4 temp;
+   register f32 entry0;
+   register f32 entry1;
+   register f32 entry2;
+
+   // column 0
+   entry0 = a[0][0];
+   entry1 = a[0][1];
+   entry2 = a[0][2];
+   temp[0][0] = entry0 * b[0][0] + entry1 * b[1][0] + entry2 * b[2][0];
+   temp[0][1] = entry0 * b[0][1] + entry1 * b[1][1] + entry2 * b[2][1];
+   temp[0][2] = entry0 * b[0][2] + entry1 * b[1][2] + entry2 * b[2][2];
+
+   // column 1
+   entry0 = a[1][0];
+   entry1 = a[1][1];
+   entry2 = a[1][2];
+   temp[1][0] = entry0 * b[0][0] + entry1 * b[1][0] + entry2 * b[2][0];
+   temp[1][1] = entry0 * b[0][1] + entry1 * b[1][1] + entry2 * b[2][1];
+   temp[1][2] = entry0 * b[0][2] + entry1 * b[1][2] + entry2 * b[2][2];
+
+   // column 2
+   entry0 = a[2][0];
+   entry1 = a[2][1];
+   entry2 = a[2][2];
+   temp[2][0] = entry0 * b[0][0] + entry1 * b[1][0] + entry2 * b[2][0];
+   temp[2][1] = entry0 * b[0][1] + entry1 * b[1][1] + entry2 * b[2][1];
+   temp[2][2] = entry0 * b[0][2] + entry1 * b[1][2] + entry2 * b[2][2];
+
+   // column 3
+   entry0 = a[3][0];
+   entry1 = a[3][1];
+   entry2 = a[3][2];
+   temp[3][0] = entry0 * b[0][0] + entry1 * b[1][0] + entry2 * b[2][0] + b[3][0];
+   temp[3][1] = entry0 * b[0][1] + entry1 * b[1][1] + entry2 * b[2][1] + b[3][1];
+   temp[3][2] = entry0 * b[0][2] + entry1 * b[1][2] + entry2 * b[2][2] + b[3][2];
+
+   temp[0][3] = temp[1][3] = temp[2][3] = 0;
+   temp[3][3] = 1;
+
+   mtxf_copy(dest, temp);
+}
+
+// mtxf_mul_vec3s as it was before it was fused.
+static void mtxf_mul_vec3s_old(Mat4 mtx, Vec3s b)
+{
+   register f32 x = b[0];
+   register f32 y = b[1];
+   register f32 z = b[2];
+
+   b[0] = x * mtx[0][0] + y * mtx[1][0] + z * mtx[2][0] + mtx[3][0];
+   b[1] = x * mtx[0][1] + y * mtx[1][1] + z * mtx[2][1] + mtx[3][1];
+   b[2] = x * mtx[0][2] + y * mtx[1][2] + z * mtx[2][2] + mtx[3][2];
+}
+
+// The sequences the graph nodes used before the fused kernels.
+static void rotate_zxy_mul_old(Mtx *fixed, Mat4 dest, Vec3f translate, Vec3s rotate, Mat4 parent)
+{
+   Mat4 local;
+
+   mtxf_rotate_zxy_and_translate(local, translate, rotate);
+   mtxf_mul_old(dest, local, parent);
+   mtxf_to_mtx(fixed, dest);
+}
+
+static void rotate_xyz_mul_old(Mtx *fixed, Mat4 dest, Vec3f translate, Vec3s rotate, Mat4 parent)
+{
+   Mat4 local;
+
+   mtxf_rotate_xyz_and_translate(local, translate, rotate);
+   mtxf_mul_old(dest, local, parent);
+   mtxf_to_mtx(fixed, dest);
+}
+
+static void mul_to_mtx_old(Mtx *fixed, Mat4 dest, Mat4 a, Mat4 b)
+{
+   mtxf_mul_old(dest, a, b);
+   mtxf_to_mtx(fixed, dest);
+}
+
+static unsigned int g_seed = 12345;
+
+static f32 random_f32(f32 range)
+{
+   g_seed = g_seed * 1103515245 + 12345;
+   return ((f32)(g_seed >> 8) / (1 << 24) * 2 - 1) * range;
+}
+
+static s16 random_s16(void)
+{
+   g_seed = g_seed * 1103515245 + 12345;
+   return (s16)(g_seed >> 8);
+}
+
+// A transformation matrix like the ones on the graph node matrix stack: a rotation,
+// a scale and a translation. The entries stay well inside the range of Mtx.
+static void random_transform(Mat4 mtx)
+{
+   Vec3f translate;
+   Vec3s rotate;
+   Vec3f scale;
+
+   translate[0] = random_f32(8000.0f);
+   translate[1] = random_f32(8000.0f);
+   translate[2] = random_f32(8000.0f);
+   rotate[0] = random_s16();
+   rotate[1] = random_s16();
+   rotate[2] = random_s16();
+   scale[0] = 0.1f + random_f32(1.0f) * random_f32(1.0f) + 1.0f;
+   scale[1] = 0.1f + random_f32(1.0f) * random_f32(1.0f) + 1.0f;
+   scale[2] = 0.1f + random_f32(1.0f) * random_f32(1.0f) + 1.0f;
+
+   mtxf_rotate_zxy_and_translate(mtx, translate, rotate);
+   mtxf_scale_vec3f(mtx, mtx, scale);
+}
+
+static void make_inputs(void)
+{
+   int i;
+
+   for (i = 0; i < SAMPLES; i++) {
+      random_transform(g_parents[i]);
+      random_transform(g_locals[i]);
+      g_translations[i][0] = random_f32(2000.0f);
+      g_translations[i][1] = random_f32(2000.0f);
+      g_translations[i][2] = random_f32(2000.0f);
+      g_rotations[i][0] = random_s16();
+      g_rotations[i][1] = random_s16();
+      g_rotations[i][2] = random_s16();
+      // Small enough that the result still fits in a Vec3s.
+      g_points[i][0] = random_s16() / 16;
+      g_points[i][1] = random_s16() / 16;
+      g_points[i][2] = random_s16() / 16;
+   }
+   // An identity parent and local matrix, and a point at the origin.
+   mtxf_identity(g_parents[0]);
+   mtxf_identity(g_locals[1]);
+   vec3s_set(g_points[2], 0, 0, 0);
+}
+
+typedef void (*fused_func)(Mtx *, Mat4, Vec3f, Vec3s, Mat4);
+
+static long check_rotate_mul(const char *name, fused_func fused, fused_func old)
+{
+   Mat4 dest1;
+   Mat4 dest2;
+   Mtx fixed1;
+   Mtx fixed2;
+   long mismatches = 0;
+   int i;
+
+   for (i = 0; i < SAMPLES; i++) {
+      fused(&fixed1, dest1, g_translations[i], g_rotations[i], g_parents[i]);
+      old(&fixed2, dest2, g_translations[i], g_rotations[i], g_parents[i]);
+      if (memcmp(dest1, dest2, sizeof(Mat4)) != 0 || memcmp(&fixed1, &fixed2, sizeof(Mtx)) != 0) {
+         mismatches++;
+      }
+      // Without the fixed point matrix.
+      fused(NULL, dest1, g_translations[i], g_rotations[i], g_parents[i]);
+      if (memcmp(dest1, dest2, sizeof(Mat4)) != 0) {
+         mismatches++;
+      }
+   }
+   if (mismatches != 0) {
+      printf("%s: %ld of %d results differ from the old version\n", name, mismatches, SAMPLES * 2);
+   }
+   return mismatches;
+}
+
+static long check_mul(void)
+{
+   Mat4 dest1;
+   Mat4 dest2;
+   Mtx fixed1;
+   Mtx fixed2;
+   long mismatches = 0;
+   int i;
+
+   for (i = 0; i < SAMPLES; i++) {
+      mtxf_mul_to_mtx(&fixed1, dest1, g_locals[i], g_parents[i]);
+      mul_to_mtx_old(&fixed2, dest2, g_locals[i], g_parents[i]);
+      if (memcmp(dest1, dest2, sizeof(Mat4)) != 0 || memcmp(&fixed1, &fixed2, sizeof(Mtx)) != 0) {
+         mismatches++;
+      }
+
+      mtxf_mul(dest1, g_locals[i], g_parents[i]);
+      if (memcmp(dest1, dest2, sizeof(Mat4)) != 0) {
+         mismatches++;
+      }
+
+      // The destination may be either operand.
+      mtxf_copy(dest1, g_locals[i]);
+      mtxf_mul(dest1, dest1, g_parents[i]);
+      if (memcmp(dest1, dest2, sizeof(Mat4)) != 0) {
+         mismatches++;
+      }
+      mtxf_copy(dest1, g_parents[i]);
+      mtxf_mul(dest1, g_locals[i], dest1);
+      if (memcmp(dest1, dest2, sizeof(Mat4)) != 0) {
+         mismatches++;
+      }
+   }
+   if (mismatches != 0) {
+      printf("mtxf_mul: %ld of %d results differ from the old version\n", mismatches, SAMPLES * 4);
+   }
+   return mismatches;
+}
+
+static long check_mul_vec3s(void)
+{
+   Vec3s point1;
+   Vec3s point2;
+   long mismatches = 0;
+   int i;
+
+   for (i = 0; i < SAMPLES; i++) {
+      vec3s_copy(point1, g_points[i]);
+      vec3s_copy(point2, g_points[i]);
+      mtxf_mul_vec3s(g_locals[i], point1);
+      mtxf_mul_vec3s_old(g_locals[i], point2);
+      if (memcmp(point1, point2, sizeof(Vec3s)) != 0) {
+         mismatches++;
+      }
+   }
+   if (mismatches != 0) {
+      printf("mtxf_mul_vec3s: %ld of %d results differ from the old version\n", mismatches, SAMPLES);
+   }
+   return mismatches;
+}
+
+static double seconds(clock_t start)
+{
+   return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void time_rotate_mul(const char *name, fused_func fused, fused_func old, long iterations)
+{
+   Mat4 dest;
+   Mtx fixed;
+   clock_t start;
+   double oldTime;
+   double newTime;
+   f32 sum = 0;
+   long i;
+
+   start = clock();
+   for (i = 0; i < iterations; i++) {
+      long p = i % SAMPLES;
+      old(&fixed, dest, g_translations[p], g_rotations[p], g_parents[p]);
+      sum += dest[3][0];
+   }
+   oldTime = seconds(start);
+
+   start = clock();
+   for (i = 0; i < iterations; i++) {
+      long p = i % SAMPLES;
+      fused(&fixed, dest, g_translations[p], g_rotations[p], g_parents[p]);
+      sum += dest[3][0];
+   }
+   newTime = seconds(start);
+   g_sink_f = sum;
+
+   printf("%-34s old %6.2f ns/call  new %6.2f ns/call  %.2fx\n", name,
+          oldTime * 1e9 / iterations, newTime * 1e9 / iterations, oldTime / newTime);
+}
+
+static void time_mul(long iterations)
+{
+   Mat4 dest;
+   Mtx fixed;
+   clock_t start;
+   double oldTime;
+   double newTime;
+   f32 sum = 0;
+   long i;
+
+   start = clock();
+   for (i = 0; i < iterations; i++) {
+      long p = i % SAMPLES;
+      mul_to_mtx_old(&fixed, dest, g_locals[p], g_parents[p]);
+      sum += dest[3][0];
+   }
+   oldTime = seconds(start);
+
+   start = clock();
+   for (i = 0; i < iterations; i++) {
+      long p = i % SAMPLES;
+      mtxf_mul_to_mtx(&fixed, dest, g_locals[p], g_parents[p]);
+      sum += dest[3][0];
+   }
+   newTime = seconds(start);
+
+   printf("%-34s old %6.2f ns/call  new %6.2f ns/call  %.2fx\n", "mtxf_mul_to_mtx",
+          oldTime * 1e9 / iterations, newTime * 1e9 / iterations, oldTime / newTime);
+
+   start = clock();
+   for (i = 0; i < iterations; i++) {
+      long p = i % SAMPLES;
+      mtxf_mul_old(dest, g_locals[p], g_parents[p]);
+      sum += dest[3][0];
+   }
+   oldTime = seconds(start);
+
+   start = clock();
+   for (i = 0; i < iterations; i++) {
+      long p = i % SAMPLES;
+      mtxf_mul(dest, g_locals[p], g_parents[p]);
+      sum += dest[3][0];
+   }
+   newTime = seconds(start);
+   g_sink_f = sum;
+
+   printf("%-34s old %6.2f ns/call  new %6.2f ns/call  %.2fx\n", "mtxf_mul",
+          oldTime * 1e9 / iterations, newTime * 1e9 / iterations, oldTime / newTime);
+}
+
+static void time_mul_vec3s(long iterations)
+{
+   Vec3s point;
+   clock_t start;
+   double oldTime;
+   double newTime;
+   s32 sum = 0;
+   long i;
+
+   start = clock();
+   for (i = 0; i < iterations; i++) {
+      long p = i % SAMPLES;
+      vec3s_copy(point, g_points[p]);
+      mtxf_mul_vec3s_old(g_locals[p], point);
+      sum += point[0];
+   }
+   oldTime = seconds(start);
+
+   start = clock();
+   for (i = 0; i < iterations; i++) {
+      long p = i % SAMPLES;
+      vec3s_copy(point, g_points[p]);
+      mtxf_mul_vec3s(g_locals[p], point);
+      sum += point[0];
+   }
+   newTime = seconds(start);
+   g_sink_s = sum;
+
+   printf("%-34s old %6.2f ns/call  new %6.2f ns/call  %.2fx\n", "mtxf_mul_vec3s",
+          oldTime * 1e9 / iterations, newTime * 1e9 / iterations, oldTime / newTime);
+}
+
+int main(int argc, char *argv[])
+{
+   long iterations = DEFAULT_ITERATIONS;
+   long failures = 0;
+   int i;
+
+   for (i = 1; i < argc; i++) {
+      if (argv[i][0] == '-' && argv[i][1] == 'n' && i + 1 < argc) {
+         iterations = strtol(argv[++i], NULL, 0);
+      } else {
+         print_usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (iterations <= 0) {
+      print_usage();
+      return EXIT_FAILURE;
+   }
+
+   make_inputs();
+
+   failures += check_rotate_mul("mtxf_rotate_zxy_and_translate_mul",
+                                mtxf_rotate_zxy_and_translate_mul, rotate_zxy_mul_old);
+   failures += check_rotate_mul("mtxf_rotate_xyz_and_translate_mul",
+                                mtxf_rotate_xyz_and_translate_mul, rotate_xyz_mul_old);
+   failures += check_mul();
+   failures += check_mul_vec3s();
+
+   time_rotate_mul("mtxf_rotate_zxy_and_translate_mul", mtxf_rotate_zxy_and_translate_mul,
+                   rotate_zxy_mul_old, iterations);
+   time_rotate_mul("mtxf_rotate_xyz_and_translate_mul", mtxf_rotate_xyz_and_translate_mul,
+                   rotate_xyz_mul_old, iterations);
+   time_mul(iterations);
+   time_mul_vec3s(iterations);
+
+   if (failures == 0) {
+      printf("all results are the same as the old version\n");
+   }
+   return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
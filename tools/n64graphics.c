@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 
 #define STBI_NO_LINEAR
@@ -207,25 +208,19 @@ uint8_t *ci2raw(const uint8_t *rawci, const uint8_t *palette, int width, int hei
 int rgba2raw(uint8_t *raw, const rgba *img, int width, int height, int depth)
 {
    int size = (width * height * depth + 7) / 8;
+   int count = width * height;
    INFO("Converting RGBA%d %dx%d to raw\n", depth, width, height);
 
    if (depth == 16) {
-      for (int i = 0; i < width * height; i++) {
-         uint8_t r, g, b, a;
-         r = SCALE_8_5(img[i].red);
-         g = SCALE_8_5(img[i].green);
-         b = SCALE_8_5(img[i].blue);
-         a = img[i].alpha ? 0x1 : 0x0;
-         raw[i*2]   = (r << 3) | (g >> 2);
-         raw[i*2+1] = ((g & 0x3) << 6) | (b << 1) | a;
+      // pack as a single u16 so the loop is branch-free and vectorizable
+      for (int i = 0; i < count; i++) {
+         uint16_t val = (SCALE_8_5(img[i].red) << 11) | (SCALE_8_5(img[i].green) << 6)
+                      | (SCALE_8_5(img[i].blue) << 1) | (img[i].alpha != 0);
+         raw[i*2]   = val >> 8;
+         raw[i*2+1] = val & 0xFF;
       }
    } else if (depth == 32) {
-      for (int i = 0; i < width * height; i++) {
-         raw[i*4]   = img[i].red;
-         raw[i*4+1] = img[i].green;
-         raw[i*4+2] = img[i].blue;
-         raw[i*4+3] = img[i].alpha;
-      }
+      memcpy(raw, img, count * sizeof(*img));
    } else {
       ERROR("Error invalid depth %d\n", depth);
       size = -1;
@@ -237,45 +232,34 @@ int rgba2raw(uint8_t *raw, const rgba *img, int width, int height, int depth)
 int ia2raw(uint8_t *raw, const ia *img, int width, int height, int depth)
 {
    int size = (width * height * depth + 7) / 8;
+   int count = width * height;
    INFO("Converting IA%d %dx%d to raw\n", depth, width, height);
    memset(raw, 0, size);
 
    switch (depth) {
       case 16:
-         for (int i = 0; i < width * height; i++) {
-            raw[i*2]   = img[i].intensity;
-            raw[i*2+1] = img[i].alpha;
-         }
+         memcpy(raw, img, count * sizeof(*img));
          break;
       case 8:
-         for (int i = 0; i < width * height; i++) {
-            uint8_t val = SCALE_8_4(img[i].intensity);
-            uint8_t alpha = SCALE_8_4(img[i].alpha);
-            raw[i] = (val << 4) | alpha;
+         for (int i = 0; i < count; i++) {
+            raw[i] = (SCALE_8_4(img[i].intensity) << 4) | SCALE_8_4(img[i].alpha);
          }
          break;
       case 4:
-         for (int i = 0; i < width * height; i++) {
-            uint8_t val = SCALE_8_3(img[i].intensity);
-            uint8_t alpha = img[i].alpha ? 0x01 : 0x00;
-            uint8_t old = raw[i/2];
-            if (i % 2) {
-               raw[i/2] = (old & 0xF0) | (val << 1) | alpha;
-            } else {
-               raw[i/2] = (old & 0x0F) | (((val << 1) | alpha) << 4);
-            }
+         // two pixels per byte, high nibble first
+         for (int i = 0; i < count / 2; i++) {
+            uint8_t hi = (SCALE_8_3(img[2*i].intensity) << 1) | (img[2*i].alpha != 0);
+            uint8_t lo = (SCALE_8_3(img[2*i+1].intensity) << 1) | (img[2*i+1].alpha != 0);
+            raw[i] = (hi << 4) | lo;
+         }
+         if (count % 2) {
+            raw[count/2] = ((SCALE_8_3(img[count-1].intensity) << 1) | (img[count-1].alpha != 0)) << 4;
          }
          break;
       case 1:
-         for (int i = 0; i < width * height; i++) {
-            uint8_t val = img[i].intensity;
-            uint8_t old = raw[i/8];
-            uint8_t bit = 1 << (7 - (i % 8));
-            if (val) {
-               raw[i/8] = old | bit;
-            } else {
-               raw[i/8] = old & (~bit);
-            }
+         // eight pixels per byte, MSb first
+         for (int i = 0; i < count; i++) {
+            raw[i/8] |= (img[i].intensity != 0) << (7 - (i % 8));
          }
          break;
       default:
@@ -290,24 +274,23 @@ int ia2raw(uint8_t *raw, const ia *img, int width, int height, int depth)
 int i2raw(uint8_t *raw, const ia *img, int width, int height, int depth)
 {
    int size = (width * height * depth + 7) / 8;
+   int count = width * height;
    INFO("Converting I%d %dx%d to raw\n", depth, width, height);
    memset(raw, 0, size);
 
    switch (depth) {
       case 8:
-         for (int i = 0; i < width * height; i++) {
+         for (int i = 0; i < count; i++) {
             raw[i] = img[i].intensity;
          }
          break;
       case 4:
-         for (int i = 0; i < width * height; i++) {
-            uint8_t val = SCALE_8_4(img[i].intensity);
-            uint8_t old = raw[i/2];
-            if (i % 2) {
-               raw[i/2] = (old & 0xF0) | val;
-            } else {
-               raw[i/2] = (old & 0x0F) | (val << 4);
-            }
+         // two pixels per byte, high nibble first
+         for (int i = 0; i < count / 2; i++) {
+            raw[i] = (SCALE_8_4(img[2*i].intensity) << 4) | SCALE_8_4(img[2*i+1].intensity);
+         }
+         if (count % 2) {
+            raw[count/2] = SCALE_8_4(img[count-1].intensity) << 4;
          }
          break;
       default:
@@ -578,8 +561,13 @@ const char *n64graphics_get_write_version(void)
 }
 
 #ifdef N64GRAPHICS_STANDALONE
-#define N64GRAPHICS_VERSION "0.4"
+#define N64GRAPHICS_VERSION "0.5"
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// max arguments on a single batch manifest line
+#define MAX_BATCH_ARGS 32
 
 typedef enum
 {
@@ -602,6 +590,9 @@ typedef struct
    int height;
    int bin_truncate;
    int pal_truncate;
+   char *batch_filename;
+   char *cache_dir;
+   int threads;
 } graphics_config;
 
 static const graphics_config default_config =
@@ -619,6 +610,9 @@ static const graphics_config default_config =
    .height = 32,
    .bin_truncate = 1,
    .pal_truncate = 1,
+   .batch_filename = NULL,
+   .cache_dir = NULL,
+   .threads = 1,
 };
 
 typedef struct
@@ -701,7 +695,8 @@ static int parse_encoding(write_encoding *encoding, const char *str)
 
 static void print_usage(void)
 {
-   ERROR("Usage: n64graphics -e/-i BIN_FILE -g IMG_FILE [-p PAL_FILE] [-o BIN_OFFSET] [-P PAL_OFFSET] [-f FORMAT] [-c CI_FORMAT] [-w WIDTH] [-h HEIGHT] [-V]\n"
+   ERROR("Usage: n64graphics -e/-i BIN_FILE -g IMG_FILE [-p PAL_FILE] [-o BIN_OFFSET] [-P PAL_OFFSET] [-f FORMAT] [-c CI_FORMAT] [-w WIDTH] [-h HEIGHT] [-C CACHE_DIR] [-V]\n"
+         "       n64graphics -b MANIFEST [-j THREADS] [-C CACHE_DIR]\n"
          "\n"
          "n64graphics v" N64GRAPHICS_VERSION ": N64 graphics manipulator\n"
          "\n"
@@ -715,6 +710,10 @@ static void print_usage(void)
          " -s SCHEME     output scheme: raw, u8 (hex), u64 (hex) (default: %s)\n"
          " -w WIDTH      export texture width (default: %d)\n"
          " -h HEIGHT     export texture height (default: %d)\n"
+         "Import arguments:\n"
+         " -C CACHE_DIR  reuse converted output keyed by PNG contents, format and scheme\n"
+         " -b MANIFEST   import every entry of MANIFEST (one set of -i/-g/-f/-s arguments per line)\n"
+         " -j THREADS    number of threads used for -b (default: %d)\n"
          "CI arguments:\n"
          " -c CI_FORMAT  CI palette format: rgba16, ia16 (default: %s)\n"
          " -p PAL_FILE   palette binary file to import/export from/to\n"
@@ -726,6 +725,7 @@ static void print_usage(void)
          encoding2str(default_config.encoding),
          default_config.width,
          default_config.height,
+         default_config.threads,
          format2str(&default_config.pal_format));
 }
 
@@ -743,6 +743,14 @@ static int parse_arguments(int argc, char *argv[], graphics_config *config)
    for (int i = 1; i < argc; i++) {
       if (argv[i][0] == '-') {
          switch (argv[i][1]) {
+            case 'b':
+               if (++i >= argc) return 0;
+               config->batch_filename = argv[i];
+               break;
+            case 'C':
+               if (++i >= argc) return 0;
+               config->cache_dir = argv[i];
+               break;
             case 'c':
                if (++i >= argc) return 0;
                if (!parse_format(&config->pal_format, argv[i])) {
@@ -773,6 +781,13 @@ static int parse_arguments(int argc, char *argv[], graphics_config *config)
                config->bin_filename = argv[i];
                config->mode = MODE_IMPORT;
                break;
+            case 'j':
+               if (++i >= argc) return 0;
+               config->threads = strtoul(argv[i], NULL, 0);
+               if (config->threads < 1) {
+                  config->threads = 1;
+               }
+               break;
             case 'o':
                if (++i >= argc) return 0;
                config->bin_offset = strtoul(argv[i], NULL, 0);
@@ -830,161 +845,378 @@ static int valid_config(const graphics_config *config)
    return 1;
 }
 
-int main(int argc, char *argv[])
+// convert config->img_filename to N64 format and write it to config->bin_filename
+// returns EXIT_SUCCESS or EXIT_FAILURE
+static int import_image(graphics_config *config)
 {
-   graphics_config config = default_config;
-   rgba *imgr;
-   ia   *imgi;
-   FILE *bin_fp;
-   uint8_t *raw;
+   rgba *imgr = NULL;
+   ia   *imgi = NULL;
+   FILE *bin_fp = NULL;
+   FILE *pal_fp = NULL;
+   uint8_t *raw = NULL;
+   uint8_t *raw16 = NULL;
    int raw_size;
    int length = 0;
    int flength;
-   int res;
+   int ret_val = EXIT_FAILURE;
 
-   int valid = parse_arguments(argc, argv, &config);
-   if (!valid || !valid_config(&config)) {
-      print_usage();
-      exit(EXIT_FAILURE);
-   }
-
-   if (config.mode == MODE_IMPORT) {
-      if (0 == strcmp("-", config.bin_filename)) {
-         bin_fp = stdout;
+   if (0 == strcmp("-", config->bin_filename)) {
+      bin_fp = stdout;
+   } else {
+      if (config->bin_truncate) {
+         bin_fp = fopen(config->bin_filename, "wb");
       } else {
-         if (config.bin_truncate) {
-            bin_fp = fopen(config.bin_filename, "wb");
+         bin_fp = fopen(config->bin_filename, "r+b");
+      }
+   }
+   if (!bin_fp) {
+      ERROR("Error opening \"%s\"\n", config->bin_filename);
+      goto free_all;
+   }
+   if (!config->bin_truncate) {
+      fseek(bin_fp, config->bin_offset, SEEK_SET);
+   }
+   switch (config->format.format) {
+      case IMG_FORMAT_RGBA:
+         imgr = png2rgba(config->img_filename, &config->width, &config->height);
+         if (!imgr) {
+            goto free_all;
+         }
+         raw_size = (config->width * config->height * config->format.depth + 7) / 8;
+         raw = malloc(raw_size);
+         if (!raw) {
+            ERROR("Error allocating %u bytes\n", raw_size);
+            goto free_all;
+         }
+         length = rgba2raw(raw, imgr, config->width, config->height, config->format.depth);
+         break;
+      case IMG_FORMAT_IA:
+         imgi = png2ia(config->img_filename, &config->width, &config->height);
+         if (!imgi) {
+            goto free_all;
+         }
+         raw_size = (config->width * config->height * config->format.depth + 7) / 8;
+         raw = malloc(raw_size);
+         if (!raw) {
+            ERROR("Error allocating %u bytes\n", raw_size);
+            goto free_all;
+         }
+         length = ia2raw(raw, imgi, config->width, config->height, config->format.depth);
+         break;
+      case IMG_FORMAT_I:
+         imgi = png2ia(config->img_filename, &config->width, &config->height);
+         if (!imgi) {
+            goto free_all;
+         }
+         raw_size = (config->width * config->height * config->format.depth + 7) / 8;
+         raw = malloc(raw_size);
+         if (!raw) {
+            ERROR("Error allocating %u bytes\n", raw_size);
+            goto free_all;
+         }
+         length = i2raw(raw, imgi, config->width, config->height, config->format.depth);
+         break;
+      case IMG_FORMAT_CI:
+      {
+         palette_t pal = {0};
+         int raw16_size;
+         int raw16_length;
+         int pal_success;
+         int pal_length;
+
+         if (config->pal_truncate) {
+            pal_fp = fopen(config->pal_filename, "wb");
          } else {
-            bin_fp = fopen(config.bin_filename, "r+b");
+            pal_fp = fopen(config->pal_filename, "r+b");
          }
+         if (!pal_fp) {
+            ERROR("Error opening \"%s\"\n", config->pal_filename);
+            goto free_all;
+         }
+         if (!config->pal_truncate) {
+            fseek(pal_fp, config->bin_offset, SEEK_SET);
+         }
+
+         raw16_size = config->width * config->height * config->pal_format.depth / 8;
+         raw16 = malloc(raw16_size);
+         if (!raw16) {
+            ERROR("Error allocating %d bytes\n", raw16_size);
+            goto free_all;
+         }
+         switch (config->pal_format.format) {
+            case IMG_FORMAT_RGBA:
+               imgr = png2rgba(config->img_filename, &config->width, &config->height);
+               if (!imgr) {
+                  goto free_all;
+               }
+               raw16_length = rgba2raw(raw16, imgr, config->width, config->height, config->pal_format.depth);
+               break;
+            case IMG_FORMAT_IA:
+               imgi = png2ia(config->img_filename, &config->width, &config->height);
+               if (!imgi) {
+                  goto free_all;
+               }
+               raw16_length = ia2raw(raw16, imgi, config->width, config->height, config->pal_format.depth);
+               break;
+            default:
+               ERROR("Unsupported palette format: %s\n", format2str(&config->pal_format));
+               goto free_all;
+         }
+
+         // convert raw to palette
+         pal.max = (1 << config->format.depth);
+         length = config->width * config->height * config->format.depth / 8;
+         raw = malloc(length);
+         if (!raw) {
+            ERROR("Error allocating %d bytes\n", length);
+            goto free_all;
+         }
+         pal_success = raw2ci(raw, &pal, raw16, raw16_length, config->format.depth);
+         if (!pal_success) {
+            ERROR("Error converting palette\n");
+            goto free_all;
+         }
+
+         // pack the bytes
+         uint8_t raw_pal[sizeof(pal.data)];
+         for (int i = 0; i < pal.max; i++) {
+            write_u16_be(&raw_pal[2*i], pal.data[i]);
+         }
+         pal_length = pal.max * sizeof(pal.data[0]);
+         INFO("Writing 0x%X bytes to offset 0x%X of \"%s\"\n", pal_length, config->pal_offset, config->pal_filename);
+         flength = fprint_write_output(pal_fp, config->encoding, raw_pal, pal_length);
+         if (config->encoding == ENCODING_RAW && flength != pal_length) {
+            ERROR("Error writing %d bytes to \"%s\"\n", pal_length, config->pal_filename);
+         }
+         INFO("Wrote 0x%X bytes to \"%s\"\n", flength, config->pal_filename);
+         break;
       }
-      if (!bin_fp) {
-         ERROR("Error opening \"%s\"\n", config.bin_filename);
-         return -1;
-      }
-      if (!config.bin_truncate) {
-         fseek(bin_fp, config.bin_offset, SEEK_SET);
+      default:
+         goto free_all;
+   }
+   if (length <= 0) {
+      ERROR("Error converting to raw format\n");
+      goto free_all;
+   }
+   INFO("Writing 0x%X bytes to offset 0x%X of \"%s\"\n", length, config->bin_offset, config->bin_filename);
+   flength = fprint_write_output(bin_fp, config->encoding, raw, length);
+   if (config->encoding == ENCODING_RAW && flength != length) {
+      ERROR("Error writing %d bytes to \"%s\"\n", length, config->bin_filename);
+   }
+   INFO("Wrote 0x%X bytes to \"%s\"\n", flength, config->bin_filename);
+   ret_val = EXIT_SUCCESS;
+
+free_all:
+   if (bin_fp && bin_fp != stdout) {
+      fclose(bin_fp);
+   }
+   if (pal_fp) {
+      fclose(pal_fp);
+   }
+   free(raw);
+   free(raw16);
+   free(imgr);
+   free(imgi);
+
+   return ret_val;
+}
+
+// 64-bit FNV-1a, used to key the texture cache on the PNG contents
+static uint64_t fnv1a_64(uint64_t hash, const uint8_t *data, long length)
+{
+   for (long i = 0; i < length; i++) {
+      hash ^= data[i];
+      hash *= 0x100000001B3ULL;
+   }
+   return hash;
+}
+
+// import through the content-addressed cache in cache_dir. the key covers
+// the PNG bytes, output format, encoding and tool version, so a hit can be
+// copied to the output without decoding the PNG again.
+// job is used to keep temporary names unique between batch threads
+static int import_image_cached(graphics_config *config, const char *cache_dir, int job)
+{
+   char cache_name[FILENAME_MAX];
+   char tmp_name[FILENAME_MAX + 32];
+   uint8_t *png_data;
+   long png_length;
+   uint64_t hash = 0xCBF29CE484222325ULL;
+   const char *format = format2str(&config->format);
+   const char *encoding = encoding2str(config->encoding);
+   int ret;
+
+   // CI writes a second file and offset writes patch an existing one; neither is cached
+   if (cache_dir == NULL || config->format.format == IMG_FORMAT_CI || !config->bin_truncate
+       || 0 == strcmp("-", config->bin_filename)) {
+      return import_image(config);
+   }
+
+   png_length = read_file(config->img_filename, &png_data);
+   if (png_length < 0) {
+      ERROR("Error reading \"%s\"\n", config->img_filename);
+      return EXIT_FAILURE;
+   }
+   hash = fnv1a_64(hash, png_data, png_length);
+   hash = fnv1a_64(hash, (const uint8_t *)format, strlen(format) + 1);
+   hash = fnv1a_64(hash, (const uint8_t *)encoding, strlen(encoding) + 1);
+   hash = fnv1a_64(hash, (const uint8_t *)N64GRAPHICS_VERSION, sizeof(N64GRAPHICS_VERSION));
+   free(png_data);
+
+   snprintf(cache_name, sizeof(cache_name), "%s/%016llx.%s.%s", cache_dir,
+            (unsigned long long)hash, format, encoding);
+   if (filesize(cache_name) >= 0 && copy_file(cache_name, config->bin_filename) >= 0) {
+      INFO("Cache hit \"%s\" for \"%s\"\n", cache_name, config->img_filename);
+      return EXIT_SUCCESS;
+   }
+
+   ret = import_image(config);
+   if (ret == EXIT_SUCCESS) {
+      // publish with a rename so concurrent builds never see a partial entry
+      make_dir(cache_dir);
+      snprintf(tmp_name, sizeof(tmp_name), "%s.%d.%d.tmp", cache_name, (int)getpid(), job);
+      if (copy_file(config->bin_filename, tmp_name) < 0 || rename(tmp_name, cache_name) != 0) {
+         remove(tmp_name);
       }
-      switch (config.format.format) {
-         case IMG_FORMAT_RGBA:
-            imgr = png2rgba(config.img_filename, &config.width, &config.height);
-            raw_size = (config.width * config.height * config.format.depth + 7) / 8;
-            raw = malloc(raw_size);
-            if (!raw) {
-               ERROR("Error allocating %u bytes\n", raw_size);
-            }
-            length = rgba2raw(raw, imgr, config.width, config.height, config.format.depth);
-            break;
-         case IMG_FORMAT_IA:
-            imgi = png2ia(config.img_filename, &config.width, &config.height);
-            raw_size = (config.width * config.height * config.format.depth + 7) / 8;
-            raw = malloc(raw_size);
-            if (!raw) {
-               ERROR("Error allocating %u bytes\n", raw_size);
-            }
-            length = ia2raw(raw, imgi, config.width, config.height, config.format.depth);
-            break;
-         case IMG_FORMAT_I:
-            imgi = png2ia(config.img_filename, &config.width, &config.height);
-            raw_size = (config.width * config.height * config.format.depth + 7) / 8;
-            raw = malloc(raw_size);
-            if (!raw) {
-               ERROR("Error allocating %u bytes\n", raw_size);
-            }
-            length = i2raw(raw, imgi, config.width, config.height, config.format.depth);
-            break;
-         case IMG_FORMAT_CI:
-         {
-            palette_t pal = {0};
-            FILE *pal_fp;
-            uint8_t *raw16;
-            int raw16_size;
-            int raw16_length;
-            uint8_t *ci;
-            int ci_length;
-            int pal_success;
-            int pal_length;
-
-            if (config.pal_truncate) {
-               pal_fp = fopen(config.pal_filename, "wb");
-            } else {
-               pal_fp = fopen(config.pal_filename, "r+b");
-            }
-            if (!pal_fp) {
-               ERROR("Error opening \"%s\"\n", config.pal_filename);
-               return EXIT_FAILURE;
-            }
-            if (!config.pal_truncate) {
-               fseek(pal_fp, config.bin_offset, SEEK_SET);
-            }
+   }
+   return ret;
+}
 
-            raw16_size = config.width * config.height * config.pal_format.depth / 8;
-            raw16 = malloc(raw16_size);
-            if (!raw16) {
-               ERROR("Error allocating %d bytes\n", raw16_size);
-               return EXIT_FAILURE;
-            }
-            switch (config.pal_format.format) {
-               case IMG_FORMAT_RGBA:
-                  imgr = png2rgba(config.img_filename, &config.width, &config.height);
-                  raw16_length = rgba2raw(raw16, imgr, config.width, config.height, config.pal_format.depth);
-                  break;
-               case IMG_FORMAT_IA:
-                  imgi = png2ia(config.img_filename, &config.width, &config.height);
-                  raw16_length = ia2raw(raw16, imgi, config.width, config.height, config.pal_format.depth);
-                  break;
-               default:
-                  ERROR("Unsupported palette format: %s\n", format2str(&config.pal_format));
-                  exit(EXIT_FAILURE);
-            }
+typedef struct
+{
+   graphics_config *configs;
+   int count;
+   int next;
+   int failures;
+   const char *cache_dir;
+   pthread_mutex_t lock;
+} batch_queue;
+
+static void *batch_worker(void *arg)
+{
+   batch_queue *queue = arg;
 
-            // convert raw to palette
-            pal.max = (1 << config.format.depth);
-            ci_length = config.width * config.height * config.format.depth / 8;
-            ci = malloc(ci_length);
-            pal_success = raw2ci(ci, &pal, raw16, raw16_length, config.format.depth);
-            if (!pal_success) {
-               ERROR("Error converting palette\n");
-               exit(EXIT_FAILURE);
-            }
+   for (;;) {
+      int job;
+      int ret;
 
-            // pack the bytes
-            uint8_t raw_pal[sizeof(pal.data)];
-            for (int i = 0; i < pal.max; i++) {
-               write_u16_be(&raw_pal[2*i], pal.data[i]);
-            }
-            pal_length = pal.max * sizeof(pal.data[0]);
-            INFO("Writing 0x%X bytes to offset 0x%X of \"%s\"\n", pal_length, config.pal_offset, config.pal_filename);
-            flength = fprint_write_output(pal_fp, config.encoding, raw_pal, pal_length);
-            if (config.encoding == ENCODING_RAW && flength != pal_length) {
-               ERROR("Error writing %d bytes to \"%s\"\n", pal_length, config.pal_filename);
-            }
-            INFO("Wrote 0x%X bytes to \"%s\"\n", flength, config.pal_filename);
+      pthread_mutex_lock(&queue->lock);
+      job = queue->next++;
+      pthread_mutex_unlock(&queue->lock);
+      if (job >= queue->count) {
+         break;
+      }
 
-            raw = ci;
-            length = ci_length;
+      ret = import_image_cached(&queue->configs[job], queue->cache_dir, job);
+      if (ret != EXIT_SUCCESS) {
+         ERROR("Error converting \"%s\"\n", queue->configs[job].img_filename);
+         pthread_mutex_lock(&queue->lock);
+         queue->failures++;
+         pthread_mutex_unlock(&queue->lock);
+      }
+   }
+
+   return NULL;
+}
 
-            free(raw16);
-            fclose(pal_fp);
+// read a manifest with one set of import arguments per line, e.g.
+//   -s u8 -i build/us/foo.rgba16.inc.c -g foo.rgba16.png -f rgba16
+// and convert every entry on 'threads' threads
+// returns EXIT_SUCCESS if every entry converted
+static int import_batch(const char *manifest_filename, const graphics_config *base, int threads)
+{
+   batch_queue queue = {0};
+   pthread_t *workers;
+   char *manifest;
+   long manifest_length;
+   int capacity = 0;
+   int line_num = 0;
+
+   manifest_length = read_file(manifest_filename, (unsigned char **)&manifest);
+   if (manifest_length < 0) {
+      ERROR("Error reading manifest \"%s\"\n", manifest_filename);
+      return EXIT_FAILURE;
+   }
+   manifest = realloc(manifest, manifest_length + 1);
+   manifest[manifest_length] = '\0';
+
+   // tokenize in place; the configs point into the manifest buffer
+   for (char *line = strtok(manifest, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+      char *argv[MAX_BATCH_ARGS + 1];
+      int argc = 1;
+      char *save;
+
+      line_num++;
+      argv[0] = "n64graphics";
+      for (char *tok = strtok_r(line, " \t\r", &save); tok != NULL; tok = strtok_r(NULL, " \t\r", &save)) {
+         if (argc > MAX_BATCH_ARGS) {
             break;
          }
-         default:
-            return EXIT_FAILURE;
+         argv[argc++] = tok;
       }
-      if (length <= 0) {
-         ERROR("Error converting to raw format\n");
-         return EXIT_FAILURE;
+      if (argc == 1 || argv[1][0] == '#') {
+         continue;
       }
-      INFO("Writing 0x%X bytes to offset 0x%X of \"%s\"\n", length, config.bin_offset, config.bin_filename);
-      flength = fprint_write_output(bin_fp, config.encoding, raw, length);
-      if (config.encoding == ENCODING_RAW && flength != length) {
-         ERROR("Error writing %d bytes to \"%s\"\n", length, config.bin_filename);
+
+      if (queue.count == capacity) {
+         capacity = capacity ? 2 * capacity : 256;
+         queue.configs = realloc(queue.configs, capacity * sizeof(*queue.configs));
       }
-      INFO("Wrote 0x%X bytes to \"%s\"\n", flength, config.bin_filename);
-      if (bin_fp != stdout) {
-         fclose(bin_fp);
+      queue.configs[queue.count] = *base;
+      queue.configs[queue.count].img_filename = NULL;
+      queue.configs[queue.count].bin_filename = NULL;
+      queue.configs[queue.count].pal_filename = NULL;
+      if (argc > MAX_BATCH_ARGS || !parse_arguments(argc, argv, &queue.configs[queue.count])
+          || !valid_config(&queue.configs[queue.count]) || queue.configs[queue.count].mode != MODE_IMPORT) {
+         ERROR("%s:%d: invalid entry\n", manifest_filename, line_num);
+         free(queue.configs);
+         free(manifest);
+         return EXIT_FAILURE;
       }
+      queue.count++;
+   }
+
+   INFO("Converting %d images on %d threads\n", queue.count, threads);
+   queue.cache_dir = base->cache_dir;
+   pthread_mutex_init(&queue.lock, NULL);
+   workers = malloc(threads * sizeof(*workers));
+   for (int i = 0; i < threads; i++) {
+      pthread_create(&workers[i], NULL, batch_worker, &queue);
+   }
+   for (int i = 0; i < threads; i++) {
+      pthread_join(workers[i], NULL);
+   }
+   pthread_mutex_destroy(&queue.lock);
 
+   free(workers);
+   free(queue.configs);
+   free(manifest);
+
+   return queue.failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+   graphics_config config = default_config;
+   rgba *imgr;
+   ia   *imgi;
+   FILE *bin_fp;
+   uint8_t *raw;
+   int raw_size;
+   int flength;
+   int res;
+
+   int valid = parse_arguments(argc, argv, &config);
+   if (valid && config.batch_filename) {
+      return import_batch(config.batch_filename, &config, config.threads);
+   }
+   if (!valid || !valid_config(&config)) {
+      print_usage();
+      exit(EXIT_FAILURE);
+   }
+
+   if (config.mode == MODE_IMPORT) {
+      return import_image_cached(&config, config.cache_dir, 0);
    } else {
       if (config.width <= 0 || config.height <= 0 || config.format.depth <= 0) {
          ERROR("Error: must set position width and height for export\n");
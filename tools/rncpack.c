@@ -86,7 +86,22 @@ typedef struct vars_s {
     uint8 *input, *output, *temp;
     size_t input_offset, output_offset, temp_offset;
 
-    uint8 tmp_crc_data[2048];
+    // 1 = greedy with one-step lazy matching, 2/3 = optimal parse (method 1 only)
+    uint32 effort;
+    uint16 *parse_count;
+    uint16 *parse_offset;
+    uint16 *step_count;
+    uint16 *step_offset;
+    uint32 *step_cost;
+    // estimated code lengths per table bucket, taken from the previous block
+    uint8 raw_price[16];
+    uint8 count_price[16];
+    uint8 offset_price[16];
+
+    // bytes that follow the bit token being filled. A raw run can take up a whole
+    // pack block (the optimal parse leaves incompressible data as one run), so this
+    // holds as much as the 0xFFFF byte window
+    uint8 tmp_crc_data[0x10000];
     huftable_t raw_table[16];
     huftable_t pos_table[16];
     huftable_t len_table[16];
@@ -238,6 +253,7 @@ vars_t *init_vars()
     v->dict_size = 0xFFFF;
     v->method = 1;
     v->puse_mode = 'p';
+    v->effort = 1;
 
     v->read_start_offset = 0;
     v->write_start_offset = 0;
@@ -460,6 +476,55 @@ int find_matches(vars_t *v)
     return 0;
 }
 
+int bits_count(int value)
+{
+    int count = 1;
+    while (value >>= 1)
+        count++;
+
+    return count;
+}
+
+// estimated bits to store value through a table with the given code lengths (see proc_19)
+int value_price(const uint8 *price, int value)
+{
+    int bits = (value > 1) ? bits_count(value) : value;
+
+    return price[bits] + ((bits > 1) ? bits - 1 : 0);
+}
+
+// estimated bits for a match token, including the raw run count that precedes it
+int match_price(vars_t *v, int count, int offset)
+{
+    return value_price(v->raw_price, 0) + value_price(v->count_price, count - 2) + value_price(v->offset_price, offset - 1);
+}
+
+// take the code lengths of the block just built as prices for the next one
+void update_prices(uint8 *price, huftable_t *data, int count)
+{
+    int max_depth = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (data[i].bit_depth > max_depth)
+            max_depth = data[i].bit_depth;
+    }
+
+    // buckets unused in this block are assumed to be at least as expensive as the rarest used one
+    for (int i = 0; i < count; ++i)
+        price[i] = data[i].bit_depth ? data[i].bit_depth : max_depth + 1;
+}
+
+void init_prices(vars_t *v)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        v->raw_price[i] = 4;
+        v->count_price[i] = 4;
+        v->offset_price[i] = 4;
+    }
+}
+
 void find_and_check_matches(vars_t *v)
 {
     find_matches(v);
@@ -492,15 +557,6 @@ void find_and_check_matches(vars_t *v)
     }
 }
 
-int bits_count(int value)
-{
-    int count = 1;
-    while (value >>= 1)
-        count++;
-
-    return count;
-}
-
 void update_bits_table(vars_t *v, huftable_t *data, uint16 bits)
 {
     if (bits <= 1)
@@ -511,6 +567,7 @@ void update_bits_table(vars_t *v, huftable_t *data, uint16 bits)
     write_word_be(v->temp, &v->temp_offset, bits);
 }
 
+
 void encode_matches(vars_t *v, uint16 w)
 {
     while (1)
@@ -571,6 +628,197 @@ void encode_matches(vars_t *v, uint16 w)
     }
 }
 
+// cheapest token sequence over the matches collected in parse_count/parse_offset,
+// stored as the last step into each position
+void optimal_parse_steps(vars_t *v, int n)
+{
+    // above this length only the longest count of each table bucket is tried
+    int nice_count = (v->effort >= 3) ? 0x100 : 0x20;
+
+    v->step_cost[0] = 0;
+    for (int i = 1; i <= n; ++i)
+        v->step_cost[i] = 0xFFFFFFFF;
+
+    for (int i = 0; i < n - 1; ++i)
+    {
+        uint32 cost = v->step_cost[i];
+        int count = v->parse_count[i];
+
+        if (cost + 8 < v->step_cost[i + 1])
+        {
+            v->step_cost[i + 1] = cost + 8;
+            v->step_count[i + 1] = 1;
+        }
+
+        if (count > n - i)
+            count = n - i;
+
+        for (int len = 2; len <= count; ++len)
+        {
+            if (len > nice_count && len != count && ((len - 1) & (len - 2)))
+                continue;
+
+            uint32 match_cost = cost + match_price(v, len, v->parse_offset[i]);
+            if (match_cost < v->step_cost[i + len])
+            {
+                v->step_cost[i + len] = match_cost;
+                v->step_count[i + len] = len;
+                v->step_offset[i + len] = v->parse_offset[i];
+            }
+        }
+    }
+}
+
+// finish on the last byte only if that beats leaving it as a literal
+int optimal_parse_end(vars_t *v, int n)
+{
+    if (v->step_cost[n] != 0xFFFFFFFF && v->step_cost[n] < v->step_cost[n - 1] + 8)
+        return n;
+
+    return n - 1;
+}
+
+// approximate code lengths from bucket frequencies
+void prices_from_freqs(uint8 *price, const uint32 *freq, int count)
+{
+    uint32 total = 0;
+    int max_price = 1;
+
+    for (int i = 0; i < count; ++i)
+        total += freq[i];
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (freq[i])
+        {
+            int bits = bits_count(total / freq[i]);
+
+            price[i] = (bits < 15) ? bits : 15;
+            if (price[i] > max_price)
+                max_price = price[i];
+        }
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (!freq[i])
+            price[i] = (max_price < 15) ? max_price + 1 : 15;
+    }
+}
+
+// re-estimate the prices from the tokens of the parse ending at 'end'
+void optimal_parse_reprice(vars_t *v, int end)
+{
+    uint32 raw_freq[16] = { 0 };
+    uint32 count_freq[16] = { 0 };
+    uint32 offset_freq[16] = { 0 };
+    int raw_length = 0;
+
+    for (int i = end; i > 0; i -= v->step_count[i])
+    {
+        int len = v->step_count[i];
+
+        if (len == 1)
+        {
+            raw_length++;
+            continue;
+        }
+
+        raw_freq[(raw_length > 1) ? bits_count(raw_length) : raw_length]++;
+        count_freq[(len - 2 > 1) ? bits_count(len - 2) : len - 2]++;
+        offset_freq[(v->step_offset[i] - 1 > 1) ? bits_count(v->step_offset[i] - 1) : v->step_offset[i] - 1]++;
+        raw_length = 0;
+    }
+    raw_freq[(raw_length > 1) ? bits_count(raw_length) : raw_length]++;
+
+    prices_from_freqs(v->raw_price, raw_freq, 16);
+    prices_from_freqs(v->count_price, count_freq, 16);
+    prices_from_freqs(v->offset_price, offset_freq, 16);
+}
+
+// Optimal parse replacement for the lazy matching loop in proc_6. Collects the
+// longest match at every position up to pack_block_max, then picks the token
+// sequence with the lowest estimated cost using the previous block's code lengths.
+// Effort 3 parses a second time with prices taken from the first parse.
+// Like the lazy loop, it may stop one byte short of pack_block_max.
+void optimal_parse(vars_t *v, uint32 *data_length)
+{
+    int n = v->pack_block_max - v->pack_block_start;
+    int end;
+
+    if (n < 2)
+        return;
+
+    // gather matches, updating the dictionary the same way the lazy loop does
+    for (int i = 0; i < n - 1; )
+    {
+        int run = 1;
+
+        find_matches(v);
+        v->parse_count[i] = v->match_count;
+        v->parse_offset[i] = v->match_offset;
+
+        while (run < v->pack_block_end - v->pack_block_start && v->pack_block_start[run] == v->pack_block_start[0])
+            run++;
+
+        if (run > 2)
+        {
+            // positions inside a run of equal bytes are not added to the
+            // dictionary; their best match is the rest of the run
+            int skip = (i + run - 1 < n - 1) ? run - 1 : n - 1 - i;
+
+            for (int j = 1; j < skip; ++j)
+            {
+                v->parse_count[i + j] = (run - j < v->max_matches) ? run - j : v->max_matches;
+                v->parse_offset[i + j] = 1;
+            }
+
+            encode_matches(v, skip);
+            i += skip;
+        }
+        else
+        {
+            encode_matches(v, 1);
+            i++;
+        }
+    }
+
+    optimal_parse_steps(v, n);
+    end = optimal_parse_end(v, n);
+
+    if (v->effort >= 3)
+    {
+        optimal_parse_reprice(v, end);
+        optimal_parse_steps(v, n);
+        end = optimal_parse_end(v, n);
+    }
+
+    if (end == n)
+        encode_matches(v, 1);
+
+    // link the chosen steps forwards, reusing the per-position match arrays
+    for (int i = end; i > 0; i -= v->step_count[i])
+    {
+        v->parse_count[i - v->step_count[i]] = v->step_count[i];
+        v->parse_offset[i - v->step_count[i]] = v->step_offset[i];
+    }
+
+    for (int i = 0; i < end; i += v->parse_count[i])
+    {
+        if (v->parse_count[i] == 1)
+        {
+            (*data_length)++;
+            continue;
+        }
+
+        update_bits_table(v, v->raw_table, *data_length);
+        update_bits_table(v, v->pos_table, v->parse_count[i] - 2);
+        update_bits_table(v, v->len_table, v->parse_offset[i] - 1);
+        v->v17++;
+        *data_length = 0;
+    }
+}
+
 void proc_6(vars_t *v)
 {
     v->v17 = 0;
@@ -599,6 +847,9 @@ void proc_6(vars_t *v)
         if (v->pack_block_left_size < v->pack_block_pos)
             v->pack_block_max = &v->pack_block_start[v->pack_block_left_size];
 
+        if (v->effort >= 2 && v->method == 1)
+            optimal_parse(v, &data_length);
+
         while ((v->pack_block_start < v->pack_block_max - 1) && v->v17 < 0xFFFE)
         {
             find_and_check_matches(v);
@@ -971,6 +1222,11 @@ void compress_data_1(vars_t *v)
         proc_16(v, v->len_table, _countof(v->len_table));
         proc_16(v, v->pos_table, _countof(v->pos_table));
 
+        // len_table holds match offsets and pos_table match counts
+        update_prices(v->raw_price, v->raw_table, _countof(v->raw_table));
+        update_prices(v->offset_price, v->len_table, _countof(v->len_table));
+        update_prices(v->count_price, v->pos_table, _countof(v->pos_table));
+
         proc_18(v, v->raw_table, _countof(v->raw_table));
         proc_18(v, v->len_table, _countof(v->len_table));
         proc_18(v, v->pos_table, _countof(v->pos_table));
@@ -1068,6 +1324,16 @@ void do_pack_data(vars_t *v)
     v->mem5 = (uint16 *)malloc(0x10000);
 
     init_dicts(v);
+    init_prices(v);
+
+    if (v->effort >= 2)
+    {
+        v->parse_count = (uint16 *)malloc(0x10000 * sizeof(uint16));
+        v->parse_offset = (uint16 *)malloc(0x10000 * sizeof(uint16));
+        v->step_count = (uint16 *)malloc(0x10001 * sizeof(uint16));
+        v->step_offset = (uint16 *)malloc(0x10001 * sizeof(uint16));
+        v->step_cost = (uint32 *)malloc(0x10001 * sizeof(uint32));
+    }
 
     write_dword_be(v->output, &v->output_offset, (RNC_SIGN << 8) | (v->method & 0xFF));
     write_dword_be(v->output, &v->output_offset, v->unpacked_size);
@@ -1120,6 +1386,15 @@ void do_pack_data(vars_t *v)
     free(v->mem3);
     free(v->mem4);
     free(v->mem5);
+
+    if (v->effort >= 2)
+    {
+        free(v->parse_count);
+        free(v->parse_offset);
+        free(v->step_count);
+        free(v->step_offset);
+        free(v->step_cost);
+    }
 }
 
 int do_pack(vars_t *v)
@@ -1572,7 +1847,8 @@ void print_usage()
     printf("Unpack        : <u> <infile.bin> [outfile.bin] [-i=hex_offset_to_read_from] [-k=hex_key_if_protected]\n");
     printf("Search        : <s> <infile.bin>\n");
     printf("Seach&Extract : <e> <infile.bin>\n");
-    printf("Pack          : <p> <infile.bin> [outfile.bin] <-m=1|2> [-k=hex_key_to_protect]\n");
+    printf("Pack          : <p> <infile.bin> [outfile.bin] <-m=1|2> [-k=hex_key_to_protect] [-e=1|2|3]\n");
+    printf("                -e: effort, 1 = lazy matching (default), 2 = optimal parse, 3 = optimal parse with refined prices (method 1 only)\n");
 }
 
 int parse_args(int argc, char **argv, vars_t *vars)
@@ -1606,6 +1882,10 @@ int parse_args(int argc, char **argv, vars_t *vars)
             if (!arg_ptr)
                 return 3;
 
+            // Allow the -m=1 form shown in the usage
+            if (*arg_ptr == '=')
+                arg_ptr++;
+
             switch (which)
             {
             case 'k':
@@ -1624,6 +1904,11 @@ int parse_args(int argc, char **argv, vars_t *vars)
             case 'o':
                 sscanf(arg_ptr, "%zx", &vars->write_start_offset);
                 break;
+            case 'e':
+                sscanf(arg_ptr, "%u", &vars->effort);
+                if (!vars->effort || vars->effort > 3)
+                    return 3;
+                break;
             case 'm':
                 sscanf(arg_ptr, "%uint32 *", &vars->method);
                 if (!vars->method || vars->method > 2)
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""Pack inputs that broke rncpack before with every effort level, unpack them again
+and check that the data comes back unchanged.
+
+Usage: rncpack_check.py [path to rncpack]
+"""
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+
+def random_bytes(seed, size):
+    rng = random.Random(seed)
+    return bytes(rng.getrandbits(8) for _ in range(size))
+
+
+# (name, data, whether it should come back from 'rncpack u')
+CASES = [
+    # A raw run longer than the 2048 byte buffer for bytes that wait on the bit
+    # token overflowed it with -e2 and -e3.
+    ("random_then_zeros", random_bytes(1, 3000) + bytes(5000), True),
+    # A raw run over a whole 0x3000 byte pack block.
+    ("random_block_then_zeros", random_bytes(2, 0x3000 + 100) + bytes(0x4000), True),
+    ("text", b"".join(b"line %d of some text, line %d\n" % (i, i * 7 % 13) for i in range(3000)), True),
+    # rncpack can't make incompressible data smaller and stops writing once the
+    # output gets as big as the input, so this only has to pack without crashing.
+    ("random_50k", random_bytes(3, 50000), False),
+]
+
+
+def run(args, cwd):
+    return subprocess.run(args, cwd=cwd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT).returncode
+
+
+def main():
+    rncpack = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(__file__), "rncpack"))
+    failures = 0
+
+    with tempfile.TemporaryDirectory() as tmp:
+        for name, data, round_trip in CASES:
+            with open(os.path.join(tmp, name + ".bin"), "wb") as f:
+                f.write(data)
+
+            for effort in (1, 2, 3):
+                # rncpack takes arguments starting with '/' as options, so use relative paths
+                packed = "%s.e%d.rnc" % (name, effort)
+                unpacked = "%s.e%d.out" % (name, effort)
+                result = "ok"
+
+                if run([rncpack, "p", name + ".bin", packed, "-m1", "-e%d" % effort], tmp) != 0:
+                    result = "pack failed"
+                elif round_trip:
+                    if run([rncpack, "u", packed, unpacked], tmp) != 0:
+                        result = "unpack failed"
+                    else:
+                        with open(os.path.join(tmp, unpacked), "rb") as f:
+                            if f.read() != data:
+                                result = "unpacked data differs"
+
+                if result != "ok":
+                    failures += 1
+                print("%-24s -e%d %s" % (name, effort, result))
+
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
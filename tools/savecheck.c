@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <PR/ultratypes.h>
+#include "save_flush.h"
+
+#define SAVECHECK_VERSION "0.1"
+
+#define DEFAULT_SEQUENCES 500
+#define VERSIONS_PER_SEQUENCE 8
+
+#define MENU_DATA_MAGIC 0x4849
+#define SAVE_FILE_MAGIC 0x4441
+
+// The slot pairs of struct SaveBuffer: four save files of 0x38 bytes, then the main menu data
+// of 0x18 bytes. Each pair is the main slot followed by its backup.
+#define NUM_PAIRS 5
+#define IMAGE_SIZE (4 * 2 * 0x38 + 2 * 0x18)
+
+static const u32 g_pair_offset[NUM_PAIRS] = { 0x00, 0x70, 0xE0, 0x150, 0x1C0 };
+static const u32 g_slot_size[NUM_PAIRS] = { 0x38, 0x38, 0x38, 0x38, 0x18 };
+static const u16 g_magic[NUM_PAIRS] = {
+   SAVE_FILE_MAGIC, SAVE_FILE_MAGIC, SAVE_FILE_MAGIC, SAVE_FILE_MAGIC, MENU_DATA_MAGIC
+};
+
+// The simulated save chip. Once g_writes_left reaches 0 the power is cut, and later writes
+// don't reach the chip. In SRAM mode the write that is cut lands its first g_torn_bytes bytes.
+static u8 g_chip[IMAGE_SIZE];
+static long g_writes_left;
+static u32 g_torn_bytes;
+static long g_writes;
+
+static int g_sram;
+static unsigned int g_seed = 12345;
+
+static void print_usage(void)
+{
+   fprintf(stderr,
+         "Usage: savecheck [-s] [-n SEQUENCES]\n"
+         "\n"
+         "savecheck v" SAVECHECK_VERSION ": cut the power after every write that src/game/save_flush.c makes to a\n"
+         "simulated save chip, and check that each save file and the main menu data can still be\n"
+         "loaded from the main or backup slot, as it was before or after the save\n"
+         "\n"
+         "Optional arguments:\n"
+         " -s           simulate SRAM, written in ranges that can be cut at any byte (default: EEPROM,\n"
+         "              written one 8 byte block at a time)\n"
+         " -n SEQUENCES number of random save sequences of %d saves each (default: %d)\n",
+         VERSIONS_PER_SEQUENCE, DEFAULT_SEQUENCES);
+}
+
+static unsigned int rand_next(unsigned int range)
+{
+   g_seed = g_seed * 1103515245 + 12345;
+   return (g_seed >> 8) % range;
+}
+
+static s32 chip_write(u32 offset, u8 *data, u32 size)
+{
+   g_writes++;
+   if (g_writes_left == 0) {
+      return 0;
+   }
+   if (--g_writes_left == 0 && g_sram) {
+      size = g_torn_bytes;
+   }
+   memcpy(&g_chip[offset], data, size);
+   return 0;
+}
+
+// Like calc_checksum and the signatures in save_file.c, with the big endian layout of the N64.
+static u16 calc_checksum(const u8 *data, u32 size)
+{
+   u16 chksum = 0;
+
+   while (size-- > 2) {
+      chksum += *data++;
+   }
+   return chksum;
+}
+
+static int verify_signature(const u8 *slot, u32 size, u16 magic)
+{
+   return ((slot[size - 4] << 8) | slot[size - 3]) == magic
+       && ((slot[size - 2] << 8) | slot[size - 1]) == calc_checksum(slot, size);
+}
+
+static void add_signature(u8 *slot, u32 size, u16 magic)
+{
+   u16 chksum;
+
+   slot[size - 4] = magic >> 8;
+   slot[size - 3] = magic & 0xFF;
+   chksum = calc_checksum(slot, size);
+   slot[size - 2] = chksum >> 8;
+   slot[size - 1] = chksum & 0xFF;
+}
+
+// Change a few bytes of a slot pair's main slot, sign it and copy it to the backup slot,
+// like save_file_do_save.
+static void random_save(u8 *image, int pair)
+{
+   u8 *slot = &image[g_pair_offset[pair]];
+   u32 size = g_slot_size[pair];
+   unsigned int changes = 1 + rand_next(4);
+
+   while (changes-- > 0) {
+      slot[rand_next(size - 4)] = rand_next(256);
+   }
+   add_signature(slot, size, g_magic[pair]);
+   memcpy(slot + size, slot, size);
+}
+
+struct Totals {
+   long flushes;
+   long blocksWritten;
+   long pairBlocks;
+   long cuts;
+   long broken;
+   long collisions;
+};
+
+// Check every slot pair on the chip after the power was cut during the flush from 'before'
+// to 'after'.
+static void check_chip(const u8 *before, const u8 *after, struct Totals *totals)
+{
+   int pair;
+   int slot;
+
+   for (pair = 0; pair < NUM_PAIRS; pair++) {
+      u32 size = g_slot_size[pair];
+      const u8 *want[2];
+      const u8 *loaded = NULL;
+      int intact = 0;
+
+      want[0] = &before[g_pair_offset[pair]];
+      want[1] = &after[g_pair_offset[pair]];
+      for (slot = 0; slot < 2; slot++) {
+         const u8 *chip = &g_chip[g_pair_offset[pair] + slot * size];
+
+         if (!memcmp(chip, want[0], size) || !memcmp(chip, want[1], size)) {
+            intact = 1;
+         }
+         // save_file_load_all uses the main slot if it is valid and the backup otherwise.
+         if (loaded == NULL && verify_signature(chip, size, g_magic[pair])) {
+            loaded = chip;
+         }
+      }
+
+      if (!intact || loaded == NULL) {
+         totals->broken++;
+      } else if (memcmp(loaded, want[0], size) && memcmp(loaded, want[1], size)) {
+         // A slot that was cut while being written but still matches its checksum. The
+         // simple checksum of the save format lets this through however it is written.
+         totals->collisions++;
+      }
+   }
+}
+
+static void check_flush(const u8 *before, const u8 *after, struct Totals *totals)
+{
+   u8 committed[IMAGE_SIZE];
+   u8 image[IMAGE_SIZE];
+   u32 maxRunBlocks = g_sram ? IMAGE_SIZE / SAVE_FLUSH_BLOCK_SIZE : 1;
+   long writes;
+   long cut;
+   int pair;
+
+   // Without a power cut, the flush must write exactly the blocks that changed.
+   memcpy(g_chip, before, IMAGE_SIZE);
+   memcpy(committed, before, IMAGE_SIZE);
+   memcpy(image, after, IMAGE_SIZE);
+   g_writes = 0;
+   g_writes_left = -1;
+   totals->blocksWritten += save_flush(image, committed, IMAGE_SIZE, maxRunBlocks, chip_write);
+   if (memcmp(g_chip, after, IMAGE_SIZE) || memcmp(committed, after, IMAGE_SIZE)) {
+      fprintf(stderr, "Flush %ld left the chip different from the image\n", totals->flushes);
+      totals->broken++;
+   }
+   for (pair = 0; pair < NUM_PAIRS; pair++) {
+      if (memcmp(&before[g_pair_offset[pair]], &after[g_pair_offset[pair]], g_slot_size[pair])) {
+         totals->pairBlocks += 2 * g_slot_size[pair] / SAVE_FLUSH_BLOCK_SIZE;
+      }
+   }
+   totals->flushes++;
+
+   writes = g_writes;
+   for (cut = 1; cut <= writes; cut++) {
+      memcpy(g_chip, before, IMAGE_SIZE);
+      memcpy(committed, before, IMAGE_SIZE);
+      g_writes = 0;
+      g_writes_left = cut;
+      g_torn_bytes = rand_next(IMAGE_SIZE);
+      save_flush(image, committed, IMAGE_SIZE, maxRunBlocks, chip_write);
+      check_chip(before, after, totals);
+      totals->cuts++;
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   struct Totals totals;
+   u8 before[IMAGE_SIZE];
+   u8 after[IMAGE_SIZE];
+   long sequences = DEFAULT_SEQUENCES;
+   long s;
+   int i;
+
+   for (i = 1; i < argc; i++) {
+      if (argv[i][0] == '-' && argv[i][1] == 's' && argv[i][2] == '\0') {
+         g_sram = 1;
+      } else if (argv[i][0] == '-' && argv[i][1] == 'n' && i + 1 < argc) {
+         sequences = strtol(argv[++i], NULL, 0);
+      } else {
+         print_usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (sequences <= 0) {
+      print_usage();
+      return EXIT_FAILURE;
+   }
+
+   memset(&totals, 0, sizeof(totals));
+   for (s = 0; s < sequences; s++) {
+      for (i = 0; i < IMAGE_SIZE; i++) {
+         before[i] = rand_next(256);
+      }
+      for (i = 0; i < NUM_PAIRS; i++) {
+         random_save(before, i);
+      }
+
+      for (i = 0; i < VERSIONS_PER_SEQUENCE; i++) {
+         int saves = 1 + rand_next(3);
+
+         // Several saves made while the last flush was running are written by one flush.
+         memcpy(after, before, IMAGE_SIZE);
+         while (saves-- > 0) {
+            random_save(after, rand_next(NUM_PAIRS));
+         }
+         check_flush(before, after, &totals);
+         memcpy(before, after, IMAGE_SIZE);
+      }
+   }
+
+   printf("%s: %ld flushes, %.1f blocks written per flush (%.1f when writing whole slot pairs)\n",
+          g_sram ? "SRAM" : "EEPROM", totals.flushes, (double)totals.blocksWritten / totals.flushes,
+          (double)totals.pairBlocks / totals.flushes);
+   printf("%ld power cuts, %ld slot pairs lost, %ld torn slots accepted by their checksum\n",
+          totals.cuts, totals.broken, totals.collisions);
+
+   // Torn slots accepted by their checksum are reported but don't fail the check. The save
+   // format only has a 16-bit additive checksum, so they can't be ruled out without changing it.
+   return totals.broken ? EXIT_FAILURE : EXIT_SUCCESS;
+}
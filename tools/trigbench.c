@@ -0,0 +1,186 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <PR/ultratypes.h>
+#include "trig.h"
+
+// The variants are compared with the full table, whatever config.h says.
+#undef TRIG_QUARTER_TABLE
+#include "trig_tables.inc.c"
+
+#define TRIGBENCH_VERSION "0.1"
+
+#define DEFAULT_ITERATIONS 20000000
+#define ATAN2_SAMPLES 4000000
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Written by every timed loop so the calls can't be optimized away.
+static volatile f32 g_sink_f;
+static volatile s16 g_sink_s;
+
+static void print_usage(void)
+{
+   fprintf(stderr,
+         "Usage: trigbench [-n ITERATIONS]\n"
+         "\n"
+         "trigbench v" TRIGBENCH_VERSION ": measure the accuracy and speed of the sins/coss and atan2s variants in src/engine/trig.c\n"
+         "\n"
+         "Optional arguments:\n"
+         " -n ITERATIONS calls per variant for the timings (default: %d)\n",
+         DEFAULT_ITERATIONS);
+}
+
+static f32 sins_table(u16 angle)
+{
+   return gSineTable[angle >> 4];
+}
+
+static double seconds(clock_t start)
+{
+   return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+typedef f32 (*sine_func)(u16);
+
+// Compare a sine variant with libm over every angle. Returns the number of angles where it
+// differs from the full table, for variants that should give the same values.
+static long report_sine(const char *name, sine_func func, long iterations)
+{
+   double maxErr = 0;
+   double sumErr = 0;
+   double err;
+   long differences = 0;
+   long i;
+   clock_t start;
+   f32 sum = 0;
+
+   for (i = 0; i < 0x10000; i++) {
+      err = fabs(func(i) - sin(i * (2 * M_PI / 0x10000)));
+      maxErr = err > maxErr ? err : maxErr;
+      sumErr += err;
+      if (func(i) != sins_table(i)) {
+         differences++;
+      }
+   }
+
+   start = clock();
+   for (i = 0; i < iterations; i++) {
+      sum += func((u16)(i * 0x9E37));
+   }
+   g_sink_f = sum;
+
+   printf("%-13s max error %.3e  avg error %.3e  %6.2f ns/call  %ld angles differ from the table\n",
+          name, maxErr, sumErr / 0x10000, seconds(start) * 1e9 / iterations, differences);
+   return differences;
+}
+
+// Points for the atan2s comparison: a small-integer grid that hits the octant edges and exact
+// ties, then random points over several magnitudes.
+static void atan2_point(long i, f32 *y, f32 *x)
+{
+   static unsigned int seed = 12345;
+   f32 scale;
+
+   if (i < 129 * 129) {
+      *y = (f32)(i / 129 - 64);
+      *x = (f32)(i % 129 - 64);
+      return;
+   }
+   seed = seed * 1103515245 + 12345;
+   scale = powf(10.0f, (f32)((seed >> 8) % 7) - 2);
+   seed = seed * 1103515245 + 12345;
+   *y = ((f32)(seed >> 8) / (1 << 24) * 2 - 1) * scale;
+   seed = seed * 1103515245 + 12345;
+   *x = ((f32)(seed >> 8) / (1 << 24) * 2 - 1) * scale;
+}
+
+static long report_atan2(long iterations)
+{
+   f32 *points = malloc(ATAN2_SAMPLES * 2 * sizeof(f32));
+   double maxErr = 0;
+   double err;
+   long mismatches = 0;
+   long i;
+   clock_t start;
+   s16 sum;
+
+   if (!points) {
+      fprintf(stderr, "Out of memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   for (i = 0; i < ATAN2_SAMPLES; i++) {
+      atan2_point(i, &points[i * 2], &points[i * 2 + 1]);
+   }
+
+   for (i = 0; i < ATAN2_SAMPLES; i++) {
+      f32 y = points[i * 2];
+      f32 x = points[i * 2 + 1];
+      s16 angle = atan2s_branches(y, x);
+
+      if (angle != atan2s_octant(y, x)) {
+         mismatches++;
+      }
+      if (x != 0 || y != 0) {
+         // atan2s measures from the y axis towards the x axis, so its arguments are swapped.
+         err = fabs(angle - atan2(x, y) * (0x8000 / M_PI));
+         err = err > 0x8000 ? 0x10000 - err : err;
+         maxErr = err > maxErr ? err : maxErr;
+      }
+   }
+
+   sum = 0;
+   start = clock();
+   for (i = 0; i < iterations; i++) {
+      long p = i % ATAN2_SAMPLES;
+      sum += atan2s_branches(points[p * 2], points[p * 2 + 1]);
+   }
+   g_sink_s = sum;
+   printf("%-13s max error %.2f units  %6.2f ns/call\n", "atan2s", maxErr,
+          seconds(start) * 1e9 / iterations);
+
+   sum = 0;
+   start = clock();
+   for (i = 0; i < iterations; i++) {
+      long p = i % ATAN2_SAMPLES;
+      sum += atan2s_octant(points[p * 2], points[p * 2 + 1]);
+   }
+   g_sink_s = sum;
+   printf("%-13s max error %.2f units  %6.2f ns/call  %ld of %d points differ from atan2s\n",
+          "atan2s_octant", maxErr, seconds(start) * 1e9 / iterations, mismatches, ATAN2_SAMPLES);
+
+   free(points);
+   return mismatches;
+}
+
+int main(int argc, char *argv[])
+{
+   long iterations = DEFAULT_ITERATIONS;
+   long failures = 0;
+   int i;
+
+   for (i = 1; i < argc; i++) {
+      if (argv[i][0] == '-' && argv[i][1] == 'n' && i + 1 < argc) {
+         iterations = strtol(argv[++i], NULL, 0);
+      } else {
+         print_usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (iterations <= 0) {
+      print_usage();
+      return EXIT_FAILURE;
+   }
+
+   report_sine("sins table", sins_table, iterations);
+   failures += report_sine("sins_quarter", sins_quarter, iterations);
+   report_sine("sins_lerp", sins_lerp, iterations);
+   failures += report_atan2(iterations);
+
+   return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <PR/ultratypes.h>
+#include "trace.h"
+
+#include "utils.h"
+
+#define UNFTRACE_VERSION "0.1"
+
+#define MAX_IDS 256
+
+// VR4300 count register runs at half the 93.75 MHz CPU clock
+#define DEFAULT_COUNT_HZ 46875000.0
+
+typedef struct
+{
+   char *names[MAX_IDS];
+   double count_hz;
+   FILE *out;
+   int first_event;
+   // 32-bit count register unwrapped to 64 bits across packets
+   unsigned long long time_base;
+   unsigned int last_time;
+   unsigned int first_time;
+   int have_time;
+   long packets;
+   long events;
+} trace_state;
+
+static void print_usage(void)
+{
+   ERROR("Usage: unftrace [-n NAMES] [-o OUTPUT] [-c HZ] [-v] CAPTURE [CAPTURE ...]\n"
+         "\n"
+         "unftrace v" UNFTRACE_VERSION ": UNFLoader binary trace to Chrome trace JSON converter\n"
+         "\n"
+         "Optional arguments:\n"
+         " -n NAMES     header to read TRACE_ID_<NAME> = <id> event names from (e.g. src/usb/trace.h)\n"
+         " -o OUTPUT    output JSON file (default: stdout)\n"
+         " -c HZ        count register frequency (default: %.0f)\n"
+         " -v           verbose progress output\n"
+         "\n"
+         "File arguments:\n"
+         " CAPTURE      raw binary packets saved by UNFLoader, in capture order\n",
+         DEFAULT_COUNT_HZ);
+}
+
+static void load_names(trace_state *state, const char *filename)
+{
+   char line[512];
+   FILE *fp = fopen(filename, "r");
+   if (!fp) {
+      ERROR("Error opening \"%s\"\n", filename);
+      exit(EXIT_FAILURE);
+   }
+   while (fgets(line, sizeof(line), fp)) {
+      char name[128];
+      int id;
+      char *p = strstr(line, "TRACE_ID_");
+      if (p && sscanf(p + 9, "%127[A-Za-z0-9_] = %d", name, &id) == 2 && id >= 0 && id < MAX_IDS) {
+         free(state->names[id]);
+         state->names[id] = strdup(name);
+      }
+   }
+   fclose(fp);
+}
+
+static void write_name(trace_state *state, int id)
+{
+   if (state->names[id]) {
+      fprintf(state->out, "\"%s\"", state->names[id]);
+   } else {
+      fprintf(state->out, "\"id_%d\"", id);
+   }
+}
+
+static void write_event(trace_state *state, const unsigned char *buf)
+{
+   unsigned int time = read_u32_be(&buf[0]);
+   int type = buf[4];
+   int id = buf[5];
+   int value = read_u16_be(&buf[6]);
+   double ts;
+
+   if (!state->have_time) {
+      state->first_time = time;
+      state->have_time = 1;
+   } else if (time < state->last_time) {
+      state->time_base += 0x100000000ULL;
+   }
+   state->last_time = time;
+   // timestamps are relative to the first event of the capture
+   ts = (double)(state->time_base + time - state->first_time) * 1000000.0 / state->count_hz;
+
+   fprintf(state->out, "%s\n{", state->first_event ? "" : ",");
+   state->first_event = 0;
+   switch (type) {
+      case TRACE_TYPE_BEGIN:
+      case TRACE_TYPE_END:
+         fprintf(state->out, "\"name\":");
+         write_name(state, id);
+         fprintf(state->out, ",\"ph\":\"%c\"", type == TRACE_TYPE_BEGIN ? 'B' : 'E');
+         break;
+      case TRACE_TYPE_COUNTER:
+         fprintf(state->out, "\"name\":");
+         write_name(state, id);
+         fprintf(state->out, ",\"ph\":\"C\",\"args\":{\"value\":%d}", value);
+         break;
+      case TRACE_TYPE_FRAME:
+         fprintf(state->out, "\"name\":\"frame %d\",\"ph\":\"i\",\"s\":\"g\"", value);
+         break;
+      default:
+         fprintf(state->out, "\"name\":\"unknown type %d\",\"ph\":\"i\",\"s\":\"t\"", type);
+         break;
+   }
+   fprintf(state->out, ",\"ts\":%.3f,\"pid\":1,\"tid\":5}", ts);
+   state->events++;
+}
+
+// scan for packet headers so partial captures and stray bytes between packets are skipped
+static void convert_capture(trace_state *state, const unsigned char *data, long length)
+{
+   long offset = 0;
+   while (offset + TRACE_PACKET_HEADER_SIZE <= length) {
+      unsigned int count;
+      unsigned int i;
+      if (read_u32_be(&data[offset]) != TRACE_MAGIC) {
+         offset++;
+         continue;
+      }
+      count = read_u32_be(&data[offset + 4]);
+      if (count > TRACE_MAX_EVENTS || offset + TRACE_PACKET_HEADER_SIZE + (long)count * (long)sizeof(struct TraceEvent) > length) {
+         INFO("Skipping truncated packet at 0x%lX\n", offset);
+         offset++;
+         continue;
+      }
+      offset += TRACE_PACKET_HEADER_SIZE;
+      for (i = 0; i < count; i++) {
+         write_event(state, &data[offset]);
+         offset += sizeof(struct TraceEvent);
+      }
+      state->packets++;
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   trace_state state;
+   char *out_filename = NULL;
+   int i;
+
+   memset(&state, 0, sizeof(state));
+   state.count_hz = DEFAULT_COUNT_HZ;
+   state.first_event = 1;
+
+   for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+      switch (argv[i][1]) {
+         case 'n':
+            if (++i >= argc) {
+               print_usage();
+               return EXIT_FAILURE;
+            }
+            load_names(&state, argv[i]);
+            break;
+         case 'o':
+            if (++i >= argc) {
+               print_usage();
+               return EXIT_FAILURE;
+            }
+            out_filename = argv[i];
+            break;
+         case 'c':
+            if (++i >= argc) {
+               print_usage();
+               return EXIT_FAILURE;
+            }
+            state.count_hz = strtod(argv[i], NULL);
+            if (state.count_hz <= 0) {
+               ERROR("Invalid count frequency \"%s\"\n", argv[i]);
+               return EXIT_FAILURE;
+            }
+            break;
+         case 'v':
+            g_verbosity = 1;
+            break;
+         default:
+            print_usage();
+            return EXIT_FAILURE;
+      }
+   }
+   if (i >= argc) {
+      print_usage();
+      return EXIT_FAILURE;
+   }
+
+   if (out_filename) {
+      state.out = fopen(out_filename, "w");
+      if (!state.out) {
+         ERROR("Error opening \"%s\"\n", out_filename);
+         return EXIT_FAILURE;
+      }
+   } else {
+      // keep INFO output off stdout when it carries the JSON
+      state.out = stdout;
+      g_verbosity = 0;
+   }
+
+   fprintf(state.out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+   for (; i < argc; i++) {
+      unsigned char *data;
+      long length = read_file(argv[i], &data);
+      if (length < 0) {
+         ERROR("Error reading capture \"%s\"\n", argv[i]);
+         return EXIT_FAILURE;
+      }
+      INFO("Reading \"%s\" (%ld bytes)\n", argv[i], length);
+      convert_capture(&state, data, length);
+      free(data);
+   }
+   fprintf(state.out, "\n]}\n");
+
+   INFO("Wrote %ld events from %ld packets\n", state.events, state.packets);
+   if (state.out != stdout) {
+      fclose(state.out);
+   }
+   for (i = 0; i < MAX_IDS; i++) {
+      free(state.names[i]);
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+"""Convert the capture in testdata/ with unftrace and compare the result with the
+expected JSON next to it.
+
+The capture holds three frames of packets as trace_flush sends them, with stray
+bytes between packets, the count register wrapping, a dropped events counter, an
+id without a name in src/usb/trace.h, and a packet cut short at the end.
+
+Usage: unftrace_check.py [path to unftrace]
+"""
+import os
+import subprocess
+import sys
+import tempfile
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+def main():
+    unftrace = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else os.path.join(TOOLS_DIR, "unftrace"))
+    capture = os.path.join(TOOLS_DIR, "testdata", "unftrace_capture.bin")
+    names = os.path.join(TOOLS_DIR, "..", "src", "usb", "trace.h")
+
+    with open(os.path.join(TOOLS_DIR, "testdata", "unftrace_capture.json")) as f:
+        expected = f.read()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        output = os.path.join(tmp, "trace.json")
+        if subprocess.run([unftrace, "-n", names, "-o", output, capture]).returncode != 0:
+            print("unftrace failed")
+            return 1
+        with open(output) as f:
+            actual = f.read()
+
+    if actual != expected:
+        expected_lines = expected.splitlines()
+        actual_lines = actual.splitlines()
+        for i in range(max(len(expected_lines), len(actual_lines))):
+            want = expected_lines[i] if i < len(expected_lines) else "<end>"
+            got = actual_lines[i] if i < len(actual_lines) else "<end>"
+            if want != got:
+                print("line %d differs:\n  expected %s\n  got      %s" % (i + 1, want, got))
+                break
+        return 1
+
+    print("unftrace output matches")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())